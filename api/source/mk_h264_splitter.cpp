@@ -11,6 +11,7 @@
 #include "mk_h264_splitter.h"
 #include "Http/HttpRequestSplitter.h"
 #include "Extension/Factory.h"
+#include "Extension/StartCode.h"
 
 using namespace mediakit;
 
@@ -60,19 +61,18 @@ ssize_t H264Splitter::onRecvHeader(const char *data, size_t len) {
 }
 
 const char *H264Splitter::onSearchPacketTail(const char *data, size_t len) {
-    for (size_t i = 2; len > 2 && i < len - 2; ++i) {
-        // 判断0x00 00 01  [AUTO-TRANSLATED:afa3d4c2]
-        // Determine if it is 0x00 00 01
-        if (data[i] == 0 && data[i + 1] == 0 && data[i + 2] == 1) {
-            if (i > 0 && data[i - 1] == 0) {
-                // 找到0x00 00 00 01  [AUTO-TRANSLATED:96a10021]
-                // Find 0x00 00 00 01
-                return data + i - 1;
-            }
-            return data + i;
-        }
+    if (len <= 2) {
+        return nullptr;
     }
-    return nullptr;
+    // 查找0x00 00 01
+    // Find 0x00 00 01
+    auto ptr = findStartCode(data + 2, data + len);
+    if (ptr && ptr[-1] == 0) {
+        // 找到0x00 00 00 01  [AUTO-TRANSLATED:96a10021]
+        // Find 0x00 00 00 01
+        return ptr - 1;
+    }
+    return ptr;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -228,11 +228,11 @@ void H264RtpEncoder::insertConfigFrame(uint64_t pts){
     }
     // gop缓存从sps开始，sps、pps后面还有时间戳相同的关键帧，所以mark bit为false  [AUTO-TRANSLATED:e8dcff77]
     // The gop cache starts from sps, sps, pps and then there are key frames with the same timestamp, so the mark bit is false
-    packRtp(_sps->data() + _sps->prefixSize(), _sps->size() - _sps->prefixSize(), pts, false, true);
-    packRtp(_pps->data() + _pps->prefixSize(), _pps->size() - _pps->prefixSize(), pts, false, false);
+    packRtp(_sps, _sps->data() + _sps->prefixSize(), _sps->size() - _sps->prefixSize(), pts, false, true);
+    packRtp(_pps, _pps->data() + _pps->prefixSize(), _pps->size() - _pps->prefixSize(), pts, false, false);
 }
 
-void H264RtpEncoder::packRtp(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+void H264RtpEncoder::packRtp(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
     if (len + 3 <= getRtpInfo().getMaxSize()) {
         // 采用STAP-A/Single NAL unit packet per H.264 模式  [AUTO-TRANSLATED:1a719984]
         // Use STAP-A/Single NAL unit packet per H.264 mode
@@ -240,11 +240,11 @@ void H264RtpEncoder::packRtp(const char *ptr, size_t len, uint64_t pts, bool is_
     } else {
         // STAP-A模式打包会大于MTU,所以采用FU-A模式  [AUTO-TRANSLATED:f3923abc]
         // STAP-A mode packaging will be larger than MTU, so FU-A mode is used
-        packRtpFu(ptr, len, pts, is_mark, gop_pos);
+        packRtpFu(frame, ptr, len, pts, is_mark, gop_pos);
     }
 }
 
-void H264RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+void H264RtpEncoder::packRtpFu(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
     auto packet_size = getRtpInfo().getMaxSize() - 2;
     if (len <= packet_size + 1) {
         // 小于FU-A打包最小字节长度要求，采用STAP-A/Single NAL unit packet per H.264 模式  [AUTO-TRANSLATED:b83bb4d1]
@@ -260,6 +260,14 @@ void H264RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool i
     FuFlags *fu_flags = (FuFlags *) (&fu_char_1);
     fu_flags->start_bit = 1;
 
+    GET_CONFIG(bool, zero_copy, Rtp::kZeroCopyFu);
+    Frame::Ptr holder;
+    if (zero_copy && frame->cacheAble()) {
+        // 不可缓存的帧生命周期不可控，只能拷贝
+        // The lifetime of a non-cacheable frame is uncontrollable, it can only be copied
+        holder = frame;
+    }
+
     size_t offset = 1;
     while (!fu_flags->end_bit) {
         if (!fu_flags->start_bit && len <= offset + packet_size) {
@@ -268,21 +276,29 @@ void H264RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool i
             fu_flags->end_bit = 1;
         }
 
-        // 传入nullptr先不做payload的内存拷贝  [AUTO-TRANSLATED:1858cf77]
-        // Pass in nullptr first, do not copy the payload memory
-        auto rtp = getRtpInfo().makeRtp(TrackVideo, nullptr, packet_size + 2, fu_flags->end_bit && is_mark, pts);
-        // rtp payload 负载部分  [AUTO-TRANSLATED:aecf73cc]
-        // rtp payload load part
-        uint8_t *payload = rtp->getPayload();
-        // FU-A 第1个字节  [AUTO-TRANSLATED:b5558495]
-        // FU-A first byte
-        payload[0] = fu_char_0;
-        // FU-A 第2个字节  [AUTO-TRANSLATED:6b4540bb]
-        // FU-A second byte
-        payload[1] = fu_char_1;
-        // H264 数据  [AUTO-TRANSLATED:79204239]
-        // H264 data
-        memcpy(payload + 2, (uint8_t *) ptr + offset, packet_size);
+        RtpPacket::Ptr rtp;
+        if (holder) {
+            // 只拷贝FU-A头，H264数据引用自帧
+            // Only copy the FU-A header, the H264 data is referenced from the frame
+            uint8_t fu_header[2] = { (uint8_t)fu_char_0, (uint8_t)fu_char_1 };
+            rtp = getRtpInfo().makeRtp(TrackVideo, fu_header, 2, holder, ptr + offset, packet_size, fu_flags->end_bit && is_mark, pts);
+        } else {
+            // 传入nullptr先不做payload的内存拷贝  [AUTO-TRANSLATED:1858cf77]
+            // Pass in nullptr first, do not copy the payload memory
+            rtp = getRtpInfo().makeRtp(TrackVideo, nullptr, packet_size + 2, fu_flags->end_bit && is_mark, pts);
+            // rtp payload 负载部分  [AUTO-TRANSLATED:aecf73cc]
+            // rtp payload load part
+            uint8_t *payload = rtp->getPayload();
+            // FU-A 第1个字节  [AUTO-TRANSLATED:b5558495]
+            // FU-A first byte
+            payload[0] = fu_char_0;
+            // FU-A 第2个字节  [AUTO-TRANSLATED:6b4540bb]
+            // FU-A second byte
+            payload[1] = fu_char_1;
+            // H264 数据  [AUTO-TRANSLATED:79204239]
+            // H264 data
+            memcpy(payload + 2, (uint8_t *) ptr + offset, packet_size);
+        }
         // 输入到rtp环形缓存  [AUTO-TRANSLATED:5208ef90]
         // Input to the rtp ring buffer
         RtpCodec::inputRtp(rtp, gop_pos);
@@ -367,7 +383,7 @@ bool H264RtpEncoder::inputFrame_l(const Frame::Ptr &frame, bool is_mark){
         // Ensure that there are SPS and PPS before each key frame
         insertConfigFrame(frame->pts());
     }
-    packRtp(frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize(), frame->pts(), is_mark, false);
+    packRtp(frame, frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize(), frame->pts(), is_mark, false);
     return true;
 }
 
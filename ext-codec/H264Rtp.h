@@ -96,8 +96,8 @@ public:
 private:
     void insertConfigFrame(uint64_t pts);
     bool inputFrame_l(const Frame::Ptr &frame, bool is_mark);
-    void packRtp(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
-    void packRtpFu(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtp(const Frame::Ptr &frame, const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtpFu(const Frame::Ptr &frame, const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
     void packRtpStapA(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
     void packRtpSingleNalu(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
     void packRtpSmallFrame(const char *data, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
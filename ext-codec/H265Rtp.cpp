@@ -263,8 +263,15 @@ void H265RtpDecoder::outputFrame(const RtpPacket::Ptr &rtp, const H265Frame::Ptr
 
 ////////////////////////////////////////////////////////////////////////
 
-void H265RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+void H265RtpEncoder::packRtpFu(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
     auto max_size = getRtpInfo().getMaxSize() - 3;
+    GET_CONFIG(bool, zero_copy, Rtp::kZeroCopyFu);
+    Frame::Ptr holder;
+    if (zero_copy && frame->cacheAble()) {
+        // 不可缓存的帧生命周期不可控，只能拷贝
+        // The lifetime of a non-cacheable frame is uncontrollable, it can only be copied
+        holder = frame;
+    }
     auto nal_type = H265_TYPE(ptr[0]); //获取NALU的5bit 帧类型
     unsigned char s_e_flags;
     bool fu_start = true;
@@ -289,22 +296,30 @@ void H265RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool i
             // Pass in nullptr first, do not copy the payload memory
             // 只有FU的最后一个分片且整个帧需要设置mark时才设置mark位
             bool mark_bit = fu_end && is_mark;
-            auto rtp = getRtpInfo().makeRtp(TrackVideo, nullptr, max_size + 3, mark_bit, pts);
-            // rtp payload 负载部分  [AUTO-TRANSLATED:03a5ef9b]
-            // rtp payload load part
-            uint8_t *payload = rtp->getPayload();
-            // FU 第1个字节，表明为FU  [AUTO-TRANSLATED:9cf07fda]
-            // FU first byte, indicating FU
-            payload[0] = 49 << 1;
-            // FU 第2个字节貌似固定为1  [AUTO-TRANSLATED:77983091]
-            // FU second byte seems to be fixed to 1
-            payload[1] = ptr[1]; // 1;
-            // FU 第3个字节  [AUTO-TRANSLATED:c627abd0]
-            // FU third byte
-            payload[2] = s_e_flags;
-            // H265 数据  [AUTO-TRANSLATED:a2c3135f]
-            // H265 data
-            memcpy(payload + 3, ptr + offset, max_size);
+            RtpPacket::Ptr rtp;
+            if (holder) {
+                // 只拷贝FU头，H265数据引用自帧
+                // Only copy the FU header, the H265 data is referenced from the frame
+                uint8_t fu_header[3] = { 49 << 1, (uint8_t)ptr[1], s_e_flags };
+                rtp = getRtpInfo().makeRtp(TrackVideo, fu_header, 3, holder, ptr + offset, max_size, mark_bit, pts);
+            } else {
+                rtp = getRtpInfo().makeRtp(TrackVideo, nullptr, max_size + 3, mark_bit, pts);
+                // rtp payload 负载部分  [AUTO-TRANSLATED:03a5ef9b]
+                // rtp payload load part
+                uint8_t *payload = rtp->getPayload();
+                // FU 第1个字节，表明为FU  [AUTO-TRANSLATED:9cf07fda]
+                // FU first byte, indicating FU
+                payload[0] = 49 << 1;
+                // FU 第2个字节貌似固定为1  [AUTO-TRANSLATED:77983091]
+                // FU second byte seems to be fixed to 1
+                payload[1] = ptr[1]; // 1;
+                // FU 第3个字节  [AUTO-TRANSLATED:c627abd0]
+                // FU third byte
+                payload[2] = s_e_flags;
+                // H265 数据  [AUTO-TRANSLATED:a2c3135f]
+                // H265 data
+                memcpy(payload + 3, ptr + offset, max_size);
+            }
             // 输入到rtp环形缓存  [AUTO-TRANSLATED:6bafd42b]
             // Input to rtp ring buffer
             RtpCodec::inputRtp(rtp, fu_start && gop_pos);
@@ -315,14 +330,14 @@ void H265RtpEncoder::packRtpFu(const char *ptr, size_t len, uint64_t pts, bool i
     }
 }
 
-void H265RtpEncoder::packRtp(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
+void H265RtpEncoder::packRtp(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos){
     if (len <= getRtpInfo().getMaxSize()) {
         //signal-nalu 
         RtpCodec::inputRtp(getRtpInfo().makeRtp(TrackVideo, ptr, len, is_mark, pts), gop_pos);
     } else {
         // FU-A模式  [AUTO-TRANSLATED:a273a49c]
         // FU-A mode
-        packRtpFu(ptr, len, pts, is_mark, gop_pos);
+        packRtpFu(frame, ptr, len, pts, is_mark, gop_pos);
     }
 }
 void H265RtpEncoder::insertConfigFrame(uint64_t pts){
@@ -332,9 +347,9 @@ void H265RtpEncoder::insertConfigFrame(uint64_t pts){
     }
     // gop缓存从vps 开始，vps ,sps、pps后面还有时间戳相同的关键帧，所以mark bit为false  [AUTO-TRANSLATED:2534b06f]
     // gop cache starts from vps, vps, sps, pps followed by key frames with the same timestamp, so mark bit is false
-    packRtp(_vps->data() + _vps->prefixSize(), _vps->size() - _vps->prefixSize(), pts, false, true);
-    packRtp(_sps->data() + _sps->prefixSize(), _sps->size() - _sps->prefixSize(), pts, false, false);
-    packRtp(_pps->data() + _pps->prefixSize(), _pps->size() - _pps->prefixSize(), pts, false, false);
+    packRtp(_vps, _vps->data() + _vps->prefixSize(), _vps->size() - _vps->prefixSize(), pts, false, true);
+    packRtp(_sps, _sps->data() + _sps->prefixSize(), _sps->size() - _sps->prefixSize(), pts, false, false);
+    packRtp(_pps, _pps->data() + _pps->prefixSize(), _pps->size() - _pps->prefixSize(), pts, false, false);
     
 }
 bool H265RtpEncoder::inputFrame_l(const Frame::Ptr &frame, bool is_mark){
@@ -343,7 +358,7 @@ bool H265RtpEncoder::inputFrame_l(const Frame::Ptr &frame, bool is_mark){
         // Ensure that there are SPS PPS VPS before each key frame
         insertConfigFrame(frame->pts());
     }
-    packRtp(frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize(), frame->pts(), is_mark, false);
+    packRtp(frame, frame->data() + frame->prefixSize(), frame->size() - frame->prefixSize(), frame->pts(), is_mark, false);
     return true;
 }
 bool H265RtpEncoder::inputFrame(const Frame::Ptr &frame) {
@@ -95,8 +95,8 @@ public:
     void flush() override;
 
 private:
-    void packRtp(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
-    void packRtpFu(const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtp(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
+    void packRtpFu(const Frame::Ptr &frame, const char *ptr, size_t len, uint64_t pts, bool is_mark, bool gop_pos);
     void insertConfigFrame(uint64_t pts);
     bool inputFrame_l(const Frame::Ptr &frame, bool is_mark);
 private:
@@ -11,6 +11,7 @@
 #include "MP2V.h"
 #include "MP2VRtp.h"
 #include "Extension/Factory.h"
+#include "Extension/StartCode.h"
 #include "Rtsp/Rtsp.h"
 
 using namespace std;
@@ -35,23 +36,22 @@ static const float s_mp2v_frame_rate_table[] = {
 void MP2VTrack::parseSequenceHeader(const uint8_t *data, size_t size) {
     // 查找 sequence header start code: 00 00 01 B3
     // Look for sequence header start code: 00 00 01 B3
-    for (size_t i = 0; i + 7 < size; ++i) {
-        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01 && data[i + 3] == 0xB3) {
-            // sequence_header() 结构:
-            // horizontal_size_value: 12 bits
-            // vertical_size_value: 12 bits
-            // aspect_ratio_information: 4 bits
-            // frame_rate_code: 4 bits
-            _width = (data[i + 4] << 4) | ((data[i + 5] >> 4) & 0x0F);
-            _height = ((data[i + 5] & 0x0F) << 8) | data[i + 6];
-            uint8_t frame_rate_code = data[i + 7] & 0x0F;
-            if (frame_rate_code > 0 && frame_rate_code <= 8) {
-                _fps = s_mp2v_frame_rate_table[frame_rate_code];
-            }
-            _seq_header_parsed = true;
-            return;
-        }
+    auto ptr = (const uint8_t *)findStartCode((const char *)data, (const char *)data + size, 0xB3);
+    if (!ptr || ptr + 7 >= data + size) {
+        return;
     }
+    // sequence_header() 结构:
+    // horizontal_size_value: 12 bits
+    // vertical_size_value: 12 bits
+    // aspect_ratio_information: 4 bits
+    // frame_rate_code: 4 bits
+    _width = (ptr[4] << 4) | ((ptr[5] >> 4) & 0x0F);
+    _height = ((ptr[5] & 0x0F) << 8) | ptr[6];
+    uint8_t frame_rate_code = ptr[7] & 0x0F;
+    if (frame_rate_code > 0 && frame_rate_code <= 8) {
+        _fps = s_mp2v_frame_rate_table[frame_rate_code];
+    }
+    _seq_header_parsed = true;
 }
 
 bool MP2VTrack::inputFrame(const Frame::Ptr &frame) {
@@ -10,6 +10,7 @@
 
 #include "MP2VRtp.h"
 #include "Common/config.h"
+#include "Extension/StartCode.h"
 
 namespace mediakit {
 
@@ -144,12 +145,7 @@ void MP2VRtpDecoder::outputFrame(const RtpPacket::Ptr &rtp) {
 
 bool MP2VRtpEncoder::hasSequenceHeader(const uint8_t *data, size_t size) {
     // 查找 sequence header start code: 00 00 01 B3
-    for (size_t i = 0; i + 3 < size; ++i) {
-        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01 && data[i + 3] == 0xB3) {
-            return true;
-        }
-    }
-    return false;
+    return findStartCode((const char *)data, (const char *)data + size, 0xB3) != nullptr;
 }
 
 void MP2VRtpEncoder::parsePictureInfo(const uint8_t *data, size_t size) {
@@ -162,33 +158,33 @@ void MP2VRtpEncoder::parsePictureInfo(const uint8_t *data, size_t size) {
     _has_seq_header = hasSequenceHeader(data, size);
 
     // 查找 picture start code: 00 00 01 00
-    for (size_t i = 0; i + 5 < size; ++i) {
-        if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] == 0x01 && data[i + 3] == 0x00) {
-            // temporal_reference: 10 bits, picture_coding_type: 3 bits
-            _temporal_ref = (data[i + 4] << 2) | ((data[i + 5] >> 6) & 0x03);
-            _picture_type = (data[i + 5] >> 3) & 0x07;
-
-            // 解析 motion vector codes (vbv_delay 之后)
-            // picture header: temporal_reference(10) + picture_coding_type(3) + vbv_delay(16)
-            if (i + 8 < size) {
-                uint8_t extra_byte = data[i + 8];
-                if (_picture_type == 2 /* P */ || _picture_type == 3 /* B */) {
-                    // full_pel_forward_vector(1) + forward_f_code(3)
-                    _ffv = (extra_byte >> 2) & 0x01;
-                    _ffc = ((extra_byte & 0x03) << 1);
-                    if (i + 9 < size) {
-                        _ffc |= (data[i + 9] >> 7) & 0x01;
-                    }
-                }
-                if (_picture_type == 3 /* B */) {
-                    // full_pel_backward_vector(1) + backward_f_code(3) 紧跟在 forward 之后
-                    if (i + 9 < size) {
-                        _fbv = (data[i + 9] >> 6) & 0x01;
-                        _bfc = (data[i + 9] >> 3) & 0x07;
-                    }
-                }
+    auto ptr = (const uint8_t *)findStartCode((const char *)data, (const char *)data + size, 0x00);
+    if (!ptr || ptr + 5 >= data + size) {
+        return;
+    }
+    size_t i = ptr - data;
+    // temporal_reference: 10 bits, picture_coding_type: 3 bits
+    _temporal_ref = (data[i + 4] << 2) | ((data[i + 5] >> 6) & 0x03);
+    _picture_type = (data[i + 5] >> 3) & 0x07;
+
+    // 解析 motion vector codes (vbv_delay 之后)
+    // picture header: temporal_reference(10) + picture_coding_type(3) + vbv_delay(16)
+    if (i + 8 < size) {
+        uint8_t extra_byte = data[i + 8];
+        if (_picture_type == 2 /* P */ || _picture_type == 3 /* B */) {
+            // full_pel_forward_vector(1) + forward_f_code(3)
+            _ffv = (extra_byte >> 2) & 0x01;
+            _ffc = ((extra_byte & 0x03) << 1);
+            if (i + 9 < size) {
+                _ffc |= (data[i + 9] >> 7) & 0x01;
+            }
+        }
+        if (_picture_type == 3 /* B */) {
+            // full_pel_backward_vector(1) + backward_f_code(3) 紧跟在 forward 之后
+            if (i + 9 < size) {
+                _fbv = (data[i + 9] >> 6) & 0x01;
+                _bfc = (data[i + 9] >> 3) & 0x07;
             }
-            return;
         }
     }
 }
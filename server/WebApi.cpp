@@ -42,6 +42,9 @@
 
 #include "Common/config.h"
 #include "Common/MediaSource.h"
+#include "Common/UdpBatchSender.h"
+#include "Common/UdpBatchReceiver.h"
+#include "Common/LatencyStats.h"
 #include "Http/HttpSession.h"
 #include "Http/HttpRequester.h"
 #include "Player/PlayerProxy.h"
@@ -61,6 +64,7 @@
 #include "../webrtc/WebRtcSignalingSession.h"
 #include "../webrtc/WebRtcProxyPlayer.h"
 #include "../webrtc/WebRtcProxyPlayerImp.h"
+#include "../webrtc/WebRtcSession.h"
 #endif
 
 #if defined(ENABLE_VERSION)
@@ -435,7 +439,7 @@ Value ToJson(const PlayerProxy::Ptr& p) {
     return item;
 }
 
-Value makeMediaSourceJson(MediaSource &media) {
+Value makeMediaSourceJson(MediaSource &media, bool with_loss) {
     Value item;
     item["schema"] = media.getSchema();
     dumpMediaTuple(media.getMediaTuple(), item);
@@ -446,6 +450,10 @@ Value makeMediaSourceJson(MediaSource &media) {
     item["totalBytes"] = (Json::UInt64) media.getTotalBytes();
     item["readerCount"] = media.readerCount();
     item["totalReaderCount"] = media.totalReaderCount();
+    auto merge_ms = media.getMergeWriteMS();
+    if (merge_ms >= 0) {
+        item["mergeWriteMS"] = merge_ms;
+    }
     item["originType"] = (int) media.getOriginType();
     item["originTypeStr"] = getOriginTypeString(media.getOriginType());
     item["originUrl"] = media.getOriginUrl();
@@ -458,25 +466,55 @@ Value makeMediaSourceJson(MediaSource &media) {
         item["originSock"] = Json::nullValue;
     }
 
-    // getLossRate有线程安全问题；使用getMediaInfo接口才能获取丢包率；getMediaList接口将忽略丢包率  [AUTO-TRANSLATED:b2e927c6]
-    // getLossRate has thread safety issues; use the getMediaInfo interface to get the packet loss rate; the getMediaList interface will ignore the packet loss rate
+    // getLossRate与复用器线程统计有线程安全问题，只在归属线程获取(getMediaInfo与getMediaList接口都在归属线程调用)
+    // 获取间隔丢包率会重置统计区间，getMediaList接口将忽略丢包率，以免影响getMediaInfo接口与hook
+    // getLossRate and the muxer thread statistics have thread safety issues, they are only obtained in the owner thread
+    // (both getMediaInfo and getMediaList interfaces are called in the owner thread)
+    // Getting the interval packet loss rate resets the statistics interval, the getMediaList interface ignores the packet loss rate
+    // so as not to affect the getMediaInfo interface and hooks
     auto current_thread = false;
     try { current_thread = media.getOwnerPoller()->isCurrentThread();} catch (...) {}
     float last_loss = -1;
     auto tracks = dumpTracks(media.getTracks(false));
+    auto muxer = media.getMuxer();
     if (current_thread) {
-        for (auto &obj : tracks) {
-            // rtp推流只有一个统计器，但是可能有多个track，如果短时间多次获取间隔丢包率，第二次会获取为-1  [AUTO-TRANSLATED:5bfbc951]
-            // RTP push stream has only one statistics, but may have multiple tracks. If you get the interval packet loss rate multiple times in a short time,
-            // the second time will get -1
-            auto loss = media.getLossRate(getTrackType(static_cast<CodecId>(obj["codec_type"].asInt())));
-            if (loss == -1) {
-                loss = last_loss;
-            } else {
-                last_loss = loss;
+        if (with_loss) {
+            for (auto &obj : tracks) {
+                // rtp推流只有一个统计器，但是可能有多个track，如果短时间多次获取间隔丢包率，第二次会获取为-1  [AUTO-TRANSLATED:5bfbc951]
+                // RTP push stream has only one statistics, but may have multiple tracks. If you get the interval packet loss rate multiple times in a short time,
+                // the second time will get -1
+                auto loss = media.getLossRate(getTrackType(static_cast<CodecId>(obj["codec_type"].asInt())));
+                if (loss == -1) {
+                    loss = last_loss;
+                } else {
+                    last_loss = loss;
+                }
+                obj["loss"] = loss;
             }
-            obj["loss"] = loss;
         }
+        std::vector<MuxerWorkerInfo> worker_info;
+        if (muxer && muxer->getMuxerWorkerInfo(worker_info)) {
+            auto &workers = item["muxerWorkers"];
+            for (auto &info : worker_info) {
+                Json::Value obj;
+                obj["name"] = info.name;
+                obj["queueSize"] = (Json::UInt64) info.queue_size;
+                obj["frames"] = (Json::UInt64) info.frames;
+                obj["dropped"] = (Json::UInt64) info.dropped;
+                obj["cpuUS"] = (Json::UInt64) info.cpu_us;
+                workers.append(std::move(obj));
+            }
+        }
+    }
+    // 平滑发送统计信息通过原子变量发布，可在任意线程获取
+    // Paced sender statistics are published through atomic variables and can be obtained in any thread
+    PacedSenderInfo paced_info;
+    if (muxer && muxer->getPacedSenderInfo(paced_info)) {
+        auto &paced = item["pacedSender"];
+        paced["queueSize"] = (Json::UInt64) paced_info.queue_size;
+        paced["cacheMS"] = paced_info.cache_ms;
+        paced["jitterMS"] = paced_info.jitter_ms;
+        paced["flushCount"] = (Json::UInt64) paced_info.flush_count;
     }
     item["tracks"] = std::move(tracks);
     return item;
@@ -507,6 +545,30 @@ uint16_t openRtpServer(uint16_t local_port, const mediakit::MediaTuple &tuple, i
 
 #endif
 
+// 延时直方图输出的百分位
+// Percentiles output of the latency histogram
+static const std::pair<const char *, double> s_latency_quantiles[] = { { "0.5", 0.5 }, { "0.9", 0.9 }, { "0.99", 0.99 }, { "0.999", 0.999 } };
+
+static bool matchLatencyStats(const LatencyStats &stats, const ArgsMap &allArgs) {
+    auto &tuple = stats.getMediaTuple();
+    return (allArgs["vhost"].empty() || allArgs["vhost"] == tuple.vhost) && (allArgs["app"].empty() || allArgs["app"] == tuple.app)
+        && (allArgs["stream"].empty() || allArgs["stream"] == tuple.stream);
+}
+
+static string escapeMetricLabel(const string &str) {
+    string ret;
+    ret.reserve(str.size());
+    for (auto ch : str) {
+        switch (ch) {
+            case '\\': ret += "\\\\"; break;
+            case '"': ret += "\\\""; break;
+            case '\n': ret += "\\n"; break;
+            default: ret += ch; break;
+        }
+    }
+    return ret;
+}
+
 void getStatisticJson(const function<void(Value &val)> &cb) {
     auto obj = std::make_shared<Value>(objectValue);
     auto &val = *obj;
@@ -530,6 +592,46 @@ void getStatisticJson(const function<void(Value &val)> &cb) {
 
     val["RtpPacket"] = (Json::UInt64)(ObjectStatistic<RtpPacket>::count());
     val["RtmpPacket"] = (Json::UInt64)(ObjectStatistic<RtmpPacket>::count());
+    {
+        auto pool = RtpPacket::getPoolStatistic();
+        auto &pool_val = val["RtpPacketPool"];
+        pool_val["obtain"] = (Json::UInt64)pool.obtain;
+        pool_val["hit"] = (Json::UInt64)pool.hit;
+        pool_val["recycle"] = (Json::UInt64)pool.recycle;
+        pool_val["returned"] = (Json::UInt64)pool.returned;
+        pool_val["drop"] = (Json::UInt64)pool.drop;
+        pool_val["free"] = (Json::UInt64)pool.free;
+        pool_val["hitRate"] = pool.obtain ? (double)pool.hit / pool.obtain : 0.0;
+    }
+    {
+        auto pool = RtmpPacket::getPoolStatistic();
+        auto &pool_val = val["RtmpPacketPool"];
+        pool_val["obtain"] = (Json::UInt64)pool.obtain;
+        pool_val["hit"] = (Json::UInt64)pool.hit;
+        pool_val["recycle"] = (Json::UInt64)pool.recycle;
+        pool_val["returned"] = (Json::UInt64)pool.returned;
+        pool_val["drop"] = (Json::UInt64)pool.drop;
+        pool_val["free"] = (Json::UInt64)pool.free;
+        pool_val["hitRate"] = pool.obtain ? (double)pool.hit / pool.obtain : 0.0;
+    }
+    {
+        auto udp = UdpBatchSender::getStatistic();
+        auto &udp_val = val["UdpBatchSend"];
+        udp_val["packets"] = (Json::UInt64)udp.packets;
+        udp_val["syscalls"] = (Json::UInt64)udp.syscalls;
+        udp_val["gso"] = (Json::UInt64)udp.gso;
+        udp_val["fallback"] = (Json::UInt64)udp.fallback;
+        udp_val["errors"] = (Json::UInt64)udp.errors;
+        udp_val["packetsPerSyscall"] = udp.syscalls ? (double)udp.packets / udp.syscalls : 0.0;
+    }
+    {
+        auto udp = UdpBatchReceiver::getStatistic();
+        auto &udp_val = val["UdpBatchRecv"];
+        udp_val["packets"] = (Json::UInt64)udp.packets;
+        udp_val["syscalls"] = (Json::UInt64)udp.syscalls;
+        udp_val["gro"] = (Json::UInt64)udp.gro;
+        udp_val["packetsPerSyscall"] = udp.syscalls ? (double)udp.packets / udp.syscalls : 0.0;
+    }
 #ifdef ENABLE_MEM_DEBUG
     auto bytes = getTotalMemUsage();
     val["totalMemUsage"] = (Json::UInt64) bytes;
@@ -994,18 +1096,25 @@ void installWebApi() {
             lst.emplace_back(media);
         }, allArgs["schema"], allArgs["vhost"], allArgs["app"], allArgs["stream"]);
 
-        if (lst.size() == 1) {
-            // 如果是搜索单一流，那么在它的归属线程中执行，用于获取丢包率参数
-            auto front = std::move(lst.front());
-            front->getOwnerPoller()->async([=]() mutable {
-                val["data"].append(makeMediaSourceJson(*front));
-                invoker(200, headerOut, val.toStyledString());
-            });
-        } else {
-            for (auto &media : lst) {
-                val["data"].append(makeMediaSourceJson(*media));
+        // 每个流在它的归属线程中生成信息，用于获取复用器线程等只能在归属线程访问的参数(不获取丢包率，以免重置其统计区间)
+        // 所有流都生成完毕(结果缓存被释放)后按原顺序回复
+        // Generate the information of each stream in its owner thread, to get the parameters that can only be accessed in the owner thread,
+        // such as muxer threads (the packet loss rate is not obtained so as not to reset its statistics interval).
+        // Reply in the original order after all streams are generated (the result cache is released)
+        auto items = std::shared_ptr<std::vector<Value>>(new std::vector<Value>(lst.size()), [val, invoker, headerOut](std::vector<Value> *ptr) {
+            auto ret = val;
+            for (auto &item : *ptr) {
+                ret["data"].append(std::move(item));
             }
-            invoker(200, headerOut, val.toStyledString());
+            delete ptr;
+            invoker(200, headerOut, ret.toStyledString());
+        });
+        size_t index = 0;
+        for (auto &media : lst) {
+            media->getOwnerPoller()->async([items, media, index]() {
+                (*items)[index] = makeMediaSourceJson(*media, false);
+            });
+            ++index;
         }
     });
 
@@ -1044,6 +1153,17 @@ void installWebApi() {
                 auto &session = info.get<Session>();
                 fillSockInfo(*obj, &session);
                 (*obj)["typeid"] = toolkit::demangle(typeid(session).name());
+#ifdef ENABLE_WEBRTC
+                if (auto rtc_session = dynamic_cast<WebRtcSession *>(&session)) {
+                    // webrtc播放器附带发送端带宽估计信息，本回调在播放器所在poller线程执行
+                    // The webrtc player comes with sender side bandwidth estimation information, this callback is executed in the poller thread of the player
+                    Value bwe;
+                    auto &transport = rtc_session->getTransport();
+                    if (transport && transport->getBweInfo(bwe)) {
+                        (*obj)["bwe"] = std::move(bwe);
+                    }
+                }
+#endif
                 toolkit::Any ret;
                 ret.set(obj);
                 return ret;
@@ -2145,6 +2265,68 @@ void installWebApi() {
         });
     });
 
+    // 获取各流热点路径延时统计(单位微秒)，可通过vhost/app/stream参数过滤；reset=1时获取后清空，用于按时间窗口统计
+    // Get the hot path latency statistics (in microseconds) of each stream, can be filtered by vhost/app/stream;
+    // clear after getting when reset=1, used for statistics by time window
+    // 测试url http://127.0.0.1/index/api/getLatencyStats?vhost=__defaultVhost__&app=live&stream=obs
+    api_regist("/index/api/getLatencyStats",[](API_ARGS_MAP){
+        CHECK_SECRET();
+        val["data"] = Json::arrayValue;
+        auto reset = allArgs["reset"].as<bool>();
+        LatencyStats::forEach([&](LatencyStats &stats) {
+            if (!matchLatencyStats(stats, allArgs)) {
+                return;
+            }
+            Value item;
+            dumpMediaTuple(stats.getMediaTuple(), item);
+            for (int i = 0; i < LatencyStats::kStageMax; ++i) {
+                auto stage = (LatencyStats::Stage)i;
+                auto &histogram = stats.getHistogram(stage);
+                auto &obj = item["stages"][LatencyStats::getStageName(stage)];
+                auto count = histogram.count();
+                obj["count"] = (Json::UInt64)count;
+                obj["avg"] = (Json::UInt64)(count ? histogram.sum() / count : 0);
+                obj["max"] = (Json::UInt64)histogram.max();
+                for (auto &quantile : s_latency_quantiles) {
+                    obj[string("p") + quantile.first] = (Json::UInt64)histogram.percentile(quantile.second);
+                }
+            }
+            if (reset) {
+                stats.reset();
+            }
+            val["data"].append(std::move(item));
+        });
+    });
+
+    // 以prometheus文本格式获取各流热点路径延时统计，可通过vhost/app/stream参数过滤
+    // Get the hot path latency statistics of each stream in prometheus text format, can be filtered by vhost/app/stream
+    // 测试url http://127.0.0.1/index/api/getLatencyMetrics
+    api_regist("/index/api/getLatencyMetrics",[](API_ARGS_MAP_ASYNC){
+        CHECK_SECRET();
+        _StrPrinter printer;
+        printer << "# HELP zlm_latency_us Hot path latency of each stream in microseconds\n";
+        printer << "# TYPE zlm_latency_us summary\n";
+        LatencyStats::forEach([&](const LatencyStats &stats) {
+            if (!matchLatencyStats(stats, allArgs)) {
+                return;
+            }
+            auto &tuple = stats.getMediaTuple();
+            for (int i = 0; i < LatencyStats::kStageMax; ++i) {
+                auto stage = (LatencyStats::Stage)i;
+                auto &histogram = stats.getHistogram(stage);
+                string labels = StrPrinter << "vhost=\"" << escapeMetricLabel(tuple.vhost) << "\",app=\"" << escapeMetricLabel(tuple.app) << "\",stream=\""
+                                           << escapeMetricLabel(tuple.stream) << "\",stage=\"" << LatencyStats::getStageName(stage) << "\"";
+                for (auto &quantile : s_latency_quantiles) {
+                    printer << "zlm_latency_us{" << labels << ",quantile=\"" << quantile.first << "\"} " << histogram.percentile(quantile.second) << "\n";
+                }
+                printer << "zlm_latency_us_sum{" << labels << "} " << histogram.sum() << "\n";
+                printer << "zlm_latency_us_count{" << labels << "} " << histogram.count() << "\n";
+            }
+        });
+        headerOut["Content-Type"] = "text/plain; version=0.0.4; charset=utf-8";
+        invoker(200, headerOut, printer);
+    });
+
 #ifdef ENABLE_WEBRTC
     api_regist("/index/api/webrtc",[](API_ARGS_STRING_ASYNC){
         CHECK_ARGS("type");
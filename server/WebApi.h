@@ -245,7 +245,13 @@ void unInstallWebApi();
 uint16_t openRtpServer(uint16_t local_port, const mediakit::MediaTuple &tuple, int tcp_mode, const std::string &local_ip, bool re_use_port, uint32_t ssrc, int only_track, bool multiplex=false);
 #endif
 
-Json::Value makeMediaSourceJson(mediakit::MediaSource &media);
+/**
+ * 生成MediaSource的信息
+ * @param with_loss 是否获取间隔丢包率，获取后丢包统计区间将被重置
+ * Generate the information of the MediaSource
+ * @param with_loss Whether to get the interval packet loss rate, the loss statistics interval is reset after getting it
+ */
+Json::Value makeMediaSourceJson(mediakit::MediaSource &media, bool with_loss = true);
 ApiArgsType getAllArgs(const mediakit::Parser &parser);
 void getStatisticJson(const std::function<void(Json::Value &val)> &cb);
 void addStreamProxy(const mediakit::MediaTuple &tuple, const std::string &url, int retry_count, bool force,
@@ -0,0 +1,243 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <list>
+#include <mutex>
+#include <chrono>
+#include <unordered_map>
+#include "LatencyStats.h"
+#include "Common/config.h"
+
+using namespace std;
+
+namespace mediakit {
+
+constexpr size_t LatencyHistogram::kBuckets;
+constexpr size_t LatencyHistogram::kMaxShards;
+
+static inline size_t highestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    size_t ret = 0;
+    while (v >>= 1) {
+        ++ret;
+    }
+    return ret;
+#endif
+}
+
+LatencyHistogram::Shard::Shard() {
+    for (auto &bucket : buckets) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+LatencyHistogram::~LatencyHistogram() {
+    for (auto &shard : _shards) {
+        delete shard.load(std::memory_order_acquire);
+    }
+}
+
+size_t LatencyHistogram::shardIndex() {
+    static atomic<size_t> s_next { 0 };
+    static thread_local size_t s_index = s_next.fetch_add(1, std::memory_order_relaxed) % kMaxShards;
+    return s_index;
+}
+
+LatencyHistogram::Shard &LatencyHistogram::getShard() {
+    auto &slot = _shards[shardIndex()];
+    auto shard = slot.load(std::memory_order_acquire);
+    if (shard) {
+        return *shard;
+    }
+    auto fresh = new Shard;
+    if (slot.compare_exchange_strong(shard, fresh, std::memory_order_acq_rel)) {
+        return *fresh;
+    }
+    // 共用该分片的其他线程已创建
+    // Already created by another thread sharing this shard
+    delete fresh;
+    return *shard;
+}
+
+size_t LatencyHistogram::bucketIndex(uint64_t us) {
+    if (us < kSubBuckets) {
+        return us;
+    }
+    auto bit = highestBit(us);
+    if (bit >= kMaxBits) {
+        return kBuckets - 1;
+    }
+    auto shift = bit - kSubBucketBits;
+    return (bit - kSubBucketBits + 1) * kSubBuckets + ((us >> shift) - kSubBuckets);
+}
+
+uint64_t LatencyHistogram::bucketUpper(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    auto shift = index / kSubBuckets - 1;
+    auto sub = index % kSubBuckets;
+    return ((kSubBuckets + sub + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t us) {
+    // 分片通常只有当前线程修改，原子操作不会在线程间争抢缓存行
+    // The shard is usually only modified by the current thread, the atomic operations do not contend for the cache line between threads
+    auto &shard = getShard();
+    shard.buckets[bucketIndex(us)].fetch_add(1, std::memory_order_relaxed);
+    shard.count.fetch_add(1, std::memory_order_relaxed);
+    shard.sum.fetch_add(us, std::memory_order_relaxed);
+    auto max = shard.max.load(std::memory_order_relaxed);
+    while (us > max && !shard.max.compare_exchange_weak(max, us, std::memory_order_relaxed)) {
+    }
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t ret = 0;
+    for (auto &slot : _shards) {
+        if (auto shard = slot.load(std::memory_order_acquire)) {
+            ret += shard->count.load(std::memory_order_relaxed);
+        }
+    }
+    return ret;
+}
+
+uint64_t LatencyHistogram::sum() const {
+    uint64_t ret = 0;
+    for (auto &slot : _shards) {
+        if (auto shard = slot.load(std::memory_order_acquire)) {
+            ret += shard->sum.load(std::memory_order_relaxed);
+        }
+    }
+    return ret;
+}
+
+uint64_t LatencyHistogram::max() const {
+    uint64_t ret = 0;
+    for (auto &slot : _shards) {
+        if (auto shard = slot.load(std::memory_order_acquire)) {
+            ret = MAX(ret, shard->max.load(std::memory_order_relaxed));
+        }
+    }
+    return ret;
+}
+
+uint64_t LatencyHistogram::percentile(double ratio) const {
+    // 先合并各分片，避免读取过程中新增的样本导致计数与桶不一致
+    // Merge the shards first, to avoid the count being inconsistent with the buckets due to samples added during reading
+    uint64_t buckets[kBuckets] = { 0 };
+    uint64_t total = 0;
+    uint64_t max_us = 0;
+    for (auto &slot : _shards) {
+        auto shard = slot.load(std::memory_order_acquire);
+        if (!shard) {
+            continue;
+        }
+        for (size_t i = 0; i < kBuckets; ++i) {
+            auto count = shard->buckets[i].load(std::memory_order_relaxed);
+            buckets[i] += count;
+            total += count;
+        }
+        max_us = MAX(max_us, shard->max.load(std::memory_order_relaxed));
+    }
+    if (!total) {
+        return 0;
+    }
+    auto target = (uint64_t)(ratio * total + 0.5);
+    target = MAX(target, (uint64_t)1);
+    uint64_t acc = 0;
+    for (size_t i = 0; i < kBuckets; ++i) {
+        acc += buckets[i];
+        if (acc >= target) {
+            // 桶上限可能超过实际最大值，最后一个桶无上限
+            // The upper bound of the bucket may exceed the actual max value, the last bucket has no upper bound
+            return i + 1 == kBuckets ? max_us : MIN(bucketUpper(i), max_us);
+        }
+    }
+    return max_us;
+}
+
+void LatencyHistogram::reset() {
+    for (auto &slot : _shards) {
+        auto shard = slot.load(std::memory_order_acquire);
+        if (!shard) {
+            continue;
+        }
+        for (auto &bucket : shard->buckets) {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+        shard->count.store(0, std::memory_order_relaxed);
+        shard->sum.store(0, std::memory_order_relaxed);
+        shard->max.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t LatencyHistogram::now() {
+    return chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+////////////////////////////////////////////LatencyStats////////////////////////////////////////////
+
+static mutex s_mtx;
+static unordered_map<string, weak_ptr<LatencyStats>> s_stats;
+
+LatencyStats::Ptr LatencyStats::get(const MediaTuple &tuple) {
+    GET_CONFIG(bool, enable, General::kLatencyStats);
+    if (!enable) {
+        return nullptr;
+    }
+    auto key = tuple.shortUrl();
+    lock_guard<mutex> lck(s_mtx);
+    auto &ref = s_stats[key];
+    auto ret = ref.lock();
+    if (!ret) {
+        ret = std::make_shared<LatencyStats>(MediaTuple(tuple.vhost, tuple.app, tuple.stream));
+        ref = ret;
+    }
+    return ret;
+}
+
+void LatencyStats::forEach(const function<void(LatencyStats &stats)> &cb) {
+    list<Ptr> stats_list;
+    {
+        lock_guard<mutex> lck(s_mtx);
+        for (auto it = s_stats.begin(); it != s_stats.end();) {
+            auto stats = it->second.lock();
+            if (!stats) {
+                it = s_stats.erase(it);
+                continue;
+            }
+            stats_list.emplace_back(std::move(stats));
+            ++it;
+        }
+    }
+    for (auto &stats : stats_list) {
+        cb(*stats);
+    }
+}
+
+void LatencyStats::reset() {
+    for (auto &histogram : _histograms) {
+        histogram.reset();
+    }
+}
+
+const char *LatencyStats::getStageName(Stage stage) {
+    switch (stage) {
+        case kIngestToMuxer: return "ingest_to_muxer";
+        case kMuxerToRing: return "muxer_to_ring";
+        case kRingToSend: return "ring_to_send";
+        default: return "invalid";
+    }
+}
+
+} // namespace mediakit
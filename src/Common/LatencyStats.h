@@ -0,0 +1,157 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_LATENCY_STATS_H
+#define ZLMEDIAKIT_LATENCY_STATS_H
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <functional>
+#include "Record/Recorder.h"
+
+namespace mediakit {
+
+/**
+ * 无锁延时直方图(HDR风格)
+ * 以微秒为单位，每个2的幂区间再等分为8个桶，相对误差不超过12.5%；
+ * 按线程分片记录，各线程只修改自己分片的缓存行，读取时再合并，可在生产环境常开
+ * Lock-free latency histogram (HDR style)
+ * In microseconds, each power of 2 range is divided into 8 buckets, the relative error is no more than 12.5%;
+ * recorded in per thread shards, each thread only modifies the cache lines of its own shard, and they are merged when read,
+ * so it can be always on in production
+ */
+class LatencyHistogram {
+public:
+    static constexpr size_t kSubBucketBits = 3;
+    static constexpr size_t kSubBuckets = 1 << kSubBucketBits;
+    // 最大可区分2^40微秒(约12天)，更大的值记在最后一个桶
+    // Up to 2^40 microseconds (about 12 days) can be distinguished, larger values are recorded in the last bucket
+    static constexpr size_t kMaxBits = 40;
+    static constexpr size_t kBuckets = (kMaxBits - kSubBucketBits + 1) * kSubBuckets;
+    // 分片个数，线程数超过时多个线程共用一个分片
+    // Number of shards, multiple threads share one shard when there are more threads
+    static constexpr size_t kMaxShards = 32;
+
+    LatencyHistogram() = default;
+    ~LatencyHistogram();
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    /**
+     * 记录一次延时，可在任意线程调用
+     * Record a latency, can be called in any thread
+     */
+    void record(uint64_t us);
+
+    uint64_t count() const;
+    uint64_t sum() const;
+    uint64_t max() const;
+
+    /**
+     * 获取百分位延时(所在桶的上限)
+     * @param ratio 百分位，取值范围(0, 1]
+     * Get the percentile latency (upper bound of the bucket)
+     * @param ratio Percentile, range (0, 1]
+     */
+    uint64_t percentile(double ratio) const;
+
+    /**
+     * 清空统计，用于按时间窗口统计；与record并发时可能丢失少量样本
+     * Clear the statistics, used for statistics by time window; a few samples may be lost when concurrent with record
+     */
+    void reset();
+
+    /**
+     * 单调时钟，单位微秒
+     * Monotonic clock, in microseconds
+     */
+    static uint64_t now();
+
+private:
+    struct Shard {
+        Shard();
+
+        std::atomic<uint64_t> count { 0 };
+        std::atomic<uint64_t> sum { 0 };
+        std::atomic<uint64_t> max { 0 };
+        std::atomic<uint64_t> buckets[kBuckets];
+        // 避免与相邻的堆内存共用缓存行
+        // Avoid sharing the cache line with the adjacent heap memory
+        char padding[64];
+    };
+
+    static size_t bucketIndex(uint64_t us);
+    static uint64_t bucketUpper(size_t index);
+    static size_t shardIndex();
+    Shard &getShard();
+
+private:
+    // 分片在线程首次记录时创建，直到直方图销毁
+    // The shard is created when the thread records for the first time, until the histogram is destroyed
+    std::atomic<Shard *> _shards[kMaxShards] {};
+};
+
+/**
+ * 单个流热点路径各阶段的延时统计
+ * Latency statistics of each hot path stage of a stream
+ */
+class LatencyStats {
+public:
+    using Ptr = std::shared_ptr<LatencyStats>;
+
+    enum Stage {
+        // 输入MultiMediaSourceMuxer到输入各协议复用器
+        // From the input of MultiMediaSourceMuxer to the input of protocol muxers
+        kIngestToMuxer = 0,
+        // 协议复用器输出数据包到合并写刷新写入环形缓存
+        // From the protocol muxer outputting the packet to the merge write flushing into the ring buffer
+        kMuxerToRing,
+        // 写入环形缓存到播放器读取并写入socket
+        // From writing into the ring buffer to the player reading it and writing to the socket
+        kRingToSend,
+        kStageMax
+    };
+
+    LatencyStats(const MediaTuple &tuple) : _tuple(tuple) {}
+
+    /**
+     * 获取流的延时统计对象，同一流的多个协议共用一个对象；配置关闭时返回nullptr
+     * Get the latency statistics object of the stream, multiple protocols of the same stream share one object; return nullptr when disabled by config
+     */
+    static Ptr get(const MediaTuple &tuple);
+
+    /**
+     * 遍历所有流的延时统计
+     * Traverse the latency statistics of all streams
+     */
+    static void forEach(const std::function<void(LatencyStats &stats)> &cb);
+
+    static const char *getStageName(Stage stage);
+
+    void record(Stage stage, uint64_t us) { _histograms[stage].record(us); }
+
+    const LatencyHistogram &getHistogram(Stage stage) const { return _histograms[stage]; }
+
+    /**
+     * 清空所有阶段的统计
+     * Clear the statistics of all stages
+     */
+    void reset();
+
+    const MediaTuple &getMediaTuple() const { return _tuple; }
+
+private:
+    MediaTuple _tuple;
+    LatencyHistogram _histograms[kStageMax];
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_LATENCY_STATS_H
@@ -55,6 +55,24 @@ public:
 class MediaSinkInterface : public FrameWriterInterface, public TrackListener {
 public:
     using Ptr = std::shared_ptr<MediaSinkInterface>;
+
+    /**
+     * 批量输入帧，用于帧突发到达的场景(mp4点播、rtp排序缓存输出等)
+     * 默认逐帧调用inputFrame，派生类可重写以在整批帧间分摊开销
+     * @param frames 帧数组
+     * @param count 帧个数
+     * Input frames in batch, used in scenarios where frames arrive in bursts (mp4 vod, rtp sorting cache output, etc.)
+     * By default inputFrame is called frame by frame, derived classes can override it to amortize the cost across the whole batch
+     * @param frames Frame array
+     * @param count Number of frames
+     */
+    virtual bool inputFrames(const Frame::Ptr *frames, size_t count) {
+        bool ret = false;
+        for (size_t i = 0; i < count; ++i) {
+            ret = inputFrame(frames[i]) ? true : ret;
+        }
+        return ret;
+    }
 };
 
 /**
@@ -28,12 +28,153 @@ namespace toolkit {
 
 namespace mediakit {
 
-static recursive_mutex s_media_source_mtx;
-using StreamMap = unordered_map<string/*strema_id*/, weak_ptr<MediaSource> >;
-using AppStreamMap = unordered_map<string/*app*/, StreamMap>;
-using VhostAppStreamMap = unordered_map<string/*vhost*/, AppStreamMap>;
-using SchemaVhostAppStreamMap = unordered_map<string/*schema*/, VhostAppStreamMap>;
-static SchemaVhostAppStreamMap s_media_source_map;
+/**
+ * 媒体源注册表，按(vhost, app, stream)哈希分片，每个分片采用写时复制
+ * 查找与遍历只需原子加载分片快照，不会阻塞；注册/注销只锁定单个分片
+ * Media source registry, sharded by hash of (vhost, app, stream), each shard is copy-on-write.
+ * Lookups and traversals only atomically load a shard snapshot and never block;
+ * register/unregister only lock a single shard.
+ */
+class MediaSourceRegistry {
+public:
+    struct Key {
+        string schema;
+        string vhost;
+        string app;
+        string stream;
+
+        bool operator==(const Key &that) const {
+            return stream == that.stream && app == that.app && vhost == that.vhost && schema == that.schema;
+        }
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            return hashTuple(key.vhost, key.app, key.stream) ^ (hash<string>()(key.schema) << 1);
+        }
+    };
+
+    using Map = unordered_map<Key, weak_ptr<MediaSource>, KeyHash>;
+    using MapPtr = shared_ptr<const Map>;
+
+    static MediaSourceRegistry &Instance() {
+        static MediaSourceRegistry s_instance;
+        return s_instance;
+    }
+
+    /**
+     * 注册媒体源，如果同名媒体源已经存在则返回之(注册失败)
+     * Register the media source, if a media source with the same name already exists, return it (registration failed)
+     */
+    MediaSource::Ptr add(const Key &key, const MediaSource::Ptr &src) {
+        auto &shard = getShard(key);
+        lock_guard<mutex> lck(shard.mtx);
+        // 写者已被互斥，直接读取当前快照即可
+        // Writers are serialized, read the current snapshot directly
+        auto &old_map = *shard.map;
+        auto it = old_map.find(key);
+        if (it != old_map.end()) {
+            if (auto exist = it->second.lock()) {
+                return exist;
+            }
+        }
+        auto new_map = std::make_shared<Map>(old_map);
+        (*new_map)[key] = src;
+        atomic_store(&shard.map, MapPtr(std::move(new_map)));
+        return nullptr;
+    }
+
+    /**
+     * 移除媒体源，仅当注册项已经销毁或者就是thiz时才移除
+     * Remove the media source, only if the registered item has been destroyed or is thiz
+     */
+    bool remove(const Key &key, const MediaSource *thiz) {
+        auto &shard = getShard(key);
+        lock_guard<mutex> lck(shard.mtx);
+        auto &old_map = *shard.map;
+        auto it = old_map.find(key);
+        if (it == old_map.end()) {
+            return false;
+        }
+        auto src = it->second.lock();
+        if (src && src.get() != thiz) {
+            return false;
+        }
+        auto new_map = std::make_shared<Map>(old_map);
+        new_map->erase(key);
+        atomic_store(&shard.map, MapPtr(std::move(new_map)));
+        return true;
+    }
+
+    /**
+     * 遍历快照，空字符串代表通配
+     * Traverse the snapshots, empty string means wildcard
+     */
+    template <typename LIST>
+    void find(LIST &list, const string &schema, const string &vhost, const string &app, const string &stream) const {
+        if (!vhost.empty() && !app.empty() && !stream.empty()) {
+            // 指定了完整的媒体元组，只需要查找一个分片
+            // The complete media tuple is specified, only one shard needs to be searched
+            auto map = atomic_load(&_shards[hashTuple(vhost, app, stream) % kShardCount].map);
+            if (!schema.empty()) {
+                auto it = map->find(Key { schema, vhost, app, stream });
+                if (it != map->end()) {
+                    emplace_back(list, it->second);
+                }
+                return;
+            }
+            find_l(*map, list, schema, vhost, app, stream);
+            return;
+        }
+        for (auto &shard : _shards) {
+            find_l(*atomic_load(&shard.map), list, schema, vhost, app, stream);
+        }
+    }
+
+private:
+    static constexpr size_t kShardCount = 256;
+
+    struct Shard {
+        mutex mtx;
+        MapPtr map = std::make_shared<Map>();
+    };
+
+    MediaSourceRegistry() = default;
+
+    static size_t hashTuple(const string &vhost, const string &app, const string &stream) {
+        hash<string> hasher;
+        auto ret = hasher(stream);
+        ret ^= hasher(app) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+        ret ^= hasher(vhost) + 0x9e3779b9 + (ret << 6) + (ret >> 2);
+        return ret;
+    }
+
+    Shard &getShard(const Key &key) { return _shards[hashTuple(key.vhost, key.app, key.stream) % kShardCount]; }
+
+    template <typename LIST>
+    static void emplace_back(LIST &list, const weak_ptr<MediaSource> &weak_src) {
+        if (auto src = weak_src.lock()) {
+            list.emplace_back(std::move(src));
+        }
+    }
+
+    template <typename LIST>
+    static void find_l(const Map &map, LIST &list, const string &schema, const string &vhost, const string &app, const string &stream) {
+        for (auto &pr : map) {
+            auto &key = pr.first;
+            if ((!schema.empty() && key.schema != schema) || (!vhost.empty() && key.vhost != vhost) || (!app.empty() && key.app != app)
+                || (!stream.empty() && key.stream != stream)) {
+                continue;
+            }
+            emplace_back(list, pr.second);
+        }
+    }
+
+private:
+    Shard _shards[kShardCount];
+};
+
+constexpr size_t MediaSourceRegistry::kShardCount;
 
 string getOriginTypeString(MediaOriginType type){
 #define SWITCH_CASE(type) case MediaOriginType::type : return #type
@@ -246,6 +387,11 @@ std::shared_ptr<RtpProcess> MediaSource::getRtpProcess() const {
     return listener ? listener->getRtpProcess(const_cast<MediaSource&>(*this)) : nullptr;
 }
 
+std::vector<std::string> MediaSource::getSimulcastStreams() const {
+    auto listener = _listener.lock();
+    return listener ? listener->getSimulcastStreams(const_cast<MediaSource &>(*this)) : std::vector<std::string>();
+}
+
 void MediaSource::onReaderChanged(int size) {
     try {
         weak_ptr<MediaSource> weak_self = shared_from_this();
@@ -305,52 +451,13 @@ bool MediaSource::stopSendRtp(const string &ssrc) {
     return listener->getMuxer(const_cast<MediaSource &>(*this))->stopSendRtp(ssrc);
 }
 
-template<typename MAP, typename LIST, typename First, typename ...KeyTypes>
-static void for_each_media_l(const MAP &map, LIST &list, const First &first, const KeyTypes &...keys) {
-    if (first.empty()) {
-        for (auto &pr : map) {
-            for_each_media_l(pr.second, list, keys...);
-        }
-        return;
-    }
-    auto it = map.find(first);
-    if (it != map.end()) {
-        for_each_media_l(it->second, list, keys...);
-    }
-}
-
-template<typename LIST, typename Ptr>
-static void emplace_back(LIST &list, const Ptr &ptr) {
-    auto src = ptr.lock();
-    if (src) {
-        list.emplace_back(std::move(src));
-    }
-}
-
-template<typename MAP, typename LIST, typename First>
-static void for_each_media_l(const MAP &map, LIST &list, const First &first) {
-    if (first.empty()) {
-        for (auto &pr : map) {
-            emplace_back(list, pr.second);
-        }
-        return;
-    }
-    auto it = map.find(first);
-    if (it != map.end()) {
-        emplace_back(list, it->second);
-    }
-}
-
 void MediaSource::for_each_media(const function<void(const Ptr &src)> &cb,
                                  const string &schema,
                                  const string &vhost,
                                  const string &app,
                                  const string &stream) {
     deque<Ptr> src_list;
-    {
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        for_each_media_l(s_media_source_map, src_list, schema, vhost, app, stream);
-    }
+    MediaSourceRegistry::Instance().find(src_list, schema, vhost, app, stream);
     for (auto &src : src_list) {
         cb(src);
     }
@@ -506,60 +613,22 @@ void MediaSource::emitEvent(bool regist){
 }
 
 void MediaSource::regist() {
-    {
-        // 减小互斥锁临界区  [AUTO-TRANSLATED:1309d309]
-        // Reduce mutex lock critical area
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        auto &ref = s_media_source_map[_schema][_tuple.vhost][_tuple.app][_tuple.stream];
-        auto src = ref.lock();
-        if (src) {
-            if (src.get() == this) {
-                return;
-            }
-            // 增加判断, 防止当前流已注册时再次注册  [AUTO-TRANSLATED:ccc5dcb1]
-            // Add judgment to prevent re-registration when the current stream is already registered
-            throw std::invalid_argument("media source already existed:" + getUrl());
+    auto src = MediaSourceRegistry::Instance().add({ _schema, _tuple.vhost, _tuple.app, _tuple.stream }, shared_from_this());
+    if (src) {
+        if (src.get() == this) {
+            return;
         }
-        ref = shared_from_this();
+        // 增加判断, 防止当前流已注册时再次注册  [AUTO-TRANSLATED:ccc5dcb1]
+        // Add judgment to prevent re-registration when the current stream is already registered
+        throw std::invalid_argument("media source already existed:" + getUrl());
     }
     emitEvent(true);
 }
 
-template<typename MAP, typename First, typename ...KeyTypes>
-static bool erase_media_source(bool &hit, const MediaSource *thiz, MAP &map, const First &first, const KeyTypes &...keys) {
-    auto it = map.find(first);
-    if (it != map.end() && erase_media_source(hit, thiz, it->second, keys...)) {
-        map.erase(it);
-    }
-    return map.empty();
-}
-
-template<typename MAP, typename First>
-static bool erase_media_source(bool &hit, const MediaSource *thiz, MAP &map, const First &first) {
-    auto it = map.find(first);
-    if (it != map.end()) {
-        auto src = it->second.lock();
-        if (!src || src.get() == thiz) {
-            // 对象已经销毁或者对象就是自己，那么移除之  [AUTO-TRANSLATED:1b9a11d1]
-            // If the object has been destroyed or the object is itself, then remove it
-            map.erase(it);
-            hit = true;
-        }
-    }
-    return map.empty();
-}
-
 // 反注册该源  [AUTO-TRANSLATED:682c27ab]
 // Unregister the source
 bool MediaSource::unregist() {
-    bool ret = false;
-    {
-        // 减小互斥锁临界区  [AUTO-TRANSLATED:1309d309]
-        // Reduce mutex lock critical area
-        lock_guard<recursive_mutex> lock(s_media_source_mtx);
-        erase_media_source(ret, this, s_media_source_map, _schema, _tuple.vhost, _tuple.app, _tuple.stream);
-    }
-
+    auto ret = MediaSourceRegistry::Instance().remove({ _schema, _tuple.vhost, _tuple.app, _tuple.stream }, this);
     if (ret) {
         emitEvent(false);
     }
@@ -830,6 +899,14 @@ std::shared_ptr<RtpProcess> MediaSourceEventInterceptor::getRtpProcess(MediaSour
     return listener->getRtpProcess(sender);
 }
 
+std::vector<std::string> MediaSourceEventInterceptor::getSimulcastStreams(MediaSource &sender) const {
+    auto listener = _listener.lock();
+    if (!listener) {
+        return MediaSourceEvent::getSimulcastStreams(sender);
+    }
+    return listener->getSimulcastStreams(sender);
+}
+
 void MediaSourceEventInterceptor::setDelegate(const std::weak_ptr<MediaSourceEvent> &listener) {
     if (listener.lock().get() == this) {
         throw std::invalid_argument("can not set self as a delegate");
@@ -875,20 +952,28 @@ static bool isFlushAble_merge(bool is_video, uint64_t last_stamp, uint64_t new_s
     return cache_size >= 1024;
 }
 
+int FlushPolicy::getMergeMS() const {
+    GET_CONFIG(int, mergeWriteMS, General::kMergeWriteMS);
+    return mergeWriteMS;
+}
+
 bool FlushPolicy::isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size) {
+    return isFlushAble_l(is_video, is_key, new_stamp, cache_size, getMergeMS());
+}
+
+bool FlushPolicy::isFlushAble_l(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size, int merge_ms) {
     bool flush_flag = false;
     if (is_key && is_video) {
         // 遇到关键帧flush掉前面的数据，确保关键帧为该组数据的第一帧，确保GOP缓存有效  [AUTO-TRANSLATED:e2ebbf9b]
         // Encounter a key frame, flush the previous data, ensure that the key frame is the first frame of this group of data, and ensure the GOP cache is valid.
         flush_flag = true;
     } else {
-        GET_CONFIG(int, mergeWriteMS, General::kMergeWriteMS);
-        if (mergeWriteMS <= 0) {
+        if (merge_ms <= 0) {
             // 关闭了合并写或者合并写阈值小于等于0  [AUTO-TRANSLATED:2397b647]
             // Merge writing is closed or the merge writing threshold is less than or equal to 0.
             flush_flag = isFlushAble_default(is_video, _last_stamp[is_video], new_stamp, cache_size);
         } else {
-            flush_flag = isFlushAble_merge(is_video, _last_stamp[is_video], new_stamp, cache_size, mergeWriteMS);
+            flush_flag = isFlushAble_merge(is_video, _last_stamp[is_video], new_stamp, cache_size, merge_ms);
         }
     }
 
@@ -898,4 +983,45 @@ bool FlushPolicy::isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, si
     return flush_flag;
 }
 
+/////////////////////////////////////AdaptiveFlushPolicy//////////////////////////////////////
+
+// 播放器发送缓存满后，维持最大合并写时长的时间(毫秒)
+// The duration (milliseconds) to keep the max merge write duration after the send buffer of a player is full
+static constexpr uint64_t kPressureHoldMS = 5 * 1000;
+
+int AdaptiveFlushPolicy::getMergeMS() const {
+    GET_CONFIG(bool, adaptive, General::kMergeWriteAdaptive);
+    if (!adaptive) {
+        return FlushPolicy::getMergeMS();
+    }
+    GET_CONFIG(int, maxMS, General::kMergeWriteMaxMS);
+    GET_CONFIG(int, maxReaders, General::kMergeWriteAdaptiveReaders);
+    auto pressure_stamp = _pressure_stamp.load(std::memory_order_relaxed);
+    if (pressure_stamp && getCurrentMillisecond() < pressure_stamp + kPressureHoldMS) {
+        // 最近有播放器发送缓存满，尽量减少写次数
+        // A player's send buffer was full recently, reduce the number of writes as much as possible
+        return maxMS;
+    }
+    auto readers = _reader_count.load(std::memory_order_relaxed);
+    if (readers <= 1 || maxMS <= 0) {
+        // 单个播放器时追求最低延时
+        // Pursue the lowest latency for a single player
+        return 0;
+    }
+    if (readers >= maxReaders) {
+        return maxMS;
+    }
+    // 在[0, maxMS]之间随播放器个数线性增长
+    // Grow linearly with the number of players between [0, maxMS]
+    return maxMS * (readers - 1) / MAX(maxReaders - 1, 1);
+}
+
+bool AdaptiveFlushPolicy::isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size) {
+    return isFlushAble_l(is_video, is_key, new_stamp, cache_size, getMergeMS());
+}
+
+void AdaptiveFlushPolicy::onSendPressure() {
+    _pressure_stamp.store(getCurrentMillisecond(), std::memory_order_relaxed);
+}
+
 } /* namespace mediakit */
\ No newline at end of file
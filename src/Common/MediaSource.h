@@ -14,6 +14,7 @@
 #include <string>
 #include <atomic>
 #include <memory>
+#include <vector>
 #include <functional>
 #include "Util/mini.h"
 #include "Network/Socket.h"
@@ -100,6 +101,9 @@ public:
     // 获取RtpProcess对象  [AUTO-TRANSLATED:c6b7da43]
     // Get RtpProcess object
     virtual std::shared_ptr<RtpProcess> getRtpProcess(MediaSource &sender) const { return nullptr; }
+    // 获取同一推流者产生的simulcast各层流id，不支持simulcast时返回空
+    // Get the stream ids of the simulcast layers produced by the same publisher, return empty if simulcast is not supported
+    virtual std::vector<std::string> getSimulcastStreams(MediaSource &sender) const { return {}; }
 
     class SendRtpArgs {
     public:
@@ -227,6 +231,14 @@ public:
     // This configuration can solve some problems where the stream is not sent smoothly, resulting in zlmediakit forwarding not being smooth
     uint32_t paced_sender_ms;
 
+    // 按需转协议共享gop缓存的最大大小，单位KB，置0则关闭
+    // Max size of the shared gop cache for on-demand protocols in KB, set to 0 to disable
+    size_t gop_cache_max_kb;
+
+    // 各协议复用器分散到的线程数，置0则在流归属线程同步复用
+    // Number of threads the protocol muxers are spread over, set to 0 to mux synchronously in the owner thread of the stream
+    uint32_t muxer_threads;
+
     // 是否开启转换为hls(mpegts)  [AUTO-TRANSLATED:bfc1167a]
     // Whether to enable conversion to hls(mpegts)
     bool enable_hls;
@@ -294,6 +306,8 @@ public:
         XX(auto_close)          \
         XX(continue_push_ms)    \
         XX(paced_sender_ms)     \
+        XX(gop_cache_max_kb)    \
+        XX(muxer_threads)       \
                                 \
         XX(enable_hls)          \
         XX(enable_hls_fmp4)     \
@@ -361,11 +375,64 @@ public:
     toolkit::EventPoller::Ptr getOwnerPoller(MediaSource &sender) override;
     std::shared_ptr<MultiMediaSourceMuxer> getMuxer(MediaSource &sender) const override;
     std::shared_ptr<RtpProcess> getRtpProcess(MediaSource &sender) const override;
+    std::vector<std::string> getSimulcastStreams(MediaSource &sender) const override;
 
 private:
     std::weak_ptr<MediaSourceEvent> _listener;
 };
 
+/**
+ * 按需转协议复用器(rtsp/rtmp/ts/fmp4)的开关状态
+ * 无人观看时停止复用并清空缓存，重新有人观看时标记需要从共享gop缓存补发数据
+ * On/off state of the on-demand protocol muxers (rtsp/rtmp/ts/fmp4)
+ * Stop muxing and clear the cache when no one is watching, mark that data needs to be replayed from the shared gop cache when someone watches again
+ */
+class DemandMuxerState {
+public:
+    DemandMuxerState(bool demand) : _demand(demand) {}
+
+    /**
+     * 复用器是否需要输入数据
+     * 缓存尚未清空时，还允许触发inputFrame函数，以便及时清空缓存
+     * Whether the muxer needs input data
+     * The inputFrame function is still allowed to be triggered when the cache has not been cleared, so that the cache can be cleared in time
+     */
+    bool isEnabled() const { return _demand ? (_clear_cache ? true : _enabled) : true; }
+
+    /**
+     * 是否需要从共享gop缓存补发数据，调用后复位
+     * Whether data needs to be replayed from the shared gop cache, reset after calling
+     */
+    bool needReplayGop() { return _replay_gop.exchange(false); }
+
+protected:
+    void onDemandReaderChanged(int size) {
+        if (_demand && size && !_enabled) {
+            // 按需转协议重新开启，需要从共享gop缓存补发数据
+            // The on-demand protocol is enabled again, data needs to be replayed from the shared gop cache
+            _replay_gop = true;
+        }
+        _enabled = _demand ? size : true;
+        if (!size && _demand) {
+            _clear_cache = true;
+        }
+    }
+
+    // 输入帧前调用，返回是否需要清空缓存
+    // Called before inputting a frame, return whether the cache needs to be cleared
+    bool needClearCache() { return _demand && _clear_cache.exchange(false); }
+
+    bool needMux() const { return _enabled || !_demand; }
+
+private:
+    bool _demand;
+    // 观看人数变化与输入帧可能在不同线程
+    // The reader count change and the frame input may be in different threads
+    std::atomic<bool> _enabled { true };
+    std::atomic<bool> _clear_cache { false };
+    std::atomic<bool> _replay_gop { false };
+};
+
 /**
  * 解析url获取媒体相关信息
  * Parse the url to get media information
@@ -471,6 +538,10 @@ public:
 
     virtual bool broadcastMessage(const toolkit::Any &data) { return false; }
 
+    // 获取当前生效的合并写时长(毫秒)，返回-1代表不支持合并写
+    // Get the effective merge write duration (milliseconds), return -1 means merge write is not supported
+    virtual int getMergeWriteMS() const { return -1; }
+
     // 获取媒体源类型  [AUTO-TRANSLATED:34290a69]
     // Get the media source type
     MediaOriginType getOriginType() const;
@@ -520,6 +591,9 @@ public:
     // 获取RtpProcess对象  [AUTO-TRANSLATED:c6b7da43]
     // Get the RtpProcess object
     std::shared_ptr<RtpProcess> getRtpProcess() const;
+    // 获取同一推流者产生的simulcast各层流id
+    // Get the stream ids of the simulcast layers produced by the same publisher
+    std::vector<std::string> getSimulcastStreams() const;
 
     // //////////////static方法，查找或生成MediaSource////////////////  [AUTO-TRANSLATED:c3950036]
     // //////////////static methods, find or generate MediaSource////////////////
@@ -9,6 +9,11 @@
 */
 
 #include <math.h>
+#include <time.h>
+#include <deque>
+#include <atomic>
+#include <algorithm>
+#include <mutex>
 #include "Common/config.h"
 #include "MultiMediaSourceMuxer.h"
 #include "Thread/WorkThreadPool.h"
@@ -33,6 +38,83 @@ public:
 };
 } // namespace
 
+// 每个track最多记录的待输出帧输入时间个数
+// The max number of input times of frames to be output recorded for each track
+static constexpr size_t kMaxIngestStamps = 64;
+
+class FramePacedSender;
+
+/**
+ * 平滑发送时间轮，每个poller线程一个，被该线程所有平滑发送的流共用
+ * 每个流只在有待发送数据时登记一次唤醒，插入与触发均为O(1)，只在本线程访问所以无锁
+ * Paced sender timing wheel, one per poller thread, shared by all paced streams of that thread
+ * Each stream registers only one wakeup when it has pending data, insertion and firing are O(1), only accessed in this thread so no lock
+ */
+class PacedSenderWheel {
+public:
+    // 时间轮精度(毫秒)与槽位个数，超过一圈的定时通过圈数实现
+    // Wheel precision (milliseconds) and slot count, timers longer than one round are implemented by round count
+    static constexpr uint64_t kTickMS = 5;
+    static constexpr size_t kSlots = 512;
+
+    static PacedSenderWheel &Instance() {
+        static thread_local PacedSenderWheel s_instance;
+        return s_instance;
+    }
+
+    void add(const std::shared_ptr<FramePacedSender> &sender, uint64_t delay_ms) {
+        if (!_running) {
+            // 空闲期间未推进，直接跳到当前时刻
+            // Not advanced during idle, jump to the current time directly
+            _current_tick = _ticker.elapsedTime() / kTickMS;
+        }
+        auto ticks = MAX((delay_ms + kTickMS - 1) / kTickMS, (uint64_t)1);
+        _slots[(_current_tick + ticks) % kSlots].emplace_back(Entry { sender, (ticks - 1) / kSlots });
+        ++_size;
+        start();
+    }
+
+private:
+    struct Entry {
+        std::weak_ptr<FramePacedSender> sender;
+        uint64_t rounds;
+    };
+
+    PacedSenderWheel() = default;
+
+    void start() {
+        if (_running) {
+            return;
+        }
+        _running = true;
+        EventPoller::getCurrentPoller()->doDelayTask(kTickMS, [this]() -> uint64_t {
+            advance();
+            if (!_size) {
+                _running = false;
+                return 0;
+            }
+            return kTickMS;
+        });
+    }
+
+    void advance() {
+        auto target = _ticker.elapsedTime() / kTickMS;
+        while (_current_tick < target) {
+            fire(++_current_tick % kSlots);
+        }
+    }
+
+    void fire(size_t index);
+
+private:
+    bool _running = false;
+    size_t _size = 0;
+    uint64_t _current_tick = 0;
+    Ticker _ticker;
+    std::vector<Entry> _firing;
+    std::vector<Entry> _slots[kSlots];
+};
+
 class FramePacedSender : public FrameWriterInterface, public std::enable_shared_from_this<FramePacedSender> {
 public:
     using OnFrame = std::function<void(const Frame::Ptr &frame)>;
@@ -45,50 +127,79 @@ public:
         _cb = std::move(cb);
     }
 
-    void resetTimer(const EventPoller::Ptr &poller) {
-        std::lock_guard<std::recursive_mutex> lck(_mtx);
+    /**
+     * 切换平滑发送线程，在原线程中完成切换以保证数据只被一个线程访问
+     * Switch the paced sending thread, the switch is done in the original thread to ensure that data is only accessed by one thread
+     */
+    void setPoller(const EventPoller::Ptr &poller) {
+        auto old_poller = std::atomic_load(&_poller);
+        if (!old_poller) {
+            std::atomic_store(&_poller, poller);
+            return;
+        }
         std::weak_ptr<FramePacedSender> weak_self = shared_from_this();
-        _timer = std::make_shared<Timer>(_paced_sender_ms / 1000.0f, [weak_self]() {
-            if (auto strong_self = weak_self.lock()) {
-                strong_self->onTick();
-                return true;
+        old_poller->async([weak_self, poller]() {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return;
             }
-            return false;
-        }, poller);
+            std::atomic_store(&strong_self->_poller, poller);
+            poller->async([weak_self]() {
+                if (auto strong_self = weak_self.lock()) {
+                    // 原线程时间轮中的唤醒已失效，在新线程重新登记
+                    // The wakeup in the wheel of the original thread is invalid, register again in the new thread
+                    strong_self->_scheduled = false;
+                    strong_self->schedule();
+                }
+            });
+        });
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        std::lock_guard<std::recursive_mutex> lck(_mtx);
-        if (!_timer) {
-            setCurrentStamp(frame->dts());
-            resetTimer(EventPoller::getCurrentPoller());
+        auto poller = std::atomic_load(&_poller);
+        if (!poller) {
+            poller = EventPoller::getCurrentPoller();
+            setPoller(poller ? poller : EventPollerPool::Instance().getPoller());
+            poller = std::atomic_load(&_poller);
         }
-        auto &last_dts = _last_dts[frame->getTrackType()];
-        if (last_dts > frame->dts()) {
-            // 时间戳回退了，点播流？
-            WarnL << "Dts decrease: " << last_dts << "->" << frame->dts() << ", flush all paced sender cache: " << _cache.size();
-            flushCache(frame->dts());
+        if (!poller->isCurrentThread()) {
+            // 输入线程与平滑发送线程不一致，切换线程
+            // The input thread is different from the paced sending thread, switch thread
+            std::weak_ptr<FramePacedSender> weak_self = shared_from_this();
+            auto cacheable = Frame::getCacheAbleFrame(frame);
+            poller->async([weak_self, cacheable]() {
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->inputFrame(cacheable);
+                }
+            }, false);
+            return true;
         }
-        _cache.emplace(frame->dts(), Frame::getCacheAbleFrame(frame));
-        last_dts = frame->dts();
+        inputFrame_l(frame);
         return true;
     }
 
-private:
     void onTick() {
-        std::lock_guard<std::recursive_mutex> lck(_mtx);
-        auto max_dts = _cache.empty() ? 0 : _cache.rbegin()->first;
+        if (!std::atomic_load(&_poller)->isCurrentThread()) {
+            // 已经切换线程，忽略原线程的唤醒
+            // The thread has been switched, ignore the wakeup of the original thread
+            return;
+        }
+        _scheduled = false;
+        auto now = getCurrentStamp();
+        auto max_dts = _cache.empty() ? 0 : _cache.back()->dts();
         while (!_cache.empty()) {
-            auto front = _cache.begin();
-            if (getCurrentStamp() < front->first + _cache_ms) {
+            auto &front = _cache.front();
+            auto due = front->dts() + _cache_ms;
+            if (now < due) {
                 // 还没到消费时间  [AUTO-TRANSLATED:09fb4c3d]
                 // Not yet time to consume
                 break;
             }
             // 时间到了，该消费frame了  [AUTO-TRANSLATED:2f007931]
             // Time is up, it's time to consume the frame
-            _cb(front->second);
-            _cache.erase(front);
+            _jitter_ms += ((float)(now - due) - _jitter_ms) / 16;
+            _cb(front);
+            _cache.pop_front();
         }
 
         if (_cache.empty() && max_dts) {
@@ -104,13 +215,71 @@ private:
             WarnL << "Flush frame paced sender cache: " << _cache.size();
             flushCache(max_dts);
         }
+        schedule();
+        publishInfo();
+    }
+
+    /**
+     * 获取统计信息，可在任意线程调用
+     * Get statistics, can be called in any thread
+     */
+    void getInfo(PacedSenderInfo &info) const {
+        info.queue_size = _info_queue_size.load(std::memory_order_relaxed);
+        info.cache_ms = _info_cache_ms.load(std::memory_order_relaxed);
+        info.jitter_ms = _info_jitter_ms.load(std::memory_order_relaxed);
+        info.flush_count = _info_flush_count.load(std::memory_order_relaxed);
+    }
+
+private:
+    void inputFrame_l(const Frame::Ptr &frame) {
+        if (!_started) {
+            _started = true;
+            setCurrentStamp(frame->dts());
+        }
+        auto &last_dts = _last_dts[frame->getTrackType()];
+        if (last_dts > frame->dts()) {
+            // 时间戳回退了，点播流？
+            WarnL << "Dts decrease: " << last_dts << "->" << frame->dts() << ", flush all paced sender cache: " << _cache.size();
+            flushCache(frame->dts());
+        }
+        last_dts = frame->dts();
+        // 音视频帧基本按dts递增输入，从尾部查找插入位置，相同dts保持输入顺序
+        // Audio and video frames are input basically in increasing dts order, find the insert position from the tail, keep the input order for the same dts
+        auto it = _cache.end();
+        while (it != _cache.begin() && (*std::prev(it))->dts() > frame->dts()) {
+            --it;
+        }
+        _cache.emplace(it, Frame::getCacheAbleFrame(frame));
+        schedule();
+        publishInfo();
+    }
+
+    // 平滑发送线程可能与归属线程不同，统计信息通过原子变量发布
+    // The paced sending thread may differ from the owner thread, so statistics are published through atomic variables
+    void publishInfo() {
+        _info_queue_size.store(_cache.size(), std::memory_order_relaxed);
+        _info_cache_ms.store(_cache_ms, std::memory_order_relaxed);
+        _info_jitter_ms.store(_jitter_ms, std::memory_order_relaxed);
+        _info_flush_count.store(_flush_count, std::memory_order_relaxed);
+    }
+
+    void schedule() {
+        if (_scheduled || _cache.empty()) {
+            return;
+        }
+        _scheduled = true;
+        auto now = getCurrentStamp();
+        auto due = _cache.front()->dts() + _cache_ms;
+        // 两次消费间隔不小于paced_sender_ms
+        // The interval between two consumptions is not less than paced_sender_ms
+        PacedSenderWheel::Instance().add(shared_from_this(), MAX(due > now ? due - now : 0, (uint64_t)_paced_sender_ms));
     }
 
     void flushCache(uint64_t dts) {
+        ++_flush_count;
         while (!_cache.empty()) {
-            auto front = _cache.begin();
-            _cb(front->second);
-            _cache.erase(front);
+            _cb(_cache.front());
+            _cache.pop_front();
         }
         setCurrentStamp(dts);
         _cache_ms = kMinCacheMS;
@@ -124,15 +293,416 @@ private:
     }
 
 private:
+    bool _started = false;
+    bool _scheduled = false;
     uint32_t _paced_sender_ms;
     uint32_t _cache_ms = kMinCacheMS;
+    float _jitter_ms = 0;
+    uint64_t _flush_count = 0;
     uint64_t _stamp_offset = 0;
     uint64_t _last_dts[2] = {0, 0};
     OnFrame _cb;
     Ticker _ticker;
-    Timer::Ptr _timer;
-    std::recursive_mutex _mtx;
-    std::multimap<uint64_t, Frame::Ptr> _cache;
+    EventPoller::Ptr _poller;
+    std::deque<Frame::Ptr> _cache;
+    std::atomic<size_t> _info_queue_size { 0 };
+    std::atomic<uint32_t> _info_cache_ms { kMinCacheMS };
+    std::atomic<float> _info_jitter_ms { 0 };
+    std::atomic<uint64_t> _info_flush_count { 0 };
+};
+
+void PacedSenderWheel::fire(size_t index) {
+    _firing.swap(_slots[index]);
+    for (auto &entry : _firing) {
+        if (entry.rounds) {
+            --entry.rounds;
+            _slots[index].emplace_back(std::move(entry));
+            continue;
+        }
+        --_size;
+        if (auto sender = entry.sender.lock()) {
+            sender->onTick();
+        }
+    }
+    _firing.clear();
+}
+
+/**
+ * 协议无关的帧级gop缓存，只缓存最近一个gop，各按需转协议共用
+ * 超过大小限制的gop不缓存，直到下一个关键帧
+ * Protocol independent frame level gop cache, only the latest gop is cached and shared by all on-demand protocols
+ * A gop that exceeds the size limit is not cached until the next key frame
+ */
+class FrameGopCache {
+public:
+    FrameGopCache(size_t max_bytes) : _max_bytes(max_bytes) {}
+
+    void inputFrame(const Frame::Ptr &frame, bool have_video) {
+        if (!have_video) {
+            // 纯音频流无需gop缓存
+            // No gop cache is needed for audio only stream
+            return;
+        }
+        if (frame->getTrackType() == TrackVideo) {
+            // 遇到第一帧配置帧或关键帧则为gop开始处
+            // The first config frame or key frame is the beginning of the gop
+            auto video_key_pos = frame->keyFrame() || frame->configFrame();
+            if (video_key_pos && !_video_key_pos) {
+                if (!_wait_key) {
+                    // 上一个gop完整缓存，超限后恢复正常，再次超限时重新告警
+                    // The previous gop was fully cached, warn again if the limit is exceeded later
+                    _overflow_warned = false;
+                }
+                clear();
+                _wait_key = false;
+            }
+            if (!frame->dropAble()) {
+                _video_key_pos = video_key_pos;
+            }
+        }
+        if (_wait_key) {
+            return;
+        }
+        if (_bytes + frame->size() > _max_bytes) {
+            if (!_overflow_warned) {
+                _overflow_warned = true;
+                WarnL << "gop size exceeds gop_cache_max_kb(" << _max_bytes / 1024 << "), gop will not be cached until next key frame";
+            }
+            clear();
+            _wait_key = true;
+            return;
+        }
+        _bytes += frame->size();
+        _frames.emplace_back(Frame::getCacheAbleFrame(frame));
+    }
+
+    void forEach(const std::function<void(const Frame::Ptr &frame)> &cb) const {
+        for (auto &frame : _frames) {
+            cb(frame);
+        }
+    }
+
+    /**
+     * 不需要缓存时释放数据，再次需要时从下一个关键帧开始缓存，避免补发不完整的gop
+     * Release the data when caching is not needed, and cache from the next key frame when needed again, to avoid replaying an incomplete gop
+     */
+    void reset() {
+        clear();
+        _wait_key = true;
+        _video_key_pos = false;
+    }
+
+private:
+    void clear() {
+        _frames.clear();
+        _bytes = 0;
+    }
+
+private:
+    bool _wait_key = true;
+    bool _video_key_pos = false;
+    bool _overflow_warned = false;
+    size_t _bytes = 0;
+    size_t _max_bytes;
+    std::list<Frame::Ptr> _frames;
+};
+
+// 获取当前线程的cpu耗时(微秒)
+// Get the cpu time of the current thread (microseconds)
+static uint64_t getThreadCpuUS() {
+#if defined(_WIN32)
+    FILETIME create_time, exit_time, kernel_time, user_time;
+    if (!GetThreadTimes(GetCurrentThread(), &create_time, &exit_time, &kernel_time, &user_time)) {
+        return 0;
+    }
+    auto kernel = ((uint64_t)kernel_time.dwHighDateTime << 32) | kernel_time.dwLowDateTime;
+    auto user = ((uint64_t)user_time.dwHighDateTime << 32) | user_time.dwLowDateTime;
+    // 单位为100纳秒
+    // The unit is 100 nanoseconds
+    return (kernel + user) / 10;
+#else
+    struct timespec ts;
+    if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts)) {
+        return 0;
+    }
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
+
+/**
+ * 协议复用器线程代理，复用器固定在某个poller线程执行帧复用，帧与控制任务经单生产者单消费者无锁队列按序投递
+ * 队列满时丢帧直到下一个关键帧；录制类复用器(mp4/hls)不轻易丢帧，队列满时帧进入加锁的溢出队列，溢出队列也满时同样丢帧直到下一个关键帧
+ * 控制任务(添加track、注册MediaSource等)不丢弃，复用器线程执行到控制任务时暂停消费，切回归属线程执行完毕后再继续
+ * Protocol muxer thread proxy, the frames are muxed in a pinned poller thread, frames and control tasks are delivered in order through a single producer single consumer lock-free queue
+ * When the queue is full, frames are dropped until the next key frame; recording muxers (mp4/hls) do not drop frames easily, frames go to a locked overflow queue
+ * when the queue is full, and are also dropped until the next key frame when the overflow queue is full too
+ * Control tasks (adding tracks, registering MediaSource, etc.) are never dropped, the muxer thread suspends consuming when it reaches a control task,
+ * and continues after the task is executed in the owner thread
+ */
+class MuxerWorker : public std::enable_shared_from_this<MuxerWorker> {
+public:
+    using Ptr = std::shared_ptr<MuxerWorker>;
+    static constexpr size_t kQueueSize = 1024;
+    // 溢出队列最多缓存的帧数，控制任务不受限制
+    // The max number of frames cached in the overflow queue, control tasks are not limited
+    static constexpr size_t kMaxOverflowFrames = 4 * kQueueSize;
+
+    MuxerWorker(std::string name, MediaSinkInterface::Ptr muxer, EventPoller::Ptr poller, bool lossless)
+        : _lossless(lossless), _name(std::move(name)), _muxer(std::move(muxer)), _poller(std::move(poller)), _items(kQueueSize) {}
+
+    const MediaSinkInterface::Ptr &getMuxer() const { return _muxer; }
+
+    /**
+     * 投递帧，只能在生产者线程调用，帧必须可缓存
+     * Deliver a frame, can only be called in the producer thread, the frame must be cacheable
+     */
+    void inputFrame(const Frame::Ptr &frame, bool have_video) {
+        if (_wait_key) {
+            // 视频从关键帧恢复，纯音频流直接恢复
+            // Video resumes from the key frame, audio only stream resumes directly
+            auto resume = frame->getTrackType() == TrackVideo ? frame->keyFrame() || frame->configFrame() : !have_video;
+            if (!resume) {
+                ++_dropped;
+                return;
+            }
+            _wait_key = false;
+        }
+        if (writable()) {
+            push(frame, nullptr);
+            return;
+        }
+        if (_lossless && overflow(frame, nullptr)) {
+            return;
+        }
+        ++_dropped;
+        _wait_key = true;
+        if (!_overflow_warned) {
+            _overflow_warned = true;
+            WarnL << "muxer " << _name << " is too slow, frames will be dropped until next key frame";
+        }
+    }
+
+    /**
+     * 投递控制任务，复用器线程处理完之前投递的帧后，在owner线程执行该任务，执行完毕前不再复用之后的帧
+     * Deliver a control task, after the muxer thread has processed the previously delivered frames, the task is executed in the owner thread,
+     * and the subsequent frames are not muxed until it is finished
+     */
+    void async(const EventPoller::Ptr &owner, std::function<void()> task) {
+        std::weak_ptr<MuxerWorker> weak_self = shared_from_this();
+        auto name = _name;
+        auto barrier = [weak_self, owner, name, task]() {
+            owner->async([weak_self, name, task]() {
+                try {
+                    task();
+                } catch (std::exception &ex) {
+                    WarnL << "muxer " << name << " throw exception: " << ex.what();
+                }
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->resume();
+                }
+            }, false);
+        };
+        if (writable()) {
+            push(nullptr, std::move(barrier));
+            return;
+        }
+        overflow(nullptr, std::move(barrier));
+    }
+
+    void getInfo(MuxerWorkerInfo &info) const {
+        info.name = _name;
+        auto head = _head.load(std::memory_order_acquire);
+        info.queue_size = _tail.load(std::memory_order_acquire) - head;
+        info.frames = _frame_count.load(std::memory_order_relaxed);
+        info.dropped = _dropped.load(std::memory_order_relaxed);
+        info.cpu_us = _cpu_us.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Item {
+        Frame::Ptr frame;
+        std::function<void()> task;
+    };
+
+    // 溢出期间或无锁队列已满时不可写入
+    // Not writable during overflow or when the lock-free queue is full
+    bool writable() const {
+        return !_overflow.load(std::memory_order_acquire)
+            && _tail.load(std::memory_order_relaxed) - _head.load(std::memory_order_acquire) < kQueueSize;
+    }
+
+    bool overflow(const Frame::Ptr &frame, std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lck(_mtx);
+            if (frame && _overflow_frames >= kMaxOverflowFrames) {
+                return false;
+            }
+            _overflow_frames += frame ? 1 : 0;
+            _overflow_items.emplace_back(Item { frame, std::move(task) });
+            _overflow = true;
+        }
+        schedule();
+        return true;
+    }
+
+    void push(const Frame::Ptr &frame, std::function<void()> task) {
+        auto tail = _tail.load(std::memory_order_relaxed);
+        auto &item = _items[tail % kQueueSize];
+        item.frame = frame;
+        item.task = std::move(task);
+        _tail.store(tail + 1, std::memory_order_release);
+        schedule();
+    }
+
+    bool pop(Item &out) {
+        auto head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        auto &item = _items[head % kQueueSize];
+        out.frame = std::move(item.frame);
+        out.task = std::move(item.task);
+        item.frame = nullptr;
+        item.task = nullptr;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return _pending.empty() && _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire)
+            && !_overflow.load(std::memory_order_acquire);
+    }
+
+    void schedule() {
+        // 与消费者复位_scheduled后检查队列配对，避免漏掉唤醒
+        // Paired with the queue check after the consumer resets _scheduled to avoid missing wakeups
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (_scheduled.exchange(true)) {
+            return;
+        }
+        std::weak_ptr<MuxerWorker> weak_self = shared_from_this();
+        _poller->async([weak_self]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->drain();
+            }
+        }, false);
+    }
+
+    // 控制任务在owner线程执行完毕，切回复用器线程继续消费
+    // The control task is finished in the owner thread, switch back to the muxer thread to continue consuming
+    void resume() {
+        std::weak_ptr<MuxerWorker> weak_self = shared_from_this();
+        _poller->async([weak_self]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->_suspended = false;
+                strong_self->drain();
+            }
+        }, false);
+    }
+
+    void drain() {
+        auto start = getThreadCpuUS();
+        while (true) {
+            try {
+                consume();
+            } catch (std::exception &ex) {
+                // 异常不能中断队列消费，否则后续数据将无法投递
+                // The exception cannot interrupt the queue consumption, otherwise the subsequent data cannot be delivered
+                WarnL << "muxer " << _name << " throw exception: " << ex.what();
+                _frames.clear();
+            }
+            if (_suspended) {
+                // 保持_scheduled，暂停期间生产者无需唤醒本线程，由resume()继续消费
+                // Keep _scheduled, the producer does not need to wake up this thread while suspended, resume() continues consuming
+                break;
+            }
+            _scheduled = false;
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (empty() || _scheduled.exchange(true)) {
+                break;
+            }
+        }
+        _cpu_us += getThreadCpuUS() - start;
+    }
+
+    void consume() {
+        Item item;
+        while (!_suspended) {
+            if (!_pending.empty()) {
+                item = std::move(_pending.front());
+                _pending.pop_front();
+            } else if (!pop(item)) {
+                if (!_overflow.load(std::memory_order_acquire)) {
+                    break;
+                }
+                // 溢出期间生产者不再写入无锁队列，无锁队列取空后再处理溢出数据以保证顺序
+                // The producer does not write the lock-free queue during overflow, the overflow data is processed after the lock-free queue is empty to keep the order
+                std::lock_guard<std::mutex> lck(_mtx);
+                _pending.swap(_overflow_items);
+                _overflow_frames = 0;
+                if (_pending.empty()) {
+                    _overflow = false;
+                }
+                continue;
+            }
+            if (item.frame) {
+                _frames.emplace_back(std::move(item.frame));
+                continue;
+            }
+            flushFrames();
+            // 控制任务切换到owner线程执行，期间暂停消费
+            // The control task is switched to the owner thread for execution, and consuming is suspended meanwhile
+            _suspended = true;
+            item.task();
+            item.task = nullptr;
+        }
+        flushFrames();
+    }
+
+    void flushFrames() {
+        if (_frames.empty()) {
+            return;
+        }
+        // 一次取出的连续帧整批输入，以便复用器合并写
+        // The continuous frames taken out at once are input as a batch so that the muxer can merge write
+        if (_frames.size() == 1) {
+            _muxer->inputFrame(_frames[0]);
+        } else {
+            _muxer->inputFrames(_frames.data(), _frames.size());
+        }
+        _frame_count += _frames.size();
+        _frames.clear();
+    }
+
+private:
+    // 以下只在生产者线程访问
+    // The following are only accessed in the producer thread
+    bool _lossless;
+    bool _wait_key = false;
+    bool _overflow_warned = false;
+    // 生产者线程写入，其他线程读取统计
+    // Written in the producer thread, read by other threads for statistics
+    std::atomic<uint64_t> _dropped { 0 };
+
+    std::string _name;
+    MediaSinkInterface::Ptr _muxer;
+    EventPoller::Ptr _poller;
+    std::vector<Item> _items;
+    std::atomic<size_t> _head { 0 };
+    std::atomic<size_t> _tail { 0 };
+    std::atomic<bool> _scheduled { false };
+    std::atomic<bool> _overflow { false };
+    std::mutex _mtx;
+    size_t _overflow_frames = 0;
+    std::deque<Item> _overflow_items;
+
+    // 以下只在复用器线程访问
+    // The following are only accessed in the muxer thread
+    bool _suspended = false;
+    std::deque<Item> _pending;
+    std::vector<Frame::Ptr> _frames;
+    std::atomic<uint64_t> _frame_count { 0 };
+    std::atomic<uint64_t> _cpu_us { 0 };
 };
 
 std::shared_ptr<MediaSinkInterface> MultiMediaSourceMuxer::makeRecorder(Recorder::type type) {
@@ -215,6 +785,7 @@ MultiMediaSourceMuxer::MultiMediaSourceMuxer(const MediaTuple& tuple, float dur_
     _create_in_poller = _poller->isCurrentThread();
     _option = option;
     _dur_sec = dur_sec;
+    _latency = LatencyStats::get(_tuple);
     setMaxTrackCount(option.max_track);
 
     if (option.enable_rtmp) {
@@ -238,6 +809,20 @@ MultiMediaSourceMuxer::MultiMediaSourceMuxer(const MediaTuple& tuple, float dur_
     if (option.enable_fmp4) {
         _fmp4 = dynamic_pointer_cast<FMP4MediaSourceMuxer>(Recorder::createRecorder(Recorder::type_fmp4, _tuple, option));
     }
+    if (option.muxer_threads) {
+        // 尽量选取与归属线程不同且互不相同的poller
+        // Try to select pollers that are different from the owner thread and from each other
+        auto &pool = EventPollerPool::Instance();
+        for (size_t i = 0; i < pool.getExecutorSize() * 2 && _worker_pollers.size() < option.muxer_threads; ++i) {
+            auto poller = pool.getPoller(false);
+            if (poller != _poller && std::find(_worker_pollers.begin(), _worker_pollers.end(), poller) == _worker_pollers.end()) {
+                _worker_pollers.emplace_back(std::move(poller));
+            }
+        }
+        if (_worker_pollers.empty()) {
+            _worker_pollers.emplace_back(pool.getPoller(false));
+        }
+    }
 
     // 音频相关设置  [AUTO-TRANSLATED:6ee58d57]
     // Audio related settings
@@ -290,10 +875,12 @@ int MultiMediaSourceMuxer::totalReaderCount() const {
 
 void MultiMediaSourceMuxer::setTimeStamp(uint32_t stamp) {
     if (_rtmp) {
-        _rtmp->setTimeStamp(stamp);
+        auto rtmp = _rtmp;
+        invokeMuxer(_rtmp, [rtmp, stamp]() { rtmp->setTimeStamp(stamp); });
     }
     if (_rtsp) {
-        _rtsp->setTimeStamp(stamp);
+        auto rtsp = _rtsp;
+        invokeMuxer(_rtsp, [rtsp, stamp]() { rtsp->setTimeStamp(stamp); });
     }
 }
 
@@ -316,6 +903,11 @@ int MultiMediaSourceMuxer::totalReaderCount(MediaSource &sender) {
 bool MultiMediaSourceMuxer::setupRecord(MediaSource &sender, Recorder::type type, bool start, const string &custom_path, size_t max_second) {
     CHECK(getOwnerPoller(MediaSource::NullMediaSource())->isCurrentThread(), "Can only call setupRecord in it's owner poller");
     onceToken token(nullptr, [&]() {
+        if (isAllTrackReady()) {
+            // 新开启的录制在此之前已同步添加完track，之后交给复用器线程
+            // The newly started recording has added tracks synchronously before, and is handed over to the muxer thread afterwards
+            updateWorkers();
+        }
         if (_option.mp4_as_player && type == Recorder::type_mp4) {
             // 开启关闭mp4录制，触发观看人数变化相关事件  [AUTO-TRANSLATED:b63a8deb]
             // Turn on/off mp4 recording, trigger events related to changes in the number of viewers
@@ -647,7 +1239,7 @@ EventPoller::Ptr MultiMediaSourceMuxer::getOwnerPoller(MediaSource &sender) {
             WarnL << "OwnerPoller changed " << _poller->getThreadName() << " -> " << ret->getThreadName() << " : " << shortUrl();
             _poller = ret;
             if (_paced_sender) {
-                _paced_sender->resetTimer(_poller);
+                _paced_sender->setPoller(_poller);
             }
         }
         return ret;
@@ -667,6 +1259,7 @@ bool MultiMediaSourceMuxer::close(MediaSource &sender) {
     _mp4 = nullptr;
     _hls = nullptr;
     _hls_fmp4 = nullptr;
+    updateWorkers();
 #if defined(ENABLE_RTPPROXY)
     _rtp_sender.clear();
 #endif // ENABLE_RTPPROXY
@@ -685,27 +1278,36 @@ bool MultiMediaSourceMuxer::onTrackReady(const Track::Ptr &track) {
         stamp.setPlayBack();
     }
 
+    auto add_track = [&](const MediaSinkInterface::Ptr &muxer) {
+        if (getWorker(muxer)) {
+            // 等待复用器线程处理完之前的帧后异步执行，无法获取结果
+            // Executed asynchronously after the muxer thread has processed the previous frames, the result cannot be obtained
+            invokeMuxer(muxer, [muxer, track]() { muxer->addTrack(track); });
+            return true;
+        }
+        return muxer->addTrack(track);
+    };
     bool ret = false;
     if (_rtmp) {
-        ret = _rtmp->addTrack(track) ? true : ret;
+        ret = add_track(_rtmp) ? true : ret;
     }
     if (_rtsp) {
-        ret = _rtsp->addTrack(track) ? true : ret;
+        ret = add_track(_rtsp) ? true : ret;
     }
     if (_ts) {
-        ret = _ts->addTrack(track) ? true : ret;
+        ret = add_track(_ts) ? true : ret;
     }
     if (_fmp4) {
-        ret = _fmp4->addTrack(track) ? true : ret;
+        ret = add_track(_fmp4) ? true : ret;
     }
     if (_hls) {
-        ret = _hls->addTrack(track) ? true : ret;
+        ret = add_track(_hls) ? true : ret;
     }
     if (_hls_fmp4) {
-        ret = _hls_fmp4->addTrack(track) ? true : ret;
+        ret = add_track(_hls_fmp4) ? true : ret;
     }
     if (_mp4) {
-        ret = _mp4->addTrack(track) ? true : ret;
+        ret = add_track(_mp4) ? true : ret;
     }
     if (_delegate) {
         _delegate->addTrack(track);
@@ -716,6 +1318,10 @@ bool MultiMediaSourceMuxer::onTrackReady(const Track::Ptr &track) {
 void MultiMediaSourceMuxer::onAllTrackReady() {
     CHECK(!_create_in_poller || getOwnerPoller(MediaSource::NullMediaSource())->isCurrentThread());
 
+    if (_option.gop_cache_max_kb && (_option.rtsp_demand || _option.rtmp_demand || _option.ts_demand || _option.fmp4_demand)) {
+        _gop_cache = std::make_shared<FrameGopCache>(_option.gop_cache_max_kb * 1024);
+    }
+
     if (_option.paced_sender_ms) {
         std::weak_ptr<MultiMediaSourceMuxer> weak_self = shared_from_this();
         _paced_sender = std::make_shared<FramePacedSender>(_option.paced_sender_ms, [weak_self](const Frame::Ptr &frame) {
@@ -727,27 +1333,20 @@ void MultiMediaSourceMuxer::onAllTrackReady() {
 
     setMediaListener(getDelegate());
 
-    if (_rtmp) {
-        _rtmp->addTrackCompleted();
-    }
-    if (_rtsp) {
-        _rtsp->addTrackCompleted();
-    }
-    if (_ts) {
-        _ts->addTrackCompleted();
-    }
-    if (_mp4) {
-        _mp4->addTrackCompleted();
-    }
-    if (_fmp4) {
-        _fmp4->addTrackCompleted();
-    }
-    if (_hls) {
-        _hls->addTrackCompleted();
-    }
-    if (_hls_fmp4) {
-        _hls_fmp4->addTrackCompleted();
-    }
+    auto add_track_completed = [&](const MediaSinkInterface::Ptr &muxer) {
+        invokeMuxer(muxer, [muxer]() { muxer->addTrackCompleted(); });
+    };
+    add_track_completed(_rtmp);
+    add_track_completed(_rtsp);
+    add_track_completed(_ts);
+    add_track_completed(_mp4);
+    add_track_completed(_fmp4);
+    add_track_completed(_hls);
+    add_track_completed(_hls_fmp4);
+    // 首次就绪时复用器已同步完成初始化，此后帧在复用器线程复用，控制调用按序切回归属线程执行
+    // The muxers are initialized synchronously when ready for the first time, afterwards frames are muxed in the muxer threads,
+    // and control calls are switched back to the owner thread in order
+    updateWorkers();
 
     auto listener = _track_listener.lock();
     if (listener) {
@@ -795,27 +1394,16 @@ void MultiMediaSourceMuxer::createGopCacheIfNeed(size_t gop_count) {
 void MultiMediaSourceMuxer::resetTracks() {
     MediaSink::resetTracks();
 
-    if (_rtmp) {
-        _rtmp->resetTracks();
-    }
-    if (_rtsp) {
-        _rtsp->resetTracks();
-    }
-    if (_ts) {
-        _ts->resetTracks();
-    }
-    if (_fmp4) {
-        _fmp4->resetTracks();
-    }
-    if (_hls_fmp4) {
-        _hls_fmp4->resetTracks();
-    }
-    if (_hls) {
-        _hls->resetTracks();
-    }
-    if (_mp4) {
-        _mp4->resetTracks();
-    }
+    auto reset_tracks = [&](const MediaSinkInterface::Ptr &muxer) {
+        invokeMuxer(muxer, [muxer]() { muxer->resetTracks(); });
+    };
+    reset_tracks(_rtmp);
+    reset_tracks(_rtsp);
+    reset_tracks(_ts);
+    reset_tracks(_fmp4);
+    reset_tracks(_hls_fmp4);
+    reset_tracks(_hls);
+    reset_tracks(_mp4);
 }
 
 void MultiMediaSourceMuxer::addProbe(uint32_t probe_ms, const std::function<void(const std::list<FrameInfo> &info_list)> &cb) {
@@ -844,7 +1432,88 @@ void MultiMediaSourceMuxer::addProbe(uint32_t probe_ms, const std::function<void
     });
 }
 
+bool MultiMediaSourceMuxer::inputFrame(const Frame::Ptr &frame) {
+    if (!_latency) {
+        return MediaSink::inputFrame(frame);
+    }
+    // track可能合并多个输入帧或缓存到下一帧才输出，所以按帧记录输入时间
+    // The track may merge multiple input frames or output them only after the next frame, so the input time is recorded per frame
+    auto &stamps = _ingest_stamps[frame->getIndex()];
+    if (stamps.size() >= kMaxIngestStamps) {
+        // 被track丢弃或时间戳回退的帧不会被取出
+        // Frames dropped by the track or with rolled back timestamps will never be taken
+        stamps.pop_front();
+    }
+    stamps.emplace_back(frame->dts(), LatencyHistogram::now());
+    return MediaSink::inputFrame(frame);
+}
+
+uint64_t MultiMediaSourceMuxer::takeIngestStamp(const Frame::Ptr &frame) {
+    auto it = _ingest_stamps.find(frame->getIndex());
+    if (it == _ingest_stamps.end()) {
+        return 0;
+    }
+    // 合并帧的dts为其第一个输入帧的dts，取出所有已被输出的输入帧，以最早的输入时间为准
+    // The dts of the merged frame is the dts of its first input frame, take all input frames that have been output, the earliest input time prevails
+    uint64_t ret = 0;
+    auto &stamps = it->second;
+    while (!stamps.empty() && stamps.front().first <= frame->dts()) {
+        if (!ret) {
+            ret = stamps.front().second;
+        }
+        stamps.pop_front();
+    }
+    return ret;
+}
+
+bool MultiMediaSourceMuxer::inputFrames(const Frame::Ptr *frames, size_t count) {
+    if (count < 2 || _paced_sender || _batching) {
+        return MediaSink::inputFrames(frames, count);
+    }
+    bool ret = false;
+    {
+        _batching = true;
+        onceToken token(nullptr, [&]() { _batching = false; });
+        for (size_t i = 0; i < count; ++i) {
+            ret = inputFrame(frames[i]) ? true : ret;
+        }
+    }
+    if (!_batch_frames.empty()) {
+        // track可能拆分或缓存帧，以track实际输出的帧为准
+        // The tracks may split or cache frames, the frames actually output by the tracks prevail
+        std::vector<Frame::Ptr> batch;
+        batch.swap(_batch_frames);
+        onTrackFrames_l(batch.data(), batch.size());
+        if (_latency) {
+            // 批量帧在此时才进入复用器
+            // The batched frames enter the muxers only at this time
+            auto now = LatencyHistogram::now();
+            for (auto stamp : _batch_stamps) {
+                if (stamp) {
+                    _latency->record(LatencyStats::kIngestToMuxer, now - stamp);
+                }
+            }
+            _batch_stamps.clear();
+        }
+        batch.clear();
+        if (_batch_frames.empty()) {
+            // 复用vector的内存
+            // Reuse the memory of the vector
+            _batch_frames.swap(batch);
+        }
+    }
+    return ret;
+}
+
 bool MultiMediaSourceMuxer::onTrackFrame(const Frame::Ptr &frame_in) {
+    if (_latency) {
+        auto stamp = takeIngestStamp(frame_in);
+        if (_batching) {
+            _batch_stamps.emplace_back(stamp);
+        } else if (stamp) {
+            _latency->record(LatencyStats::kIngestToMuxer, LatencyHistogram::now() - stamp);
+        }
+    }
     if (_on_frame) {
         _on_frame(frame_in);
     }
@@ -857,33 +1526,103 @@ bool MultiMediaSourceMuxer::onTrackFrame(const Frame::Ptr &frame_in) {
     return _paced_sender ? _paced_sender->inputFrame(frame) : onTrackFrame_l(frame);
 }
 
-bool MultiMediaSourceMuxer::onTrackFrame_l(const Frame::Ptr &frame_in) {
-    auto frame = frame_in;
+void MultiMediaSourceMuxer::replayGopIfNeed(const Frame::Ptr &frame) {
+    // 当前帧为新gop的开始时无需补发
+    // No need to replay when the current frame is the beginning of a new gop
+    auto gop_start = frame->getTrackType() == TrackVideo && (frame->keyFrame() || frame->configFrame());
+    auto replay = [&](const MediaSinkInterface::Ptr &muxer, bool need_replay) {
+        if (!need_replay || gop_start) {
+            return;
+        }
+        if (auto worker = getWorker(muxer)) {
+            // 补发数据先于当前帧入队，保证复用器线程中的顺序
+            // The replayed data is queued before the current frame to keep the order in the muxer thread
+            _gop_cache->forEach([&](const Frame::Ptr &cached) { worker->inputFrame(cached, true); });
+            return;
+        }
+        _gop_cache->forEach([&](const Frame::Ptr &cached) { muxer->inputFrame(cached); });
+    };
+    if (_rtmp) {
+        replay(_rtmp, _rtmp->needReplayGop());
+    }
+    if (_rtsp) {
+        replay(_rtsp, _rtsp->needReplayGop());
+    }
+    if (_ts) {
+        replay(_ts, _ts->needReplayGop());
+    }
+    if (_fmp4) {
+        replay(_fmp4, _fmp4->needReplayGop());
+    }
+}
+
+bool MultiMediaSourceMuxer::onTrackFrame_l(const Frame::Ptr &frame) {
+    if (_batching) {
+        // 批量输入期间先收集，在inputFrames末尾统一分发
+        // Collect during batch input first, and dispatch together at the end of inputFrames
+        _batch_frames.emplace_back(Frame::getCacheAbleFrame(frame));
+        return true;
+    }
+    return onTrackFrames_l(&frame, 1);
+}
+
+bool MultiMediaSourceMuxer::onTrackFrames_l(const Frame::Ptr *frames, size_t count) {
     bool ret = false;
+    if (_gop_cache) {
+        // 只有批量的第一帧可能需要补发，补发后标记即被复位
+        // Only the first frame of the batch may need replaying, the flag is reset after replaying
+        replayGopIfNeed(frames[0]);
+    }
+    if (!_workers.empty()) {
+        auto have_video = haveVideo();
+        for (size_t i = 0; i < count; ++i) {
+            // 跨线程投递需要可缓存的帧，各复用器线程共用同一份
+            // Cross-thread delivery requires cacheable frames, which are shared by all muxer threads
+            auto frame = Frame::getCacheAbleFrame(frames[i]);
+            for (auto &worker : _workers) {
+                worker->inputFrame(frame, have_video);
+            }
+            writeRing_l(frame);
+        }
+        // 复用结果在复用器线程才能确定
+        // The muxing result can only be determined in the muxer thread
+        return true;
+    }
+    auto input = [&](MediaSinkInterface &muxer) {
+        return count == 1 ? muxer.inputFrame(frames[0]) : muxer.inputFrames(frames, count);
+    };
     if (_rtmp) {
-        ret = _rtmp->inputFrame(frame) ? true : ret;
+        ret = input(*_rtmp) ? true : ret;
     }
     if (_rtsp) {
-        ret = _rtsp->inputFrame(frame) ? true : ret;
+        ret = input(*_rtsp) ? true : ret;
     }
     if (_ts) {
-        ret = _ts->inputFrame(frame) ? true : ret;
+        ret = input(*_ts) ? true : ret;
     }
 
     if (_hls) {
-        ret = _hls->inputFrame(frame) ? true : ret;
+        ret = input(*_hls) ? true : ret;
     }
 
     if (_hls_fmp4) {
-        ret = _hls_fmp4->inputFrame(frame) ? true : ret;
+        ret = input(*_hls_fmp4) ? true : ret;
     }
 
     if (_mp4) {
-        ret = _mp4->inputFrame(frame) ? true : ret;
+        ret = input(*_mp4) ? true : ret;
     }
     if (_fmp4) {
-        ret = _fmp4->inputFrame(frame) ? true : ret;
+        ret = input(*_fmp4) ? true : ret;
     }
+    for (size_t i = 0; i < count; ++i) {
+        writeRing_l(frames[i]);
+    }
+    return ret;
+}
+
+void MultiMediaSourceMuxer::writeRing_l(const Frame::Ptr &frame_in) {
+    auto frame = frame_in;
     if (_delegate) {
         _delegate->inputFrame(frame);
     }
@@ -905,7 +1644,92 @@ bool MultiMediaSourceMuxer::onTrackFrame_l(const Frame::Ptr &frame_in) {
             _ring->write(frame, !haveVideo());
         }
     }
-    return ret;
+    if (_gop_cache) {
+        if (haveDemandMuxerOff()) {
+            _gop_cache->inputFrame(frame, haveVideo());
+        } else {
+            // 按需转协议都已开启，新播放器由各协议环形缓冲的gop缓存秒开，共享缓存不再重复占用内存
+            // All on-demand protocols are enabled, new players are served by the gop cache of the ring of each protocol,
+            // the shared cache no longer takes up memory repeatedly
+            _gop_cache->reset();
+        }
+    }
+}
+
+bool MultiMediaSourceMuxer::haveDemandMuxerOff() const {
+    // 开启中的按需复用器(或未开启按需的复用器)的isEnabled恒为true
+    // isEnabled of an enabled on-demand muxer (or a muxer without on-demand) is always true
+    return (_rtmp && !_rtmp->isEnabled()) || (_rtsp && !_rtsp->isEnabled()) || (_ts && !_ts->isEnabled()) || (_fmp4 && !_fmp4->isEnabled());
+}
+
+bool MultiMediaSourceMuxer::getPacedSenderInfo(PacedSenderInfo &info) const {
+    if (!_paced_sender) {
+        return false;
+    }
+    _paced_sender->getInfo(info);
+    return true;
+}
+
+bool MultiMediaSourceMuxer::getMuxerWorkerInfo(std::vector<MuxerWorkerInfo> &info) const {
+    if (_workers.empty()) {
+        return false;
+    }
+    info.resize(_workers.size());
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        _workers[i]->getInfo(info[i]);
+    }
+    return true;
+}
+
+void MultiMediaSourceMuxer::updateWorkers() {
+    if (_worker_pollers.empty()) {
+        return;
+    }
+    // 按固定顺序为各协议分配poller，同一协议始终在同一线程复用
+    // Assign pollers to the protocols in a fixed order, the same protocol is always muxed in the same thread
+    std::pair<const char *, MediaSinkInterface::Ptr> muxers[] = {
+        { "rtsp", _rtsp }, { "rtmp", _rtmp }, { "ts", _ts }, { "fmp4", _fmp4 }, { "hls", _hls }, { "hls_fmp4", _hls_fmp4 }, { "mp4", _mp4 }
+    };
+    // 录制文件(mp4/hls)丢帧会导致文件损坏，这些复用器不丢帧
+    // Dropping frames corrupts the recorded files (mp4/hls), these muxers do not drop frames
+    auto lossless = [&](const MediaSinkInterface::Ptr &muxer) { return muxer == _hls || muxer == _hls_fmp4 || muxer == _mp4; };
+    std::vector<MuxerWorker::Ptr> workers;
+    for (size_t i = 0; i < sizeof(muxers) / sizeof(muxers[0]); ++i) {
+        auto &muxer = muxers[i].second;
+        if (!muxer) {
+            continue;
+        }
+        auto worker = getWorker(muxer);
+        if (!worker) {
+            worker = std::make_shared<MuxerWorker>(muxers[i].first, muxer, _worker_pollers[i % _worker_pollers.size()], lossless(muxer));
+        }
+        workers.emplace_back(std::move(worker));
+    }
+    // 被移除的复用器如果正在复用，会在其线程复用完毕后释放
+    // If the removed muxer is muxing, it is released after the muxing is finished in its thread
+    _workers.swap(workers);
+}
+
+std::shared_ptr<MuxerWorker> MultiMediaSourceMuxer::getWorker(const MediaSinkInterface::Ptr &muxer) const {
+    for (auto &worker : _workers) {
+        if (worker->getMuxer() == muxer) {
+            return worker;
+        }
+    }
+    return nullptr;
+}
+
+void MultiMediaSourceMuxer::invokeMuxer(const MediaSinkInterface::Ptr &muxer, std::function<void()> task) {
+    if (!muxer) {
+        return;
+    }
+    if (auto worker = getWorker(muxer)) {
+        // MediaSource的注册与track设置仍在归属线程执行，复用器线程只负责帧复用
+        // The registration of MediaSource and the track setup are still executed in the owner thread, the muxer thread is only responsible for muxing frames
+        worker->async(getOwnerPoller(MediaSource::NullMediaSource()), std::move(task));
+    } else {
+        task();
+    }
 }
 
 bool MultiMediaSourceMuxer::isEnabled(){
@@ -922,8 +1746,11 @@ bool MultiMediaSourceMuxer::isEnabled(){
                      (_ring ? (bool)_ring->readerCount() : false)  ||
                      (_hls ? _hls->isEnabled() : false) ||
                      (_hls_fmp4 ? _hls_fmp4->isEnabled() : false) ||
-                     _mp4;
-
+                     _mp4 ||
+                     // 共享gop缓存需要持续输入数据，否则流无人观看时缓存失效，第一个播放器无法秒开
+                     // The shared gop cache needs continuous data input, otherwise the cache becomes invalid when the stream has no reader,
+                     // and the first player cannot start instantly
+                     _gop_cache;
         if (_is_enable) {
             // 无人观看时，不刷新计时器,因为无人观看时每次都会检查一遍，所以刷新计数器无意义且浪费cpu  [AUTO-TRANSLATED:03ab47cf]
             // When no one is watching, do not refresh the timer, because each time no one is watching, it will be checked, so refreshing the counter is meaningless and wastes cpu
@@ -11,9 +11,11 @@
 #ifndef ZLMEDIAKIT_MULTIMEDIASOURCEMUXER_H
 #define ZLMEDIAKIT_MULTIMEDIASOURCEMUXER_H
 
+#include <deque>
 #include "Common/Stamp.h"
 #include "Common/MediaSource.h"
 #include "Common/MediaSink.h"
+#include "Common/LatencyStats.h"
 #include "Record/Recorder.h"
 #include "Rtp/RtpSender.h"
 #include "Record/HlsRecorder.h"
@@ -37,6 +39,39 @@ struct FrameInfo {
     bool config_frame = false;
 };
 
+struct PacedSenderInfo {
+    // 平滑发送缓存的帧数
+    // Number of frames cached by the paced sender
+    size_t queue_size = 0;
+    // 当前缓存时长
+    // Current cache duration
+    uint32_t cache_ms = 0;
+    // 实际发送时刻相对期望发送时刻延后的平滑值
+    // Smoothed delay of the actual sending time relative to the expected sending time
+    float jitter_ms = 0;
+    // 因时间戳回退或消费太慢强制清空缓存的次数
+    // Times of forced cache flush due to timestamp rollback or slow consumption
+    uint64_t flush_count = 0;
+};
+
+struct MuxerWorkerInfo {
+    // 复用器名称，如rtsp、rtmp、hls
+    // Muxer name, such as rtsp, rtmp, hls
+    std::string name;
+    // 待复用的帧与任务个数
+    // Number of frames and tasks waiting to be muxed
+    size_t queue_size = 0;
+    // 已复用的帧数
+    // Number of muxed frames
+    uint64_t frames = 0;
+    // 因复用太慢丢弃的帧数
+    // Number of frames dropped because muxing is too slow
+    uint64_t dropped = 0;
+    // 复用线程累计cpu耗时，单位微秒
+    // Accumulated cpu time of muxing, in microseconds
+    uint64_t cpu_us = 0;
+};
+
 class MultiMediaSourceMuxer : public MediaSourceEventInterceptor, public MediaSink, public toolkit::noncopyable, public std::enable_shared_from_this<MultiMediaSourceMuxer>{
 public:
     using Ptr = std::shared_ptr<MultiMediaSourceMuxer>;
@@ -105,6 +140,18 @@ public:
      */
     void resetTracks() override;
 
+    /**
+     * 输入frame，开启延时统计时记录输入时刻
+     * Input frame, record the input time when latency statistics is enabled
+     */
+    bool inputFrame(const Frame::Ptr &frame) override;
+
+    /**
+     * 批量输入frame，track输出的帧收集后以整批方式分发给各协议复用器
+     * Input frames in batch, the frames output by the tracks are collected and dispatched to the muxer of each protocol as a whole batch
+     */
+    bool inputFrames(const Frame::Ptr *frames, size_t count) override;
+
     /////////////////////////////////MediaSourceEvent override/////////////////////////////////
 
     /**
@@ -203,6 +250,22 @@ public:
 
     void addProbe(uint32_t probe_ms, const std::function<void(const std::list<FrameInfo> &info_list)> &cb);
 
+    /**
+     * 获取平滑发送统计信息，可在任意线程调用
+     * @return 未开启平滑发送时返回false
+     * Get paced sender statistics, can be called in any thread
+     * @return Return false if paced sending is not enabled
+     */
+    bool getPacedSenderInfo(PacedSenderInfo &info) const;
+
+    /**
+     * 获取各协议复用器线程统计信息，需在归属线程调用
+     * @return 未开启多线程复用时返回false
+     * Get the statistics of the protocol muxer threads, must be called in the owner thread
+     * @return Return false if multi-threaded muxing is not enabled
+     */
+    bool getMuxerWorkerInfo(std::vector<MuxerWorkerInfo> &info) const;
+
 protected:
     /////////////////////////////////MediaSink override/////////////////////////////////
 
@@ -236,18 +299,36 @@ protected:
      */
     bool onTrackFrame(const Frame::Ptr &frame) override;
     bool onTrackFrame_l(const Frame::Ptr &frame);
+    bool onTrackFrames_l(const Frame::Ptr *frames, size_t count);
+    void writeRing_l(const Frame::Ptr &frame);
 
 private:
     void createGopCacheIfNeed(size_t gop_count);
+    void replayGopIfNeed(const Frame::Ptr &frame);
+    bool haveDemandMuxerOff() const;
     std::shared_ptr<MediaSinkInterface> makeRecorder(Recorder::type type);
+    void updateWorkers();
+    std::shared_ptr<class MuxerWorker> getWorker(const MediaSinkInterface::Ptr &muxer) const;
+    void invokeMuxer(const MediaSinkInterface::Ptr &muxer, std::function<void()> task);
+    uint64_t takeIngestStamp(const Frame::Ptr &frame);
 
 private:
     bool _is_enable = false;
     bool _create_in_poller = false;
     bool _video_key_pos = false;
+    bool _batching = false;
     float _dur_sec;
+    // 各track待输出帧的<dts, 输入时间>，按输入顺序排列
+    // <dts, input time> of the frames to be output of each track, in input order
+    std::unordered_map<int, std::deque<std::pair<uint64_t, uint64_t>>> _ingest_stamps;
+    std::vector<uint64_t> _batch_stamps;
+    LatencyStats::Ptr _latency;
     std::function<void(const Frame::Ptr &frame)> _on_frame;
+    std::vector<Frame::Ptr> _batch_frames;
     std::shared_ptr<class FramePacedSender> _paced_sender;
+    std::shared_ptr<class FrameGopCache> _gop_cache;
+    std::vector<std::shared_ptr<MuxerWorker>> _workers;
+    std::vector<toolkit::EventPoller::Ptr> _worker_pollers;
     MediaTuple _tuple;
     ProtocolOption _option;
     toolkit::Ticker _last_check;
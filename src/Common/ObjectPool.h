@@ -0,0 +1,314 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_OBJECT_POOL_H
+#define ZLMEDIAKIT_OBJECT_POOL_H
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+
+namespace mediakit {
+
+template <typename C>
+class ObjectPool;
+
+/**
+ * 原始内存块，用于池化shared_ptr的控制块，data必须为第一个成员以便由数据地址还原内存块
+ * Raw memory block, used to pool the control block of shared_ptr, data must be the first member so that the block can be restored from the data address
+ */
+template <size_t kSize, size_t kAlign>
+class RawBlock {
+public:
+    typename std::aligned_storage<kSize, kAlign>::type data;
+    // 申请该内存块的线程池，释放时归还给它
+    // The thread pool that obtained this block, it is returned to this pool when released
+    ObjectPool<RawBlock> *owner = nullptr;
+};
+
+/**
+ * 线程本地对象池
+ * 每个线程(一般是EventPoller线程)拥有独立的空闲对象列表，对象总是回收到创建它的线程的池中:
+ * 在本线程释放时直接放回空闲列表(无锁)，在其他线程释放时放入该池的归还列表(多生产者单消费者)，
+ * 所属线程在空闲列表耗尽时批量取回，所以跨线程生产消费的场景也能复用对象
+ * Thread local object pool
+ * Each thread (usually an EventPoller thread) owns an independent free list, objects are always recycled into
+ * the pool of the thread that created them: released on the owner thread they go back to the free list directly (lock free),
+ * released on other threads they are put into the return list of the pool (multi producer single consumer),
+ * and the owner thread takes them back in batch when its free list is exhausted, so objects are reused in cross-thread scenarios too
+ */
+template <typename C>
+class ObjectPool {
+public:
+    // 回收前重置对象，返回false则销毁之
+    // Reset the object before recycling, return false to destroy it
+    using onRecycle = bool (*)(C *obj);
+
+    class Statistic {
+    public:
+        // 申请对象总次数
+        // Total times of obtaining objects
+        uint64_t obtain = 0;
+        // 命中空闲对象次数
+        // Times of hitting free objects
+        uint64_t hit = 0;
+        // 回收对象次数(包括跨线程归还)
+        // Times of recycling objects (including returned from other threads)
+        uint64_t recycle = 0;
+        // 跨线程归还对象次数
+        // Times of objects returned from other threads
+        uint64_t returned = 0;
+        // 未能回收(池满、所属线程已退出或对象不可复用)而直接销毁的次数
+        // Times of destroying objects directly (pool full, owner thread exited or object not reusable)
+        uint64_t drop = 0;
+        // 当前空闲对象个数
+        // Current free objects count
+        uint64_t free = 0;
+    };
+
+    /**
+     * 从本线程的对象池获取对象
+     * @param max_size 本线程池最多缓存的空闲对象个数，0则不缓存
+     * @param on_recycle 对象释放时的重置回调，可能在任意线程被调用
+     * Obtain an object from the pool of this thread
+     * @param max_size Max free objects cached by the pool of this thread, 0 means no cache
+     * @param on_recycle Reset callback when the object is released, may be called on any thread
+     */
+    static std::shared_ptr<C> obtain(size_t max_size, onRecycle on_recycle) {
+        auto pool = local();
+        // 池对象在进程生命周期内不销毁，删除器持有裸指针，避免每次申请都增减池的引用计数；
+        // shared_ptr的控制块同样从本线程的内存块池申请，命中时整个申请过程无内存分配
+        // The pool is never destroyed during the process lifetime, the deleter holds a raw pointer to avoid refcount traffic on every obtain;
+        // the control block of shared_ptr is also obtained from the block pool of this thread, so a hit does no memory allocation at all
+        return std::shared_ptr<C>(pool->take(max_size), Deleter { pool, on_recycle }, Allocator<C>(max_size));
+    }
+
+    /**
+     * 获取所有线程对象池的统计信息之和
+     * Get the sum of the statistics of all thread pools
+     */
+    static Statistic getStatistic() {
+        Statistic ret;
+        std::lock_guard<std::mutex> lck(mutex());
+        for (auto pool : all()) {
+            ret.obtain += pool->_obtain.load(std::memory_order_relaxed);
+            ret.hit += pool->_hit.load(std::memory_order_relaxed);
+            ret.recycle += pool->_recycle.load(std::memory_order_relaxed) + pool->_returned.load(std::memory_order_relaxed);
+            ret.returned += pool->_returned.load(std::memory_order_relaxed);
+            ret.drop += pool->_drop.load(std::memory_order_relaxed);
+            ret.free += pool->_free.load(std::memory_order_relaxed) + pool->_returned_size.load(std::memory_order_relaxed);
+        }
+        return ret;
+    }
+
+private:
+    template <typename>
+    friend class ObjectPool;
+
+    class Deleter {
+    public:
+        void operator()(C *obj) const { pool->recycle(obj, on_recycle); }
+
+        ObjectPool *pool;
+        onRecycle on_recycle;
+    };
+
+    // shared_ptr控制块的分配器，单个控制块从本线程的RawBlock池申请，释放时归还给申请它的线程池
+    // Allocator of the shared_ptr control block, a single control block is obtained from the RawBlock pool of this thread,
+    // and returned to the pool of the thread that obtained it when released
+    template <typename T>
+    class Allocator {
+    public:
+        using value_type = T;
+        using Block = RawBlock<sizeof(T), alignof(T)>;
+
+        template <typename U>
+        struct rebind {
+            using other = Allocator<U>;
+        };
+
+        Allocator(size_t max_size_in) : max_size(max_size_in) {}
+
+        template <typename U>
+        Allocator(const Allocator<U> &that) : max_size(that.max_size) {}
+
+        T *allocate(size_t n) {
+            if (n != 1) {
+                return std::allocator<T>().allocate(n);
+            }
+            auto pool = ObjectPool<Block>::local();
+            auto block = pool->take(max_size);
+            block->owner = pool;
+            return reinterpret_cast<T *>(&block->data);
+        }
+
+        void deallocate(T *ptr, size_t n) {
+            if (n != 1) {
+                std::allocator<T>().deallocate(ptr, n);
+                return;
+            }
+            auto block = reinterpret_cast<Block *>(ptr);
+            block->owner->recycle(block, [](Block *) { return true; });
+        }
+
+        template <typename U>
+        bool operator==(const Allocator<U> &) const { return true; }
+
+        template <typename U>
+        bool operator!=(const Allocator<U> &) const { return false; }
+
+        size_t max_size;
+    };
+
+    // 线程退出时释放空闲对象，池对象本身保留，以便之后在其他线程释放的对象能安全归还(直接销毁)
+    // Free the idle objects when the thread exits, the pool itself is kept so that objects released later on other threads can be returned safely (destroyed directly)
+    class Holder {
+    public:
+        Holder() {
+            pool = new ObjectPool;
+            std::lock_guard<std::mutex> lck(mutex());
+            all().emplace_back(pool);
+        }
+
+        ~Holder() { pool->onThreadExit(); }
+
+        ObjectPool *pool;
+    };
+
+    ObjectPool() = default;
+    ~ObjectPool() = default;
+
+    static ObjectPool *local() {
+        static thread_local Holder s_holder;
+        return s_holder.pool;
+    }
+
+    static std::mutex &mutex() {
+        static std::mutex s_mtx;
+        return s_mtx;
+    }
+
+    static std::list<ObjectPool *> &all() {
+        static std::list<ObjectPool *> s_pools;
+        return s_pools;
+    }
+
+    // 只由所属线程修改的计数，无需原子的读改写
+    // Counters only modified by the owner thread, no atomic read-modify-write is needed
+    static void increase(std::atomic<uint64_t> &counter) { counter.store(counter.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    C *take(size_t max_size) {
+        _max_size.store(max_size, std::memory_order_relaxed);
+        increase(_obtain);
+        if (_objs.empty() && _returned_size.load(std::memory_order_relaxed)) {
+            takeReturned();
+        }
+        if (_objs.empty()) {
+            return new C;
+        }
+        auto obj = _objs.back();
+        _objs.pop_back();
+        increase(_hit);
+        _free.store(_objs.size(), std::memory_order_relaxed);
+        return obj;
+    }
+
+    void recycle(C *obj, onRecycle on_recycle) {
+        if (!on_recycle(obj)) {
+            _drop.fetch_add(1, std::memory_order_relaxed);
+            delete obj;
+            return;
+        }
+        auto max_size = _max_size.load(std::memory_order_relaxed);
+        if (_thread_id == std::this_thread::get_id()) {
+            if (_exited || _objs.size() >= max_size) {
+                _drop.fetch_add(1, std::memory_order_relaxed);
+                delete obj;
+                return;
+            }
+            _objs.emplace_back(obj);
+            increase(_recycle);
+            _free.store(_objs.size(), std::memory_order_relaxed);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lck(_returned_mtx);
+            if (!_exited && _returned_objs.size() < max_size) {
+                _returned_objs.emplace_back(obj);
+                _returned_size.store(_returned_objs.size(), std::memory_order_relaxed);
+                _returned.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+        }
+        _drop.fetch_add(1, std::memory_order_relaxed);
+        delete obj;
+    }
+
+    // 所属线程批量取回其他线程归还的对象
+    // The owner thread takes back the objects returned by other threads in batch
+    void takeReturned() {
+        {
+            std::lock_guard<std::mutex> lck(_returned_mtx);
+            _objs.swap(_returned_objs);
+            _returned_size.store(0, std::memory_order_relaxed);
+        }
+        // 交换后_returned_objs为原空闲列表(已为空)，保留其容量供下次归还使用
+        // After swapping, _returned_objs is the original free list (empty), keep its capacity for the next return
+        _free.store(_objs.size(), std::memory_order_relaxed);
+    }
+
+    void onThreadExit() {
+        std::vector<C *> objs;
+        {
+            std::lock_guard<std::mutex> lck(_returned_mtx);
+            _exited = true;
+            objs.swap(_returned_objs);
+            _returned_size.store(0, std::memory_order_relaxed);
+        }
+        objs.insert(objs.end(), _objs.begin(), _objs.end());
+        _objs.clear();
+        _free.store(0, std::memory_order_relaxed);
+        for (auto obj : objs) {
+            delete obj;
+        }
+    }
+
+private:
+    std::atomic<bool> _exited { false };
+    std::atomic<size_t> _max_size { 0 };
+    std::thread::id _thread_id = std::this_thread::get_id();
+    // 空闲对象，只在所属线程访问
+    // Free objects, only accessed by the owner thread
+    std::vector<C *> _objs;
+    // 其他线程归还的对象，受_returned_mtx保护
+    // Objects returned by other threads, protected by _returned_mtx
+    std::mutex _returned_mtx;
+    std::vector<C *> _returned_objs;
+    std::atomic<size_t> _returned_size { 0 };
+    // 统计信息
+    // Statistics
+    std::atomic<uint64_t> _obtain { 0 };
+    std::atomic<uint64_t> _hit { 0 };
+    // 所属线程回收的次数，跨线程归还的次数计入_returned
+    // Times of recycling on the owner thread, objects returned from other threads are counted in _returned
+    std::atomic<uint64_t> _recycle { 0 };
+    std::atomic<uint64_t> _returned { 0 };
+    std::atomic<uint64_t> _drop { 0 };
+    std::atomic<uint64_t> _free { 0 };
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_OBJECT_POOL_H
@@ -11,7 +11,10 @@
 #ifndef ZLMEDIAKIT_PACKET_CACHE_H_
 #define ZLMEDIAKIT_PACKET_CACHE_H_
 
+#include <atomic>
 #include "Common/config.h"
+#include "Common/ObjectPool.h"
+#include "Common/LatencyStats.h"
 #include "Util/List.h"
 
 namespace mediakit {
@@ -21,12 +24,44 @@ class FlushPolicy {
 public:
     bool isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size);
 
+    // 当前合并写时长(毫秒)，小于等于0时关闭合并写
+    // Current merge write duration (milliseconds), merge write is closed when it is less than or equal to 0
+    int getMergeMS() const;
+
+protected:
+    bool isFlushAble_l(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size, int merge_ms);
+
 private:
     // 音视频的最后时间戳  [AUTO-TRANSLATED:957d18ed]
     // Last timestamp of audio and video
     uint64_t _last_stamp[2] = { 0, 0 };
 };
 
+// / 自适应缓存刷新策略类
+// / 单个播放器且发送缓存无压力时不合并写以降低延时，播放器越多合并写时长越大以提高吞吐量，
+// / 任一播放器发送缓存满后的一段时间内采用最大合并写时长
+// / Adaptive cache refresh strategy class
+// / No merge write for a single player without send buffer pressure to reduce latency, the more players the longer the merge write duration to improve throughput,
+// / the max merge write duration is used for a while after the send buffer of any player is full
+class AdaptiveFlushPolicy : public FlushPolicy {
+public:
+    bool isFlushAble(bool is_video, bool is_key, uint64_t new_stamp, size_t cache_size);
+
+    int getMergeMS() const;
+
+    // 播放器个数变化，可在任意线程调用
+    // The number of players changed, can be called in any thread
+    void setReaderCount(int size) { _reader_count = size; }
+
+    // 播放器发送缓存有压力，可在任意线程调用
+    // The send buffer of a player is under pressure, can be called in any thread
+    void onSendPressure();
+
+private:
+    std::atomic<int> _reader_count { 0 };
+    std::atomic<uint64_t> _pressure_stamp { 0 };
+};
+
 // / 合并写缓存模板  [AUTO-TRANSLATED:25cde944]
 // / Merge write cache template
 // / \tparam packet 包类型  [AUTO-TRANSLATED:43085d9b]
@@ -38,16 +73,26 @@ private:
 template<typename packet, typename policy = FlushPolicy, typename packet_list = toolkit::List<std::shared_ptr<packet> > >
 class PacketCache {
 public:
-    PacketCache() { _cache = std::make_shared<packet_list>(); }
+    PacketCache() { _cache = obtainList(); }
 
     virtual ~PacketCache() = default;
 
     void inputPacket(uint64_t stamp, bool is_video, std::shared_ptr<packet> pkt, bool key_pos) {
         bool flag = flushImmediatelyWhenCloseMerge();
-        if (!flag && _policy.isFlushAble(is_video, key_pos, stamp, _cache->size())) {
+        if (flag && _batch) {
+            // 批量输入时不逐包刷新，但遇到关键帧仍需刷新，确保关键帧为该组数据的第一帧
+            // Do not flush packet by packet during batch input, but still flush at key frames to ensure the key frame is the first one of the group
+            if (is_video && key_pos) {
+                flush();
+            }
+            flag = false;
+        } else if (!flag && _policy.isFlushAble(is_video, key_pos, stamp, _cache->size())) {
             flush();
         }
 
+        if (_latency && _cache->empty()) {
+            _cache_stamp = LatencyHistogram::now();
+        }
         // 追加数据到最后  [AUTO-TRANSLATED:e24ccfb6]
         // Append data to the end
         _cache->emplace_back(std::move(pkt));
@@ -64,8 +109,13 @@ public:
         if (_cache->empty()) {
             return;
         }
+        if (_latency) {
+            // 第一个包从进入合并写缓存到写入环形缓存的耗时
+            // Time of the first packet from entering the merge write cache to being written into the ring buffer
+            _latency->record(LatencyStats::kMuxerToRing, LatencyHistogram::now() - _cache_stamp);
+        }
         onFlush(std::move(_cache), _key_pos);
-        _cache = std::make_shared<packet_list>();
+        _cache = obtainList();
         _key_pos = false;
     }
 
@@ -73,9 +123,32 @@ public:
         _cache->clear();
     }
 
+    /**
+     * 开始批量输入，关闭合并写时也不再逐包刷新，直到endBatch时统一刷新一次
+     * 可嵌套调用
+     * Begin batch input, no more flushing packet by packet even when merge write is closed, until flushing once in endBatch
+     * Can be nested
+     */
+    void beginBatch() { ++_batch; }
+
+    void endBatch() {
+        if (_batch && !--_batch && flushImmediatelyWhenCloseMerge()) {
+            flush();
+        }
+    }
+
     virtual void onFlush(std::shared_ptr<packet_list>, bool key_pos) = 0;
 
 private:
+    static std::shared_ptr<packet_list> obtainList() {
+        // 合并写缓存列表从本线程对象池获取，在本线程释放时回收复用
+        // The merge write cache list is obtained from the object pool of this thread, and recycled when released in this thread
+        return ObjectPool<packet_list>::obtain(kListPoolSize, [](packet_list *list) {
+            list->clear();
+            return true;
+        });
+    }
+
     bool flushImmediatelyWhenCloseMerge() {
         // 一般的协议关闭合并写时，立即刷新缓存，这样可以减少一帧的延时，但是rtp例外  [AUTO-TRANSLATED:54eba701]
         // Generally, when the protocol closes the merge write, the cache is refreshed immediately, which can reduce the delay of one frame, but RTP is an exception.
@@ -86,16 +159,28 @@ private:
         // 但是却对性能提升很大，这样做还是比较划算的  [AUTO-TRANSLATED:80eab719]
         // But it greatly improves performance, so it is still worthwhile to do so.
 
-        GET_CONFIG(int, mergeWriteMS, General::kMergeWriteMS);
         GET_CONFIG(int, rtspLowLatency, Rtsp::kLowLatency);
-        return std::is_same<packet, RtpPacket>::value ? rtspLowLatency : (mergeWriteMS <= 0);
+        return std::is_same<packet, RtpPacket>::value ? rtspLowLatency : (_policy.getMergeMS() <= 0);
     }
 
+protected:
+    void setLatencyStats(LatencyStats::Ptr stats) { _latency = std::move(stats); }
+
+    policy &getFlushPolicy() { return _policy; }
+    const policy &getFlushPolicy() const { return _policy; }
+
 private:
+    static constexpr size_t kListPoolSize = 256;
+
     bool _key_pos = false;
+    int _batch = 0;
+    uint64_t _cache_stamp = 0;
     policy _policy;
+    LatencyStats::Ptr _latency;
     std::shared_ptr<packet_list> _cache;
 };
+template <typename packet, typename policy, typename packet_list>
+constexpr size_t PacketCache<packet, policy, packet_list>::kListPoolSize;
 }
 
 #endif //ZLMEDIAKIT_PACKET_CACHE_H_
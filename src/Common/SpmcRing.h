@@ -0,0 +1,645 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_SPMC_RING_H
+#define ZLMEDIAKIT_SPMC_RING_H
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <stdexcept>
+#include <unordered_map>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Poller/EventPoller.h"
+#include "Common/LatencyStats.h"
+
+namespace mediakit {
+
+template <typename T>
+class SpmcRingDispatcher;
+
+template <typename T>
+class SpmcRing;
+
+/**
+ * 单写多读环形缓冲的共享存储
+ * 数据按序号追加到不可变的分块链表中，写入者发布序号后该位置的数据不再修改，所以读者无需加锁即可读取；
+ * 分块由写入者和读者通过智能指针共同持有，没有读者引用时自动释放
+ * Shared storage of the single-writer multi-reader ring
+ * Data is appended by sequence number to a linked list of immutable chunks, the data at a position is never modified after the
+ * writer publishes the sequence number, so readers can read it without locking;
+ * chunks are held by the writer and readers through smart pointers and released automatically when no reader refers to them
+ */
+template <typename T>
+class SpmcRingStorage {
+public:
+    using Ptr = std::shared_ptr<SpmcRingStorage>;
+    using onReaderChanged = std::function<void(int size)>;
+
+    enum { kChunkSize = 64 };
+
+    class Chunk {
+    public:
+        using Ptr = std::shared_ptr<Chunk>;
+
+        Chunk(uint64_t base_seq) : base(base_seq) {}
+
+        ~Chunk() {
+            // 迭代释放只被本块引用的后续块，避免长链表递归析构导致栈溢出
+            // Release the following chunks only referenced by this chunk iteratively, to avoid stack overflow caused by recursive destruction of a long list
+            auto chunk = std::move(next);
+            while (chunk && chunk.use_count() == 1) {
+                auto following = std::move(chunk->next);
+                chunk = std::move(following);
+            }
+        }
+
+        // 本块第一个数据的序号
+        // Sequence number of the first data in this chunk
+        uint64_t base;
+        // 下一块，在发布下一块的第一个序号前赋值，之后不再修改
+        // The next chunk, assigned before publishing the first sequence number of it and never modified afterwards
+        Ptr next;
+        T data[kChunkSize];
+        // 写入时刻，开启延时统计时有效
+        // Write time, valid when latency statistics is enabled
+        uint64_t stamp[kChunkSize] = { 0 };
+    };
+
+    class Position {
+    public:
+        using Ptr = std::shared_ptr<const Position>;
+
+        Position(typename Chunk::Ptr chunk_ptr, uint64_t seq_num) : chunk(std::move(chunk_ptr)), seq(seq_num) {}
+
+        typename Chunk::Ptr chunk;
+        uint64_t seq;
+    };
+
+    SpmcRingStorage(size_t max_size, onReaderChanged cb) {
+        _max_size = max_size ? max_size : 1;
+        _on_reader_changed = std::move(cb);
+        _tail = std::make_shared<Chunk>(0);
+        std::atomic_store(&_tail_pos, std::make_shared<const Position>(_tail, 0));
+    }
+
+    /**
+     * 写入数据，只能由单个线程调用
+     * Write data, can only be called by a single thread
+     */
+    void write(T in, bool is_key) {
+        auto seq = _write_seq.load(std::memory_order_relaxed);
+        auto index = seq - _tail->base;
+        if (index == kChunkSize) {
+            auto chunk = std::make_shared<Chunk>(seq);
+            _tail->next = chunk;
+            _tail = std::move(chunk);
+            index = 0;
+            std::atomic_store(&_tail_pos, std::make_shared<const Position>(_tail, seq));
+        }
+        _tail->data[index] = std::move(in);
+        if (_latency) {
+            _tail->stamp[index] = LatencyHistogram::now();
+        }
+
+        // 连续的关键帧(例如纯音频)每块只记录一次，避免每次写入都申请内存
+        // Consecutive key frames (such as audio only) are recorded only once per chunk, to avoid allocating memory on every write
+        auto reset_key = _reset_key.load(std::memory_order_relaxed) && _reset_key.exchange(false);
+        if (is_key && (!_last_is_key || index == 0 || reset_key)) {
+            auto pos = std::make_shared<const Position>(_tail, seq);
+            std::atomic_store(&_key_pos, pos);
+            std::atomic_store(&_cache_pos, pos);
+            _key_seq = seq;
+            _have_key = true;
+        } else if (_have_key && seq - _key_seq >= _max_size) {
+            // gop过大，不再缓存，同时释放对旧数据的引用
+            // The gop is too large, stop caching and release the reference to the old data
+            std::atomic_store(&_key_pos, typename Position::Ptr());
+            std::atomic_store(&_cache_pos, typename Position::Ptr());
+            _have_key = false;
+        }
+        _last_is_key = is_key;
+        // 与读者清除待执行标记的操作需全序，避免漏掉通知
+        // Must be totally ordered with the reader clearing the pending flag, to avoid missing notifications
+        _write_seq.store(seq + 1);
+    }
+
+    uint64_t writeSeq() const { return _write_seq.load(); }
+
+    size_t maxSize() const { return _max_size; }
+
+    /**
+     * 清空gop缓存，同时释放对旧数据的引用，下一个关键帧重新开始缓存
+     * Clear the gop cache and release the reference to the old data, caching restarts from the next key frame
+     */
+    void clearCache() {
+        std::atomic_store(&_key_pos, typename Position::Ptr());
+        std::atomic_store(&_cache_pos, typename Position::Ptr());
+        // 通知写入线程在下一个关键帧重新记录位置(连续关键帧时不必等到下一块)
+        // Notify the writer thread to record the position again at the next key frame (no need to wait for the next chunk for consecutive key frames)
+        _reset_key = true;
+    }
+
+    typename Position::Ptr keyPos() const { return std::atomic_load(&_key_pos); }
+
+    /**
+     * 新读者的起始位置
+     * @param use_cache 是否从gop缓存开始读取
+     * Start position of a new reader
+     * @param use_cache Whether to start reading from the gop cache
+     */
+    typename Position::Ptr startPos(bool use_cache) const {
+        if (use_cache) {
+            auto pos = std::atomic_load(&_cache_pos);
+            if (pos) {
+                return pos;
+            }
+        }
+        return livePos();
+    }
+
+    /**
+     * 当前最新位置
+     * Current latest position
+     */
+    typename Position::Ptr livePos() const {
+        // 先获取序号，tail_pos在发布该序号前已更新
+        // Get the sequence number first, tail_pos has been updated before publishing it
+        auto seq = writeSeq();
+        auto tail = std::atomic_load(&_tail_pos);
+        if (tail->seq >= seq) {
+            return tail;
+        }
+        return std::make_shared<const Position>(tail->chunk, seq);
+    }
+
+    void onSizeChanged(bool add_flag) {
+        auto size = add_flag ? ++_reader_count : --_reader_count;
+        if (!_closed && _on_reader_changed) {
+            _on_reader_changed(size);
+        }
+    }
+
+    int readerCount() const { return _reader_count; }
+
+    void setOnPressure(std::function<void()> cb) { _on_pressure = std::move(cb); }
+
+    void setLatencyStats(LatencyStats::Ptr stats) { _latency = std::move(stats); }
+
+    const LatencyStats::Ptr &getLatencyStats() const { return _latency; }
+
+    void onPressure() const {
+        if (_on_pressure) {
+            _on_pressure();
+        }
+    }
+
+    void close() { _closed = true; }
+
+private:
+    bool _have_key = false;
+    bool _last_is_key = false;
+    uint64_t _key_seq = 0;
+    size_t _max_size;
+    typename Chunk::Ptr _tail;
+    std::atomic<uint64_t> _write_seq { 0 };
+    std::atomic<int> _reader_count { 0 };
+    std::atomic<bool> _closed { false };
+    std::atomic<bool> _reset_key { false };
+    onReaderChanged _on_reader_changed;
+    std::function<void()> _on_pressure;
+    LatencyStats::Ptr _latency;
+    // 以下通过std::atomic_load/std::atomic_store访问
+    // The following are accessed by std::atomic_load/std::atomic_store
+    typename Position::Ptr _tail_pos;
+    typename Position::Ptr _key_pos;
+    typename Position::Ptr _cache_pos;
+};
+
+/**
+ * 单写多读环形缓冲的读者，只能在attach时指定的poller线程中使用
+ * 每个读者维护自己的读取序号，落后超过缓存大小时跳到最新的关键帧继续读取
+ * Reader of the single-writer multi-reader ring, can only be used in the poller thread specified when attaching
+ * Each reader maintains its own read sequence number, and jumps to the latest key frame when it falls behind more than the cache size
+ */
+template <typename T>
+class SpmcRingReader {
+public:
+    using Ptr = std::shared_ptr<SpmcRingReader>;
+    using Storage = SpmcRingStorage<T>;
+    friend class SpmcRingDispatcher<T>;
+
+    // 落后超过缓存大小的该倍数时认为读者已无法恢复，直接断开
+    // A reader that falls behind more than this multiple of the cache size is considered unrecoverable and detached directly
+    enum { kMaxLagTimes = 4 };
+    // 追赶告警的最小间隔，单位微秒
+    // Min interval of the catch-up warning, in microseconds
+    enum : uint64_t { kWarnIntervalUS = 10 * 1000 * 1000 };
+
+    SpmcRingReader(typename Storage::Ptr storage, typename Storage::Position::Ptr pos) {
+        _storage = std::move(storage);
+        _chunk = pos->chunk;
+        _seq = pos->seq;
+    }
+
+    void setReadCB(std::function<void(const T &)> cb) {
+        if (!cb) {
+            _read_cb = [](const T &) {};
+            return;
+        }
+        _read_cb = std::move(cb);
+        // 立即读取gop缓存，补发的数据不计入延时统计
+        // Read the gop cache immediately, the replayed data is not counted in the latency statistics
+        onRead(_storage->writeSeq(), false);
+    }
+
+    void setDetachCB(std::function<void()> cb) { _detach_cb = cb ? std::move(cb) : []() {}; }
+
+    void setGetInfoCB(std::function<toolkit::Any()> cb) { _get_info = cb ? std::move(cb) : []() { return toolkit::Any(); }; }
+
+    void setMessageCB(std::function<void(const toolkit::Any &data)> cb) { _msg_cb = cb ? std::move(cb) : [](const toolkit::Any &) {}; }
+
+    /**
+     * 读者发送缓存已满，通知写入端
+     * The send buffer of the reader is full, notify the writer side
+     */
+    void onSendPressure() const { _storage->onPressure(); }
+
+    /**
+     * 获取环形缓冲的读者总数
+     * Get the total number of readers of the ring
+     */
+    int readerCount() const { return _storage->readerCount(); }
+
+private:
+    void onRead(uint64_t end, bool live = true) {
+        if (!_read_cb || _detached) {
+            // 未设置回调前保持读取位置，以便设置后读取gop缓存
+            // Keep the read position before the callback is set, so that the gop cache can be read after setting
+            return;
+        }
+        if (_seq < end && end - _seq > _storage->maxSize()) {
+            if (!catchUp(end)) {
+                return;
+            }
+            // 追赶时从关键帧重新读取的数据不代表实时延时
+            // The data re-read from the key frame when catching up does not represent the live latency
+            live = false;
+        }
+        // 记录本批次第一个数据(延时最大)从写入到发送完毕的耗时
+        // Record the time from writing to sending of the first data (with the max latency) of this batch
+        uint64_t write_stamp = 0;
+        while (_seq < end) {
+            auto index = _seq - _chunk->base;
+            if (index == Storage::kChunkSize) {
+                _chunk = _chunk->next;
+                index = 0;
+            }
+            if (live && !write_stamp) {
+                write_stamp = _chunk->stamp[index];
+            }
+            ++_seq;
+            _read_cb(_chunk->data[index]);
+        }
+        if (write_stamp) {
+            _storage->getLatencyStats()->record(LatencyStats::kRingToSend, LatencyHistogram::now() - write_stamp);
+        }
+    }
+
+    // 返回false代表读者落后太多已被断开
+    // Return false means the reader falls behind too much and has been detached
+    bool catchUp(uint64_t end) {
+        auto lag = end - _seq;
+        _storage->onPressure();
+        if (lag > kMaxLagTimes * _storage->maxSize()) {
+            WarnL << "ring reader is lagging behind " << lag << " packets, detach it";
+            _detached = true;
+            // 释放对旧数据的引用
+            // Release the reference to the old data
+            _chunk = nullptr;
+            onDetach();
+            return false;
+        }
+        auto pos = _storage->keyPos();
+        if (!pos || pos->seq <= _seq) {
+            // 没有更新的关键帧，直接跳到最新位置
+            // No newer key frame, jump to the latest position directly
+            pos = _storage->livePos();
+        }
+        // 持续落后的读者每次读取都可能追赶，告警限频
+        // A reader that keeps falling behind may catch up on every read, so the warning is rate limited
+        ++_skip_count;
+        auto now = LatencyHistogram::now();
+        if (!_last_warn || now - _last_warn >= kWarnIntervalUS) {
+            WarnL << "ring reader is lagging behind " << lag << " packets, skip to " << pos->seq << ", skipped " << _skip_count << " times since last warning";
+            _last_warn = now;
+            _skip_count = 0;
+        }
+        _chunk = pos->chunk;
+        _seq = pos->seq;
+        return true;
+    }
+
+    void onMessage(const toolkit::Any &data) { _msg_cb(data); }
+
+    void onDetach() const { _detach_cb(); }
+
+    toolkit::Any getInfo() const { return _get_info(); }
+
+private:
+    bool _detached = false;
+    uint64_t _seq;
+    uint64_t _last_warn = 0;
+    size_t _skip_count = 0;
+    typename Storage::Ptr _storage;
+    typename Storage::Chunk::Ptr _chunk;
+    std::function<void(const T &)> _read_cb;
+    std::function<void()> _detach_cb = []() {};
+    std::function<toolkit::Any()> _get_info = []() { return toolkit::Any(); };
+    std::function<void(const toolkit::Any &data)> _msg_cb = [](const toolkit::Any &) {};
+};
+
+/**
+ * 每个poller线程一个分发器，写入时每个线程最多只投递一个待执行任务，该任务执行时本线程所有读者一次性读完所有新数据
+ * One dispatcher per poller thread, at most one pending task is posted to each thread when writing,
+ * and all readers of this thread read all new data at once when the task is executed
+ */
+template <typename T>
+class SpmcRingDispatcher : public std::enable_shared_from_this<SpmcRingDispatcher<T>> {
+public:
+    using Ptr = std::shared_ptr<SpmcRingDispatcher>;
+    using Storage = SpmcRingStorage<T>;
+    using RingReader = SpmcRingReader<T>;
+    using onChangeInfoCB = std::function<toolkit::Any(toolkit::Any &&info)>;
+
+    SpmcRingDispatcher(toolkit::EventPoller::Ptr poller, typename Storage::Ptr storage) {
+        _poller = std::move(poller);
+        _storage = std::move(storage);
+    }
+
+    const toolkit::EventPoller::Ptr &getPoller() const { return _poller; }
+
+    /**
+     * 有新数据，在写入线程调用
+     * New data is available, called in the writer thread
+     */
+    void notify() {
+        if (!_reader_count.load() || _scheduled.exchange(true)) {
+            // 没有读者或已有待执行任务
+            // No reader or there is already a pending task
+            return;
+        }
+        std::weak_ptr<SpmcRingDispatcher> weak_self = this->shared_from_this();
+        _poller->async([weak_self]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onRead();
+            }
+        }, false);
+    }
+
+    std::shared_ptr<RingReader> attach(bool use_cache) {
+        std::weak_ptr<SpmcRingDispatcher> weak_self = this->shared_from_this();
+        auto poller = _poller;
+        auto on_dealloc = [weak_self, poller](RingReader *ptr) {
+            poller->async([weak_self, ptr]() {
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->onReaderGone();
+                }
+                delete ptr;
+            });
+        };
+        std::shared_ptr<RingReader> reader(new RingReader(_storage, _storage->startPos(use_cache)), on_dealloc);
+        _readers.emplace_back(reader);
+        ++_reader_count;
+        _storage->onSizeChanged(true);
+        return reader;
+    }
+
+    void sendMessage(const toolkit::Any &data) {
+        forEachReader([&](RingReader &reader) { reader.onMessage(data); });
+    }
+
+    void getInfoList(std::list<toolkit::Any> &ret, const onChangeInfoCB &on_change) {
+        forEachReader([&](RingReader &reader) {
+            auto info = reader.getInfo();
+            if (on_change) {
+                info = on_change(std::move(info));
+            }
+            ret.emplace_back(std::move(info));
+        });
+    }
+
+    void onDetach() {
+        forEachReader([](RingReader &reader) { reader.onDetach(); });
+    }
+
+private:
+    void onRead() {
+        // 先清除标记再读取序号，保证之后的写入会重新投递任务
+        // Clear the flag before reading the sequence number, to ensure that subsequent writes will post a new task
+        _scheduled.store(false);
+        auto end = _storage->writeSeq();
+        forEachReader([end](RingReader &reader) { reader.onRead(end); });
+    }
+
+    void onReaderGone() {
+        --_reader_count;
+        _storage->onSizeChanged(false);
+        if (!_iterating) {
+            compact();
+        }
+    }
+
+    template <typename FUNC>
+    void forEachReader(const FUNC &func) {
+        // 回调中可能增删读者，采用下标遍历并延后清理
+        // Readers may be added or removed in the callback, so iterate by index and clean up later
+        _iterating = true;
+        for (size_t i = 0; i < _readers.size(); ++i) {
+            auto reader = _readers[i].lock();
+            if (reader) {
+                func(*reader);
+            }
+        }
+        _iterating = false;
+        compact();
+    }
+
+    void compact() {
+        for (auto it = _readers.begin(); it != _readers.end();) {
+            if (it->expired()) {
+                it = _readers.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+private:
+    bool _iterating = false;
+    std::atomic<bool> _scheduled { false };
+    std::atomic<size_t> _reader_count { 0 };
+    toolkit::EventPoller::Ptr _poller;
+    typename Storage::Ptr _storage;
+    // 只在本poller线程访问
+    // Only accessed in this poller thread
+    std::vector<std::weak_ptr<RingReader>> _readers;
+};
+
+/**
+ * 单写多读环形缓冲，接口与toolkit::RingBuffer保持一致
+ * 与toolkit::RingBuffer每次写入都向各poller投递任务并各自复制gop缓存不同，
+ * 本类所有poller共享同一份不可变数据，写入只发布序号，每个poller在上次任务执行前的多次写入只投递一次任务
+ * Single-writer multi-reader ring, the interface is consistent with toolkit::RingBuffer
+ * Unlike toolkit::RingBuffer which posts a task to every poller on each write and copies the gop cache for each of them,
+ * all pollers of this class share the same immutable data, a write only publishes the sequence number,
+ * and multiple writes before the last task of a poller is executed only post one task
+ */
+template <typename T>
+class SpmcRing : public std::enable_shared_from_this<SpmcRing<T>> {
+public:
+    using Ptr = std::shared_ptr<SpmcRing>;
+    using RingReader = SpmcRingReader<T>;
+    using Storage = SpmcRingStorage<T>;
+    using Dispatcher = SpmcRingDispatcher<T>;
+    using onReaderChanged = typename Storage::onReaderChanged;
+    using onGetInfoCB = std::function<void(const std::list<toolkit::Any> &info_list)>;
+    using onChangeInfoCB = typename Dispatcher::onChangeInfoCB;
+
+    /**
+     * @param max_size gop缓存最大个数，读者落后超过该值时跳到最新的关键帧
+     * @param cb 读者个数变化回调，在读者所在poller线程触发
+     * @param max_size Max count of the gop cache, readers that fall behind more than this value jump to the latest key frame
+     * @param cb Reader count changed callback, triggered in the poller thread of the reader
+     */
+    SpmcRing(size_t max_size = 1024, onReaderChanged cb = nullptr) {
+        _storage = std::make_shared<Storage>(max_size, std::move(cb));
+        std::atomic_store(&_dispatchers, std::make_shared<const DispatcherList>());
+    }
+
+    ~SpmcRing() {
+        _storage->close();
+        auto dispatchers = std::atomic_load(&_dispatchers);
+        for (auto &dispatcher : *dispatchers) {
+            dispatcher->getPoller()->async([dispatcher]() { dispatcher->onDetach(); }, false);
+        }
+    }
+
+    /**
+     * 写入数据，只能由单个线程调用
+     * Write data, can only be called by a single thread
+     */
+    void write(T in, bool is_key = true) {
+        _storage->write(std::move(in), is_key);
+        auto version = _version.load(std::memory_order_acquire);
+        if (version != _writer_version) {
+            // 分发器列表有变化
+            // The dispatcher list has changed
+            _writer_version = version;
+            _writer_dispatchers = std::atomic_load(&_dispatchers);
+        }
+        for (auto &dispatcher : *_writer_dispatchers) {
+            dispatcher->notify();
+        }
+    }
+
+    void sendMessage(const toolkit::Any &data) {
+        auto dispatchers = std::atomic_load(&_dispatchers);
+        for (auto &dispatcher : *dispatchers) {
+            dispatcher->getPoller()->async([dispatcher, data]() { dispatcher->sendMessage(data); }, false);
+        }
+    }
+
+    /**
+     * 创建读者，必须在poller线程中调用
+     * Create a reader, must be called in the poller thread
+     */
+    std::shared_ptr<RingReader> attach(const toolkit::EventPoller::Ptr &poller, bool use_cache = true) {
+        if (!poller->isCurrentThread()) {
+            throw std::runtime_error("You can attach SpmcRing only in it's own poller thread");
+        }
+        return getDispatcher(poller)->attach(use_cache);
+    }
+
+    int readerCount() const { return _storage->readerCount(); }
+
+    /**
+     * 设置读者发送缓存满或读取落后时的回调，可能在任意poller线程触发，必须在attach前设置
+     * Set the callback when the send buffer of a reader is full or the reader falls behind,
+     * may be triggered in any poller thread, must be set before attaching
+     */
+    void setOnPressure(std::function<void()> cb) { _storage->setOnPressure(std::move(cb)); }
+
+    /**
+     * 设置延时统计对象，统计写入到读者发送完毕的耗时，必须在写入前设置
+     * Set the latency statistics object to count the time from writing to the reader finishing sending, must be set before writing
+     */
+    void setLatencyStats(LatencyStats::Ptr stats) { _storage->setLatencyStats(std::move(stats)); }
+
+    void clearCache() { _storage->clearCache(); }
+
+    void getInfoList(const onGetInfoCB &cb, const onChangeInfoCB &on_change = nullptr) {
+        if (!cb) {
+            return;
+        }
+        auto dispatchers = std::atomic_load(&_dispatchers);
+        auto info_vec = std::make_shared<std::vector<std::list<toolkit::Any>>>(dispatchers->size());
+        // 所有分发器处理完毕后触发回调
+        // Trigger the callback after all dispatchers are done
+        std::shared_ptr<void> on_done(nullptr, [cb, info_vec](void *) {
+            std::list<toolkit::Any> ret;
+            for (auto &info : *info_vec) {
+                ret.splice(ret.end(), info);
+            }
+            cb(ret);
+        });
+        size_t index = 0;
+        for (auto &dispatcher : *dispatchers) {
+            auto &info = (*info_vec)[index++];
+            dispatcher->getPoller()->async([dispatcher, &info, on_done, on_change]() { dispatcher->getInfoList(info, on_change); });
+        }
+    }
+
+private:
+    using DispatcherList = std::vector<typename Dispatcher::Ptr>;
+
+    typename Dispatcher::Ptr getDispatcher(const toolkit::EventPoller::Ptr &poller) {
+        std::lock_guard<std::mutex> lck(_mtx);
+        auto &ref = _dispatcher_map[poller.get()];
+        if (!ref) {
+            ref = std::make_shared<Dispatcher>(poller, _storage);
+            // 写时复制，写入线程无需加锁即可遍历
+            // Copy on write, the writer thread can traverse it without locking
+            auto dispatchers = std::make_shared<DispatcherList>(*std::atomic_load(&_dispatchers));
+            dispatchers->emplace_back(ref);
+            std::atomic_store(&_dispatchers, std::shared_ptr<const DispatcherList>(std::move(dispatchers)));
+            ++_version;
+        }
+        return ref;
+    }
+
+private:
+    typename Storage::Ptr _storage;
+    std::mutex _mtx;
+    std::unordered_map<toolkit::EventPoller *, typename Dispatcher::Ptr> _dispatcher_map;
+    std::shared_ptr<const DispatcherList> _dispatchers;
+    std::atomic<uint64_t> _version { 0 };
+    // 以下只在写入线程访问
+    // The following are only accessed in the writer thread
+    uint64_t _writer_version = ~0ULL;
+    std::shared_ptr<const DispatcherList> _writer_dispatchers;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_SPMC_RING_H
@@ -0,0 +1,270 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include "UdpBatchReceiver.h"
+#include "Common/config.h"
+#include "Util/ResourcePool.h"
+#if defined(__linux__) || defined(__linux)
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+static atomic<uint64_t> s_packets { 0 };
+static atomic<uint64_t> s_syscalls { 0 };
+static atomic<uint64_t> s_gro { 0 };
+
+#if defined(__linux__) || defined(__linux)
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+// 单次recvmmsg最多接收的包个数
+// Max packets received by one recvmmsg
+static constexpr size_t kMaxBatchSize = 32;
+// 开启GRO时单次recvmmsg最多接收的包个数，每个包可能包含多个分片
+// Max packets received by one recvmmsg when GRO is enabled, each packet may contain multiple segments
+static constexpr size_t kMaxGroBatchSize = 8;
+// 未开启GRO时每个包的缓存大小
+// Buffer size of each packet when GRO is disabled
+static constexpr size_t kPacketBufferSize = 2048;
+// 开启GRO时每个包的缓存大小(合并后的包最大64K)
+// Buffer size of each packet when GRO is enabled (max 64K after merging)
+static constexpr size_t kGroBufferSize = 64 * 1024;
+
+// 接收缓存从本线程的缓存池获取，同一poller上的所有接收器共享，释放后回到池中复用
+// The receive buffers are obtained from the buffer pool of this thread, shared by all receivers on the same poller, and reused after being released
+static ResourcePool<BufferRaw> &getBufferPool(bool gro) {
+    static thread_local ResourcePool<BufferRaw> s_pool[2];
+    static thread_local bool s_inited = false;
+    if (!s_inited) {
+        s_inited = true;
+        s_pool[0].setSize(kMaxBatchSize * 2);
+        s_pool[1].setSize(kMaxGroBatchSize * 2);
+    }
+    return s_pool[gro ? 1 : 0];
+}
+
+static BufferRaw::Ptr obtainBuffer(bool gro) {
+    auto ret = getBufferPool(gro).obtain2();
+    // 预留一个字节用于某些协议追加'\0'
+    // Reserve one byte for appending '\0' by some protocols
+    ret->setCapacity((gro ? kGroBufferSize : kPacketBufferSize) + 1);
+    ret->setSize(0);
+    return ret;
+}
+
+UdpBatchReceiver::Ptr UdpBatchReceiver::create(const Socket::Ptr &sock, onRecvBatch cb) {
+    GET_CONFIG(int, mode, General::kUdpBatchRecvMode);
+    if (mode == kModeSocket || sock->sockType() != SockNum::Sock_UDP || sock->rawFD() < 0) {
+        return nullptr;
+    }
+    bool gro = false;
+#if defined(UDP_GRO)
+    if (mode == kModeGro) {
+        int on = 1;
+        gro = setsockopt(sock->rawFD(), SOL_UDP, UDP_GRO, &on, sizeof(on)) == 0;
+        if (!gro) {
+            WarnL << "udp gro is not supported, fall back to recvmmsg: " << get_uv_errmsg(true);
+        }
+    }
+#endif
+    // 复制一个fd单独监听读事件，与socket对象的fd生命周期互不影响
+    // Duplicate a fd to listen to read events separately, so its lifetime is independent of the fd of the socket object
+    auto fd = dup(sock->rawFD());
+    if (fd < 0) {
+        WarnL << "dup udp socket failed: " << get_uv_errmsg(true);
+        return nullptr;
+    }
+    Ptr ret(new UdpBatchReceiver(sock->getPoller(), fd, gro, std::move(cb)));
+    weak_ptr<UdpBatchReceiver> weak_self = ret;
+    if (ret->_poller->addEvent(fd, EventPoller::Event_Read | EventPoller::Event_Error, [weak_self](int event) {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->onRead();
+            }
+        }) == -1) {
+        WarnL << "add udp batch receiver event failed: " << get_uv_errmsg(true);
+        // 析构时关闭fd
+        // Close fd when destructing
+        return nullptr;
+    }
+    // socket自身不再读取数据，避免与本对象争抢
+    // The socket itself no longer reads data, to avoid competing with this object
+    sock->enableRecv(false);
+    return ret;
+}
+
+UdpBatchReceiver::UdpBatchReceiver(EventPoller::Ptr poller, int fd, bool gro, onRecvBatch cb) {
+    _poller = std::move(poller);
+    _fd = fd;
+    _gro = gro;
+    _cb = std::move(cb);
+    _buffers.resize(gro ? kMaxGroBatchSize : kMaxBatchSize);
+    _pkts.reserve(kMaxBatchSize);
+}
+
+UdpBatchReceiver::~UdpBatchReceiver() {
+    auto fd = _fd;
+    _poller->delEvent(fd, [fd](bool) { close(fd); });
+}
+
+void UdpBatchReceiver::enableRecv(bool enabled) {
+    // 切换到poller线程执行，与onRead保持同一线程
+    // Switch to the poller thread, to be in the same thread as onRead
+    weak_ptr<UdpBatchReceiver> weak_self = shared_from_this();
+    _poller->async([weak_self, enabled]() {
+        auto strong_self = weak_self.lock();
+        if (!strong_self || strong_self->_enable_recv == enabled) {
+            return;
+        }
+        strong_self->_enable_recv = enabled;
+        strong_self->_poller->modifyEvent(strong_self->_fd, (enabled ? EventPoller::Event_Read : 0) | EventPoller::Event_Error);
+    });
+}
+
+void UdpBatchReceiver::onRead() {
+    // 读空socket缓存，一次读满说明可能还有数据
+    // Drain the socket buffer, a full batch means there may be more data
+    while (_enable_recv && readOnce() == _buffers.size()) {
+    }
+}
+
+size_t UdpBatchReceiver::readOnce() {
+    struct mmsghdr msgs[kMaxBatchSize];
+    struct iovec iov[kMaxBatchSize];
+    struct sockaddr_storage addrs[kMaxBatchSize];
+    char controls[kMaxBatchSize][CMSG_SPACE(sizeof(int))];
+    auto batch_size = _buffers.size();
+    auto buffer_size = _gro ? kGroBufferSize : kPacketBufferSize;
+    for (size_t i = 0; i < batch_size; ++i) {
+        auto &buffer = _buffers[i];
+        // 缓存只在本次读取期间持有，未用完的在返回前归还缓存池，接收器空闲时不占用内存
+        // The buffers are only held during this read, the unused ones are returned to the pool before returning, so an idle receiver occupies no memory
+        buffer = obtainBuffer(_gro);
+        iov[i].iov_base = buffer->data();
+        iov[i].iov_len = buffer_size;
+        auto &hdr = msgs[i].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = &addrs[i];
+        hdr.msg_namelen = sizeof(addrs[i]);
+        hdr.msg_iov = &iov[i];
+        hdr.msg_iovlen = 1;
+        if (_gro) {
+            hdr.msg_control = controls[i];
+            hdr.msg_controllen = sizeof(controls[i]);
+        }
+        msgs[i].msg_len = 0;
+    }
+
+    ++s_syscalls;
+    auto ret = recvmmsg(_fd, msgs, batch_size, MSG_DONTWAIT, nullptr);
+    if (ret <= 0) {
+        releaseBuffers();
+        return 0;
+    }
+
+    for (int i = 0; i < ret; ++i) {
+        auto &hdr = msgs[i].msg_hdr;
+        auto len = msgs[i].msg_len;
+        auto buffer = std::move(_buffers[i]);
+        if (hdr.msg_flags & MSG_TRUNC) {
+            // 包被截断，丢弃之
+            // The packet is truncated, drop it
+            continue;
+        }
+        buffer->setSize(len);
+
+        size_t seg_size = 0;
+#if defined(UDP_GRO)
+        for (auto cmsg = _gro ? CMSG_FIRSTHDR(&hdr) : nullptr; cmsg; cmsg = CMSG_NXTHDR(&hdr, cmsg)) {
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO) {
+                seg_size = *((int *)CMSG_DATA(cmsg));
+                break;
+            }
+        }
+#endif
+        if (!seg_size || seg_size >= len) {
+            if (_gro && len <= kPacketBufferSize) {
+                // 未被合并的小包拷贝到小缓存中，避免上层持有该包期间占用64K的缓存
+                // Copy the small packet that is not merged into a small buffer, to avoid occupying the 64K buffer while the upper layer holds it
+                auto small = obtainBuffer(false);
+                memcpy(small->data(), buffer->data(), len);
+                small->setSize(len);
+                buffer = std::move(small);
+            }
+            _pkts.emplace_back();
+            auto &pkt = _pkts.back();
+            pkt.buffer = std::move(buffer);
+            memcpy(&pkt.addr, &addrs[i], hdr.msg_namelen);
+            pkt.addr_len = hdr.msg_namelen;
+            continue;
+        }
+
+        // 拆分GRO合并的包，各分片共享同一块内存(不拷贝)，所有分片释放后该内存回到缓存池
+        // Split the packet merged by GRO, all segments share the same memory (without copying), which returns to the pool after all segments are released
+        Buffer::Ptr whole = std::move(buffer);
+        for (size_t offset = 0; offset < len; offset += seg_size) {
+            _pkts.emplace_back();
+            auto &pkt = _pkts.back();
+            pkt.buffer = std::make_shared<BufferOffset<Buffer::Ptr>>(whole, offset, MIN(seg_size, len - offset));
+            memcpy(&pkt.addr, &addrs[i], hdr.msg_namelen);
+            pkt.addr_len = hdr.msg_namelen;
+            ++s_gro;
+        }
+    }
+    releaseBuffers();
+    s_packets += _pkts.size();
+    if (!_pkts.empty()) {
+        _cb(_pkts);
+        _pkts.clear();
+    }
+    return ret;
+}
+
+void UdpBatchReceiver::releaseBuffers() {
+    for (auto &buffer : _buffers) {
+        buffer = nullptr;
+    }
+}
+
+#else
+
+UdpBatchReceiver::Ptr UdpBatchReceiver::create(const Socket::Ptr &sock, onRecvBatch cb) {
+    return nullptr;
+}
+
+UdpBatchReceiver::UdpBatchReceiver(EventPoller::Ptr poller, int fd, bool gro, onRecvBatch cb) {}
+UdpBatchReceiver::~UdpBatchReceiver() {}
+void UdpBatchReceiver::enableRecv(bool enabled) {}
+void UdpBatchReceiver::onRead() {}
+size_t UdpBatchReceiver::readOnce() { return 0; }
+void UdpBatchReceiver::releaseBuffers() {}
+
+#endif // defined(__linux__) || defined(__linux)
+
+UdpBatchReceiver::Statistic UdpBatchReceiver::getStatistic() {
+    Statistic ret;
+    ret.packets = s_packets.load();
+    ret.syscalls = s_syscalls.load();
+    ret.gro = s_gro.load();
+    return ret;
+}
+
+} // namespace mediakit
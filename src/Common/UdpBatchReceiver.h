@@ -0,0 +1,113 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_UDP_BATCH_RECEIVER_H
+#define ZLMEDIAKIT_UDP_BATCH_RECEIVER_H
+
+#include <vector>
+#include <functional>
+#include "Network/Socket.h"
+
+namespace mediakit {
+
+/**
+ * udp批量接收
+ * 接管udp socket的读事件，通过recvmmsg一次系统调用读取多个包，并把整批包(含对端地址)一次性回调给上层，
+ * 开启GRO后内核会把同一对端的多个包合并为一个大包，在此按分片长度拆分(不拷贝)，
+ * 接收缓存来自线程级缓存池，回调返回后上层可以继续持有(包括跨线程)，释放后自动回收
+ * UDP batch receiving
+ * Take over the read event of the udp socket, read multiple packets with one recvmmsg system call, and call back the whole batch (with peer addresses) to the upper layer at once,
+ * after enabling GRO, the kernel merges multiple packets from the same peer into one big packet, which is split by segment length here (without copying),
+ * the receive buffers come from a thread level pool, the upper layer can keep holding them after the callback (even across threads), and they are recycled automatically after being released
+ */
+class UdpBatchReceiver : public std::enable_shared_from_this<UdpBatchReceiver> {
+public:
+    using Ptr = std::shared_ptr<UdpBatchReceiver>;
+
+    enum Mode {
+        // 使用socket自身的接收
+        // Use the receiving of the socket itself
+        kModeSocket = 0,
+        // 使用recvmmsg批量接收
+        // Receive in batch via recvmmsg
+        kModeMMsg = 1,
+        // 使用recvmmsg批量接收，并启用GRO
+        // Receive in batch via recvmmsg, and enable GRO
+        kModeGro = 2,
+    };
+
+    class Packet {
+    public:
+        toolkit::Buffer::Ptr buffer;
+        struct sockaddr_storage addr;
+        socklen_t addr_len;
+    };
+
+    using onRecvBatch = std::function<void(std::vector<Packet> &pkts)>;
+
+    class Statistic {
+    public:
+        // 通过批量接收路径收到的包个数
+        // Packets received via the batch receiving path
+        uint64_t packets = 0;
+        // 批量接收路径的系统调用次数
+        // System calls of the batch receiving path
+        uint64_t syscalls = 0;
+        // 被GRO合并的包个数
+        // Packets merged by GRO
+        uint64_t gro = 0;
+    };
+
+    /**
+     * 创建批量接收器，创建后sock自身不再接收数据，该对象销毁后需要调用者自行恢复
+     * @param sock udp socket
+     * @param cb 收到一批数据的回调，在sock所在poller线程触发
+     * @return 未开启批量接收或非linux平台时返回nullptr
+     * Create a batch receiver, the sock itself no longer receives data after creation, the caller needs to restore it after this object is destroyed
+     * @param sock udp socket
+     * @param cb Callback of receiving a batch of data, triggered in the poller thread of sock
+     * @return nullptr if batch receiving is not enabled or not on linux
+     */
+    static Ptr create(const toolkit::Socket::Ptr &sock, onRecvBatch cb);
+
+    ~UdpBatchReceiver();
+
+    /**
+     * 开启或暂停接收
+     * Enable or pause receiving
+     */
+    void enableRecv(bool enabled);
+
+    /**
+     * 获取批量接收统计信息
+     * Get batch receiving statistics
+     */
+    static Statistic getStatistic();
+
+private:
+    UdpBatchReceiver(toolkit::EventPoller::Ptr poller, int fd, bool gro, onRecvBatch cb);
+    void onRead();
+    size_t readOnce();
+    void releaseBuffers();
+
+private:
+    bool _gro;
+    bool _enable_recv = true;
+    int _fd;
+    onRecvBatch _cb;
+    toolkit::EventPoller::Ptr _poller;
+    std::vector<Packet> _pkts;
+    // 本次读取使用的接收缓存，读取结束后清空
+    // Receive buffers used by the current read, cleared after reading
+    std::vector<toolkit::BufferRaw::Ptr> _buffers;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_UDP_BATCH_RECEIVER_H
@@ -0,0 +1,231 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include "UdpBatchSender.h"
+#include "Common/config.h"
+#if defined(__linux__) || defined(__linux)
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#endif
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+static atomic<uint64_t> s_packets { 0 };
+static atomic<uint64_t> s_syscalls { 0 };
+static atomic<uint64_t> s_gso { 0 };
+static atomic<uint64_t> s_fallback { 0 };
+static atomic<uint64_t> s_errors { 0 };
+
+#if defined(__linux__) || defined(__linux)
+
+#ifndef SOL_UDP
+#define SOL_UDP 17
+#endif
+
+static constexpr size_t kMaxBatchSize = UdpBatchSender::kMaxBatchSize;
+// 单次GSO最多合并的分片个数(内核UDP_MAX_SEGMENTS)
+// Max segments merged by one GSO (kernel UDP_MAX_SEGMENTS)
+static constexpr size_t kMaxGsoSegments = 64;
+// 单次GSO最多发送的字节数(需小于ip包最大长度)
+// Max bytes sent by one GSO (must be less than the max length of an ip packet)
+static constexpr size_t kMaxGsoBytes = 65000;
+
+#if defined(UDP_SEGMENT)
+// 网卡或内核不支持GSO时关闭之
+// Disable GSO when the network card or kernel does not support it
+static atomic<bool> s_gso_supported { true };
+
+// 从index开始，统计可以通过一次GSO发送的包个数
+// Count the packets that can be sent by one GSO starting from index
+static size_t gsoCount(const vector<Buffer::Ptr> &pkts, size_t index) {
+    auto seg_size = pkts[index]->size();
+    size_t bytes = 0;
+    size_t count = 0;
+    for (auto i = index; i < pkts.size() && count < kMaxGsoSegments; ++i) {
+        auto size = pkts[i]->size();
+        if (size > seg_size || bytes + size > kMaxGsoBytes) {
+            break;
+        }
+        bytes += size;
+        ++count;
+        if (size < seg_size) {
+            // 只有最后一个分片可以比其他分片短
+            // Only the last segment can be shorter than the others
+            break;
+        }
+    }
+    return count;
+}
+
+// 返回-1代表需要回退到sendmmsg
+// Return -1 means fall back to sendmmsg
+static ssize_t sendGso(int fd, const vector<Buffer::Ptr> &pkts, size_t index, size_t count, const struct sockaddr *addr, socklen_t addr_len) {
+    struct iovec iov[kMaxGsoSegments];
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = pkts[index + i]->data();
+        iov[i].iov_len = pkts[index + i]->size();
+    }
+    char control[CMSG_SPACE(sizeof(uint16_t))] = { 0 };
+    struct msghdr msg = { 0 };
+    msg.msg_name = (void *)addr;
+    msg.msg_namelen = addr_len;
+    msg.msg_iov = iov;
+    msg.msg_iovlen = count;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+
+    auto cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_UDP;
+    cmsg->cmsg_type = UDP_SEGMENT;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+    *((uint16_t *)CMSG_DATA(cmsg)) = (uint16_t)pkts[index]->size();
+
+    ++s_syscalls;
+    auto ret = ::sendmsg(fd, &msg, 0);
+    if (ret >= 0) {
+        ++s_gso;
+        return count;
+    }
+    ++s_errors;
+    if (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT || errno == EOPNOTSUPP) {
+        // 网卡不支持校验和卸载或内核版本过低
+        // The network card does not support checksum offload or the kernel version is too low
+        if (s_gso_supported.exchange(false)) {
+            WarnL << "udp gso is not supported, fall back to sendmmsg: " << get_uv_errmsg(true);
+        }
+        return -1;
+    }
+    return 0;
+}
+#endif // defined(UDP_SEGMENT)
+
+static size_t sendMMsg(int fd, const vector<Buffer::Ptr> &pkts, size_t index, size_t count, const struct sockaddr *addr, socklen_t addr_len) {
+    struct mmsghdr msgs[kMaxBatchSize];
+    struct iovec iov[kMaxBatchSize];
+    count = MIN(count, kMaxBatchSize);
+    for (size_t i = 0; i < count; ++i) {
+        iov[i].iov_base = pkts[index + i]->data();
+        iov[i].iov_len = pkts[index + i]->size();
+        auto &hdr = msgs[i].msg_hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_name = (void *)addr;
+        hdr.msg_namelen = addr_len;
+        hdr.msg_iov = &iov[i];
+        hdr.msg_iovlen = 1;
+    }
+    ++s_syscalls;
+    auto ret = ::sendmmsg(fd, msgs, count, 0);
+    if (ret <= 0) {
+        ++s_errors;
+        return 0;
+    }
+    return ret;
+}
+
+// 返回成功发送的包个数，遇到socket缓存满等情况时提前返回
+// Return the number of packets sent successfully, return early when the socket buffer is full, etc.
+static size_t sendBatch(int fd, const vector<Buffer::Ptr> &pkts, const struct sockaddr *addr, socklen_t addr_len, bool gso) {
+    size_t sent = 0;
+    while (sent < pkts.size()) {
+        size_t count = pkts.size() - sent;
+#if defined(UDP_SEGMENT)
+        if (gso && s_gso_supported) {
+            auto gso_count = gsoCount(pkts, sent);
+            if (gso_count > 1) {
+                auto ret = sendGso(fd, pkts, sent, gso_count, addr, addr_len);
+                if (ret > 0) {
+                    sent += ret;
+                    continue;
+                }
+                if (ret == 0) {
+                    break;
+                }
+            } else {
+                // 该包无法与后续包合并，单独发送
+                // This packet cannot be merged with subsequent packets, send it separately
+                count = 1;
+            }
+        }
+#endif
+        count = MIN(count, kMaxBatchSize);
+        auto ret = sendMMsg(fd, pkts, sent, count, addr, addr_len);
+        sent += ret;
+        if (ret < count) {
+            break;
+        }
+    }
+    s_packets += sent;
+    return sent;
+}
+
+#endif // defined(__linux__) || defined(__linux)
+
+void UdpBatchSender::send(const Socket::Ptr &sock, vector<Buffer::Ptr> &pkts, const struct sockaddr *addr, socklen_t addr_len) {
+    if (pkts.empty()) {
+        return;
+    }
+    size_t sent = 0;
+#if defined(__linux__) || defined(__linux)
+    GET_CONFIG(int, mode, General::kUdpBatchSendMode);
+    if (mode != kModeSocket && sock->sockType() == SockNum::Sock_UDP) {
+        // 先清空socket发送队列，保证发送顺序
+        // Flush the socket send queue first to ensure the sending order
+        sock->flushAll();
+        auto fd = sock->rawFD();
+        auto dst = addr;
+        auto dst_len = addr_len;
+        struct sockaddr_storage peer_addr;
+        if (!dst) {
+            // 软绑定(bindPeerAddr soft_bind)的socket并未connect，对端地址只保存在Socket对象中，sendmmsg需要显式指定目标地址
+            // The socket soft bound by bindPeerAddr is not connected, the peer address is only kept in the Socket object,
+            // so sendmmsg must specify the target address explicitly
+            auto peer_ip = sock->get_peer_ip();
+            auto peer_port = sock->get_peer_port();
+            if (!peer_ip.empty() && peer_port) {
+                peer_addr = SockUtil::make_sockaddr(peer_ip.data(), peer_port);
+                dst = (struct sockaddr *)&peer_addr;
+                dst_len = SockUtil::get_sock_len(dst);
+            }
+        }
+        if (fd >= 0 && dst && !sock->isSocketBusy()) {
+            sent = sendBatch(fd, pkts, dst, dst_len, mode == kModeGso);
+        }
+        s_fallback += pkts.size() - sent;
+    }
+#endif
+    if (sent < pkts.size()) {
+        // 剩余的包交给socket发送队列，由其处理发送失败与重试
+        // The remaining packets are handed over to the socket send queue, which handles send failures and retries
+        auto size = pkts.size();
+        for (auto i = sent; i < size; ++i) {
+            sock->send(std::move(pkts[i]), (struct sockaddr *)addr, addr_len, i + 1 == size);
+        }
+    }
+    pkts.clear();
+}
+
+UdpBatchSender::Statistic UdpBatchSender::getStatistic() {
+    Statistic ret;
+    ret.packets = s_packets.load();
+    ret.syscalls = s_syscalls.load();
+    ret.gso = s_gso.load();
+    ret.fallback = s_fallback.load();
+    ret.errors = s_errors.load();
+    return ret;
+}
+
+} // namespace mediakit
@@ -0,0 +1,86 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_UDP_BATCH_SENDER_H
+#define ZLMEDIAKIT_UDP_BATCH_SENDER_H
+
+#include <vector>
+#include "Network/Socket.h"
+
+namespace mediakit {
+
+/**
+ * udp批量发送
+ * 把一次刷新(PacketCache::onFlush)的多个udp包通过sendmmsg一次系统调用发送出去，
+ * 如果连续多个包发往同一个对端且长度相同(最后一个包可以更短)，则通过UDP_SEGMENT(GSO)合并为一次sendmsg
+ * UDP batch sending
+ * Send multiple udp packets of one flush (PacketCache::onFlush) with one sendmmsg system call,
+ * if several consecutive packets are sent to the same peer with the same length (the last one can be shorter), they are merged into one sendmsg via UDP_SEGMENT (GSO)
+ */
+class UdpBatchSender {
+public:
+    enum Mode {
+        // 使用socket自身的发送队列
+        // Use the send queue of the socket itself
+        kModeSocket = 0,
+        // 使用sendmmsg批量发送
+        // Send in batch via sendmmsg
+        kModeMMsg = 1,
+        // 使用sendmmsg批量发送，并对等长包启用GSO
+        // Send in batch via sendmmsg, and enable GSO for packets of equal length
+        kModeGso = 2,
+    };
+
+    // 单次sendmmsg最多发送的包个数，调用方缓存的包个数达到该值时即可发送
+    // Max packets sent by one sendmmsg, the caller can send once the cached packets reach this count
+    enum { kMaxBatchSize = 64 };
+
+    class Statistic {
+    public:
+        // 通过批量发送路径发送的包个数
+        // Packets sent via the batch sending path
+        uint64_t packets = 0;
+        // 批量发送路径的系统调用次数
+        // System calls of the batch sending path
+        uint64_t syscalls = 0;
+        // 采用GSO发送的次数
+        // Times of sending via GSO
+        uint64_t gso = 0;
+        // 因socket繁忙等原因回退到socket发送队列的包个数
+        // Packets that fall back to the socket send queue due to socket busy, etc.
+        uint64_t fallback = 0;
+        // 批量发送系统调用失败的次数
+        // Failed system calls of the batch sending path
+        uint64_t errors = 0;
+    };
+
+    /**
+     * 批量发送udp包，发送后清空pkts
+     * @param sock udp socket
+     * @param pkts 待发送的包
+     * @param addr 目标地址，为nullptr时发往socket绑定的对端(包括软绑定)
+     * @param addr_len 目标地址长度
+     * Send udp packets in batch, pkts will be cleared after sending
+     * @param sock udp socket
+     * @param pkts Packets to be sent
+     * @param addr Target address, nullptr means the peer bound by the socket (including soft bound)
+     * @param addr_len Target address length
+     */
+    static void send(const toolkit::Socket::Ptr &sock, std::vector<toolkit::Buffer::Ptr> &pkts, const struct sockaddr *addr = nullptr, socklen_t addr_len = 0);
+
+    /**
+     * 获取批量发送统计信息
+     * Get batch sending statistics
+     */
+    static Statistic getStatistic();
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_UDP_BATCH_SENDER_H
@@ -97,6 +97,9 @@ const string kMaxStreamWaitTimeMS = GENERAL_FIELD "maxStreamWaitMS";
 const string kEnableVhost = GENERAL_FIELD "enableVhost";
 const string kResetWhenRePlay = GENERAL_FIELD "resetWhenRePlay";
 const string kMergeWriteMS = GENERAL_FIELD "mergeWriteMS";
+const string kMergeWriteAdaptive = GENERAL_FIELD "mergeWriteAdaptive";
+const string kMergeWriteMaxMS = GENERAL_FIELD "mergeWriteMaxMS";
+const string kMergeWriteAdaptiveReaders = GENERAL_FIELD "mergeWriteAdaptiveReaders";
 const string kCheckNvidiaDev = GENERAL_FIELD "check_nvidia_dev";
 const string kEnableFFmpegLog = GENERAL_FIELD "enable_ffmpeg_log";
 const string kWaitTrackReadyMS = GENERAL_FIELD "wait_track_ready_ms";
@@ -105,6 +108,10 @@ const string kWaitAddTrackMS = GENERAL_FIELD "wait_add_track_ms";
 const string kUnreadyFrameCache = GENERAL_FIELD "unready_frame_cache";
 const string kBroadcastPlayerCountChanged = GENERAL_FIELD "broadcast_player_count_changed";
 const string kListenIP = GENERAL_FIELD "listen_ip";
+const string kUdpBatchSendMode = GENERAL_FIELD "udp_batch_send_mode";
+const string kUdpBatchRecvMode = GENERAL_FIELD "udp_batch_recv_mode";
+const string kLatencyStats = GENERAL_FIELD "latency_stats";
+const string kTSStreamDemux = GENERAL_FIELD "ts_stream_demux";
 
 static onceToken token([]() {
     mINI::Instance()[kFlowThreshold] = 1024;
@@ -113,6 +120,9 @@ static onceToken token([]() {
     mINI::Instance()[kEnableVhost] = 0;
     mINI::Instance()[kResetWhenRePlay] = 1;
     mINI::Instance()[kMergeWriteMS] = 0;
+    mINI::Instance()[kMergeWriteAdaptive] = 0;
+    mINI::Instance()[kMergeWriteMaxMS] = 100;
+    mINI::Instance()[kMergeWriteAdaptiveReaders] = 32;
     mINI::Instance()[kMediaServerId] = makeRandStr(16);
     mINI::Instance()[kCheckNvidiaDev] = 1;
     mINI::Instance()[kEnableFFmpegLog] = 0;
@@ -122,6 +132,10 @@ static onceToken token([]() {
     mINI::Instance()[kUnreadyFrameCache] = 100;
     mINI::Instance()[kBroadcastPlayerCountChanged] = 0;
     mINI::Instance()[kListenIP] = "::";
+    mINI::Instance()[kUdpBatchSendMode] = 0;
+    mINI::Instance()[kUdpBatchRecvMode] = 0;
+    mINI::Instance()[kLatencyStats] = 0;
+    mINI::Instance()[kTSStreamDemux] = 0;
 });
 
 } // namespace General
@@ -133,6 +147,8 @@ const string kAddMuteAudio = string(kFieldName) + "add_mute_audio";
 const string kAutoClose = string(kFieldName) + "auto_close";
 const string kContinuePushMS = string(kFieldName) + "continue_push_ms";
 const string kPacedSenderMS = string(kFieldName) + "paced_sender_ms";
+const string kGopCacheMaxKB = string(kFieldName) + "gop_cache_max_kb";
+const string kMuxerThreads = string(kFieldName) + "muxer_threads";
 
 const string kEnableHls = string(kFieldName) + "enable_hls";
 const string kEnableHlsFmp4 = string(kFieldName) + "enable_hls_fmp4";
@@ -160,6 +176,8 @@ static onceToken token([]() {
     mINI::Instance()[kAddMuteAudio] = 1;
     mINI::Instance()[kContinuePushMS] = 15000;
     mINI::Instance()[kPacedSenderMS] = 0;
+    mINI::Instance()[kGopCacheMaxKB] = 0;
+    mINI::Instance()[kMuxerThreads] = 0;
     mINI::Instance()[kAutoClose] = 0;
 
     mINI::Instance()[kEnableHls] = 1;
@@ -268,12 +286,14 @@ const string kHandshakeSecond = RTMP_FIELD "handshakeSecond";
 const string kKeepAliveSecond = RTMP_FIELD "keepAliveSecond";
 const string kDirectProxy = RTMP_FIELD "directProxy";
 const string kEnhanced = RTMP_FIELD "enhanced";
+const string kPacketPoolSize = RTMP_FIELD "packetPoolSize";
 
 static onceToken token([]() {
     mINI::Instance()[kHandshakeSecond] = 15;
     mINI::Instance()[kKeepAliveSecond] = 15;
     mINI::Instance()[kDirectProxy] = 1;
     mINI::Instance()[kEnhanced] = 1;
+    mINI::Instance()[kPacketPoolSize] = 256;
 });
 } // namespace Rtmp
 
@@ -290,6 +310,8 @@ const string kAudioMtuSize = RTP_FIELD "audioMtuSize";
 const string kRtpMaxSize = RTP_FIELD "rtpMaxSize";
 const string kLowLatency = RTP_FIELD "lowLatency";
 const string kH264StapA = RTP_FIELD "h264_stap_a";
+const string kPacketPoolSize = RTP_FIELD "packetPoolSize";
+const string kZeroCopyFu = RTP_FIELD "zeroCopyFu";
 
 static onceToken token([]() {
     mINI::Instance()[kVideoMtuSize] = 1400;
@@ -297,6 +319,8 @@ static onceToken token([]() {
     mINI::Instance()[kRtpMaxSize] = 10;
     mINI::Instance()[kLowLatency] = 0;
     mINI::Instance()[kH264StapA] = 1;
+    mINI::Instance()[kPacketPoolSize] = 1024;
+    mINI::Instance()[kZeroCopyFu] = 0;
 });
 } // namespace Rtp
 
@@ -386,6 +410,8 @@ const string kGopCache = RTP_PROXY_FIELD "gop_cache";
 const string kRtpG711DurMs = RTP_PROXY_FIELD "rtp_g711_dur_ms";
 const string kUdpRecvSocketBuffer = RTP_PROXY_FIELD "udp_recv_socket_buffer";
 const std::string kMergeFrame = RTP_PROXY_FIELD "merge_frame";
+const std::string kMultiplexShard = RTP_PROXY_FIELD "multiplex_shard";
+const std::string kPSStreamDemux = RTP_PROXY_FIELD "ps_stream_demux";
 
 static onceToken token([]() {
     mINI::Instance()[kDumpDir] = "";
@@ -399,6 +425,8 @@ static onceToken token([]() {
     mINI::Instance()[kRtpG711DurMs] = 100;
     mINI::Instance()[kUdpRecvSocketBuffer] = 4 * 1024 * 1024;
     mINI::Instance()[kMergeFrame] = 1;
+    mINI::Instance()[kMultiplexShard] = 0;
+    mINI::Instance()[kPSStreamDemux] = 0;
 });
 } // namespace RtpProxy
 
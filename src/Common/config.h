@@ -242,6 +242,15 @@ extern const std::string kResetWhenRePlay;
 // 开启后会同时关闭TCP_NODELAY并开启MSG_MORE  [AUTO-TRANSLATED:953b82cf]
 // When enabled, TCP_NODELAY will be closed and MSG_MORE will be enabled at the same time
 extern const std::string kMergeWriteMS;
+// 是否根据播放器个数与发送缓存压力自适应调整合并写时长，开启后mergeWriteMS将被忽略
+// Whether to adjust the merge write duration adaptively according to the number of players and the send buffer pressure, mergeWriteMS is ignored when enabled
+extern const std::string kMergeWriteAdaptive;
+// 自适应合并写的最大时长(单位毫秒)，播放器个数达到mergeWriteAdaptiveReaders或发送缓存有压力时采用该值
+// Max duration of adaptive merge write (unit milliseconds), used when the number of players reaches mergeWriteAdaptiveReaders or the send buffer is under pressure
+extern const std::string kMergeWriteMaxMS;
+// 自适应合并写达到最大时长的播放器个数
+// Number of players at which adaptive merge write reaches the max duration
+extern const std::string kMergeWriteAdaptiveReaders;
 // 在docker环境下，不能通过英伟达驱动是否存在来判断是否支持硬件转码  [AUTO-TRANSLATED:de678431]
 // In the docker environment, the existence of the NVIDIA driver cannot be used to determine whether hardware transcoding is supported
 extern const std::string kCheckNvidiaDev;
@@ -268,6 +277,18 @@ extern const std::string kBroadcastPlayerCountChanged;
 // 绑定的本地网卡ip  [AUTO-TRANSLATED:daa90832]
 // Bound local network card ip
 extern const std::string kListenIP;
+// udp批量发送模式，0: 使用socket发送队列，1: sendmmsg批量发送，2: sendmmsg批量发送并对等长包启用GSO(UDP_SEGMENT)，仅linux有效
+// Udp batch sending mode, 0: use the socket send queue, 1: send in batch via sendmmsg, 2: sendmmsg and GSO (UDP_SEGMENT) for packets of equal length, linux only
+extern const std::string kUdpBatchSendMode;
+// udp批量接收模式，0: 使用socket自身的接收，1: recvmmsg批量接收，2: recvmmsg批量接收并启用GRO(UDP_GRO)，仅linux有效
+// Udp batch receiving mode, 0: use the receiving of the socket itself, 1: receive in batch via recvmmsg, 2: recvmmsg and GRO (UDP_GRO), linux only
+extern const std::string kUdpBatchRecvMode;
+// 是否统计每个流热点路径各阶段的延时直方图，可通过getLatencyStats接口获取
+// Whether to collect latency histograms of each hot path stage of each stream, which can be obtained through the getLatencyStats api
+extern const std::string kLatencyStats;
+// 是否使用增量式ts解析器(按188字节对齐批量解析，pid索引表跳过未选中的pid，PES组装到池化缓存)；关闭时使用media-server的ts解复用器
+// Whether to use the incremental ts parser (parses in 188-byte aligned batches, skips the unselected pids through the pid index table, assembles PES into pooled buffers); use the ts demuxer of media-server when disabled
+extern const std::string kTSStreamDemux;
 } // namespace General
 
 namespace Protocol {
@@ -296,6 +317,16 @@ extern const std::string kContinuePushMS;
 // 该配置开启后可以解决一些流发送不平滑导致zlmediakit转发也不平滑的问题  [AUTO-TRANSLATED:0f2b1657]
 // Enabling this configuration can solve some problems where the stream is not sent smoothly, resulting in ZLMediaKit forwarding not being smooth
 extern const std::string kPacedSenderMS;
+// 按需转协议共享gop缓存的最大大小，单位KB，置0则关闭
+// 开启后按需转协议(rtsp/rtmp/ts/fmp4)在无人观看时不生成数据，有播放器加入时从共享gop缓存补发数据实现秒开
+// Max size of the shared gop cache for on-demand protocols in KB, set to 0 to disable
+// When enabled, on-demand protocols (rtsp/rtmp/ts/fmp4) generate no data without players, and the shared gop cache is replayed when a player joins to achieve instant playback
+extern const std::string kGopCacheMaxKB;
+// 各协议复用器(rtsp/rtmp/ts/fmp4/hls/mp4)分散到的线程数，置0则关闭
+// 开启后各协议复用器分别在独立线程复用，帧通过无锁队列投递，单个协议内帧顺序不变
+// Number of threads the protocol muxers (rtsp/rtmp/ts/fmp4/hls/mp4) are spread over, set to 0 to disable
+// When enabled, each protocol muxer runs in its own thread and frames are delivered through lock-free queues, the frame order within a protocol is unchanged
+extern const std::string kMuxerThreads;
 
 // 是否开启转换为hls(mpegts)  [AUTO-TRANSLATED:bfc1167a]
 // Whether to enable conversion to HLS (MPEGTS)
@@ -442,6 +473,9 @@ extern const std::string kDirectProxy;
 // h265-rtmp是否采用增强型(或者国内扩展)  [AUTO-TRANSLATED:4a52d042]
 // Whether h265-rtmp uses enhanced (or domestic extension)
 extern const std::string kEnhanced;
+// 每个线程rtmp包对象池最多缓存的空闲包个数，置0则关闭对象池
+// Max free rtmp packets cached by the object pool of each thread, set to 0 to disable the object pool
+extern const std::string kPacketPoolSize;
 } // namespace Rtmp
 
 // //////////RTP配置///////////  [AUTO-TRANSLATED:23cbcb86]
@@ -462,6 +496,12 @@ extern const std::string kLowLatency;
 // H264 rtp打包模式是否采用stap-a模式(为了在老版本浏览器上兼容webrtc)还是采用Single NAL unit packet per H.264 模式  [AUTO-TRANSLATED:30632378]
 // Whether H264 RTP packaging mode uses stap-a mode (for compatibility with webrtc on older browsers) or Single NAL unit packet per H.264 mode
 extern const std::string kH264StapA;
+// 每个线程rtp包对象池最多缓存的空闲包个数，置0则关闭对象池
+// Max free rtp packets cached by the object pool of each thread, set to 0 to disable the object pool
+extern const std::string kPacketPoolSize;
+// h264/h265 FU分片是否零拷贝引用帧数据，rtsp over tcp播放时由socket聚合发送头部与负载
+// Whether the h264/h265 FU fragments reference the frame data with zero copy, the header and payload are gathered by the socket when playing rtsp over tcp
+extern const std::string kZeroCopyFu;
 } // namespace Rtp
 
 // //////////组播配置///////////  [AUTO-TRANSLATED:dc39b9d6]
@@ -574,6 +614,12 @@ extern const std::string kRtpG711DurMs;
 extern const std::string kUdpRecvSocketBuffer;
 // ps/ts解析后是否等待下一帧以判断本帧是否完整，开启后提高兼容性，但是可能增加延时
 extern const std::string kMergeFrame;
+// 单端口多路复用模式是否按ssrc分片到所有poller线程处理(SO_REUSEPORT)，适合大量ssrc来自同一对端的场景
+// Whether to process by ssrc shards across all poller threads in single-port multiplex mode (SO_REUSEPORT), suitable for many ssrcs from the same peer
+extern const std::string kMultiplexShard;
+// 是否使用流式ps解析器，直接解析rtp负载并引用rtp缓存，每帧只拷贝一次；关闭时使用media-server的ps解复用器
+// Whether to use the streaming ps parser, which parses the rtp payload directly and references the rtp buffers, copying only once per frame; use the ps demuxer of media-server when disabled
+extern const std::string kPSStreamDemux;
 } // namespace RtpProxy
 
 /**
@@ -0,0 +1,156 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cstdint>
+#include "StartCode.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ENABLE_STARTCODE_SSE2
+#include <emmintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+// gcc/clang可以通过target属性单独编译avx2函数，无需全局开启-mavx2
+// gcc/clang can compile the avx2 function separately with the target attribute, without enabling -mavx2 globally
+#define ENABLE_STARTCODE_AVX2
+#include <immintrin.h>
+#endif
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define ENABLE_STARTCODE_NEON
+#include <arm_neon.h>
+#endif
+
+namespace mediakit {
+
+const char *findStartCodeScalar(const char *ptr, const char *end) {
+    auto p = (const uint8_t *)ptr;
+    auto e = (const uint8_t *)end;
+    while (e - p >= 3) {
+        if (p[2] > 1) {
+            // p, p+1, p+2开始都不可能是起始码
+            // It is impossible for a start code to begin at p, p+1 or p+2
+            p += 3;
+        } else if (p[2] == 0) {
+            ++p;
+        } else if (p[1] || p[0]) {
+            // p[2]为1但前两个字节不全为0
+            // p[2] is 1 but the first two bytes are not all zero
+            p += 3;
+        } else {
+            return (const char *)p;
+        }
+    }
+    return nullptr;
+}
+
+#if defined(ENABLE_STARTCODE_SSE2)
+// 一次比较16个起始位置，需要往后多读2个字节
+// Compare 16 start positions at a time, 2 more bytes need to be read
+static const char *findStartCodeSSE2(const char *ptr, const char *end) {
+    auto p = ptr;
+    const auto zero = _mm_setzero_si128();
+    const auto one = _mm_set1_epi8(1);
+    while (end - p >= 16 + 2) {
+        auto b0 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), zero);
+        auto b1 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 1)), zero);
+        auto b2 = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + 2)), one);
+        if (_mm_movemask_epi8(_mm_and_si128(_mm_and_si128(b0, b1), b2))) {
+            // 本块内必有起始码，交给纯c实现定位第一个
+            // There must be a start code in this block, let the pure c implementation locate the first one
+            return findStartCodeScalar(p, p + 16 + 2);
+        }
+        p += 16;
+    }
+    return findStartCodeScalar(p, end);
+}
+#endif
+
+#if defined(ENABLE_STARTCODE_AVX2)
+__attribute__((target("avx2"))) static const char *findStartCodeAVX2(const char *ptr, const char *end) {
+    auto p = ptr;
+    const auto zero = _mm256_setzero_si256();
+    const auto one = _mm256_set1_epi8(1);
+    while (end - p >= 32 + 2) {
+        auto b0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), zero);
+        auto b1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 1)), zero);
+        auto b2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 2)), one);
+        if (_mm256_movemask_epi8(_mm256_and_si256(_mm256_and_si256(b0, b1), b2))) {
+            return findStartCodeScalar(p, p + 32 + 2);
+        }
+        p += 32;
+    }
+    return findStartCodeSSE2(p, end);
+}
+#endif
+
+#if defined(ENABLE_STARTCODE_NEON)
+static const char *findStartCodeNEON(const char *ptr, const char *end) {
+    auto p = (const uint8_t *)ptr;
+    auto e = (const uint8_t *)end;
+    const auto zero = vdupq_n_u8(0);
+    const auto one = vdupq_n_u8(1);
+    while (e - p >= 16 + 2) {
+        auto b0 = vceqq_u8(vld1q_u8(p), zero);
+        auto b1 = vceqq_u8(vld1q_u8(p + 1), zero);
+        auto b2 = vceqq_u8(vld1q_u8(p + 2), one);
+        if (vmaxvq_u8(vandq_u8(vandq_u8(b0, b1), b2))) {
+            return findStartCodeScalar((const char *)p, (const char *)p + 16 + 2);
+        }
+        p += 16;
+    }
+    return findStartCodeScalar((const char *)p, end);
+}
+#endif
+
+using FindStartCodeFunc = const char *(*)(const char *, const char *);
+
+struct StartCodeKernel {
+    FindStartCodeFunc func;
+    const char *name;
+};
+
+static StartCodeKernel selectKernel() {
+#if defined(ENABLE_STARTCODE_AVX2)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return { findStartCodeAVX2, "avx2" };
+    }
+#endif
+#if defined(ENABLE_STARTCODE_SSE2)
+    return { findStartCodeSSE2, "sse2" };
+#elif defined(ENABLE_STARTCODE_NEON)
+    return { findStartCodeNEON, "neon" };
+#else
+    return { findStartCodeScalar, "scalar" };
+#endif
+}
+
+static const StartCodeKernel &getKernel() {
+    static StartCodeKernel s_kernel = selectKernel();
+    return s_kernel;
+}
+
+const char *findStartCode(const char *ptr, const char *end) {
+    return getKernel().func(ptr, end);
+}
+
+const char *findStartCode(const char *ptr, const char *end, uint8_t code) {
+    while ((ptr = findStartCode(ptr, end - 1))) {
+        if ((uint8_t)ptr[3] == code) {
+            return ptr;
+        }
+        ptr += 3;
+    }
+    return nullptr;
+}
+
+const char *getStartCodeKernel() {
+    return getKernel().name;
+}
+
+} // namespace mediakit
@@ -0,0 +1,49 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_STARTCODE_H
+#define ZLMEDIAKIT_STARTCODE_H
+
+#include <cstdint>
+
+namespace mediakit {
+
+/**
+ * 在[ptr, end)范围内查找Annex-B/mpeg起始码00 00 01(三个字节都必须在范围内)
+ * 根据cpu能力在运行时选择avx2/sse2/neon或纯c实现
+ * @return 起始码第一个字节位置，未找到返回nullptr
+ * Find the Annex-B/mpeg start code 00 00 01 in [ptr, end) (all three bytes must be in range)
+ * The avx2/sse2/neon or pure c implementation is selected at runtime according to the cpu capabilities
+ * @return Position of the first byte of the start code, nullptr if not found
+ */
+const char *findStartCode(const char *ptr, const char *end);
+
+/**
+ * 在[ptr, end)范围内查找指定类型的mpeg起始码00 00 01 code(四个字节都必须在范围内)
+ * @return 起始码第一个字节位置，未找到返回nullptr
+ * Find the mpeg start code 00 00 01 code of the specified type in [ptr, end) (all four bytes must be in range)
+ * @return Position of the first byte of the start code, nullptr if not found
+ */
+const char *findStartCode(const char *ptr, const char *end, uint8_t code);
+
+/**
+ * 纯c实现，供测试对比
+ * Pure c implementation, for test comparison
+ */
+const char *findStartCodeScalar(const char *ptr, const char *end);
+
+/**
+ * 获取当前使用的实现名称
+ * Get the name of the implementation in use
+ */
+const char *getStartCodeKernel();
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_STARTCODE_H
@@ -13,6 +13,7 @@
 
 #include "Common/MediaSource.h"
 #include "Common/PacketCache.h"
+#include "Common/SpmcRing.h"
 #include "Util/RingBuffer.h"
 
 #define FMP4_GOP_SIZE 512
@@ -34,11 +35,11 @@ public:
 
 // FMP4直播源  [AUTO-TRANSLATED:15c43604]
 // FMP4 Live Source
-class FMP4MediaSource final : public MediaSource, public toolkit::RingDelegate<FMP4Packet::Ptr>, private PacketCache<FMP4Packet>{
+class FMP4MediaSource final : public MediaSource, public toolkit::RingDelegate<FMP4Packet::Ptr>, private PacketCache<FMP4Packet, AdaptiveFlushPolicy> {
 public:
     using Ptr = std::shared_ptr<FMP4MediaSource>;
     using RingDataType = std::shared_ptr<toolkit::List<FMP4Packet::Ptr> >;
-    using RingType = toolkit::RingBuffer<RingDataType>;
+    using RingType = SpmcRing<RingDataType>;
 
     FMP4MediaSource(const MediaTuple& tuple,
                     int ring_size = FMP4_GOP_SIZE) : MediaSource(FMP4_SCHEMA, tuple), _ring_size(ring_size) {}
@@ -99,6 +100,10 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    int getMergeWriteMS() const override {
+        return getFlushPolicy().getMergeMS();
+    }
+
     /**
      * 输入FMP4包
      * @param packet FMP4包
@@ -118,7 +123,7 @@ public:
         }
         _speed[TrackVideo] += packet->size();
         auto stamp = packet->time_stamp;
-        PacketCache<FMP4Packet>::inputPacket(stamp, true, std::move(packet), key);
+        PacketCache<FMP4Packet, AdaptiveFlushPolicy>::inputPacket(stamp, true, std::move(packet), key);
     }
 
     /**
@@ -128,10 +133,13 @@ public:
      * [AUTO-TRANSLATED:d863f8c9]
      */
     void clearCache() override {
-        PacketCache<FMP4Packet>::clearCache();
+        PacketCache<FMP4Packet, AdaptiveFlushPolicy>::clearCache();
         _ring->clearCache();
     }
 
+    using PacketCache<FMP4Packet, AdaptiveFlushPolicy>::beginBatch;
+    using PacketCache<FMP4Packet, AdaptiveFlushPolicy>::endBatch;
+
 private:
     void createRing(){
         std::weak_ptr<FMP4MediaSource> weak_self = std::static_pointer_cast<FMP4MediaSource>(shared_from_this());
@@ -140,8 +148,17 @@ private:
             if (!strong_self) {
                 return;
             }
+            strong_self->getFlushPolicy().setReaderCount(size);
             strong_self->onReaderChanged(size);
         });
+        _ring->setOnPressure([weak_self]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->getFlushPolicy().onSendPressure();
+            }
+        });
+        auto latency = LatencyStats::get(getMediaTuple());
+        setLatencyStats(latency);
+        _ring->setLatencyStats(latency);
         if (!_init_segment.empty()) {
             regist();
         }
@@ -13,15 +13,16 @@
 
 #include "FMP4MediaSource.h"
 #include "Record/MP4Muxer.h"
+#include "Util/onceToken.h"
 
 namespace mediakit {
 
-class FMP4MediaSourceMuxer final : public MP4MuxerMemory, public MediaSourceEventInterceptor,
+class FMP4MediaSourceMuxer final : public MP4MuxerMemory, public MediaSourceEventInterceptor, public DemandMuxerState,
                                    public std::enable_shared_from_this<FMP4MediaSourceMuxer> {
 public:
     using Ptr = std::shared_ptr<FMP4MediaSourceMuxer>;
 
-    FMP4MediaSourceMuxer(const MediaTuple& tuple, const ProtocolOption &option) {
+    FMP4MediaSourceMuxer(const MediaTuple& tuple, const ProtocolOption &option) : DemandMuxerState(option.fmp4_demand) {
         _option = option;
         _media_src = std::make_shared<FMP4MediaSource>(tuple);
     }
@@ -44,28 +45,23 @@ public:
     }
 
     void onReaderChanged(MediaSource &sender, int size) override {
-        _enabled = _option.fmp4_demand ? size : true;
-        if (!size && _option.fmp4_demand) {
-            _clear_cache = true;
-        }
+        onDemandReaderChanged(size);
         MediaSourceEventInterceptor::onReaderChanged(sender, size);
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.fmp4_demand) {
-            _clear_cache = false;
+        if (needClearCache()) {
             _media_src->clearCache();
         }
-        if (_enabled || !_option.fmp4_demand) {
+        if (needMux()) {
             return MP4MuxerMemory::inputFrame(frame);
         }
         return false;
     }
 
-    bool isEnabled() {
-        // 缓存尚未清空时，还允许触发inputFrame函数，以便及时清空缓存  [AUTO-TRANSLATED:7cfd4d49]
-        // The inputFrame function is still allowed to be triggered when the cache has not been cleared, so that the cache can be cleared in time.
-        return _option.fmp4_demand ? (_clear_cache ? true : _enabled) : true;
+    bool inputFrames(const Frame::Ptr *frames, size_t count) override {
+        toolkit::onceToken token([&]() { _media_src->beginBatch(); }, [&]() { _media_src->endBatch(); });
+        return MP4MuxerMemory::inputFrames(frames, count);
     }
 
     void addTrackCompleted() override {
@@ -88,8 +84,6 @@ protected:
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
     ProtocolOption _option;
     FMP4MediaSource::Ptr _media_src;
 };
@@ -94,9 +94,15 @@ bool MP4Reader::readSample() {
         }
         _last_dts = frame->dts();
         if (_muxer) {
-            _muxer->inputFrame(frame);
+            _frames.emplace_back(std::move(frame));
         }
     }
+    if (!_frames.empty()) {
+        // 本次定时器到期的帧批量输入(倍速播放或seek后会有很多帧)
+        // Input the frames due in this timer round in batch (there are many frames after fast forward or seek)
+        _muxer->inputFrames(_frames.data(), _frames.size());
+        _frames.clear();
+    }
 
     GET_CONFIG(bool, file_repeat, Record::kFileRepeat);
     if (eof && (file_repeat || _file_repeat)) {
@@ -103,6 +103,7 @@ private:
     MultiMP4Demuxer::Ptr _demuxer;
     MultiMediaSourceMuxer::Ptr _muxer;
     toolkit::EventPoller::Ptr _poller;
+    std::vector<Frame::Ptr> _frames;
 };
 
 } /* namespace mediakit */
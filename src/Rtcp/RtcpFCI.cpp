@@ -304,20 +304,21 @@ public:
     vector<SymbolStatus> getSymbolList() const;
     // 构造函数  [AUTO-TRANSLATED:b9f7407d]
     // Constructor
-    StatusVecChunk(bool symbol_bit, const vector<SymbolStatus> &status);
+    StatusVecChunk(bool symbol_bit, const SymbolStatus *status, size_t size);
     // 打印本对象  [AUTO-TRANSLATED:e8bd8207]
     // Print this object
     string dumpString() const;
 };
 #pragma pack(pop)
 
-StatusVecChunk::StatusVecChunk(bool symbol_bit, const vector<SymbolStatus> &status) {
-    CHECK(status.size() << symbol_bit <= 14);
+StatusVecChunk::StatusVecChunk(bool symbol_bit, const SymbolStatus *status, size_t size) {
+    CHECK(size << symbol_bit <= 14);
     uint16_t value = 0;
     type = 1;
     symbol = symbol_bit;
     int i = 13;
-    for (auto &item : status) {
+    for (auto end = status + size; status < end; ++status) {
+        auto item = *status;
         CHECK(item <= SymbolStatus::reserved);
         if (!symbol) {
             CHECK(item <= SymbolStatus::small_delta);
@@ -487,6 +488,45 @@ FCI_TWCC::TwccPacketStatus FCI_TWCC::getPacketChunkList(size_t total_size) const
     return ret;
 }
 
+void FCI_TWCC::forEachPacket(size_t total_size, const std::function<void(uint16_t seq, SymbolStatus status, int16_t delta)> &cb) const {
+    auto begin = (uint8_t *)this + kSize;
+    auto end = (uint8_t *)this + total_size;
+    auto rtp_count = getPacketCount();
+    // 先跳过所有状态块，找到recv delta列表的起始位置
+    // First skip all status chunks to find the start position of the recv delta list
+    auto ptr = begin;
+    for (uint32_t i = 0; i < rtp_count; ptr += 2) {
+        CHECK(ptr + RunLengthChunk::kSize <= end);
+        RunLengthChunk *chunk = (RunLengthChunk *)ptr;
+        if (!chunk->type) {
+            i += chunk->getRunLength();
+        } else {
+            i += ((StatusVecChunk *)ptr)->symbol ? 7 : 14;
+        }
+    }
+    auto delta_ptr = ptr;
+    auto seq = getBaseSeq();
+    uint32_t i = 0;
+    for (ptr = begin; i < rtp_count; ptr += 2) {
+        RunLengthChunk *chunk = (RunLengthChunk *)ptr;
+        if (!chunk->type) {
+            // RunLengthChunk
+            auto status = (SymbolStatus)chunk->symbol;
+            for (auto j = chunk->getRunLength(); j && i < rtp_count; --j, ++i) {
+                cb(seq++, status, getRecvDelta(status, delta_ptr, end));
+            }
+            continue;
+        }
+        // StatusVecChunk
+        auto value = ntohs(*((uint16_t *)ptr));
+        auto two_bit = ((StatusVecChunk *)ptr)->symbol;
+        for (int bit = two_bit ? 12 : 13; bit >= 0 && i < rtp_count; bit -= two_bit ? 2 : 1, ++i) {
+            auto status = (SymbolStatus)((value >> bit) & (two_bit ? 3 : 1));
+            cb(seq++, status, getRecvDelta(status, delta_ptr, end));
+        }
+    }
+}
+
 string FCI_TWCC::dumpString(size_t total_size) const {
     _StrPrinter printer;
     auto map = getPacketChunkList(total_size);
@@ -499,63 +539,60 @@ string FCI_TWCC::dumpString(size_t total_size) const {
     return printer;
 }
 
-static void appendDeltaString(string &delta_str, FCI_TWCC::TwccPacketStatus &status, int count) {
-    for (auto it = status.begin(); it != status.end() && count--;) {
-        switch (it->second.first) {
-        // large delta模式先写高字节，再写低字节  [AUTO-TRANSLATED:cb25ff45]
-        // Large delta mode writes the high byte first, then the low byte
-        case SymbolStatus::large_delta:
-            delta_str.push_back((it->second.second >> 8) & 0xFF);
-            // small delta模式只写低字节  [AUTO-TRANSLATED:5caea5d6]
-            // Small delta mode only writes the low byte
-        case SymbolStatus::small_delta:
-            delta_str.push_back(it->second.second & 0xFF);
-            break;
-        default:
-            break;
-        }
-        // 移除已经处理过的数据  [AUTO-TRANSLATED:106fb6db]
-        // Remove the data that has been processed
-        it = status.erase(it);
+string FCI_TWCC::create(uint32_t ref_time, uint8_t fb_pkt_count, TwccPacketStatus &status) {
+    // 仅支持seq连续的包状态
+    // Only packet status with continuous seq is supported
+    vector<SymbolStatus> symbols;
+    vector<int16_t> deltas;
+    symbols.reserve(status.size());
+    deltas.reserve(status.size());
+    for (auto &pr : status) {
+        symbols.emplace_back(pr.second.first);
+        deltas.emplace_back(pr.second.second);
     }
+    string fci;
+    create(fci, status.begin()->first, ref_time, fb_pkt_count, symbols.data(), deltas.data(), symbols.size());
+    status.clear();
+    return fci;
 }
 
-string FCI_TWCC::create(uint32_t ref_time, uint8_t fb_pkt_count, TwccPacketStatus &status) {
-    string fci;
+void FCI_TWCC::create(std::string &fci, uint16_t base_seq, uint32_t ref_time, uint8_t fb_pkt_count,
+                      const SymbolStatus *status, const int16_t *delta, size_t count) {
+    fci.clear();
     fci.resize(FCI_TWCC::kSize);
     FCI_TWCC *ptr = (FCI_TWCC *)(fci.data());
-    ptr->base_seq = htons(status.begin()->first);
-    ptr->pkt_status_count = htons(status.size());
+    ptr->base_seq = htons(base_seq);
+    ptr->pkt_status_count = htons(count);
     ptr->fb_pkt_count = fb_pkt_count;
     ptr->ref_time[0] = (ref_time >> 16) & 0xFF;
     ptr->ref_time[1] = (ref_time >> 8) & 0xFF;
     ptr->ref_time[2] = (ref_time >> 0) & 0xFF;
 
-    string delta_str;
-    while (!status.empty()) {
+    size_t pos = 0;
+    while (pos < count) {
         {
             // 第一个rtp的状态  [AUTO-TRANSLATED:b0efb9ad]
             // The status of the first rtp
-            auto symbol = status.begin()->second.first;
-            int16_t count = 0;
-            for (auto &pr : status) {
-                if (pr.second.first != symbol) {
+            auto symbol = status[pos];
+            int16_t run = 0;
+            for (auto i = pos; i < count; ++i) {
+                if (status[i] != symbol) {
                     // 状态发送变更了，本chunk结束  [AUTO-TRANSLATED:f1c2c6d1]
                     // The status sending changed, this chunk ends
                     break;
                 }
-                if (++count >= (0xFFFF >> 3)) {
+                if (++run >= (0xFFFF >> 3)) {
                     // RunLengthChunk 13个bit表明rtp个数，最多可以表述0xFFFF >> 3个rtp状态  [AUTO-TRANSLATED:c6c4de01]
                     // RunLengthChunk 13 bits indicate the number of rtp, at most 0xFFFF >> 3 rtp status can be expressed
                     break;
                 }
             }
-            if (count >= 7) {
+            if (run >= 7) {
                 // 连续状态相同个数大于6个时，使用RunLengthChunk模式比较节省带宽  [AUTO-TRANSLATED:c243c73f]
                 // When the number of consecutive states is greater than 6, using RunLengthChunk mode is more bandwidth-saving
-                RunLengthChunk chunk(symbol, count);
+                RunLengthChunk chunk(symbol, run);
                 fci.append((char *)&chunk, RunLengthChunk::kSize);
-                appendDeltaString(delta_str, status, count);
+                pos += run;
                 continue;
             }
         }
@@ -566,16 +603,16 @@ string FCI_TWCC::create(uint32_t ref_time, uint8_t fb_pkt_count, TwccPacketStatu
             // symbol_list中元素是1个bit  [AUTO-TRANSLATED:e5f8cbf8]
             // Elements in symbol_list are 1 bit
             auto symbol = 0;
-            vector<SymbolStatus> vec;
-            for (auto &pr : status) {
-                vec.push_back(pr.second.first);
-                if (pr.second.first >= SymbolStatus::large_delta) {
+            size_t size = 0;
+            for (auto i = pos; i < count; ++i) {
+                ++size;
+                if (status[i] >= SymbolStatus::large_delta) {
                     // symbol_list中元素是2个bit  [AUTO-TRANSLATED:43429094]
                     // Elements in symbol_list are 2 bits
                     symbol = 1;
                 }
 
-                if (vec.size() << symbol >= 14) {
+                if (size << symbol >= 14) {
                     // symbol为0时，最多存放14个rtp的状态  [AUTO-TRANSLATED:1da4fad6]
                     // When symbol is 0, at most 14 RTP statuses can be stored
                     // symbol为1时，最多存放7个rtp的状态  [AUTO-TRANSLATED:34f39e9a]
@@ -583,17 +620,30 @@ string FCI_TWCC::create(uint32_t ref_time, uint8_t fb_pkt_count, TwccPacketStatu
                     break;
                 }
             }
-            vec.resize(MIN(vec.size(), (size_t)14 >> symbol));
-            StatusVecChunk chunk(symbol, vec);
+            size = MIN(size, (size_t)14 >> symbol);
+            StatusVecChunk chunk(symbol, status + pos, size);
             fci.append((char *)&chunk, StatusVecChunk::kSize);
-            appendDeltaString(delta_str, status, vec.size());
+            pos += size;
         }
     }
 
-    // recv delta部分  [AUTO-TRANSLATED:f7e0d5bc]
-    // recv delta part
-    fci.append(delta_str);
-    return fci;
+    // recv delta部分，按照包状态顺序排列  [AUTO-TRANSLATED:f7e0d5bc]
+    // recv delta part, arranged in the order of packet status
+    for (size_t i = 0; i < count; ++i) {
+        switch (status[i]) {
+        // large delta模式先写高字节，再写低字节  [AUTO-TRANSLATED:cb25ff45]
+        // Large delta mode writes the high byte first, then the low byte
+        case SymbolStatus::large_delta:
+            fci.push_back((delta[i] >> 8) & 0xFF);
+            // small delta模式只写低字节  [AUTO-TRANSLATED:5caea5d6]
+            // Small delta mode only writes the low byte
+        case SymbolStatus::small_delta:
+            fci.push_back(delta[i] & 0xFF);
+            break;
+        default:
+            break;
+        }
+    }
 }
 
 } // namespace mediakit
\ No newline at end of file
@@ -367,9 +367,37 @@ public:
     uint32_t getReferenceTime() const;
     uint16_t getPacketCount() const;
     TwccPacketStatus getPacketChunkList(size_t total_size) const;
+    /**
+     * 按序遍历反馈的每个rtp状态，不分配内存且支持seq回环
+     * @param cb 回调参数为rtp ext seq、包状态、recv delta(单位为250us)
+     * Traverse the status of each rtp in the feedback in order, without allocating memory and supporting seq loop
+     * @param cb Callback parameters are rtp ext seq, packet status, recv delta (unit is 250us)
+     */
+    void forEachPacket(size_t total_size, const std::function<void(uint16_t seq, SymbolStatus status, int16_t delta)> &cb) const;
 
     static std::string create(uint32_t ref_time, uint8_t fb_pkt_count, TwccPacketStatus &status);
 
+    /**
+     * 根据seq连续的包状态生成fci，fci会被清空后写入，重复使用同一个fci对象时不再分配内存
+     * @param fci 输出
+     * @param base_seq 第一个包的rtp ext seq
+     * @param ref_time 基准时间，单位64ms
+     * @param fb_pkt_count 反馈包号
+     * @param status 包状态数组
+     * @param delta recv delta数组，单位为250us
+     * @param count 包个数
+     * Generate fci from the packet status with continuous seq, fci is cleared before writing, no memory is allocated when the same fci object is reused
+     * @param fci Output
+     * @param base_seq Rtp ext seq of the first packet
+     * @param ref_time Reference time, unit 64ms
+     * @param fb_pkt_count Feedback packet count
+     * @param status Packet status array
+     * @param delta Recv delta array, unit is 250us
+     * @param count Number of packets
+     */
+    static void create(std::string &fci, uint16_t base_seq, uint32_t ref_time, uint8_t fb_pkt_count,
+                       const SymbolStatus *status, const int16_t *delta, size_t count);
+
 private:
     // base sequence number,基础序号,本次反馈的第一个包的序号;也就是RTP扩展头的序列号  [AUTO-TRANSLATED:4e43ffcc]
     // base sequence number, basic sequence number, the sequence number of the first packet in this feedback; that is, the sequence number of the RTP extension header
@@ -9,6 +9,7 @@
  */
 
 #include "Rtmp.h"
+#include "Rtmp/utils.h"
 #include "Common/config.h"
 #include "Extension/Factory.h"
 
@@ -157,18 +158,25 @@ void Metadata::addTrack(AMFValue &metadata, const Track::Ptr &track) {
     new_metadata->getMetadata().object_for_each([&](const std::string &key, const AMFValue &value) { metadata.set(key, value); });
 }
 
+bool RtmpPacket::onRecycle(RtmpPacket *packet) {
+    if (packet->buffer.capacity() > kPoolSlotSize) {
+        // 大帧不回收，防止对象池占用过多内存
+        // Large frames are not recycled to prevent the object pool from occupying too much memory
+        return false;
+    }
+    // clear不释放内存，复用时追加数据无需重新开辟
+    // clear does not release the memory, no reallocation is needed when appending data after reuse
+    packet->clear();
+    return true;
+}
+
 RtmpPacket::Ptr RtmpPacket::create() {
-#if 0
-    static ResourcePool<RtmpPacket> packet_pool;
-    static onceToken token([]() {
-        packet_pool.setSize(1024);
-    });
-    auto ret = packet_pool.obtain2();
-    ret->clear();
-    return ret;
-#else
-    return Ptr(new RtmpPacket);
-#endif
+    GET_CONFIG(size_t, pool_size, Rtmp::kPacketPoolSize);
+    return ObjectPool<RtmpPacket>::obtain(pool_size, onRecycle);
+}
+
+ObjectPool<RtmpPacket>::Statistic RtmpPacket::getPoolStatistic() {
+    return ObjectPool<RtmpPacket>::getStatistic();
 }
 
 void RtmpPacket::clear() {
@@ -177,6 +185,76 @@ void RtmpPacket::clear() {
     ts_field = 0;
     body_size = 0;
     buffer.clear();
+    _chunk_cache = nullptr;
+}
+
+Buffer::Ptr RtmpPacket::getChunkedData(uint32_t stream_index, int chunk_id, size_t chunk_size) const {
+    auto cache = std::atomic_load(&_chunk_cache);
+    if (cache) {
+        if (cache->stream_index == stream_index && cache->chunk_id == chunk_id && cache->chunk_size == chunk_size) {
+            return cache->data;
+        }
+        // 已缓存其他参数的切片，由调用者自行切片
+        // The chunks of other parameters have been cached, the caller chunks it by itself
+        return nullptr;
+    }
+
+    // 所有消息都使用fmt0头(绝对时间戳)，切片结果只与时间戳、消息流id、块流id及chunk大小有关，与具体会话无关
+    // All messages use the fmt0 header (absolute timestamp), the chunked result is only related to the timestamp,
+    // message stream id, chunk stream id and chunk size, not to the specific session
+    // 与RtmpProtocol::sendRtmp的逐块发送保持一致：空负载只有消息头，不带扩展时间戳
+    // Consistent with chunk by chunk sending of RtmpProtocol::sendRtmp: an empty payload only has the message header without extended timestamp
+    auto ext_stamp = time_stamp >= 0xFFFFFF;
+    auto payload_size = size();
+    auto chunk_count = (payload_size + chunk_size - 1) / chunk_size;
+    auto total_size = sizeof(RtmpHeader) + (chunk_count ? chunk_count - 1 : 0) + (ext_stamp ? 4 * chunk_count : 0) + payload_size;
+
+    auto ret = BufferRaw::create();
+    ret->setCapacity(total_size);
+    ret->setSize(total_size);
+    auto ptr = ret->data();
+    auto header = (RtmpHeader *)ptr;
+    header->fmt = 0;
+    header->chunk_id = chunk_id;
+    header->type_id = type_id;
+    set_be24(header->time_stamp, ext_stamp ? 0xFFFFFF : time_stamp);
+    set_be24(header->body_size, (uint32_t)payload_size);
+    set_le32(header->stream_index, stream_index);
+    ptr += sizeof(RtmpHeader);
+
+    size_t offset = 0;
+    while (offset < payload_size) {
+        if (offset) {
+            // fmt3头，只有一个字节标明chunk id
+            // fmt3 header, only one byte to indicate the chunk id
+            header = (RtmpHeader *)ptr;
+            header->fmt = 3;
+            header->chunk_id = chunk_id;
+            ptr += 1;
+        }
+        if (ext_stamp) {
+            set_be32(ptr, time_stamp);
+            ptr += 4;
+        }
+        auto chunk = MIN(chunk_size, payload_size - offset);
+        memcpy(ptr, data() + offset, chunk);
+        ptr += chunk;
+        offset += chunk;
+    }
+
+    auto new_cache = std::make_shared<ChunkCache>();
+    new_cache->stream_index = stream_index;
+    new_cache->chunk_id = chunk_id;
+    new_cache->chunk_size = chunk_size;
+    new_cache->data = ret;
+    // 多个线程同时切片时只保留第一个
+    // Only the first one is kept when multiple threads chunk it at the same time
+    std::atomic_compare_exchange_strong(&_chunk_cache, &cache, std::move(new_cache));
+    return ret;
+}
+
+void RtmpPacket::dropChunkedData() const {
+    std::atomic_store(&_chunk_cache, std::shared_ptr<ChunkCache>());
 }
 
 bool RtmpPacket::isVideoKeyFrame() const {
@@ -17,6 +17,7 @@
 #include "amf.h"
 #include "Network/Buffer.h"
 #include "Extension/Track.h"
+#include "Common/ObjectPool.h"
 
 #define DEFAULT_CHUNK_LEN	128
 #define HANDSHAKE_PLAINTEXT	0x03
@@ -175,6 +176,9 @@ class RtmpPacket : public toolkit::Buffer{
 public:
     friend class RtmpProtocol;
     using Ptr = std::shared_ptr<RtmpPacket>;
+    // 对象池回收的包最大缓存容量，超过则销毁，防止大帧长期占用内存
+    // Max buffer capacity of packets recycled by the object pool, destroyed if exceeded to prevent large frames from occupying memory for a long time
+    enum { kPoolSlotSize = 64 * 1024 };
     bool is_abs_stamp;
     uint8_t type_id;
     uint32_t time_stamp;
@@ -187,6 +191,32 @@ public:
 public:
     static Ptr create();
 
+    // 获取rtmp包对象池统计信息
+    // Get rtmp packet object pool statistics
+    static ObjectPool<RtmpPacket>::Statistic getPoolStatistic();
+
+    /**
+     * 获取切片后的完整rtmp消息(包括所有chunk头)，多个播放器以相同参数发送同一个包时只切片一次
+     * 每个包只缓存首次请求的参数组合，参数不同时返回nullptr，调用者应自行切片
+     * @param stream_index 消息流id
+     * @param chunk_id 块流id
+     * @param chunk_size 发送端chunk大小
+     * Get the complete chunked rtmp message (including all chunk headers), the packet is only chunked once
+     * when multiple players send it with the same parameters
+     * Each packet only caches the parameter combination of the first request, nullptr is returned for different parameters
+     * and the caller should chunk it by itself
+     * @param stream_index Message stream id
+     * @param chunk_id Chunk stream id
+     * @param chunk_size Chunk size of the sender
+     */
+    toolkit::Buffer::Ptr getChunkedData(uint32_t stream_index, int chunk_id, size_t chunk_size) const;
+
+    /**
+     * 释放切片缓存，包离开环形缓冲后不会再被共享发送
+     * Release the chunked cache, the packet will not be sent shared anymore after it leaves the ring
+     */
+    void dropChunkedData() const;
+
     char *data() const override{
         return (char*)buffer.data();
     }
@@ -215,13 +245,26 @@ public:
 
 private:
     friend class toolkit::ResourcePool_l<RtmpPacket>;
+    friend class ObjectPool<RtmpPacket>;
     RtmpPacket(){
         clear();
     }
 
+    static bool onRecycle(RtmpPacket *packet);
+
     RtmpPacket &operator=(const RtmpPacket &that);
 
 private:
+    class ChunkCache {
+    public:
+        uint32_t stream_index;
+        int chunk_id;
+        size_t chunk_size;
+        toolkit::Buffer::Ptr data;
+    };
+    // 切片缓存，多线程共享，通过std::atomic_load/atomic_compare_exchange访问
+    // Chunked cache, shared by multiple threads, accessed by std::atomic_load/atomic_compare_exchange
+    mutable std::shared_ptr<ChunkCache> _chunk_cache;
     // 对象个数统计  [AUTO-TRANSLATED:3b43e8c2]
     // Object count statistics
     toolkit::ObjectStatistic<RtmpPacket> _statistic;
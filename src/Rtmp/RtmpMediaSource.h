@@ -20,6 +20,7 @@
 #include "Rtmp.h"
 #include "Common/MediaSource.h"
 #include "Common/PacketCache.h"
+#include "Common/SpmcRing.h"
 #include "Util/RingBuffer.h"
 
 #define RTMP_GOP_SIZE 512
@@ -40,11 +41,11 @@ namespace mediakit {
  
  * [AUTO-TRANSLATED:72d515c8]
  */
-class RtmpMediaSource : public MediaSource, public toolkit::RingDelegate<RtmpPacket::Ptr>, private PacketCache<RtmpPacket>{
+class RtmpMediaSource : public MediaSource, public toolkit::RingDelegate<RtmpPacket::Ptr>, private PacketCache<RtmpPacket, AdaptiveFlushPolicy> {
 public:
     using Ptr = std::shared_ptr<RtmpMediaSource>;
     using RingDataType = std::shared_ptr<toolkit::List<RtmpPacket::Ptr> >;
-    using RingType = toolkit::RingBuffer<RingDataType>;
+    using RingType = SpmcRing<RingDataType>;
 
     /**
      * 构造函数
@@ -97,6 +98,10 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    int getMergeWriteMS() const override {
+        return getFlushPolicy().getMergeMS();
+    }
+
     /**
      * 获取metadata
      * Get metadata
@@ -152,10 +157,15 @@ public:
     uint32_t getTimeStamp(TrackType trackType) override;
 
     void clearCache() override{
-        PacketCache<RtmpPacket>::clearCache();
+        PacketCache<RtmpPacket, AdaptiveFlushPolicy>::clearCache();
         _ring->clearCache();
     }
 
+    // 批量写入期间合并刷新，由复用器的inputFrames调用
+    // Merge flushing during batch writing, called by inputFrames of the muxer
+    using PacketCache<RtmpPacket, AdaptiveFlushPolicy>::beginBatch;
+    using PacketCache<RtmpPacket, AdaptiveFlushPolicy>::endBatch;
+
     bool haveVideo() const {
         return _have_video;
     }
@@ -178,7 +188,15 @@ private:
     void onFlush(std::shared_ptr<toolkit::List<RtmpPacket::Ptr> > rtmp_list, bool key_pos) override {
         // 如果不存在视频，那么就没有存在GOP缓存的意义，所以is_key一直为true确保一直清空GOP缓存  [AUTO-TRANSLATED:5818a8d8]
         // If there is no video, then there is no point in having a GOP cache, so is_key is always true to ensure that the GOP cache is always cleared
-        _ring->write(std::move(rtmp_list), _have_video ? key_pos : true);
+        // 列表离开环形缓冲时释放其中各包的切片缓存，防止被config帧等长期持有的包一直占用双倍内存
+        // Release the chunked cache of the packets when the list leaves the ring, to prevent packets held for a long time
+        // such as config frames from occupying double memory all the time
+        auto ptr = rtmp_list.get();
+        std::shared_ptr<toolkit::List<RtmpPacket::Ptr>> ring_list(ptr, [rtmp_list](toolkit::List<RtmpPacket::Ptr> *list) mutable {
+            list->for_each([](const RtmpPacket::Ptr &pkt) { pkt->dropChunkedData(); });
+            rtmp_list = nullptr;
+        });
+        _ring->write(std::move(ring_list), _have_video ? key_pos : true);
     }
 
 private:
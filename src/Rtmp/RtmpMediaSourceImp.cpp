@@ -74,6 +74,7 @@ void RtmpMediaSource::onWrite(RtmpPacket::Ptr pkt, bool /*= true*/) {
             if (!strong_self) {
                 return;
             }
+            strong_self->getFlushPolicy().setReaderCount(size);
             strong_self->onReaderChanged(size);
         };
 
@@ -82,13 +83,21 @@ void RtmpMediaSource::onWrite(RtmpPacket::Ptr pkt, bool /*= true*/) {
         // 每次遇到关键帧第一个RTMP包，则会清空GOP缓存(因为有新的关键帧了，同样可以实现秒开)  [AUTO-TRANSLATED:dee67297]
         // Every time a key frame's first RTMP packet is encountered, the GOP cache will be cleared (because there is a new key frame, which can also achieve instant opening)
         _ring = std::make_shared<RingType>(_ring_size, std::move(lam));
+        _ring->setOnPressure([weak_self]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->getFlushPolicy().onSendPressure();
+            }
+        });
+        auto latency = LatencyStats::get(getMediaTuple());
+        setLatencyStats(latency);
+        _ring->setLatencyStats(latency);
         if (_metadata) {
             regist();
         }
     }
     bool key = pkt->isVideoKeyFrame();
     auto stamp = pkt->time_stamp;
-    PacketCache<RtmpPacket>::inputPacket(stamp, is_video, std::move(pkt), key);
+    PacketCache<RtmpPacket, AdaptiveFlushPolicy>::inputPacket(stamp, is_video, std::move(pkt), key);
 }
 
 RtmpMediaSourceImp::RtmpMediaSourceImp(const MediaTuple &tuple, int ringSize)
@@ -13,17 +13,18 @@
 
 #include "RtmpMuxer.h"
 #include "Rtmp/RtmpMediaSource.h"
+#include "Util/onceToken.h"
 
 namespace mediakit {
 
-class RtmpMediaSourceMuxer final : public RtmpMuxer, public MediaSourceEventInterceptor,
+class RtmpMediaSourceMuxer final : public RtmpMuxer, public MediaSourceEventInterceptor, public DemandMuxerState,
                                    public std::enable_shared_from_this<RtmpMediaSourceMuxer> {
 public:
     using Ptr = std::shared_ptr<RtmpMediaSourceMuxer>;
 
     RtmpMediaSourceMuxer(const MediaTuple& tuple,
                          const ProtocolOption &option,
-                         const TitleMeta::Ptr &title = nullptr) : RtmpMuxer(title) {
+                         const TitleMeta::Ptr &title = nullptr) : RtmpMuxer(title), DemandMuxerState(option.rtmp_demand) {
         _option = option;
         _media_src = std::make_shared<RtmpMediaSource>(tuple);
         getRtmpRing()->setDelegate(_media_src);
@@ -57,28 +58,25 @@ public:
     }
 
     void onReaderChanged(MediaSource &sender, int size) override {
-        _enabled = _option.rtmp_demand ? size : true;
-        if (!size && _option.rtmp_demand) {
-            _clear_cache = true;
-        }
+        onDemandReaderChanged(size);
         MediaSourceEventInterceptor::onReaderChanged(sender, size);
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.rtmp_demand) {
-            _clear_cache = false;
+        if (needClearCache()) {
             _media_src->clearCache();
         }
-        if (_enabled || !_option.rtmp_demand) {
+        if (needMux()) {
             return RtmpMuxer::inputFrame(frame);
         }
         return false;
     }
 
-    bool isEnabled() {
-        // 缓存尚未清空时，还允许触发inputFrame函数，以便及时清空缓存  [AUTO-TRANSLATED:7cfd4d49]
-        // The inputFrame function is still allowed to be triggered when the cache has not been cleared, so that the cache can be cleared in time.
-        return _option.rtmp_demand ? (_clear_cache ? true : _enabled) : true;
+    bool inputFrames(const Frame::Ptr *frames, size_t count) override {
+        // 整批帧写完后再刷新合并写缓存，关闭合并写时可减少环形缓存写入与播放器派发次数
+        // Flush the merge write cache after the whole batch is written, which reduces ring buffer writes and player dispatches when merge write is closed
+        toolkit::onceToken token([&]() { _media_src->beginBatch(); }, [&]() { _media_src->endBatch(); });
+        return RtmpMuxer::inputFrames(frames, count);
     }
 
     MediaSource::Ptr getMediaSource() const {
@@ -86,8 +84,6 @@ public:
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
     ProtocolOption _option;
     RtmpMediaSource::Ptr _media_src;
 };
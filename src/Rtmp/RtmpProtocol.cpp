@@ -121,27 +121,24 @@ void RtmpProtocol::reset() {
 
 void RtmpProtocol::sendAcknowledgement(uint32_t size) {
     size = htonl(size);
-    std::string acknowledgement((char *) &size, 4);
-    sendRequest(MSG_ACK, acknowledgement);
+    sendRequest(MSG_ACK, obtainBuffer(&size, 4));
 }
 
 void RtmpProtocol::sendAcknowledgementSize(uint32_t size) {
     size = htonl(size);
-    std::string set_windowSize((char *) &size, 4);
-    sendRequest(MSG_WIN_SIZE, set_windowSize);
+    sendRequest(MSG_WIN_SIZE, obtainBuffer(&size, 4));
 }
 
 void RtmpProtocol::sendPeerBandwidth(uint32_t size) {
-    size = htonl(size);
-    std::string set_peerBandwidth((char *) &size, 4);
-    set_peerBandwidth.push_back((char) 0x02);
-    sendRequest(MSG_SET_PEER_BW, set_peerBandwidth);
+    char set_peer_bandwidth[5];
+    set_be32(set_peer_bandwidth, size);
+    set_peer_bandwidth[4] = 0x02;
+    sendRequest(MSG_SET_PEER_BW, obtainBuffer(set_peer_bandwidth, sizeof(set_peer_bandwidth)));
 }
 
 void RtmpProtocol::sendChunkSize(uint32_t size) {
     uint32_t len = htonl(size);
-    std::string set_chunk((char *) &len, 4);
-    sendRequest(MSG_SET_CHUNK, set_chunk);
+    sendRequest(MSG_SET_CHUNK, obtainBuffer(&len, 4));
     _chunk_size_out = size;
 }
 
@@ -164,13 +161,11 @@ void RtmpProtocol::sendSetBufferLength(uint32_t stream_index, uint32_t len) {
 }
 
 void RtmpProtocol::sendUserControl(uint16_t event_type, uint32_t event_data) {
-    std::string control;
+    char control[6];
     event_type = htons(event_type);
-    control.append((char *) &event_type, 2);
-
-    event_data = htonl(event_data);
-    control.append((char *) &event_data, 4);
-    sendRequest(MSG_USER_CONTROL, control);
+    memcpy(control, &event_type, 2);
+    set_be32(control + 2, event_data);
+    sendRequest(MSG_USER_CONTROL, obtainBuffer(control, sizeof(control)));
 }
 
 void RtmpProtocol::sendUserControl(uint16_t event_type, const string &event_data) {
@@ -195,14 +190,18 @@ void RtmpProtocol::sendInvoke(const string &cmd, const AMFValue &val) {
 }
 
 void RtmpProtocol::sendRequest(int cmd, const string& str) {
+    sendRequest(cmd, std::make_shared<BufferString>(str));
+}
+
+void RtmpProtocol::sendRequest(int cmd, const Buffer::Ptr &buf) {
     if (cmd <= MSG_SET_PEER_BW) {
         // 若 cmd 属于 Protocol Control Messages ，则应使用 chunk id 2 发送  [AUTO-TRANSLATED:3f17e21f]
         // If cmd belongs to Protocol Control Messages, it should be sent using chunk id 2
-        sendRtmp(cmd, _stream_index, str, 0, CHUNK_NETWORK);
+        sendRtmp(cmd, _stream_index, buf, 0, CHUNK_NETWORK);
     } else {
         // 否则使用 chunk id 发送(任意值3-128，参见 obs 及 ffmpeg 选取 3)  [AUTO-TRANSLATED:65f8d861]
         // Otherwise, use chunk id to send (any value 3-128, see obs and ffmpeg select 3)
-        sendRtmp(cmd, _stream_index, str, 0, CHUNK_SYSTEM);
+        sendRtmp(cmd, _stream_index, buf, 0, CHUNK_SYSTEM);
     }
 }
 
@@ -298,7 +297,29 @@ void RtmpProtocol::sendRtmp(uint8_t type, uint32_t stream_index, const Buffer::P
         totalSize += chunk;
         offset += chunk;
     }
-    _bytes_sent += (uint32_t)totalSize;
+    onSendBytes(totalSize);
+}
+
+void RtmpProtocol::sendRtmp(const RtmpPacket::Ptr &pkt, uint32_t stream_index, int chunk_id, bool shared) {
+    if (chunk_id < 2 || chunk_id > 63) {
+        auto strErr = StrPrinter << "不支持发送该类型的块流 ID:" << chunk_id << endl;
+        throw std::runtime_error(strErr);
+    }
+    auto buffer = shared ? pkt->getChunkedData(stream_index, chunk_id, _chunk_size_out) : nullptr;
+    if (!buffer) {
+        // 只有一个读者时切片缓存无法复用，直接零拷贝发送；或该包已按其他参数切片，退化为本会话单独切片
+        // When there is only one reader, the chunked cache cannot be reused, so send it directly with zero copy;
+        // or the packet has been chunked with other parameters, fall back to chunking it for this session only
+        sendRtmp(pkt->type_id, stream_index, pkt, pkt->time_stamp, chunk_id);
+        return;
+    }
+    auto size = buffer->size();
+    onSendRawData(std::move(buffer));
+    onSendBytes(size);
+}
+
+void RtmpProtocol::onSendBytes(size_t bytes) {
+    _bytes_sent += (uint32_t)bytes;
     if (_windows_size > 0 && _bytes_sent - _bytes_sent_last >= _windows_size) {
         _bytes_sent_last = _bytes_sent;
         sendAcknowledgement(_bytes_sent);
@@ -766,6 +787,16 @@ const char* RtmpProtocol::handle_rtmp(const char *data, size_t len) {
             return ptr;
         }
         if (more) {
+            if (chunk_data.buffer.size() + more > chunk_data.buffer.capacity()) {
+                // 按倍数扩容，避免逐个chunk追加时反复扩容；
+                // 为防止恶意的超大body_size造成内存放大，首个chunk最多预留kPoolSlotSize，之后最多预留已收到数据的2倍，且不超过消息长度
+                // Grow geometrically to avoid repeated expansion when appending chunk by chunk;
+                // To prevent memory amplification by a malicious oversized body_size, at most kPoolSlotSize is reserved on the first chunk,
+                // and then at most twice the data received so far, never more than the message length
+                auto need = chunk_data.buffer.size() + more;
+                auto capacity = MAX(need, chunk_data.buffer.empty() ? (size_t)RtmpPacket::kPoolSlotSize : chunk_data.buffer.size() * 2);
+                chunk_data.buffer.reserve(MIN(capacity, (size_t)chunk_data.body_size));
+            }
             chunk_data.buffer.append(ptr + header_len + offset, more);
         }
         ptr += header_len + offset + more;
@@ -920,13 +951,26 @@ void RtmpProtocol::handle_chunk(RtmpPacket::Ptr packet) {
                 latest_ts = ts;
                 auto sub_packet_ptr = RtmpPacket::create();
                 auto &sub_packet = *sub_packet_ptr;
-                sub_packet.buffer.assign((char *)ptr, size);
+                auto last = ptr + size + 4 + 8 + 3 >= ptr_tail;
+                if (last) {
+                    // 最后一个子消息直接复用聚合消息的内存，免拷贝
+                    // The last sub message directly reuses the memory of the aggregate message without copying
+                    auto head = ptr - (uint8_t *)chunk_data.buffer.data();
+                    sub_packet.buffer = std::move(chunk_data.buffer);
+                    sub_packet.buffer.erase(head + size);
+                    sub_packet.buffer.erase(0, head);
+                } else {
+                    sub_packet.buffer.assign((char *)ptr, size);
+                }
                 sub_packet.type_id = type;
                 sub_packet.body_size = size;
                 sub_packet.time_stamp = timestamp;
                 sub_packet.stream_index = chunk_data.stream_index;
                 sub_packet.chunk_id = chunk_data.chunk_id;
                 handle_chunk(std::move(sub_packet_ptr));
+                if (last) {
+                    break;
+                }
                 ptr += size + 4;
             }
             break;
@@ -59,12 +59,18 @@ protected:
     void sendUserControl(uint16_t event_type, const std::string &event_data);
     void sendInvoke(const std::string &cmd, const AMFValue &val);
     void sendRequest(int cmd, const std::string &str);
+    void sendRequest(int cmd, const toolkit::Buffer::Ptr &buf);
     void sendResponse(int type, const std::string &str);
     void sendRtmp(uint8_t type, uint32_t stream_index, const std::string &buffer, uint32_t stamp, int chunk_id);
     void sendRtmp(uint8_t type, uint32_t stream_index, const toolkit::Buffer::Ptr &buffer, uint32_t stamp, int chunk_id);
+    // 发送媒体包，shared为true(有多个读者)时，同一个包被多个会话以相同chunk大小发送时共享切片结果，否则零拷贝逐块发送
+    // Send the media packet, when shared is true (there are multiple readers), the chunked result is shared when the same packet
+    // is sent by multiple sessions with the same chunk size, otherwise it is sent chunk by chunk with zero copy
+    void sendRtmp(const RtmpPacket::Ptr &pkt, uint32_t stream_index, int chunk_id, bool shared = false);
     toolkit::BufferRaw::Ptr obtainBuffer(const void *data = nullptr, size_t len = 0);
     
 private:
+    void onSendBytes(size_t bytes);
     void handle_C1_simple(const char *data);
 #ifdef ENABLE_OPENSSL
     void handle_S1_complex(const char *data, RtmpHandshake &c2);
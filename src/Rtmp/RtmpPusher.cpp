@@ -211,7 +211,7 @@ void RtmpPusher::send_metaData(){
 
     // config frame
     src->getConfigFrame([&](const RtmpPacket::Ptr &pkt) {
-        sendRtmp(pkt->type_id, _stream_index, pkt, pkt->time_stamp, pkt->chunk_id);
+        sendRtmp(pkt, _stream_index, pkt->chunk_id);
     });
 
     src->pause(false);
@@ -225,6 +225,7 @@ void RtmpPusher::send_metaData(){
 
         size_t i = 0;
         auto size = pkt->size();
+        auto shared = strong_self->_rtmp_reader->readerCount() >= 2;
         strong_self->setSendFlushFlag(false);
         pkt->for_each([&](const RtmpPacket::Ptr &rtmp) {
             if (++i == size) {
@@ -238,7 +239,7 @@ void RtmpPusher::send_metaData(){
                 pkt.append(rtmp->data(), rtmp->size());
                 strong_self->sendRequest(MSG_DATA, pkt);
             } else {
-                strong_self->sendRtmp(rtmp->type_id, strong_self->_stream_index, rtmp, rtmp->time_stamp, rtmp->chunk_id);
+                strong_self->sendRtmp(rtmp, strong_self->_stream_index, rtmp->chunk_id, shared);
             }
         });
     });
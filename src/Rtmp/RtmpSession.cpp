@@ -308,13 +308,21 @@ void RtmpSession::sendPlayResponse(const string &err, const RtmpMediaSource::Ptr
         }
         size_t i = 0;
         auto size = pkt->size();
+        // 有多个读者时才共享切片结果
+        // Share the chunked result only when there are multiple readers
+        auto shared = strong_self->_ring_reader->readerCount() >= 2;
         strong_self->setSendFlushFlag(false);
         pkt->for_each([&](const RtmpPacket::Ptr &rtmp){
             if(++i == size){
                 strong_self->setSendFlushFlag(true);
             }
-            strong_self->onSendMedia(rtmp);
+            strong_self->onSendMedia(rtmp, shared);
         });
+        if (strong_self->getSock()->isSocketBusy()) {
+            // 发送缓存已满，通知媒体源加大合并写时长
+            // The send buffer is full, notify the media source to increase the merge write duration
+            strong_self->_ring_reader->onSendPressure();
+        }
     });
     _ring_reader->setDetachCB([weak_self]() {
         auto strong_self = weak_self.lock();
@@ -576,16 +584,16 @@ void RtmpSession::onCmd_seek(AMFDecoder &dec) {
     }
 }
 
-void RtmpSession::onSendMedia(const RtmpPacket::Ptr &pkt) {
+void RtmpSession::onSendMedia(const RtmpPacket::Ptr &pkt, bool shared) {
     switch (pkt->type_id) {
         case MSG_AUDIO:
-            sendRtmp(pkt->type_id, STREAM_MEDIA, pkt, pkt->time_stamp, CHUNK_AUDIO);
+            sendRtmp(pkt, STREAM_MEDIA, CHUNK_AUDIO, shared);
             break;
         case MSG_VIDEO:
-            sendRtmp(pkt->type_id, STREAM_MEDIA, pkt, pkt->time_stamp, CHUNK_VIDEO);
+            sendRtmp(pkt, STREAM_MEDIA, CHUNK_VIDEO, shared);
             break;
         default:
-            sendRtmp(pkt->type_id, pkt->stream_index, pkt, pkt->time_stamp, pkt->chunk_id);
+            sendRtmp(pkt, pkt->stream_index, pkt->chunk_id, shared);
             break;
     }
 }
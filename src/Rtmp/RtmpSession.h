@@ -51,7 +51,7 @@ private:
     void onCmd_playCtrl(AMFDecoder &dec);
     void setMetaData(AMFDecoder &dec);
 
-    void onSendMedia(const RtmpPacket::Ptr &pkt);
+    void onSendMedia(const RtmpPacket::Ptr &pkt, bool shared = false);
     void onSendRawData(toolkit::Buffer::Ptr buffer) override{
         _total_bytes += buffer->size();
         send(std::move(buffer));
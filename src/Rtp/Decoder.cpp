@@ -29,12 +29,22 @@ void Decoder::setOnDecode(Decoder::onDecode cb) {
 void Decoder::setOnStream(Decoder::onStream cb) {
     _on_stream = std::move(cb);
 }
+
+void Decoder::setOnDecodeBuffer(Decoder::onDecodeBuffer cb) {
+    _on_decode_buffer = std::move(cb);
+}
     
 static Decoder::Ptr createDecoder_l(DecoderImp::Type type) {
     switch (type){
         case DecoderImp::decoder_ps:
 #ifdef ENABLE_RTPPROXY
+        {
+            GET_CONFIG(bool, ps_stream_demux, RtpProxy::kPSStreamDemux);
+            if (ps_stream_demux) {
+                return std::make_shared<PSStreamDecoder>();
+            }
             return std::make_shared<PSDecoder>();
+        }
 #else
             WarnL << "创建ps解复用器失败，请打开ENABLE_RTPPROXY然后重新编译";
             return nullptr;
@@ -42,7 +52,13 @@ static Decoder::Ptr createDecoder_l(DecoderImp::Type type) {
 
         case DecoderImp::decoder_ts:
 #ifdef ENABLE_HLS
+        {
+            GET_CONFIG(bool, ts_stream_demux, General::kTSStreamDemux);
+            if (ts_stream_demux) {
+                return std::make_shared<TSStreamDecoder>();
+            }
             return std::make_shared<TSDecoder>();
+        }
 #else
             WarnL << "创建mpegts解复用器失败，请打开ENABLE_HLS然后重新编译";
             return nullptr;
@@ -63,6 +79,7 @@ DecoderImp::Ptr DecoderImp::createDecoder(Type type, MediaSinkInterface *sink){
 }
 
 void DecoderImp::flush() {
+    _decoder->flush();
     for (auto &pr : _tracks) {
         pr.second.second.flush();
     }
@@ -72,12 +89,23 @@ ssize_t DecoderImp::input(const uint8_t *data, size_t bytes){
     return _decoder->input(data, bytes);
 }
 
+ssize_t DecoderImp::input(const Buffer::Ptr &owner, const uint8_t *data, size_t bytes) {
+    return _decoder->input(owner, data, bytes);
+}
+
+void DecoderImp::reset() {
+    _decoder->reset();
+}
+
 DecoderImp::DecoderImp(const Decoder::Ptr &decoder, MediaSinkInterface *sink){
     _decoder = decoder;
     _sink = sink;
     _decoder->setOnDecode([this](int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes) {
         onDecode(stream, codecid, flags, pts, dts, data, bytes);
     });
+    _decoder->setOnDecodeBuffer([this](int stream, int codecid, int flags, int64_t pts, int64_t dts, const Buffer::Ptr &buffer) {
+        onDecode(stream, codecid, flags, pts, dts, buffer->data(), buffer->size(), buffer);
+    });
     _decoder->setOnStream([this](int stream, int codecid, const void *extra, size_t bytes, int finish) {
         onStream(stream, codecid, extra, bytes, finish);
     });
@@ -107,7 +135,7 @@ void DecoderImp::onStream(int stream, int codecid, const void *extra, size_t byt
     }
 }
 
-void DecoderImp::onDecode(int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes) {
+void DecoderImp::onDecode(int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes, const Buffer::Ptr &buffer) {
     pts /= 90;
     dts /= 90;
 
@@ -124,7 +152,9 @@ void DecoderImp::onDecode(int stream, int codecid, int flags, int64_t pts, int64
         return;
     }
     GET_CONFIG(bool, merge_frame, RtpProxy::kMergeFrame)
-    auto frame = Factory::getFrameFromPtr(codec, (char *)data, bytes, dts, pts);
+    // 解析器输出了缓存时直接引用，避免合并帧时再次拷贝
+    // Reference the buffer directly when the parser outputs it, to avoid copying again when merging frames
+    auto frame = buffer ? Factory::getFrameFromBuffer(codec, buffer, dts, pts) : Factory::getFrameFromPtr(codec, (char *)data, bytes, dts, pts);
     if (getTrackType(codec) != TrackVideo || !merge_frame) {
         onFrame(stream, frame);
         if (_last_is_keyframe && _video_merge) {
@@ -140,7 +170,7 @@ void DecoderImp::onDecode(int stream, int codecid, int flags, int64_t pts, int64
     });
 }
 #else
-void DecoderImp::onDecode(int stream,int codecid,int flags,int64_t pts,int64_t dts,const void *data,size_t bytes) {}
+void DecoderImp::onDecode(int stream,int codecid,int flags,int64_t pts,int64_t dts,const void *data,size_t bytes,const Buffer::Ptr &buffer) {}
 void DecoderImp::onStream(int stream,int codecid,const void *extra,size_t bytes,int finish) {}
 #endif
 
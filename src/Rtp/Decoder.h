@@ -23,11 +23,37 @@ public:
     using Ptr = std::shared_ptr<Decoder>;
     using onDecode = std::function<void(int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes)>;
     using onStream = std::function<void(int stream, int codecid, const void *extra, size_t bytes, int finish)>;
+    using onDecodeBuffer = std::function<void(int stream, int codecid, int flags, int64_t pts, int64_t dts, const toolkit::Buffer::Ptr &buffer)>;
 
     virtual ssize_t input(const uint8_t *data, size_t bytes) = 0;
+
+    /**
+     * 输入数据，owner为data所在的缓存，解析器可以保存该引用以避免拷贝
+     * Input data, owner is the buffer where data is located, the parser can keep this reference to avoid copying
+     */
+    virtual ssize_t input(const toolkit::Buffer::Ptr &owner, const uint8_t *data, size_t bytes) { return input(data, bytes); }
+
+    /**
+     * 输入数据不连续(例如rtp丢包)，丢弃未完成的数据并重新同步
+     * The input data is discontinuous (such as rtp packet loss), discard the incomplete data and resynchronize
+     */
+    virtual void reset() {}
+
+    /**
+     * 输出所有缓存的帧
+     * Output all cached frames
+     */
+    virtual void flush() {}
+
     void setOnDecode(onDecode cb);
     void setOnStream(onStream cb);
 
+    /**
+     * 设置以缓存形式输出帧的回调，设置后优先于onDecode，避免上层再次拷贝
+     * Set the callback of outputting frames as buffers, it takes precedence over onDecode once set, to avoid copying again in the upper layer
+     */
+    void setOnDecodeBuffer(onDecodeBuffer cb);
+
 protected:
     Decoder() = default;
     virtual ~Decoder() = default;
@@ -35,6 +61,7 @@ protected:
 protected:
     onDecode _on_decode;
     onStream _on_stream;
+    onDecodeBuffer _on_decode_buffer;
 };
 
 class DecoderImp {
@@ -45,6 +72,8 @@ public:
 
     static Ptr createDecoder(Type type, MediaSinkInterface *sink);
     ssize_t input(const uint8_t *data, size_t bytes);
+    ssize_t input(const toolkit::Buffer::Ptr &owner, const uint8_t *data, size_t bytes);
+    void reset();
     void flush();
 
 protected:
@@ -53,7 +82,7 @@ protected:
 
 private:
     DecoderImp(const Decoder::Ptr &decoder, MediaSinkInterface *sink);
-    void onDecode(int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes);
+    void onDecode(int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes, const toolkit::Buffer::Ptr &buffer = nullptr);
     void onStream(int stream, int codecid, const void *extra, size_t bytes, int finish);
 
 private:
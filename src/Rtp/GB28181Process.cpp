@@ -59,7 +59,14 @@ GB28181Process::GB28181Process(const MediaInfo &media_info, MediaSinkInterface *
 }
 
 void GB28181Process::onRtpSorted(RtpPacket::Ptr rtp) {
-    _rtp_decoder[rtp->getHeader()->pt]->inputRtp(rtp, false);
+    auto &decoder = _rtp_decoder[rtp->getHeader()->pt];
+    if (decoder) {
+        decoder->inputRtp(rtp, false);
+        return;
+    }
+    // ps/ts负载不合并，直接交给解复用器
+    // ps/ts payloads are not merged, they are handed to the demuxer directly
+    onMpegRtp(std::move(rtp));
 }
 
 void GB28181Process::flush() {
@@ -137,9 +144,12 @@ bool GB28181Process::inputRtp(bool, const char *data, size_t data_len) {
                 WarnL << "Unknown rtp payload type(" << (int)pt << "), decode it as mpeg-ps or mpeg-ts";
             }
             ref = std::make_shared<RtpReceiverImp>(90000, [this](RtpPacket::Ptr rtp) { onRtpSorted(std::move(rtp)); });
-            // ts或ps负载  [AUTO-TRANSLATED:3ca31480]
-            // ts or ps payload
-            _rtp_decoder[pt] = std::make_shared<CommonRtpDecoder>(CodecInvalid, 32 * 1024);
+            GET_CONFIG(bool, ps_stream_demux, RtpProxy::kPSStreamDemux);
+            if (!ps_stream_demux) {
+                // ts或ps负载  [AUTO-TRANSLATED:3ca31480]
+                // ts or ps payload
+                _rtp_decoder[pt] = std::make_shared<CommonRtpDecoder>(CodecInvalid, 32 * 1024);
+            }
             // 设置dump目录  [AUTO-TRANSLATED:23c88ace]
             // Set dump directory
             GET_CONFIG(string, dump_dir, RtpProxy::kDumpDir);
@@ -155,11 +165,14 @@ bool GB28181Process::inputRtp(bool, const char *data, size_t data_len) {
 
         // 设置frame回调  [AUTO-TRANSLATED:dec7590f]
         // Set frame callback
-        _rtp_decoder[pt]->addDelegate([this, pt](const Frame::Ptr &frame) {
-            frame->setIndex(pt);
-            onRtpDecode(frame);
-            return true;
-        });
+        auto &decoder = _rtp_decoder[pt];
+        if (decoder) {
+            decoder->addDelegate([this, pt](const Frame::Ptr &frame) {
+                frame->setIndex(pt);
+                onRtpDecode(frame);
+                return true;
+            });
+        }
     }
 
     return ref->inputRtp(TrackVideo, (unsigned char *)data, data_len);
@@ -185,19 +198,7 @@ void GB28181Process::onRtpDecode(const Frame::Ptr &frame) {
     }
 
     if (!_decoder) {
-        // 创建解码器  [AUTO-TRANSLATED:0cc03d90]
-        // Create decoder
-        if (checkTS((uint8_t *)frame->data(), frame->size())) {
-            // 猜测是ts负载  [AUTO-TRANSLATED:c2be3a47]
-            // Guess it is a ts payload
-            InfoL << _media_info.stream << " judged to be TS";
-            _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ts, _interface);
-        } else {
-            // 猜测是ps负载  [AUTO-TRANSLATED:b7c0ff45]
-            // Guess it is a ps payload
-            InfoL << _media_info.stream << " judged to be PS";
-            _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ps, _interface);
-        }
+        createDecoder((uint8_t *)frame->data(), frame->size());
     }
 
     if (_decoder) {
@@ -205,5 +206,49 @@ void GB28181Process::onRtpDecode(const Frame::Ptr &frame) {
     }
 }
 
+void GB28181Process::onMpegRtp(RtpPacket::Ptr rtp) {
+    auto seq = rtp->getSeq();
+    auto payload = rtp->getPayload();
+    auto size = rtp->getPayloadSize();
+    auto lost = _have_mpeg_seq && (uint16_t)(_mpeg_seq + 1) != seq;
+    _have_mpeg_seq = true;
+    _mpeg_seq = seq;
+    if (!size) {
+        return;
+    }
+    if (_save_file_ps) {
+        fwrite(payload, size, 1, _save_file_ps.get());
+    }
+    if (!_decoder) {
+        createDecoder(payload, size);
+        if (!_decoder) {
+            return;
+        }
+    } else if (lost) {
+        // 丢包后丢弃不完整的帧并重新同步
+        // Discard the incomplete frame and resynchronize after packet loss
+        _decoder->reset();
+    }
+    // 解复用器直接引用rtp包内存
+    // The demuxer references the memory of the rtp packet directly
+    _decoder->input(rtp, payload, size);
+}
+
+void GB28181Process::createDecoder(const uint8_t *data, size_t size) {
+    // 创建解码器  [AUTO-TRANSLATED:0cc03d90]
+    // Create decoder
+    if (checkTS(data, size)) {
+        // 猜测是ts负载  [AUTO-TRANSLATED:c2be3a47]
+        // Guess it is a ts payload
+        InfoL << _media_info.stream << " judged to be TS";
+        _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ts, _interface);
+    } else {
+        // 猜测是ps负载  [AUTO-TRANSLATED:b7c0ff45]
+        // Guess it is a ps payload
+        InfoL << _media_info.stream << " judged to be PS";
+        _decoder = DecoderImp::createDecoder(DecoderImp::decoder_ps, _interface);
+    }
+}
+
 } // namespace mediakit
 #endif // defined(ENABLE_RTPPROXY)
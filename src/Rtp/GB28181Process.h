@@ -56,8 +56,12 @@ protected:
 
 private:
     void onRtpDecode(const Frame::Ptr &frame);
+    void onMpegRtp(RtpPacket::Ptr rtp);
+    void createDecoder(const uint8_t *data, size_t size);
 
 private:
+    bool _have_mpeg_seq = false;
+    uint16_t _mpeg_seq = 0;
     MediaInfo _media_info;
     DecoderImp::Ptr _decoder;
     MediaSinkInterface *_interface;
@@ -11,7 +11,9 @@
 #if defined(ENABLE_RTPPROXY)
 
 #include "PSDecoder.h"
+#include "Extension/StartCode.h"
 #include "mpeg-ps.h"
+#include "mpeg-proto.h"
 
 using namespace toolkit;
 
@@ -75,5 +77,406 @@ const char *PSDecoder::onSearchPacketTail(const char *data, size_t len) {
     }
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////
+
+// PSM最大长度
+// Maximum length of PSM
+static constexpr size_t kMaxPsmSize = 1024;
+// 单帧最大长度，超过后丢弃
+// Maximum size of a single frame, discarded if exceeded
+static constexpr size_t kMaxFrameSize = 16 * 1024 * 1024;
+
+static inline bool isPesId(uint8_t id) {
+    // 0xBD为私有流(海康等厂商会携带)，0xC0~0xDF为音频，0xE0~0xEF为视频
+    // 0xBD is private stream (carried by Hikvision etc.), 0xC0~0xDF is audio, 0xE0~0xEF is video
+    return id == 0xBD || (id >= 0xC0 && id <= 0xEF);
+}
+
+static inline int64_t readTimestamp(const uint8_t *p) {
+    return ((int64_t)(p[0] & 0x0E) << 29) | ((int64_t)p[1] << 22) | ((int64_t)(p[2] & 0xFE) << 14) | ((int64_t)p[3] << 7) | (p[4] >> 1);
+}
+
+ssize_t PSStreamDecoder::input(const uint8_t *data, size_t bytes) {
+    // 没有外部缓存引用，负载在onPayload中拷贝
+    // No reference of external buffer, the payload is copied in onPayload
+    return input(nullptr, data, bytes);
+}
+
+ssize_t PSStreamDecoder::input(const Buffer::Ptr &owner, const uint8_t *data, size_t bytes) {
+    auto ptr = data;
+    auto end = data + bytes;
+    while (ptr < end) {
+        switch (_state) {
+            case kSync: {
+                while (ptr < end) {
+                    _sync_word = (_sync_word << 8) | *ptr++;
+                    if ((_sync_word & 0xFFFFFF00) == 0x00000100 && (_sync_word & 0xFF) >= 0xB9) {
+                        break;
+                    }
+                }
+                if ((_sync_word & 0xFFFFFF00) != 0x00000100 || (_sync_word & 0xFF) < 0xB9) {
+                    break;
+                }
+                _header.assign("\x00\x00\x01", 3);
+                _header.push_back((char)(_sync_word & 0xFF));
+                _sync_word = 0xFFFFFFFF;
+                _state = kHeader;
+                break;
+            }
+
+            case kHeader: {
+                // 头部长度可能随着收集的字节增加而确定，需要循环判断
+                // The header size may be determined as more bytes are collected, so check in a loop
+                auto need = getHeaderSize();
+                while (_header.size() < need && ptr < end) {
+                    auto take = MIN(need - _header.size(), (size_t)(end - ptr));
+                    _header.append((const char *)ptr, take);
+                    ptr += take;
+                    need = getHeaderSize();
+                }
+                if (!need) {
+                    WarnL << "Invalid ps packet header: " << hexdump(_header.data(), MIN(_header.size(), (size_t)32));
+                    _state = kSync;
+                    break;
+                }
+                if (_header.size() >= need) {
+                    onHeader();
+                }
+                break;
+            }
+
+            case kPayload:
+            case kSkip: {
+                auto take = MIN(_remain, (size_t)(end - ptr));
+                if (_state == kPayload) {
+                    onPayload(owner, ptr, take);
+                }
+                ptr += take;
+                _remain -= take;
+                if (!_remain) {
+                    if (_state == kPayload) {
+                        onPesEnd();
+                    }
+                    _state = kSync;
+                }
+                break;
+            }
+
+            default: _state = kSync; break;
+        }
+    }
+    return bytes;
+}
+
+size_t PSStreamDecoder::getHeaderSize() const {
+    auto h = (const uint8_t *)_header.data();
+    auto size = _header.size();
+    auto id = h[3];
+    switch (id) {
+        // program end
+        case 0xB9: return 4;
+        // pack header
+        case 0xBA: {
+            if (size < 5) {
+                return 5;
+            }
+            if ((h[4] & 0xC0) != 0x40) {
+                // mpeg1 pack header
+                return 12;
+            }
+            if (size < 14) {
+                return 14;
+            }
+            return 14 + (h[13] & 0x07);
+        }
+        default: break;
+    }
+
+    if (size < 6) {
+        return 6;
+    }
+    size_t len = (h[4] << 8) | h[5];
+    if (id == 0xBC) {
+        // PSM需要完整收集后解析，过大的PSM直接跳过
+        // PSM needs to be fully collected before parsing, too large PSM is skipped
+        return 6 + len <= kMaxPsmSize ? 6 + len : 6;
+    }
+    if (!isPesId(id)) {
+        return 6;
+    }
+    if (len < 3) {
+        // ps中PES必须指定长度
+        // PES in ps must specify the length
+        return 0;
+    }
+    if (size < 9) {
+        return 9;
+    }
+    if ((h[6] & 0xC0) != 0x80) {
+        // mpeg1 PES，跳过
+        // mpeg1 PES, skip
+        return 9;
+    }
+    if (3 + (size_t)h[8] > len) {
+        return 0;
+    }
+    return 9 + h[8];
+}
+
+void PSStreamDecoder::onHeader() {
+    auto h = (const uint8_t *)_header.data();
+    auto id = h[3];
+    if (id == 0xB9 || id == 0xBA) {
+        onPackEnd();
+        _state = kSync;
+        return;
+    }
+    size_t len = (h[4] << 8) | h[5];
+    if (id == 0xBC && _header.size() == 6 + len) {
+        onPsm(h, _header.size());
+        _state = kSync;
+        return;
+    }
+    if (!isPesId(id) || (h[6] & 0xC0) != 0x80) {
+        // 跳过system header、padding、PSM以外的其他包以及mpeg1 PES
+        // Skip system header, padding, and other packets except PSM, as well as mpeg1 PES
+        _remain = len + 6 - _header.size();
+        _state = _remain ? kSkip : kSync;
+        return;
+    }
+    onPesHeader(h);
+    _remain = len - 3 - h[8];
+    _state = kPayload;
+    if (!_remain) {
+        onPesEnd();
+        _state = kSync;
+    }
+}
+
+void PSStreamDecoder::onPsm(const uint8_t *ptr, size_t size) {
+    // 跳过program_stream_info及末尾的crc32
+    // Skip program_stream_info and the trailing crc32
+    if (size < 16) {
+        return;
+    }
+    size_t pos = 10 + ((ptr[8] << 8) | ptr[9]);
+    if (pos + 2 > size) {
+        return;
+    }
+    size_t map_end = MIN(pos + 2 + ((ptr[pos] << 8) | ptr[pos + 1]), size - 4);
+    pos += 2;
+
+    std::vector<std::pair<uint8_t, int>> streams;
+    bool changed = false;
+    while (pos + 4 <= map_end) {
+        auto type = ptr[pos];
+        auto id = ptr[pos + 1];
+        pos += 4 + ((ptr[pos + 2] << 8) | ptr[pos + 3]);
+        auto &stream = _streams[id];
+        if (stream.codec != type) {
+            stream.codec = type;
+            changed = true;
+        }
+        stream.video = id >= 0xE0 && id <= 0xEF;
+        streams.emplace_back(id, type);
+    }
+    if (!changed || !_on_stream) {
+        return;
+    }
+    for (size_t i = 0; i < streams.size(); ++i) {
+        _on_stream(streams[i].first, streams[i].second, nullptr, 0, i + 1 == streams.size());
+    }
+}
+
+void PSStreamDecoder::onPesHeader(const uint8_t *ptr) {
+    _pes_id = ptr[3];
+    auto &stream = _streams[_pes_id];
+    stream.video = _pes_id >= 0xE0 && _pes_id <= 0xEF;
+    auto header_size = ptr[8];
+    auto has_pts = (ptr[7] & 0x80) && header_size >= 5;
+    auto pts = has_pts ? readTimestamp(ptr + 9) : stream.pts;
+    if (stream.emitted) {
+        stream.emitted = false;
+        if (pts == stream.pts) {
+            // 在pack边界输出的帧还有后续PES，说明该设备的帧跨越多个PS包，已输出的帧不完整，丢弃剩余部分并改为根据pts变化输出
+            // The frame output at the pack boundary still has subsequent PES, which means the frames of this device span multiple ps packs,
+            // the output frame is incomplete, discard the rest and output by pts change instead
+            WarnL << "Ps frame of stream " << (int)_pes_id << " spans multiple packs, output it when the pts changes";
+            stream.split_pack = true;
+            stream.drop = true;
+        }
+    }
+    if (!has_pts) {
+        // 没有pts，是上一帧的后续数据
+        // No pts, it is the subsequent data of the previous frame
+        return;
+    }
+    auto dts = (ptr[7] & 0x40) && header_size >= 10 ? readTimestamp(ptr + 14) : pts;
+    if (stream.bytes && stream.pts != pts) {
+        // 视频帧可能被分成多个相同pts的PES，pts变化说明上一帧收齐了
+        // A video frame may be split into multiple PES with the same pts, pts changed means the previous frame is complete
+        emitFrame(_pes_id, stream);
+    }
+    if (stream.drop && stream.pts != pts) {
+        stream.drop = false;
+        stream.check_start = true;
+    }
+    stream.pts = pts;
+    stream.dts = dts;
+}
+
+void PSStreamDecoder::onPayload(const Buffer::Ptr &owner, const uint8_t *data, size_t size) {
+    auto &stream = _streams[_pes_id];
+    if (stream.drop || !size) {
+        return;
+    }
+    if (stream.check_start && stream.video) {
+        stream.check_start = false;
+        static const uint8_t s_start_code[] = { 0x00, 0x00, 0x00, 0x01 };
+        auto cmp = MIN(size, sizeof(s_start_code));
+        if (memcmp(data, s_start_code, cmp) && memcmp(data, s_start_code + 1, MIN(size, sizeof(s_start_code) - 1))) {
+            stream.drop = true;
+            return;
+        }
+    }
+    if (stream.bytes + size > kMaxFrameSize) {
+        WarnL << "Ps frame too large, dropped: " << stream.bytes + size;
+        stream.slices.clear();
+        stream.bytes = 0;
+        stream.drop = true;
+        return;
+    }
+    if (owner) {
+        stream.slices.emplace_back(Slice { owner, data, size });
+    } else {
+        auto buffer = BufferRaw::create();
+        buffer->assign((const char *)data, size);
+        stream.slices.emplace_back(Slice { buffer, (const uint8_t *)buffer->data(), size });
+    }
+    stream.bytes += size;
+}
+
+void PSStreamDecoder::onPesEnd() {
+    auto &stream = _streams[_pes_id];
+    if (!stream.video) {
+        // 音频一个PES就是完整的一帧(或多帧)
+        // An audio PES is a complete frame (or multiple frames)
+        emitFrame(_pes_id, stream);
+    }
+}
+
+void PSStreamDecoder::onPackEnd() {
+    // 一个PS包通常只包含一帧视频，收到下一个pack header(或program end)时视频帧已收齐，
+    // 立即输出，而不是等到下一帧的pts才输出，从而减少一帧的延时
+    // A ps pack usually contains only one video frame, the video frame is complete when the next pack header (or program end) is received,
+    // output it immediately instead of waiting for the pts of the next frame, which saves one frame of latency
+    for (auto &pr : _streams) {
+        auto &stream = pr.second;
+        if (!stream.video || stream.split_pack || stream.drop || !stream.bytes) {
+            continue;
+        }
+        emitFrame(pr.first, stream);
+        stream.emitted = true;
+    }
+}
+
+void PSStreamDecoder::reset() {
+    _state = kSync;
+    _sync_word = 0xFFFFFFFF;
+    _remain = 0;
+    _header.clear();
+    // 不知道丢失的是哪个流的数据，全部丢弃到下一帧
+    // It is unknown which stream the lost data belongs to, discard all until the next frame
+    for (auto &pr : _streams) {
+        auto &stream = pr.second;
+        stream.slices.clear();
+        stream.bytes = 0;
+        stream.drop = true;
+        stream.emitted = false;
+    }
+}
+
+void PSStreamDecoder::flush() {
+    for (auto &pr : _streams) {
+        emitFrame(pr.first, pr.second);
+    }
+}
+
+bool PSStreamDecoder::probeCodec(uint8_t id, Stream &stream) {
+    // 没有收到PSM时，根据负载内容猜测编码格式
+    // When no PSM is received, guess the codec according to the payload content
+    // 负载开头可能被分成多个很小的分片，取前面一部分拼接后判断
+    // The beginning of the payload may be split into several tiny slices, concatenate the first part before judging
+    uint8_t head[64];
+    size_t head_size = 0;
+    for (auto &slice : stream.slices) {
+        auto take = MIN(slice.size, sizeof(head) - head_size);
+        memcpy(head + head_size, slice.data, take);
+        head_size += take;
+        if (head_size == sizeof(head)) {
+            break;
+        }
+    }
+    auto ptr = head;
+    auto end = head + head_size;
+    if (stream.video) {
+        auto nal = findStartCode((const char *)ptr, (const char *)end);
+        if (!nal || (const uint8_t *)nal + 3 >= end) {
+            return false;
+        }
+        auto type = (uint8_t)nal[3];
+        if (type == 0x40 || type == 0x42 || type == 0x44 || type == 0x46) {
+            // h265 vps/sps/pps/aud
+            stream.codec = PSI_STREAM_H265;
+        } else if (!(type & 0x80)) {
+            switch (type & 0x1F) {
+                case 1: case 5: case 6: case 7: case 8: case 9: stream.codec = PSI_STREAM_H264; break;
+                default: return false;
+            }
+        } else {
+            return false;
+        }
+    } else if (end - ptr >= 2 && ptr[0] == 0xFF && (ptr[1] & 0xF6) == 0xF0) {
+        // adts
+        stream.codec = PSI_STREAM_AAC;
+    } else {
+        return false;
+    }
+    InfoL << "Guess ps stream " << (int)id << " codec: " << getCodecName(getCodecByMpegId(stream.codec));
+    if (_on_stream) {
+        _on_stream(id, stream.codec, nullptr, 0, 0);
+    }
+    return true;
+}
+
+void PSStreamDecoder::emitFrame(uint8_t id, Stream &stream) {
+    if (!stream.bytes) {
+        return;
+    }
+    if (!stream.codec && !probeCodec(id, stream)) {
+        stream.slices.clear();
+        stream.bytes = 0;
+        return;
+    }
+    // 唯一的一次拷贝：把分片列表组装为完整帧
+    // The only copy: assemble the slice list into a complete frame
+    auto buffer = BufferRaw::create();
+    buffer->setCapacity(stream.bytes + 1);
+    auto dst = buffer->data();
+    for (auto &slice : stream.slices) {
+        memcpy(dst, slice.data, slice.size);
+        dst += slice.size;
+    }
+    buffer->setSize(stream.bytes);
+    stream.slices.clear();
+    stream.bytes = 0;
+
+    if (_on_decode_buffer) {
+        _on_decode_buffer(id, stream.codec, 0, stream.pts, stream.dts, buffer);
+    } else if (_on_decode) {
+        _on_decode(id, stream.codec, 0, stream.pts, stream.dts, buffer->data(), buffer->size());
+    }
+}
+
 }//namespace mediakit
 #endif//#if defined(ENABLE_RTPPROXY)
@@ -13,6 +13,8 @@
 
 #if defined(ENABLE_RTPPROXY)
 #include <stdint.h>
+#include <vector>
+#include <unordered_map>
 #include "Decoder.h"
 #include "Http/HttpRequestSplitter.h"
 
@@ -37,6 +39,90 @@ private:
     void *_ps_demuxer = nullptr;
 };
 
+/**
+ * 流式ps解析器，直接解析rtp负载分片，不缓存整包
+ * PES负载以引用输入缓存的分片列表保存，只在输出完整帧时拷贝一次
+ * 视频帧在下一个pack header到达时输出；若设备的帧跨越多个PS包，则退化为在下一帧pts到达时输出(延时一帧)
+ * Streaming ps parser, parses the rtp payload fragments directly without buffering whole packets
+ * PES payloads are saved as a slice list referencing the input buffers, only copied once when outputting a complete frame
+ * Video frames are output when the next pack header arrives; if the frames of the device span multiple ps packs,
+ * it falls back to outputting when the pts of the next frame arrives (one frame latency)
+ */
+class PSStreamDecoder : public Decoder {
+public:
+    ~PSStreamDecoder() override = default;
+
+    ssize_t input(const uint8_t *data, size_t bytes) override;
+    ssize_t input(const toolkit::Buffer::Ptr &owner, const uint8_t *data, size_t bytes) override;
+    void reset() override;
+    void flush() override;
+
+private:
+    enum State {
+        // 查找起始码
+        // Search for the start code
+        kSync = 0,
+        // 收集头部
+        // Collect the header
+        kHeader,
+        // PES负载
+        // PES payload
+        kPayload,
+        // 跳过不关心的包
+        // Skip the packets not cared about
+        kSkip,
+    };
+
+    class Slice {
+    public:
+        toolkit::Buffer::Ptr owner;
+        const uint8_t *data;
+        size_t size;
+    };
+
+    class Stream {
+    public:
+        // PSI_STREAM_xxx，0表示未知
+        // PSI_STREAM_xxx, 0 means unknown
+        int codec = 0;
+        bool video = false;
+        // 丢包后丢弃数据直到下一帧
+        // Discard data after packet loss until the next frame
+        bool drop = false;
+        // 开始解析或丢包后，视频新一帧的负载需要以起始码开头，防止把不完整帧的后续PES当作新帧
+        // When starting or after packet loss, the payload of a new video frame must start with a start code, to prevent the subsequent PES of an incomplete frame from being taken as a new frame
+        bool check_start = true;
+        // 视频帧已在pack边界输出，用于检测帧是否跨越多个PS包
+        // The video frame has been output at the pack boundary, used to detect whether frames span multiple ps packs
+        bool emitted = false;
+        // 帧跨越多个PS包，只能在pts变化时输出(延时一帧)
+        // Frames span multiple ps packs, they can only be output when the pts changes (one frame latency)
+        bool split_pack = false;
+        int64_t pts = 0;
+        int64_t dts = 0;
+        size_t bytes = 0;
+        std::vector<Slice> slices;
+    };
+
+    size_t getHeaderSize() const;
+    void onHeader();
+    void onPsm(const uint8_t *ptr, size_t size);
+    void onPesHeader(const uint8_t *ptr);
+    void onPayload(const toolkit::Buffer::Ptr &owner, const uint8_t *data, size_t size);
+    void onPesEnd();
+    void onPackEnd();
+    void emitFrame(uint8_t id, Stream &stream);
+    bool probeCodec(uint8_t id, Stream &stream);
+
+private:
+    State _state = kSync;
+    uint8_t _pes_id = 0;
+    uint32_t _sync_word = 0xFFFFFFFF;
+    size_t _remain = 0;
+    std::string _header;
+    std::unordered_map<uint8_t, Stream> _streams;
+};
+
 }//namespace mediakit
 #endif//defined(ENABLE_RTPPROXY)
 #endif //ZLMEDIAKIT_PSDECODER_H
@@ -12,6 +12,7 @@
 #include "GB28181Process.h"
 #include "RtpProcess.h"
 #include "Util/File.h"
+#include "Util/onceToken.h"
 #include "Common/config.h"
 
 using namespace std;
@@ -142,7 +143,26 @@ bool RtpProcess::inputRtp(bool is_udp, const Socket::Ptr &sock, const char *data
         return false;
     }
 
-    bool ret = _process ? _process->inputRtp(is_udp, data, len) : false;
+    bool ret = false;
+    if (_process) {
+        // 一个rtp包可能使排序缓存一次输出很多包(例如丢包恢复后)，期间解出的第一帧之后的帧批量输入
+        // One rtp packet may make the sorting cache output many packets at once (e.g. after packet loss recovery),
+        // the frames decoded meanwhile after the first one are input in batch
+        _batching = (bool)_muxer;
+        _batch_count = 0;
+        try {
+            ret = _process->inputRtp(is_udp, data, len);
+        } catch (...) {
+            _batching = false;
+            _frames.clear();
+            throw;
+        }
+        _batching = false;
+        if (!_frames.empty()) {
+            onceToken token(nullptr, [&]() { _frames.clear(); });
+            _muxer->inputFrames(_frames.data(), _frames.size());
+        }
+    }
     if (dts_out) {
         *dts_out = _dts;
     }
@@ -156,6 +176,14 @@ bool RtpProcess::inputFrame(const Frame::Ptr &frame) {
     }
     if (_muxer) {
         _last_frame_time.resetTime();
+        if (_batching && _batch_count++) {
+            // 解复用器的输出帧一般引用其内部缓存，批量缓存前需要拷贝
+            // The frames output by the demuxer usually reference its internal buffer, they must be copied before being cached for the batch
+            _frames.emplace_back(Frame::getCacheAbleFrame(frame));
+            return true;
+        }
+        // 多数情况下一个rtp包最多解出一帧，第一帧直接输入，无需拷贝
+        // In most cases one rtp packet produces at most one frame, the first frame is input directly without copying
         return _muxer->inputFrame(frame);
     }
     if (_cache_ticker.elapsedTime() > kMaxCachedFrameMS) {
@@ -329,7 +357,31 @@ bool RtpProcess::close(mediakit::MediaSource &sender) {
     return true;
 }
 
+void RtpProcess::setUdpReceiver(const UdpBatchReceiver::Ptr &receiver) {
+    _udp_receiver = receiver;
+}
+
+void RtpProcess::setSockShared(bool shared) {
+    _sock_shared = shared;
+}
+
+bool RtpProcess::isPaused() const {
+    return _paused;
+}
+
 bool RtpProcess::pause(MediaSource &sender, bool pause) {
+    _paused = pause;
+    if (_sock_shared) {
+        // 共享的socket上还有其他流，不能停止接收
+        // There are other streams on the shared socket, receiving must not be stopped
+        return true;
+    }
+    if (auto receiver = _udp_receiver.lock()) {
+        // socket的读事件已由批量接收器接管
+        // The read event of the socket has been taken over by the batch receiver
+        receiver->enableRecv(!pause);
+        return true;
+    }
     if (_sock) {
         _sock->enableRecv(!pause);
     }
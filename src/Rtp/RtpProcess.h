@@ -12,9 +12,11 @@
 #define ZLMEDIAKIT_RTPPROCESS_H
 
 #if defined(ENABLE_RTPPROXY)
+#include <atomic>
 #include "ProcessInterface.h"
 #include "Rtcp/RtcpContext.h"
 #include "Common/MultiMediaSourceMuxer.h"
+#include "Common/UdpBatchReceiver.h"
 
 namespace mediakit {
 
@@ -85,6 +87,25 @@ public:
      */
     void setOnlyTrack(OnlyTrack only_track);
 
+    /**
+     * 设置udp批量接收器，暂停推流时通过它停止接收
+     * Set the udp batch receiver, it is used to stop receiving when pausing
+     */
+    void setUdpReceiver(const UdpBatchReceiver::Ptr &receiver);
+
+    /**
+     * 设置socket是否被多个流共享(单端口按ssrc分片)，共享时暂停推流只标记本流，由调用者丢弃其rtp，不停止socket接收
+     * Set whether the socket is shared by multiple streams (single port sharded by ssrc), when shared, pausing only marks this stream,
+     * the caller drops its rtp, and the socket does not stop receiving
+     */
+    void setSockShared(bool shared);
+
+    /**
+     * 是否已被暂停推流
+     * Whether the pushing has been paused
+     */
+    bool isPaused() const;
+
     /**
      * flush输出缓存
      * Flush output cache
@@ -130,6 +151,10 @@ private:
 
 private:
     bool _pause_timeout = false;
+    bool _batching = false;
+    size_t _batch_count = 0;
+    bool _sock_shared = false;
+    std::atomic<bool> _paused { false };
     uint32_t _pause_seconds = 5 * 60;
     uint64_t _dts = 0;
     uint64_t _total_bytes = 0;
@@ -137,6 +162,7 @@ private:
     std::string _auth_err;
     std::unique_ptr<sockaddr_storage> _addr;
     toolkit::Socket::Ptr _sock;
+    std::weak_ptr<UdpBatchReceiver> _udp_receiver;
     MediaInfo _media_info;
     toolkit::Ticker _last_frame_time;
     onDetachCB _on_detach;
@@ -149,6 +175,7 @@ private:
     std::recursive_mutex _func_mtx;
     toolkit::Ticker _cache_ticker;
     std::deque<std::function<void()> > _cached_func;
+    std::vector<Frame::Ptr> _frames;
 };
 
 }//namespace mediakit
@@ -16,6 +16,7 @@
 #include "Util/uv_errno.h"
 #include "RtpCache.h"
 #include "Rtcp/RtcpContext.h"
+#include "Common/UdpBatchSender.h"
 
 using namespace std;
 using namespace toolkit;
@@ -419,14 +420,17 @@ void RtpSender::onFlushRtpList(shared_ptr<List<Buffer::Ptr>> rtp_list) {
     auto send_func = [this](const shared_ptr<List<Buffer::Ptr>> &rtp_list) {
         size_t i = 0;
         auto size = rtp_list->size();
+        // udp模式下一次刷新的rtp批量发送
+        // In udp mode, the rtp of one flush is sent in batch
+        std::vector<Buffer::Ptr> udp_batch;
         rtp_list->for_each([&](Buffer::Ptr &packet) {
             switch (_args.con_type) {
                 case MediaSourceEvent::SendRtpArgs::kUdpActive:
                 case MediaSourceEvent::SendRtpArgs::kUdpPassive: {
-                    onSendRtpUdp(packet, i == 0);
+                    onSendRtpUdp(packet, i++ == 0);
                     // udp模式，rtp over tcp前4个字节可以忽略  [AUTO-TRANSLATED:5d648f4b]
                     // UDP mode, the first 4 bytes of rtp over tcp can be ignored
-                    _socket_rtp->send(std::make_shared<BufferRtp>(std::move(packet), RtpPacket::kRtpTcpHeaderSize), nullptr, 0, ++i == size);
+                    udp_batch.emplace_back(std::make_shared<BufferRtp>(std::move(packet), RtpPacket::kRtpTcpHeaderSize));
                     break;
                 }
                 case MediaSourceEvent::SendRtpArgs::kTcpActive:
@@ -456,6 +460,7 @@ void RtpSender::onFlushRtpList(shared_ptr<List<Buffer::Ptr>> rtp_list) {
                 }
             }
         });
+        UdpBatchSender::send(_socket_rtp, udp_batch);
     };
     if (_args.con_type != MediaSourceEvent::SendRtpArgs::kVoiceTalk) {
         weak_ptr<RtpSender> weak_self = shared_from_this();
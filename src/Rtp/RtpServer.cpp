@@ -9,11 +9,13 @@
  */
 
 #if defined(ENABLE_RTPPROXY)
+#include <unordered_map>
 #include "Util/uv_errno.h"
 #include "RtpServer.h"
 #include "RtpProcess.h"
 #include "Rtcp/RtcpContext.h"
 #include "Common/config.h"
+#include "Common/UdpBatchReceiver.h"
 
 using namespace std;
 using namespace toolkit;
@@ -134,19 +136,259 @@ private:
     std::shared_ptr<struct sockaddr_storage> _rtcp_addr;
 };
 
+// 单端口多路复用时按ssrc分片处理：每个poller线程绑定一个SO_REUSEPORT的udp socket，
+// 收到的rtp按ssrc哈希转发到固定的poller线程解析，同一个ssrc始终在同一个线程处理
+// In single-port multiplex mode, process by ssrc shards: each poller thread binds a SO_REUSEPORT udp socket,
+// the received rtp is forwarded to a fixed poller thread by ssrc hash, the same ssrc is always processed in the same thread
+class RtpShardServer : public std::enable_shared_from_this<RtpShardServer> {
+public:
+    using Ptr = std::shared_ptr<RtpShardServer>;
+
+    RtpShardServer(MediaTuple tuple, int only_track) {
+        _tuple = std::move(tuple);
+        // 多路复用时每个ssrc一个流，与RtpSession一致使用ssrc作为流id，忽略调用者传入的流id
+        // In multiplex mode there is one stream per ssrc, consistent with RtpSession, the ssrc is used as the stream id
+        // and the stream id passed by the caller is ignored
+        _tuple.stream.clear();
+        _only_track = only_track;
+    }
+
+    ~RtpShardServer() {
+        for (auto &shard : _shards) {
+            shard->receiver = nullptr;
+            shard->sock->setOnRead(nullptr);
+            // 在各自线程释放RtpProcess对象
+            // Release RtpProcess objects in their own thread
+            shard->sock->getPoller()->async([shard]() { shard->processes.clear(); }, false);
+        }
+    }
+
+    /**
+     * @param rtp_sock 已经绑定端口的rtp socket，作为第一个分片，其他poller线程以SO_REUSEPORT方式绑定相同端口
+     * @param rtp_sock The rtp socket already bound to the port, as the first shard, other poller threads bind the same port with SO_REUSEPORT
+     */
+    void start(Socket::Ptr rtp_sock, const char *local_ip, int recv_buf) {
+        auto local_port = rtp_sock->get_local_port();
+        auto first_poller = rtp_sock->getPoller();
+        auto first = std::make_shared<Shard>();
+        first->sock = std::move(rtp_sock);
+        _shards.emplace_back(std::move(first));
+
+        EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+            auto poller = std::static_pointer_cast<EventPoller>(executor);
+            if (poller == first_poller) {
+                return;
+            }
+            auto sock = Socket::createSocket(poller, true);
+            if (!sock->bindUdpSock(local_port, local_ip, true)) {
+                // 未开启端口复用时只有第一个分片
+                // Only the first shard if port reuse is not enabled
+                WarnL << "Bind rtp shard socket failed: " << local_ip << ":" << local_port << ", " << get_uv_errmsg(true);
+                return;
+            }
+            SockUtil::setRecvBuf(sock->rawFD(), recv_buf);
+            auto shard = std::make_shared<Shard>();
+            shard->sock = std::move(sock);
+            _shards.emplace_back(std::move(shard));
+        });
+
+        // 分片列表确定后再开始接收
+        // Start receiving after the shard list is determined
+        weak_ptr<RtpShardServer> weak_self = shared_from_this();
+        for (size_t index = 0; index < _shards.size(); ++index) {
+            auto &shard = _shards[index];
+            auto receiver = UdpBatchReceiver::create(shard->sock, [weak_self, index](vector<UdpBatchReceiver::Packet> &pkts) {
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->onRecv(index, pkts);
+                }
+            });
+            if (receiver) {
+                shard->receiver = std::move(receiver);
+                continue;
+            }
+            shard->sock->setOnRead([weak_self, index](const Buffer::Ptr &buf, struct sockaddr *addr, int addr_len) {
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->onRecv(index, buf, addr, addr_len);
+                }
+            });
+        }
+        InfoL << "Rtp multiplex server started with " << _shards.size() << " shards, port: " << local_port;
+    }
+
+    uint16_t getPort() const { return _shards.empty() ? 0 : _shards[0]->sock->get_local_port(); }
+
+private:
+    class Shard {
+    public:
+        Socket::Ptr sock;
+        UdpBatchReceiver::Ptr receiver;
+        // 本分片负责的ssrc及其处理对象，只在本分片poller线程访问
+        // The ssrcs this shard is responsible for and their processing objects, only accessed in the poller thread of this shard
+        std::unordered_map<uint32_t, RtpProcess::Ptr> processes;
+    };
+
+    class Packet {
+    public:
+        uint32_t ssrc;
+        Buffer::Ptr buffer;
+        struct sockaddr_storage addr;
+    };
+
+    static bool parseSSRC(const char *data, size_t len, uint32_t &ssrc) {
+        // 与RtpSession一致，忽略非rtp数据(包括rtcp)，不参与分片
+        // Consistent with RtpSession, ignore non-rtp data (including rtcp), which does not participate in sharding
+        return isRtp(data, len) && getSSRC(data, len, ssrc);
+    }
+
+    size_t getShardIndex(uint32_t ssrc) const {
+        // 乘法哈希打散连续分配的ssrc
+        // Multiplicative hash to scatter consecutively allocated ssrcs
+        return (uint32_t)(ssrc * 2654435761U) % _shards.size();
+    }
+
+    void onRecv(size_t index, const Buffer::Ptr &buf, struct sockaddr *addr, int addr_len) {
+        uint32_t ssrc;
+        if (!parseSSRC(buf->data(), buf->size(), ssrc)) {
+            return;
+        }
+        auto target = getShardIndex(ssrc);
+        if (target == index) {
+            onRtp(index, ssrc, buf->data(), buf->size(), addr);
+            return;
+        }
+        auto pkts = std::make_shared<vector<Packet>>(1);
+        copyPacket(pkts->back(), ssrc, buf, addr, addr_len);
+        forward(target, std::move(pkts));
+    }
+
+    void onRecv(size_t index, vector<UdpBatchReceiver::Packet> &pkts) {
+        // 同一批次中转发到同一分片的包合并为一个任务
+        // Packets in the same batch forwarded to the same shard are merged into one task
+        vector<std::shared_ptr<vector<Packet>>> forwards(_shards.size());
+        for (auto &pkt : pkts) {
+            uint32_t ssrc;
+            if (!parseSSRC(pkt.buffer->data(), pkt.buffer->size(), ssrc)) {
+                continue;
+            }
+            auto target = getShardIndex(ssrc);
+            if (target == index) {
+                onRtp(index, ssrc, pkt.buffer->data(), pkt.buffer->size(), (struct sockaddr *)&pkt.addr);
+                continue;
+            }
+            auto &batch = forwards[target];
+            if (!batch) {
+                batch = std::make_shared<vector<Packet>>();
+                batch->reserve(pkts.size());
+            }
+            // 批量接收的缓存不会被复用，直接转发，无需拷贝
+            // The buffers of batch receiving are not reused, forward them directly without copying
+            batch->emplace_back();
+            auto &fwd = batch->back();
+            fwd.ssrc = ssrc;
+            fwd.buffer = std::move(pkt.buffer);
+            memcpy(&fwd.addr, &pkt.addr, MIN((size_t)pkt.addr_len, sizeof(fwd.addr)));
+        }
+        for (size_t target = 0; target < forwards.size(); ++target) {
+            if (forwards[target]) {
+                forward(target, std::move(forwards[target]));
+            }
+        }
+    }
+
+    static void copyPacket(Packet &pkt, uint32_t ssrc, const Buffer::Ptr &buf, struct sockaddr *addr, int addr_len) {
+        // socket的接收缓存会被复用，跨线程前必须拷贝
+        // The receive buffer of the socket will be reused, it must be copied before crossing threads
+        auto buffer = BufferRaw::create();
+        buffer->assign(buf->data(), buf->size());
+        pkt.ssrc = ssrc;
+        pkt.buffer = std::move(buffer);
+        memcpy(&pkt.addr, addr, MIN((size_t)addr_len, sizeof(pkt.addr)));
+    }
+
+    void forward(size_t target, std::shared_ptr<vector<Packet>> pkts) {
+        weak_ptr<RtpShardServer> weak_self = shared_from_this();
+        _shards[target]->sock->getPoller()->async([weak_self, target, pkts]() {
+            auto strong_self = weak_self.lock();
+            if (!strong_self) {
+                return;
+            }
+            for (auto &pkt : *pkts) {
+                strong_self->onRtp(target, pkt.ssrc, pkt.buffer->data(), pkt.buffer->size(), (struct sockaddr *)&pkt.addr);
+            }
+        }, false);
+    }
+
+    void onRtp(size_t index, uint32_t ssrc, const char *data, size_t len, struct sockaddr *addr) {
+        auto &shard = *_shards[index];
+        auto &process = shard.processes[ssrc];
+        if (!process) {
+            auto tuple = _tuple;
+            tuple.stream = printSSRC(ssrc);
+            process = RtpProcess::createProcess(tuple);
+            process->setOnlyTrack((RtpProcess::OnlyTrack)_only_track);
+            process->setSockShared(true);
+            weak_ptr<RtpShardServer> weak_self = shared_from_this();
+            weak_ptr<RtpProcess> weak_process = process;
+            process->setOnDetach([weak_self, index, ssrc, weak_process](const SockException &ex) {
+                auto strong_self = weak_self.lock();
+                if (!strong_self) {
+                    return;
+                }
+                // 超时定时器可能在其他线程触发，切换到分片线程移除
+                // The timeout timer may be triggered in another thread, switch to the shard thread to remove
+                strong_self->_shards[index]->sock->getPoller()->async([weak_self, index, ssrc, weak_process]() {
+                    auto strong_self = weak_self.lock();
+                    if (!strong_self) {
+                        return;
+                    }
+                    auto &processes = strong_self->_shards[index]->processes;
+                    auto it = processes.find(ssrc);
+                    if (it != processes.end() && it->second == weak_process.lock()) {
+                        processes.erase(it);
+                    }
+                }, false);
+            });
+        }
+        if (process->isPaused()) {
+            // 暂停推流的ssrc在此丢弃，socket由本分片所有ssrc共享
+            // The rtp of the paused ssrc is dropped here, the socket is shared by all ssrcs of this shard
+            return;
+        }
+        try {
+            process->inputRtp(true, shard.sock, data, len, addr);
+        } catch (std::exception &ex) {
+            // 与RtpSession一致，出错后销毁该流，后续rtp将重新创建
+            // Consistent with RtpSession, destroy the stream after an error, subsequent rtp will recreate it
+            auto ptr = std::move(process);
+            shard.processes.erase(ssrc);
+            ptr->onDetach(SockException(Err_shutdown, ex.what()));
+        }
+    }
+
+private:
+    int _only_track = 0;
+    MediaTuple _tuple;
+    std::vector<std::shared_ptr<Shard>> _shards;
+};
+
 void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTuple &tuple, TcpMode tcp_mode, bool re_use_port, uint32_t ssrc, int only_track, bool multiplex) {
     // 创建udp服务器  [AUTO-TRANSLATED:99619428]
     // Create UDP server
     auto poller = EventPollerPool::Instance().getPoller();
     Socket::Ptr rtp_socket = Socket::createSocket(poller, true);
     Socket::Ptr rtcp_socket = Socket::createSocket(poller, true);
+    GET_CONFIG(bool, multiplexShard, RtpProxy::kMultiplexShard);
+    auto use_shard = multiplexShard && (tuple.stream.empty() || multiplex);
+    // 分片模式下其他poller线程需以SO_REUSEPORT绑定相同端口，第一个socket也必须开启端口复用
+    // In shard mode other poller threads need to bind the same port with SO_REUSEPORT, so the first socket must also enable port reuse
+    auto rtp_re_use_port = re_use_port || use_shard;
     if (local_port == 0) {
         // 随机端口，rtp端口采用偶数  [AUTO-TRANSLATED:3664eaf5]
         // Random port, RTP port uses even numbers
         auto pair = std::make_pair(rtp_socket, rtcp_socket);
-        makeSockPair(pair, local_ip, re_use_port);
+        makeSockPair(pair, local_ip, rtp_re_use_port);
         local_port = rtp_socket->get_local_port();
-    } else if (!rtp_socket->bindUdpSock(local_port, local_ip, re_use_port)) {
+    } else if (!rtp_socket->bindUdpSock(local_port, local_ip, rtp_re_use_port)) {
         // 用户指定端口  [AUTO-TRANSLATED:1328393b]
         // User-specified port
         throw std::runtime_error(StrPrinter << "创建rtp端口 " << local_ip << ":" << local_port << " 失败:" << get_uv_errmsg(true));
@@ -165,6 +407,7 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
     // Create UDP server
     UdpServer::Ptr udp_server;
     RtcpHelper::Ptr helper;
+    RtpShardServer::Ptr shard_server;
     // 增加了多路复用判断，如果多路复用为true，就走else逻辑，同时保留了原来stream_id为空走else逻辑  [AUTO-TRANSLATED:114690b1]
     // Added multiplexing judgment. If multiplexing is true, then go to the else logic, while retaining the original stream_id is empty to go to the else logic
     if (!tuple.stream.empty() && !multiplex) {
@@ -176,7 +419,7 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
         bool bind_peer_addr = false;
         auto ssrc_ptr = std::make_shared<uint32_t>(ssrc);
         _ssrc = ssrc_ptr;
-        rtp_socket->setOnRead([rtp_socket, helper, ssrc_ptr, bind_peer_addr](const Buffer::Ptr &buf, struct sockaddr *addr, int addr_len) mutable {
+        auto on_read = [rtp_socket, helper, ssrc_ptr, bind_peer_addr](const Buffer::Ptr &buf, struct sockaddr *addr, int addr_len) mutable {
             RtpHeader *header = (RtpHeader *)buf->data();
             auto rtp_ssrc = ntohl(header->ssrc);
             auto ssrc = *ssrc_ptr;
@@ -191,7 +434,26 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
                 }
                 helper->onRecvRtp(rtp_socket, buf, addr);
             }
+        };
+        // 优先通过recvmmsg批量接收，未开启或不支持时使用socket自身的接收
+        // Prefer receiving in batch via recvmmsg, use the receiving of the socket itself if it is disabled or not supported
+        auto udp_receiver = UdpBatchReceiver::create(rtp_socket, [on_read](vector<UdpBatchReceiver::Packet> &pkts) mutable {
+            for (auto &pkt : pkts) {
+                on_read(pkt.buffer, (struct sockaddr *)&pkt.addr, pkt.addr_len);
+            }
         });
+        if (udp_receiver) {
+            helper->getProcess()->setUdpReceiver(udp_receiver);
+            _udp_receiver = std::move(udp_receiver);
+        } else {
+            rtp_socket->setOnRead(std::move(on_read));
+        }
+    } else if (use_shard) {
+        // 单端口按ssrc分片到多个线程处理，适合大量ssrc来自同一对端的场景
+        // Single port processed by ssrc shards across multiple threads, suitable for many ssrcs from the same peer
+        shard_server = std::make_shared<RtpShardServer>(tuple, only_track);
+        shard_server->start(std::move(rtp_socket), local_ip, udpRecvSocketBuffer);
+        rtp_socket = nullptr;
     } else {
         // 单端口多线程接收多个流，根据ssrc区分流  [AUTO-TRANSLATED:e11c3ca8]
         // Single-port multi-threaded reception of multiple streams, distinguishing streams based on SSRC
@@ -237,6 +499,7 @@ void RtpServer::start(uint16_t local_port, const char *local_ip, const MediaTupl
 
     _tcp_server = tcp_server;
     _udp_server = udp_server;
+    _shard_server = shard_server;
     _rtp_socket = rtp_socket;
     _rtcp_helper = helper;
     _tcp_mode = tcp_mode;
@@ -249,6 +512,9 @@ void RtpServer::setOnDetach(RtpProcess::onDetachCB cb) {
 }
 
 uint16_t RtpServer::getPort() {
+    if (_shard_server) {
+        return _shard_server->getPort();
+    }
     return _udp_server ? _udp_server->getPort() : _rtp_socket->get_local_port();
 }
 
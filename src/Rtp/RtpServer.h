@@ -21,6 +21,8 @@
 namespace mediakit {
 
 class RtcpHelper;
+class RtpShardServer;
+class UdpBatchReceiver;
 
 /**
  * RTP服务器，支持UDP/TCP
@@ -111,6 +113,8 @@ protected:
     toolkit::TcpServer::Ptr _tcp_server;
     std::shared_ptr<uint32_t> _ssrc;
     std::shared_ptr<RtcpHelper> _rtcp_helper;
+    std::shared_ptr<UdpBatchReceiver> _udp_receiver;
+    std::shared_ptr<RtpShardServer> _shard_server;
     std::function<void()> _on_cleanup;
 
     int _only_track = 0;
@@ -15,6 +15,7 @@
 #include "Rtsp/Rtsp.h"
 #include "Rtsp/RtpReceiver.h"
 #include "Common/config.h"
+#include "Extension/StartCode.h"
 
 using namespace std;
 using namespace toolkit;
@@ -164,16 +165,12 @@ static const char *findSSRC(const char *data, ssize_t len, uint32_t ssrc) {
 }
 
 static const char *findPsHeaderFlag(const char *data, ssize_t len) {
-    for (ssize_t i = 2; i <= len - 4; ++i) {
-        auto ptr = (const uint8_t *)data + i;
-        // PsHeader 0x000001ba、PsSystemHeader0x000001bb（关键帧标识）  [AUTO-TRANSLATED:f8146534]
-        // PsHeader 0x000001ba, PsSystemHeader 0x000001bb (keyframe identifier)
-        if (ptr[0] == (0x00) && ptr[1] == (0x00) && ptr[2] == (0x01) && ptr[3] == (0xbb)) {
-            return (const char *)ptr;
-        }
+    if (len < 2 + 4) {
+        return nullptr;
     }
-
-    return nullptr;
+    // PsHeader 0x000001ba、PsSystemHeader0x000001bb（关键帧标识）  [AUTO-TRANSLATED:f8146534]
+    // PsHeader 0x000001ba, PsSystemHeader 0x000001bb (keyframe identifier)
+    return findStartCode(data + 2, data + len, 0xbb);
 }
 
 // rtp长度到ssrc间的长度固定为10  [AUTO-TRANSLATED:7428bd59]
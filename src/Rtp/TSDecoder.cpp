@@ -9,6 +9,9 @@
  */
 
 #include "TSDecoder.h"
+
+using namespace toolkit;
+
 namespace mediakit {
 
 bool TSSegment::isTSPacket(const char *data, size_t len){
@@ -58,6 +61,7 @@ const char *TSSegment::onSearchPacketTail(const char *data, size_t len) {
 
 #if defined(ENABLE_HLS)
 #include "mpeg-ts.h"
+#include "mpeg-proto.h"
 TSDecoder::TSDecoder() : _ts_segment() {
     _ts_segment.setOnSegment([this](const char *data, size_t len){
         ts_demuxer_input(_demuxer_ctx,(uint8_t*)data,len);
@@ -104,6 +108,418 @@ ssize_t TSDecoder::input(const uint8_t *data, size_t bytes) {
     return bytes;
 }
 
+////////////////////////////////////////////////////////////////
+
+// 单帧最大大小，防止异常数据耗尽内存
+// Max size of a single frame, to prevent abnormal data from exhausting memory
+static constexpr size_t kMaxFrameSize = 16 * 1024 * 1024;
+// PSI section最大长度
+// Max length of a PSI section
+static constexpr size_t kMaxSectionSize = 4096;
+static constexpr size_t kPidCount = 8192;
+
+static inline int64_t readTimestamp(const uint8_t *p) {
+    return ((int64_t)(p[0] & 0x0E) << 29) | ((int64_t)p[1] << 22) | ((int64_t)(p[2] & 0xFE) << 14) | ((int64_t)p[3] << 7) | (p[4] >> 1);
+}
+
+TSStreamDecoder::TSStreamDecoder() {
+    _pid_type.resize(kPidCount, kPidIgnore);
+    _pid_stream.resize(kPidCount, 0);
+    _pid_type[0] = kPidPat;
+    _buffer_pool.setSize(64);
+}
+
+ssize_t TSStreamDecoder::input(const uint8_t *data, size_t bytes) {
+    auto ptr = data;
+    auto end = data + bytes;
+    if (!_remain.empty()) {
+        // 先补全上次输入末尾的不完整包
+        // Complete the incomplete packet at the end of the last input first
+        auto take = MIN(TS_PACKET_SIZE - _remain.size(), bytes);
+        _remain.append((const char *)ptr, take);
+        ptr += take;
+        if (_remain.size() < TS_PACKET_SIZE) {
+            return bytes;
+        }
+        onPacket((const uint8_t *)_remain.data());
+        _remain.clear();
+    }
+
+    // 对齐的输入直接原地按188字节批量解析，无需缓存
+    // The aligned input is parsed in place in batches of 188 bytes directly without buffering
+    while (end - ptr >= TS_PACKET_SIZE) {
+        if (*ptr == TS_SYNC_BYTE) {
+            onPacket(ptr);
+            ptr += TS_PACKET_SIZE;
+            continue;
+        }
+        // 失去同步，查找下一个同步字节(如果后面还有完整包，要求下一个包也以同步字节开头)
+        // Out of sync, search for the next sync byte (if there is a complete packet after it, the next packet is required to start with the sync byte too)
+        auto pos = ptr + 1;
+        while ((pos = (const uint8_t *)memchr(pos, TS_SYNC_BYTE, end - pos))) {
+            if (end - pos <= TS_PACKET_SIZE || pos[TS_PACKET_SIZE] == TS_SYNC_BYTE) {
+                break;
+            }
+            ++pos;
+        }
+        WarnL << "Ts packet out of sync, skipped bytes: " << (pos ? pos : end) - ptr;
+        if (!pos) {
+            return bytes;
+        }
+        ptr = pos;
+    }
+    if (ptr < end && *ptr == TS_SYNC_BYTE) {
+        _remain.assign((const char *)ptr, end - ptr);
+    }
+    return bytes;
+}
+
+void TSStreamDecoder::onPacket(const uint8_t *packet) {
+    uint16_t pid = ((packet[1] & 0x1F) << 8) | packet[2];
+    auto type = (PidType)_pid_type[pid];
+    if (type == kPidIgnore) {
+        // 快速路径：未选中的pid不做任何解析
+        // Fast path: no parsing for the unselected pid
+        return;
+    }
+    if (packet[1] & 0x80) {
+        // transport_error_indicator
+        if (type == kPidPes) {
+            _streams[_pid_stream[pid]].corrupt = true;
+        }
+        return;
+    }
+    auto start = (packet[1] & 0x40) != 0;
+    auto afc = (packet[3] >> 4) & 0x03;
+    if (!(afc & 0x01)) {
+        // 没有负载
+        // No payload
+        return;
+    }
+    size_t offset = 4;
+    bool discontinuity = false;
+    bool random_access = false;
+    if (afc & 0x02) {
+        if (packet[4]) {
+            discontinuity = packet[5] & 0x80;
+            random_access = packet[5] & 0x40;
+        }
+        offset += 1 + packet[4];
+        if (offset >= TS_PACKET_SIZE) {
+            return;
+        }
+    }
+    auto payload = packet + offset;
+    auto size = TS_PACKET_SIZE - offset;
+    if (type != kPidPes) {
+        onPsi(pid, type, start, payload, size);
+        return;
+    }
+
+    auto &stream = _streams[_pid_stream[pid]];
+    auto cc = packet[3] & 0x0F;
+    // discontinuity_indicator表示连续性计数器在此包重新开始(如切换节目源)，不是丢包
+    // The discontinuity_indicator means the continuity counter restarts in this packet (such as switching the source), not packet loss
+    if (!discontinuity && stream.cc != 0xFF && cc != ((stream.cc + 1) & 0x0F)) {
+        if (cc == stream.cc) {
+            // 重复包
+            // Duplicate packet
+            return;
+        }
+        WarnL << "Ts packet lost, pid: " << pid << ", cc: " << (int)stream.cc << " -> " << (int)cc;
+        stream.corrupt = true;
+    }
+    stream.cc = cc;
+    onPes(stream, start, random_access, payload, size);
+}
+
+void TSStreamDecoder::onPsi(uint16_t pid, PidType type, bool start, const uint8_t *payload, size_t size) {
+    auto &psi = _psi[pid];
+    if (start) {
+        size_t pointer = payload[0];
+        if (1 + pointer >= size) {
+            psi.clear();
+            return;
+        }
+        if (!psi.empty()) {
+            // pointer_field之前的数据是上一个section的结尾
+            // The data before the pointer_field is the end of the previous section
+            psi.append((const char *)payload + 1, pointer);
+            onSections(pid, type, psi);
+        }
+        psi.assign((const char *)payload + 1 + pointer, size - 1 - pointer);
+    } else if (!psi.empty()) {
+        psi.append((const char *)payload, size);
+    } else {
+        return;
+    }
+    onSections(pid, type, psi);
+}
+
+void TSStreamDecoder::onSections(uint16_t pid, PidType type, std::string &psi) {
+    // 一个ts包内可能有多个section，直到遇到0xFF填充字节
+    // There may be multiple sections in one ts packet, until the 0xFF stuffing byte is encountered
+    size_t offset = 0;
+    while (psi.size() - offset >= 3) {
+        auto section = (const uint8_t *)psi.data() + offset;
+        if (section[0] == 0xFF) {
+            offset = psi.size();
+            break;
+        }
+        size_t section_size = 3 + (((section[1] & 0x0F) << 8) | section[2]);
+        if (section_size > kMaxSectionSize) {
+            WarnL << "Invalid psi section size: " << section_size << ", pid: " << pid;
+            offset = psi.size();
+            break;
+        }
+        if (psi.size() - offset < section_size) {
+            // 等待section的后续部分
+            // Wait for the subsequent part of the section
+            break;
+        }
+        if (type == kPidPat) {
+            onPat(section, section_size);
+        } else {
+            onPmt(pid, section, section_size);
+        }
+        offset += section_size;
+    }
+    psi.erase(0, offset);
+}
+
+void TSStreamDecoder::onPat(const uint8_t *section, size_t size) {
+    // 8字节头部 + 4字节crc32
+    // 8 bytes header + 4 bytes crc32
+    if (section[0] != 0x00 || size < 12) {
+        return;
+    }
+    int version = (section[5] >> 1) & 0x1F;
+    if (version == _pat_version) {
+        return;
+    }
+    _pat_version = version;
+    for (auto ptr = section + 8; ptr + 4 <= section + size - 4; ptr += 4) {
+        uint16_t program = (ptr[0] << 8) | ptr[1];
+        uint16_t pid = ((ptr[2] & 0x1F) << 8) | ptr[3];
+        if (program && _pid_type[pid] == kPidIgnore) {
+            _pid_type[pid] = kPidPmt;
+        }
+    }
+}
+
+void TSStreamDecoder::onPmt(uint16_t pmt_pid, const uint8_t *section, size_t size) {
+    // 12字节头部 + 4字节crc32
+    // 12 bytes header + 4 bytes crc32
+    if (section[0] != 0x02 || size < 16) {
+        return;
+    }
+    int version = (section[5] >> 1) & 0x1F;
+    // 多个节目的PMT可以在同一个pid上传输，以pid和节目号区分
+    // PMTs of multiple programs can be transmitted on the same pid, distinguished by pid and program number
+    uint32_t key = (pmt_pid << 16) | (section[3] << 8) | section[4];
+    auto it = _pmt_version.find(key);
+    if (it != _pmt_version.end() && it->second == version) {
+        // PMT没有变化，这是最常见的情况
+        // PMT has not changed, this is the most common case
+        return;
+    }
+    _pmt_version[key] = version;
+
+    std::vector<std::pair<uint16_t, int>> streams;
+    auto end = section + size - 4;
+    auto ptr = section + 12 + (((section[10] & 0x0F) << 8) | section[11]);
+    while (ptr + 5 <= end) {
+        int codec = ptr[0];
+        uint16_t pid = ((ptr[1] & 0x1F) << 8) | ptr[2];
+        size_t info_size = ((ptr[3] & 0x0F) << 8) | ptr[4];
+        auto info = ptr + 5;
+        ptr = info + info_size;
+        if (ptr > end) {
+            break;
+        }
+        if (codec == 0x06) {
+            // 私有流，通过registration_descriptor识别opus
+            // Private stream, identify opus through the registration_descriptor
+            for (auto desc = info; desc + 2 <= info + info_size; desc += 2 + desc[1]) {
+                if (desc[0] == 0x05 && desc[1] >= 4 && desc + 6 <= info + info_size && !memcmp(desc + 2, "Opus", 4)) {
+                    codec = PSI_STREAM_AUDIO_OPUS;
+                    break;
+                }
+            }
+        }
+        if (getCodecByMpegId(codec) == CodecInvalid) {
+            // 不支持的编码，该pid保持未选中，后续直接跳过
+            // Unsupported codec, the pid remains unselected and is skipped directly afterwards
+            continue;
+        }
+        streams.emplace_back(pid, codec);
+    }
+
+    for (auto &pr : streams) {
+        auto pid = pr.first;
+        if (_pid_type[pid] == kPidPes) {
+            _streams[_pid_stream[pid]].codec = pr.second;
+            continue;
+        }
+        if (_pid_type[pid] != kPidIgnore || _streams.size() >= 0xFF) {
+            continue;
+        }
+        _pid_type[pid] = kPidPes;
+        _pid_stream[pid] = (uint8_t)_streams.size();
+        _streams.emplace_back();
+        _streams.back().pid = pid;
+        _streams.back().codec = pr.second;
+    }
+    if (_on_stream) {
+        for (size_t i = 0; i < streams.size(); ++i) {
+            _on_stream(streams[i].first, streams[i].second, nullptr, 0, i + 1 == streams.size());
+        }
+    }
+}
+
+void TSStreamDecoder::onPes(Stream &stream, bool start, bool key, const uint8_t *payload, size_t size) {
+    if (start) {
+        if (stream.started && !stream.corrupt) {
+            // 不定长PES，下一个PES开始说明上一帧收齐了
+            // Unbounded PES, the start of the next PES means the previous frame is complete
+            emitFrame(stream);
+        } else if (stream.buffer) {
+            stream.buffer->setSize(0);
+        }
+        stream.started = true;
+        stream.corrupt = false;
+        stream.key = key;
+        stream.header_done = false;
+        stream.header.clear();
+    }
+    if (!stream.started || stream.corrupt) {
+        // 从PES中间开始接收或丢包，丢弃直到下一个PES开始
+        // Start receiving from the middle of the PES or packet loss, discard until the start of the next PES
+        return;
+    }
+    if (stream.header_done) {
+        appendPayload(stream, payload, size);
+        return;
+    }
+    if (stream.header.empty() && size >= 9 && size >= 9u + payload[8]) {
+        // PES头在一个ts包内，这是最常见的情况
+        // The PES header is in one ts packet, this is the most common case
+        size_t header_size = 9 + payload[8];
+        onPesHeader(stream, payload, header_size);
+        if (stream.header_done) {
+            appendPayload(stream, payload + header_size, size - header_size);
+        }
+        return;
+    }
+    // PES头跨越了多个ts包，先缓存
+    // The PES header spans multiple ts packets, buffer it first
+    stream.header.append((const char *)payload, size);
+    auto header = (const uint8_t *)stream.header.data();
+    if (stream.header.size() < 9 || stream.header.size() < 9u + header[8]) {
+        return;
+    }
+    size_t header_size = 9 + header[8];
+    onPesHeader(stream, header, header_size);
+    if (stream.header_done) {
+        auto rest = stream.header.substr(header_size);
+        appendPayload(stream, (const uint8_t *)rest.data(), rest.size());
+    }
+    stream.header.clear();
+}
+
+void TSStreamDecoder::onPesHeader(Stream &stream, const uint8_t *header, size_t header_size) {
+    if (header[0] || header[1] || header[2] != 0x01) {
+        WarnL << "Invalid pes header of pid: " << stream.pid;
+        stream.corrupt = true;
+        return;
+    }
+    size_t pes_size = (header[4] << 8) | header[5];
+    stream.expect = pes_size > header_size - 6 ? pes_size - (header_size - 6) : 0;
+    auto flags = header[7];
+    if ((flags & 0x80) && header_size >= 14) {
+        stream.pts = readTimestamp(header + 9);
+        stream.dts = (flags & 0x40) && header_size >= 19 ? readTimestamp(header + 14) : stream.pts;
+    }
+    stream.header_done = true;
+}
+
+void TSStreamDecoder::appendPayload(Stream &stream, const uint8_t *data, size_t size) {
+    if (!stream.buffer) {
+        stream.buffer = _buffer_pool.obtain2();
+        stream.buffer->setCapacity(MAX(stream.capacity_hint, stream.expect) + 1);
+        stream.buffer->setSize(0);
+    }
+    auto &buffer = stream.buffer;
+    auto bytes = buffer->size();
+    if (stream.expect) {
+        // 忽略定长PES末尾多余的数据
+        // Ignore the redundant data at the end of the bounded PES
+        size = MIN(size, stream.expect - bytes);
+    }
+    if (bytes + size + 1 > buffer->getCapacity()) {
+        if (bytes + size > kMaxFrameSize) {
+            WarnL << "Ts frame too large, dropped: " << bytes + size << ", pid: " << stream.pid;
+            buffer->setSize(0);
+            stream.corrupt = true;
+            return;
+        }
+        // 扩容并保留已有数据
+        // Expand and keep the existing data
+        auto bigger = _buffer_pool.obtain2();
+        bigger->setCapacity(MAX(buffer->getCapacity() * 2, bytes + size + 1));
+        memcpy(bigger->data(), buffer->data(), bytes);
+        bigger->setSize(bytes);
+        buffer = std::move(bigger);
+    }
+    memcpy(buffer->data() + bytes, data, size);
+    buffer->setSize(bytes + size);
+    if (stream.expect && buffer->size() >= stream.expect) {
+        // 定长PES收齐后立即输出，无需等待下一个PES
+        // Output the bounded PES immediately when complete, no need to wait for the next PES
+        emitFrame(stream);
+        stream.started = false;
+    }
+}
+
+void TSStreamDecoder::emitFrame(Stream &stream) {
+    if (!stream.buffer || !stream.buffer->size()) {
+        return;
+    }
+    BufferRaw::Ptr buffer;
+    buffer.swap(stream.buffer);
+    stream.capacity_hint = MAX(stream.capacity_hint, buffer->size());
+    int flags = stream.key ? MPEG_FLAG_IDR_FRAME : 0;
+    if (_on_decode_buffer) {
+        _on_decode_buffer(stream.pid, stream.codec, flags, stream.pts, stream.dts, buffer);
+    } else if (_on_decode) {
+        _on_decode(stream.pid, stream.codec, flags, stream.pts, stream.dts, buffer->data(), buffer->size());
+    }
+}
+
+void TSStreamDecoder::reset() {
+    _remain.clear();
+    _psi.clear();
+    // 不知道丢失的是哪个pid的数据，全部丢弃到下一个PES
+    // It is unknown which pid the lost data belongs to, discard all until the next PES
+    for (auto &stream : _streams) {
+        stream.cc = 0xFF;
+        stream.started = false;
+        stream.header.clear();
+        if (stream.buffer) {
+            stream.buffer->setSize(0);
+        }
+    }
+}
+
+void TSStreamDecoder::flush() {
+    for (auto &stream : _streams) {
+        if (stream.started && !stream.corrupt) {
+            emitFrame(stream);
+        }
+        stream.started = false;
+    }
+}
+
 #endif//defined(ENABLE_HLS)
 
 }//namespace mediakit
@@ -11,7 +11,10 @@
 #ifndef ZLMEDIAKIT_TSDECODER_H
 #define ZLMEDIAKIT_TSDECODER_H
 
+#include <vector>
+#include <unordered_map>
 #include "Util/logger.h"
+#include "Util/ResourcePool.h"
 #include "Http/HttpRequestSplitter.h"
 #include "Decoder.h"
 
@@ -51,6 +54,94 @@ private:
     TSSegment _ts_segment;
     struct ts_demuxer_t* _demuxer_ctx = nullptr;
 };
+
+/**
+ * 增量式ts解析器，按188字节对齐批量解析输入数据，只有跨越输入边界的包才会被缓存
+ * 通过pid索引表快速跳过未选中的pid，PES负载直接组装到池化缓存中作为输出帧
+ * Incremental ts parser, parses the input data in 188-byte aligned batches, only the packets crossing the input boundary are buffered
+ * Skips the unselected pids quickly through the pid index table, PES payloads are assembled directly into pooled buffers as output frames
+ */
+class TSStreamDecoder : public Decoder {
+public:
+    TSStreamDecoder();
+    ~TSStreamDecoder() override = default;
+
+    ssize_t input(const uint8_t *data, size_t bytes) override;
+    void reset() override;
+    void flush() override;
+
+private:
+    enum PidType : uint8_t {
+        // 未选中的pid，直接跳过
+        // Unselected pid, skip directly
+        kPidIgnore = 0,
+        kPidPat,
+        kPidPmt,
+        kPidPes,
+    };
+
+    class Stream {
+    public:
+        uint16_t pid = 0;
+        // PSI_STREAM_xxx
+        int codec = 0;
+        // 连续性计数器，0xFF表示未知
+        // Continuity counter, 0xFF means unknown
+        uint8_t cc = 0xFF;
+        // 正在接收PES
+        // Receiving PES
+        bool started = false;
+        // 丢包后丢弃当前PES
+        // Discard the current PES after packet loss
+        bool corrupt = false;
+        // PES头还未接收完整
+        // PES header has not been received completely
+        bool header_done = false;
+        std::string header;
+        // 当前PES开始的ts包带有random_access_indicator
+        // The ts packet starting the current PES carries the random_access_indicator
+        bool key = false;
+        // PES负载长度，0表示不定长(等待下一个PES开始)
+        // PES payload length, 0 means unbounded (waiting for the start of the next PES)
+        size_t expect = 0;
+        // 以前帧的最大大小作为预分配大小，避免频繁扩容
+        // Use the max size of the previous frames as the preallocated size to avoid frequent expansion
+        size_t capacity_hint = 0;
+        int64_t pts = 0;
+        int64_t dts = 0;
+        toolkit::BufferRaw::Ptr buffer;
+    };
+
+    void onPacket(const uint8_t *packet);
+    void onPsi(uint16_t pid, PidType type, bool start, const uint8_t *payload, size_t size);
+    void onSections(uint16_t pid, PidType type, std::string &psi);
+    void onPat(const uint8_t *section, size_t size);
+    void onPmt(uint16_t pmt_pid, const uint8_t *section, size_t size);
+    void onPes(Stream &stream, bool start, bool key, const uint8_t *payload, size_t size);
+    void onPesHeader(Stream &stream, const uint8_t *payload, size_t size);
+    void appendPayload(Stream &stream, const uint8_t *data, size_t size);
+    void emitFrame(Stream &stream);
+
+private:
+    // pid类型索引表
+    // Pid type index table
+    std::vector<uint8_t> _pid_type;
+    // pid到_streams下标的索引表
+    // Index table from pid to _streams subscript
+    std::vector<uint8_t> _pid_stream;
+    std::vector<Stream> _streams;
+    // 跨越输入边界的不完整ts包
+    // Incomplete ts packet crossing the input boundary
+    std::string _remain;
+    // 每个PSI pid正在接收的section
+    // The section being received of each PSI pid
+    std::unordered_map<uint16_t, std::string> _psi;
+    int _pat_version = -1;
+    // (pid << 16 | 节目号)到PMT版本号的映射
+    // Mapping from (pid << 16 | program number) to PMT version
+    std::unordered_map<uint32_t, int> _pmt_version;
+    toolkit::ResourcePool<toolkit::BufferRaw> _buffer_pool;
+};
 #endif//defined(ENABLE_HLS)
 
 }//namespace mediakit
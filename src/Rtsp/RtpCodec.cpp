@@ -17,13 +17,31 @@ RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void* data, size_t len, bo
     auto rtp = RtpPacket::create();
     rtp->setCapacity(payload_len + RtpPacket::kRtpTcpHeaderSize);
     rtp->setSize(payload_len + RtpPacket::kRtpTcpHeaderSize);
-    rtp->sample_rate = _sample_rate;
-    rtp->type = type;
-    rtp->track_index = _track_index;
+    auto ptr = setupRtp(*rtp, type, len, mark, stamp);
+    // 有效负载  [AUTO-TRANSLATED:8530a274]
+    // payload
+    if (data) {
+        memcpy(ptr, data, len);
+    }
+    return rtp;
+}
+
+RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void *head, size_t head_len, toolkit::Buffer::Ptr holder, const char *ref, size_t ref_len, bool mark, uint64_t stamp) {
+    auto rtp = RtpPacket::create(RtpPacket::kRtpTcpHeaderSize + RtpPacket::kRtpHeaderSize + head_len, std::move(holder), ref, ref_len);
+    auto ptr = setupRtp(*rtp, type, head_len + ref_len, mark, stamp);
+    memcpy(ptr, head, head_len);
+    return rtp;
+}
+
+uint8_t *RtpInfo::setupRtp(RtpPacket &rtp, TrackType type, size_t len, bool mark, uint64_t stamp) {
+    uint16_t payload_len = (uint16_t) (len + RtpPacket::kRtpHeaderSize);
+    rtp.sample_rate = _sample_rate;
+    rtp.type = type;
+    rtp.track_index = _track_index;
 
     // rtsp over tcp 头  [AUTO-TRANSLATED:4225b9ec]
     // rtsp over tcp header
-    auto ptr = (uint8_t *) rtp->data();
+    auto ptr = (uint8_t *) rtp.BufferRaw::data();
     ptr[0] = '$';
     ptr[1] = _interleaved;
     ptr[2] = payload_len >> 8;
@@ -31,7 +49,7 @@ RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void* data, size_t len, bo
 
     // rtp头  [AUTO-TRANSLATED:64aef747]
     // rtp header
-    auto header = rtp->getHeader();
+    auto header = rtp.getHeader();
     header->version = RtpPacket::kRtpVersion;
     header->padding = 0;
     header->ext = 0;
@@ -42,13 +60,8 @@ RtpPacket::Ptr RtpInfo::makeRtp(TrackType type, const void* data, size_t len, bo
     ++_seq;
     header->stamp = htonl(uint64_t(stamp) * _sample_rate / 1000);
     header->ssrc = htonl(_ssrc);
-    rtp->ntp_stamp = stamp;
-    // 有效负载  [AUTO-TRANSLATED:8530a274]
-    // payload
-    if (data) {
-        memcpy(&ptr[RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize], data, len);
-    }
-    return rtp;
+    rtp.ntp_stamp = stamp;
+    return &ptr[RtpPacket::kRtpHeaderSize + RtpPacket::kRtpTcpHeaderSize];
 }
 
 }//namespace mediakit
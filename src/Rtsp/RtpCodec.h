@@ -84,6 +84,26 @@ public:
 
     RtpPacket::Ptr makeRtp(TrackType type,const void *data, size_t len, bool mark, uint64_t stamp);
 
+    /**
+     * 生成零拷贝rtp包，负载由head与ref两部分组成，只拷贝head(如FU头)，ref引用自holder
+     * @param head 负载头部，拷贝到rtp包内
+     * @param head_len 负载头部长度
+     * @param holder ref所属的帧，rtp包释放前一直持有
+     * @param ref 负载剩余部分，不拷贝
+     * @param ref_len 负载剩余部分长度
+     * Generate a zero copy rtp packet, the payload consists of head and ref, only head (such as the FU header) is copied,
+     * ref is referenced from holder
+     * @param head Payload header, copied into the rtp packet
+     * @param head_len Payload header length
+     * @param holder The frame to which ref belongs, held until the rtp packet is released
+     * @param ref The rest of the payload, not copied
+     * @param ref_len The rest of the payload length
+     */
+    RtpPacket::Ptr makeRtp(TrackType type, const void *head, size_t head_len, toolkit::Buffer::Ptr holder, const char *ref, size_t ref_len, bool mark, uint64_t stamp);
+
+private:
+    uint8_t *setupRtp(RtpPacket &rtp, TrackType type, size_t len, bool mark, uint64_t stamp);
+
 private:
     uint8_t _pt;
     uint8_t _interleaved;
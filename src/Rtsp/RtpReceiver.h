@@ -12,6 +12,8 @@
 #define ZLMEDIAKIT_RTPRECEIVER_H
 
 #include <map>
+#include <vector>
+#include <algorithm>
 #include <string>
 #include <memory>
 #include "Rtsp/Rtsp.h"
@@ -22,11 +24,17 @@
 
 namespace mediakit {
 
+/**
+ * rtp排序器(抖动缓冲)
+ * 乱序包保存在以seq % 容量为下标的环形数组中，顺序到达时直接输出，无需分配内存
+ * Rtp sorter (jitter buffer)
+ * Out-of-order packets are stored in a circular array indexed by seq % capacity, packets arriving in order
+ * are output directly without memory allocation
+ */
 template<typename T, typename SEQ = uint16_t>
 class PacketSortor {
 public:
     static constexpr SEQ SEQ_MAX = (std::numeric_limits<SEQ>::max)();
-    using iterator = typename std::map<SEQ, T>::iterator;
 
     virtual ~PacketSortor() = default;
 
@@ -41,7 +49,14 @@ public:
     void clear() {
         _started = false;
         _ticker.resetTime();
-        _pkt_sort_cache_map.clear();
+        for (auto &slot : _slots) {
+            if (slot.used) {
+                slot.used = false;
+                slot.packet = T();
+            }
+        }
+        _count = 0;
+        _pkt_drop_cache.clear();
     }
 
     /**
@@ -50,7 +65,7 @@ public:
      
      * [AUTO-TRANSLATED:8e05a703]
      */
-    size_t getJitterSize() const { return _pkt_sort_cache_map.size(); }
+    size_t getJitterSize() const { return _count; }
 
     /**
      * 输入并排序
@@ -77,132 +92,170 @@ public:
             // 清空连续包列表  [AUTO-TRANSLATED:fdaafd3b]
             // Clear the continuous packet list
             flushPacket();
-            _pkt_drop_cache_map.clear();
+            _pkt_drop_cache.clear();
             return;
         }
 
-        if (seq < _next_seq && !mayLooped(_next_seq, seq)) {
-            // 无回环风险, 缓存seq回退包  [AUTO-TRANSLATED:4200dd1b]
-            // No loop risk, cache seq rollback packets
-            _pkt_drop_cache_map.emplace(seq, std::move(packet));
-            if (_pkt_drop_cache_map.size() > _max_distance || _ticker.elapsedTime() > _max_buffer_ms) {
+        // 考虑回环后seq领先next_seq的距离
+        // The distance that seq is ahead of next_seq, considering the loop
+        auto ahead = static_cast<SEQ>(seq - _next_seq);
+        if (ahead > SEQ_MAX >> 1) {
+            // seq回退包(迟到或重复)，缓存之
+            // Seq rollback packet (late or duplicated), cache it
+            _pkt_drop_cache.emplace_back(seq, std::move(packet));
+            if (_pkt_drop_cache.size() > _max_distance || _ticker.elapsedTime() > _max_buffer_ms) {
                 // seq回退包太多，可能源端重置seq计数器，这部分数据需要输出  [AUTO-TRANSLATED:d31aead7]
                 // Too many seq rollback packets, the source may reset the seq counter, this part of data needs to be output
-                forceFlush(_next_seq);
-                // 旧的seq计数器的数据清空后把新seq计数器的数据赋值给排序列队  [AUTO-TRANSLATED:f69f864c]
-                // After clearing the data of the old seq counter, assign the data of the new seq counter to the sorting queue
-                _pkt_sort_cache_map = std::move(_pkt_drop_cache_map);
-                popIterator(_pkt_sort_cache_map.begin());
+                resetSeq();
             }
             return;
         }
-        _pkt_sort_cache_map.emplace(seq, std::move(packet));
 
-        if (needForceFlush(seq)) {
-            forceFlush(_next_seq);
+        while (_count && static_cast<SEQ>(seq - _next_seq) > _max_distance) {
+            // seq跳跃太大，丢包无法恢复，依次输出最近的缓存包直到该包落入排序窗口
+            // The seq jump is too large, the packet loss cannot be recovered, output the nearest cached packets in turn until
+            // this packet falls into the sorting window
+            forceFlush();
+        }
+        ahead = static_cast<SEQ>(seq - _next_seq);
+        if (!ahead || ahead > _max_distance) {
+            // 该包已是下一个包，或缓存已空需从该包重新开始
+            // This packet is already the next one, or the cache is empty and needs to restart from this packet
+            output(seq, std::move(packet));
+            flushPacket();
+            return;
         }
-    }
 
-    void flush() {
-        if (!_pkt_sort_cache_map.empty()) {
-            forceFlush(_next_seq);
-            _pkt_sort_cache_map.clear();
+        insert(seq, std::move(packet));
+        if (_count > _max_buffer_size || _ticker.elapsedTime() > _max_buffer_ms) {
+            forceFlush();
         }
     }
 
+    void flush() { flushAll(); }
+
     void setParams(size_t max_buffer_size, size_t max_buffer_ms, size_t max_distance) {
+        // 环形数组容量与max_distance相关，先输出已缓存的包
+        // The capacity of the circular array is related to max_distance, output the cached packets first
+        flushAll();
+        _slots.clear();
         _max_buffer_size = max_buffer_size;
         _max_buffer_ms = max_buffer_ms;
-        _max_distance = max_distance;
+        _max_distance = MIN(max_distance, (size_t)(SEQ_MAX >> 1));
     }
 
 private:
-    SEQ distance(SEQ seq) {
-        SEQ ret;
-        if (seq > _next_seq) {
-            ret = seq - _next_seq;
-        } else {
-            ret = _next_seq - seq;
+    struct Slot {
+        bool used = false;
+        SEQ seq = 0;
+        T packet;
+    };
+
+    void insert(SEQ seq, T packet) {
+        if (_slots.empty()) {
+            // 容量为大于max_distance的2的幂，缓存中的包与next_seq的距离不超过max_distance，所以不会冲突
+            // The capacity is a power of 2 greater than max_distance, the distance between the cached packets and next_seq
+            // does not exceed max_distance, so there is no conflict
+            size_t capacity = 1;
+            while (capacity <= _max_distance) {
+                capacity <<= 1;
+            }
+            _slots.resize(capacity);
+            _mask = capacity - 1;
         }
-        if (ret > SEQ_MAX >> 1) {
-            return SEQ_MAX - ret;
+        auto &slot = _slots[seq & _mask];
+        if (slot.used) {
+            // 重复包，保留先收到的
+            // Duplicated packet, keep the first received one
+            return;
         }
-        return ret;
+        slot.used = true;
+        slot.seq = seq;
+        slot.packet = std::move(packet);
+        ++_count;
     }
 
-    bool needForceFlush(SEQ seq) {
-        return _pkt_sort_cache_map.size() > _max_buffer_size || distance(seq) > _max_distance || _ticker.elapsedTime() > _max_buffer_ms;
-    }
-
-    void forceFlush(SEQ next_seq) {
-        if (_pkt_sort_cache_map.empty()) {
+    void forceFlush() {
+        if (!_count) {
             return;
         }
         // 寻找距离比next_seq大的最近的seq  [AUTO-TRANSLATED:d2de6f5b]
         // Find the nearest seq that is greater than next_seq
-        auto it = _pkt_sort_cache_map.lower_bound(next_seq);
-        if (it == _pkt_sort_cache_map.end()) {
-            // 没有比next_seq更大的seq，应该是回环时丢包导致  [AUTO-TRANSLATED:d0d6970b]
-            // There is no seq greater than next_seq, it should be caused by packet loss during loopback
-            it = _pkt_sort_cache_map.begin();
-        }
+        auto seq = _next_seq;
+        while (!_slots[(++seq) & _mask].used) {}
         // 丢包无法恢复，把这个包当做next_seq  [AUTO-TRANSLATED:2d8c0b9e]
         // Packet loss cannot be recovered, treat this packet as next_seq
-        popIterator(it);
+        popSlot(_slots[seq & _mask]);
         // 清空连续包列表  [AUTO-TRANSLATED:fdaafd3b]
         // Clear the continuous packet list
         flushPacket();
-        // 删除距离next_seq太大的包  [AUTO-TRANSLATED:9e774c5e]
-        // Delete packets that are too far away from next_seq
-        for (auto it = _pkt_sort_cache_map.begin(); it != _pkt_sort_cache_map.end();) {
-            if (distance(it->first) > _max_distance) {
-                it = _pkt_sort_cache_map.erase(it);
-            } else {
-                ++it;
-            }
-        }
     }
 
-    bool mayLooped(SEQ last_seq, SEQ now_seq) { return last_seq > SEQ_MAX - _max_distance || now_seq < _max_distance; }
-
-    void flushPacket() {
-        if (_pkt_sort_cache_map.empty()) {
-            return;
-        }
-        auto it = _pkt_sort_cache_map.lower_bound(_next_seq);
-        if (!mayLooped(_next_seq, _next_seq)) {
-            // 无回环风险, 清空 < next_seq的值  [AUTO-TRANSLATED:10c77bf9]
-            // No loop risk, clear values less than next_seq
-            it = _pkt_sort_cache_map.erase(_pkt_sort_cache_map.begin(), it);
+    void flushAll() {
+        while (_count) {
+            forceFlush();
         }
+    }
 
-        while (it != _pkt_sort_cache_map.end()) {
+    void flushPacket() {
+        while (_count) {
             // 找到下一个包  [AUTO-TRANSLATED:8e20ab9f]
             // Find the next packet
-            if (it->first == _next_seq) {
-                it = popIterator(it);
-                continue;
+            auto &slot = _slots[_next_seq & _mask];
+            if (!slot.used) {
+                break;
             }
-            break;
+            popSlot(slot);
         }
     }
 
-    iterator popIterator(iterator it) {
-        try {
-            output(it->first, std::move(it->second));
-            return _pkt_sort_cache_map.erase(it);
-        } catch (...) {
-            // 防止抛异常未移除迭代器，导致rtp包为空
-            _pkt_sort_cache_map.erase(it);
-            throw;
+    void resetSeq() {
+        flushAll();
+        auto cache = std::move(_pkt_drop_cache);
+        _pkt_drop_cache.clear();
+        // 旧的seq计数器的数据清空后，新seq计数器的数据按seq排序后重新输入；
+        // 以最后收到的包为基准，丢弃距离超过max_distance的迟到包，再按有符号距离排序，以正确处理回环
+        // After clearing the data of the old seq counter, the data of the new seq counter is sorted by seq and input again;
+        // based on the last received packet, the late packets farther than max_distance are discarded, and then sorted by the
+        // signed distance to handle the loop correctly
+        auto base = cache.back().first;
+        auto max_distance = _max_distance;
+        auto distance = [base](SEQ seq) {
+            auto ahead = static_cast<SEQ>(seq - base);
+            return ahead > SEQ_MAX >> 1 ? -(int64_t)static_cast<SEQ>(base - seq) : (int64_t)ahead;
+        };
+        cache.erase(std::remove_if(cache.begin(), cache.end(), [&](const std::pair<SEQ, T> &item) {
+            auto dis = distance(item.first);
+            return dis > (int64_t)max_distance || -dis > (int64_t)max_distance;
+        }), cache.end());
+        std::stable_sort(cache.begin(), cache.end(), [&](const std::pair<SEQ, T> &a, const std::pair<SEQ, T> &b) { return distance(a.first) < distance(b.first); });
+        output(cache[0].first, std::move(cache[0].second));
+        for (size_t i = 1; i < cache.size(); ++i) {
+            auto ahead = static_cast<SEQ>(cache[i].first - _next_seq);
+            if (ahead == 0) {
+                output(cache[i].first, std::move(cache[i].second));
+                flushPacket();
+            } else if (ahead <= _max_distance) {
+                insert(cache[i].first, std::move(cache[i].second));
+            }
         }
     }
 
+    void popSlot(Slot &slot) {
+        // 先从缓存移除再输出，防止回调抛异常后缓存中残留空包
+        // Remove from the cache before output to prevent empty packets remaining in the cache after the callback throws an exception
+        slot.used = false;
+        --_count;
+        auto packet = std::move(slot.packet);
+        slot.packet = T();
+        output(slot.seq, std::move(packet));
+    }
+
     void output(SEQ seq, T packet) {
         if (seq != _next_seq) {
             WarnL << "packet dropped: " << _next_seq << " -> " << static_cast<SEQ>(seq - 1)
                   << ", latest seq: " << _latest_seq
-                  << ", jitter buffer size: " << _pkt_sort_cache_map.size()
+                  << ", jitter buffer size: " << _count
                   << ", jitter buffer ms: " << _ticker.elapsedTime();
         }
         _next_seq = static_cast<SEQ>(seq + 1);
@@ -230,12 +283,16 @@ private:
     // 下次应该输出的SEQ  [AUTO-TRANSLATED:e757a4fa]
     // The next SEQ to be output
     SEQ _next_seq = 0;
-    // pkt排序缓存，根据seq排序  [AUTO-TRANSLATED:3787f9a6]
-    // pkt sorting cache, sorted by seq
-    std::map<SEQ, T> _pkt_sort_cache_map;
+    // pkt排序缓存，以seq % 容量为下标的环形数组
+    // Pkt sorting cache, a circular array indexed by seq % capacity
+    std::vector<Slot> _slots;
+    size_t _mask = 0;
+    // 排序缓存中的包个数
+    // Number of packets in the sorting cache
+    size_t _count = 0;
     // 预丢弃包列表  [AUTO-TRANSLATED:67e57ebc]
     // Pre-discard packet list
-    std::map<SEQ, T> _pkt_drop_cache_map;
+    std::vector<std::pair<SEQ, T>> _pkt_drop_cache;
     // 回调  [AUTO-TRANSLATED:03bad27d]
     // Callback
     std::function<void(SEQ seq, T packet)> _cb;
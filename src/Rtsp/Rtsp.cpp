@@ -11,6 +11,7 @@
 #include <cstdlib>
 #include <cinttypes>
 #include <random>
+#include <thread>
 #include "Rtsp.h"
 #include "Network/Socket.h"
 #include "Common/Parser.h"
@@ -662,11 +663,13 @@ string RtpHeader::dumpString(size_t rtp_size) const {
 RtpHeader *RtpPacket::getHeader() {
     // 需除去rtcp over tcp 4个字节长度  [AUTO-TRANSLATED:936f6f5b]
     // Need to remove the rtcp over tcp 4 byte length
-    return (RtpHeader *)(data() + RtpPacket::kRtpTcpHeaderSize);
+    // 头部总是保存在本包内，无需拷贝零拷贝负载
+    // The header is always stored in this packet, no need to copy the zero copy payload
+    return (RtpHeader *)(BufferRaw::data() + RtpPacket::kRtpTcpHeaderSize);
 }
 
 const RtpHeader *RtpPacket::getHeader() const {
-    return (RtpHeader *)(data() + RtpPacket::kRtpTcpHeaderSize);
+    return (RtpHeader *)(BufferRaw::data() + RtpPacket::kRtpTcpHeaderSize);
 }
 
 string RtpPacket::dumpString() const {
@@ -690,6 +693,9 @@ uint32_t RtpPacket::getSSRC() const {
 }
 
 uint8_t *RtpPacket::getPayload() {
+    if (_ref_size) {
+        flatten();
+    }
     return getHeader()->getPayloadData();
 }
 
@@ -699,18 +705,99 @@ size_t RtpPacket::getPayloadSize() const {
     return getHeader()->getPayloadSize(size() - kRtpTcpHeaderSize);
 }
 
+char *RtpPacket::data() const {
+    // _ref_size在rtp包发布前设置、回收时清空，普通包无需访问原子变量
+    // _ref_size is set before the rtp packet is published and cleared when recycled, normal packets do not need to access the atomic variable
+    if (_ref_size) {
+        flatten();
+    }
+    return BufferRaw::data();
+}
+
+char *RtpSlice::data() const {
+    if (_ref) {
+        return (char *)_rtp->_ref;
+    }
+    // 通过BufferRaw::data()访问头部，避免触发负载拷贝
+    // Access the header through BufferRaw::data() to avoid triggering the payload copy
+    return _rtp->BufferRaw::data() + _offset;
+}
+
+size_t RtpSlice::size() const {
+    return _ref ? _rtp->_ref_size : _rtp->getHeadSize() - _offset;
+}
+
+void RtpPacket::flatten() const {
+    if (_flat_state.load(std::memory_order_acquire) == kFlatDone) {
+        return;
+    }
+    uint8_t state = kFlatNone;
+    if (_flat_state.compare_exchange_strong(state, kFlatBusy, std::memory_order_acq_rel)) {
+        // 内存已在创建时预留，此处不会重新分配内存
+        // The memory has been reserved when created, no reallocation here
+        memcpy(BufferRaw::data() + size() - _ref_size, _ref, _ref_size);
+        _flat_state.store(kFlatDone, std::memory_order_release);
+        return;
+    }
+    // 其他线程正在拷贝
+    // Another thread is copying
+    while (_flat_state.load(std::memory_order_acquire) != kFlatDone) {
+        std::this_thread::yield();
+    }
+}
+
+void RtpPacket::clearRef() {
+    _holder = nullptr;
+    _ref = nullptr;
+    _ref_size = 0;
+    _flat_state.store(kFlatDone, std::memory_order_relaxed);
+}
+
+bool RtpPacket::onRecycle(RtpPacket *rtp) {
+    // 释放引用的帧
+    // Release the referenced frame
+    rtp->clearRef();
+    if (rtp->getCapacity() > RtpPacket::kPoolSlotSize) {
+        // 超大包不回收，防止对象池占用过多内存
+        // Oversized packets are not recycled to prevent the object pool from occupying too much memory
+        return false;
+    }
+    rtp->setSize(0);
+    return true;
+}
+
 RtpPacket::Ptr RtpPacket::create() {
-#if 0
-    static ResourcePool<RtpPacket> packet_pool;
-    static onceToken token([]() {
-        packet_pool.setSize(1024);
-    });
-    auto ret = packet_pool.obtain2();
-    ret->setSize(0);
+    GET_CONFIG(size_t, pool_size, Rtp::kPacketPoolSize);
+    auto ret = ObjectPool<RtpPacket>::obtain(pool_size, onRecycle);
+    if (!ret->getCapacity()) {
+        // 新创建的对象，预分配一个MTU大小的内存，后续复用不再开辟内存
+        // Newly created object, preallocate one MTU sized memory, no more allocation when reused later
+        ret->setCapacity(kPoolSlotSize);
+    }
+    ret->type = TrackInvalid;
+    ret->sample_rate = 0;
+    ret->ntp_stamp = 0;
+    ret->track_index = 0;
     return ret;
-#else
-    return Ptr(new RtpPacket);
-#endif
+}
+
+RtpPacket::Ptr RtpPacket::create(size_t head_size, Buffer::Ptr holder, const char *ref, size_t ref_size) {
+    auto ret = create();
+    // 预留负载的内存，保证拷贝负载时不会重新分配内存(其他线程可能正在访问头部)
+    // Reserve the memory of the payload to ensure no reallocation when copying the payload (other threads may be accessing the header)
+    ret->setCapacity(head_size + ref_size);
+    ret->setSize(head_size + ref_size);
+    if (ref_size) {
+        ret->_holder = std::move(holder);
+        ret->_ref = ref;
+        ret->_ref_size = ref_size;
+        ret->_flat_state.store(kFlatNone, std::memory_order_relaxed);
+    }
+    return ret;
+}
+
+ObjectPool<RtpPacket>::Statistic RtpPacket::getPoolStatistic() {
+    return ObjectPool<RtpPacket>::getStatistic();
 }
 
 /**
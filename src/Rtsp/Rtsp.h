@@ -14,9 +14,11 @@
 #include <string.h>
 #include <string>
 #include <memory>
+#include <atomic>
 #include <unordered_map>
 #include "Network/Socket.h"
 #include "Common/macros.h"
+#include "Common/ObjectPool.h"
 #include "Extension/Frame.h"
 
 namespace mediakit {
@@ -155,12 +157,44 @@ private:
 
 #pragma pack(pop)
 
+class RtpPacket;
+
+/**
+ * rtp包的一段内存，内嵌于rtp包中，不会触发零拷贝负载的拷贝
+ * 通过shared_ptr别名构造共享rtp包的引用计数，发送时无需额外分配内存
+ * A section of memory of the rtp packet, embedded in the rtp packet, does not trigger the copy of the zero copy payload
+ * Shares the reference count of the rtp packet through the shared_ptr aliasing constructor, no extra memory allocation when sending
+ */
+class RtpSlice : public toolkit::Buffer {
+public:
+    /**
+     * @param rtp 所属rtp包
+     * @param offset 头部跳过的字节数
+     * @param ref 是否为引用的负载
+     * @param rtp The rtp packet it belongs to
+     * @param offset Skipped header bytes
+     * @param ref Whether it is the referenced payload
+     */
+    RtpSlice(const RtpPacket *rtp, size_t offset, bool ref) : _ref(ref), _offset(offset), _rtp(rtp) {}
+
+    char *data() const override;
+    size_t size() const override;
+
+private:
+    bool _ref;
+    size_t _offset;
+    const RtpPacket *_rtp;
+};
+
 // 此rtp为rtp over tcp形式，需要忽略前4个字节  [AUTO-TRANSLATED:ceb00f83]
 // This rtp is in the form of rtp over tcp, the first 4 bytes need to be ignored
 class RtpPacket : public toolkit::BufferRaw {
 public:
     using Ptr = std::shared_ptr<RtpPacket>;
     enum { kRtpVersion = 2, kRtpHeaderSize = 12, kRtpTcpHeaderSize = 4 };
+    // 对象池中rtp包的固定内存大小(足够容纳一个MTU的rtp over tcp包)，超过该大小的包不回收
+    // Fixed memory size of the rtp packet in the object pool (enough for one MTU rtp over tcp packet), larger packets are not recycled
+    enum { kPoolSlotSize = 1536 };
 
     // 获取rtp头  [AUTO-TRANSLATED:41d58919]
     // Get the rtp header
@@ -188,6 +222,39 @@ public:
     // Valid payload length, excluding csrc, ext, padding
     size_t getPayloadSize() const;
 
+    /**
+     * 零拷贝模式下，负载尾部引用自帧数据，本包只保存rtp over tcp头、rtp头以及FU头等
+     * 首次访问data()或getPayload()时才会把引用的负载拷贝到本包(多线程安全，只拷贝一次)
+     * In zero copy mode, the tail of the payload is referenced from the frame data, this packet only stores the rtp over tcp header,
+     * the rtp header and the FU header, etc.
+     * The referenced payload is copied into this packet only when data() or getPayload() is accessed for the first time
+     * (thread safe, copied only once)
+     */
+    char *data() const override;
+    // 是否引用了帧数据
+    // Whether the frame data is referenced
+    bool isZeroCopy() const { return _ref_size != 0; }
+    // 本包自身保存的字节数(不包括引用的负载)
+    // Bytes stored by this packet itself (excluding the referenced payload)
+    size_t getHeadSize() const { return size() - _ref_size; }
+    // 引用的负载长度
+    // Length of the referenced payload
+    size_t getRefSize() const { return _ref_size; }
+
+    /**
+     * 把rtp包拆分为可供socket聚合发送(writev/sendmsg)的buffer，零拷贝包拆分为头部与引用的负载两个buffer
+     * @param rtp rtp包
+     * @param offset 跳过的头部字节数
+     * @param cb buffer回调
+     * Split the rtp packet into buffers that can be gathered by the socket (writev/sendmsg),
+     * a zero copy packet is split into the header and the referenced payload
+     * @param rtp Rtp packet
+     * @param offset Skipped header bytes
+     * @param cb Buffer callback
+     */
+    template <typename FUNC>
+    static void forEachSlice(const Ptr &rtp, size_t offset, FUNC &&cb);
+
     // 音视频类型  [AUTO-TRANSLATED:dc0fa851]
     // Audio and video type
     TrackType type;
@@ -202,16 +269,71 @@ public:
 
     static Ptr create();
 
+    /**
+     * 创建零拷贝rtp包
+     * @param head_size 本包保存的字节数(包括rtp over tcp头与rtp头)，由调用者填充
+     * @param holder 负载所属的帧，rtp包释放前一直持有
+     * @param ref 引用的负载
+     * @param ref_size 引用的负载长度
+     * Create a zero copy rtp packet
+     * @param head_size Bytes stored by this packet (including the rtp over tcp header and the rtp header), filled by the caller
+     * @param holder The frame to which the payload belongs, held until the rtp packet is released
+     * @param ref Referenced payload
+     * @param ref_size Length of the referenced payload
+     */
+    static Ptr create(size_t head_size, toolkit::Buffer::Ptr holder, const char *ref, size_t ref_size);
+
+    // 获取rtp包对象池统计信息
+    // Get rtp packet object pool statistics
+    static ObjectPool<RtpPacket>::Statistic getPoolStatistic();
+
 private:
+    friend class RtpSlice;
     friend class toolkit::ResourcePool_l<RtpPacket>;
+    friend class ObjectPool<RtpPacket>;
     RtpPacket() = default;
+    static bool onRecycle(RtpPacket *rtp);
+    void clearRef();
+    void flatten() const;
 
 private:
+    enum { kFlatNone = 0, kFlatBusy, kFlatDone };
+    // 零拷贝负载
+    // Zero copy payload
+    size_t _ref_size = 0;
+    const char *_ref = nullptr;
+    toolkit::Buffer::Ptr _holder;
+    mutable std::atomic<uint8_t> _flat_state { kFlatDone };
+    // 随rtp包一起回收复用的切片，分别为包括/不包括rtp over tcp头的头部以及引用的负载
+    // Slices recycled and reused together with the rtp packet, which are the header including/excluding the rtp over tcp header and the referenced payload
+    RtpSlice _tcp_slice { this, 0, false };
+    RtpSlice _udp_slice { this, kRtpTcpHeaderSize, false };
+    RtpSlice _ref_slice { this, 0, true };
     // 对象个数统计  [AUTO-TRANSLATED:f4a012d0]
     // Object Count Statistics
     toolkit::ObjectStatistic<RtpPacket> _statistic;
 };
 
+template <typename FUNC>
+void RtpPacket::forEachSlice(const Ptr &rtp, size_t offset, FUNC &&cb) {
+    if (!offset && !rtp->isZeroCopy()) {
+        cb(rtp);
+        return;
+    }
+    if (offset != 0 && offset != kRtpTcpHeaderSize) {
+        // 不常见的偏移量，整包发送(零拷贝包会先拷贝负载)
+        // Uncommon offset, send the whole packet (the payload of a zero copy packet is copied first)
+        cb(std::make_shared<toolkit::BufferOffset<toolkit::Buffer::Ptr>>(rtp, offset));
+        return;
+    }
+    // 别名构造的shared_ptr只增加rtp包的引用计数，不分配内存
+    // The aliasing shared_ptr only increases the reference count of the rtp packet, no memory allocation
+    cb(toolkit::Buffer::Ptr(rtp, offset ? &rtp->_udp_slice : &rtp->_tcp_slice));
+    if (rtp->isZeroCopy()) {
+        cb(toolkit::Buffer::Ptr(rtp, &rtp->_ref_slice));
+    }
+}
+
 class RtpPayload {
 public:
     static int getClockRate(int pt);
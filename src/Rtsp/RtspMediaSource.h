@@ -17,6 +17,7 @@
 #include <functional>
 #include "Common/MediaSource.h"
 #include "Common/PacketCache.h"
+#include "Common/SpmcRing.h"
 #include "Util/RingBuffer.h"
 
 #define RTP_GOP_SIZE 512
@@ -35,11 +36,11 @@ namespace mediakit {
  
  * [AUTO-TRANSLATED:e04eee56]
  */
-class RtspMediaSource : public MediaSource, public toolkit::RingDelegate<RtpPacket::Ptr>, private PacketCache<RtpPacket> {
+class RtspMediaSource : public MediaSource, public toolkit::RingDelegate<RtpPacket::Ptr>, private PacketCache<RtpPacket, AdaptiveFlushPolicy> {
 public:
     using Ptr = std::shared_ptr<RtspMediaSource>;
     using RingDataType = std::shared_ptr<toolkit::List<RtpPacket::Ptr> >;
-    using RingType = toolkit::RingBuffer<RingDataType>;
+    using RingType = SpmcRing<RingDataType>;
 
     /**
      * 构造函数
@@ -97,6 +98,10 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    int getMergeWriteMS() const override {
+        return getFlushPolicy().getMergeMS();
+    }
+
     /**
      * 获取该源的sdp
      * Get the sdp of this source
@@ -178,10 +183,13 @@ public:
     void onWrite(RtpPacket::Ptr rtp, bool keyPos) override;
 
     void clearCache() override{
-        PacketCache<RtpPacket>::clearCache();
+        PacketCache<RtpPacket, AdaptiveFlushPolicy>::clearCache();
         _ring->clearCache();
     }
 
+    using PacketCache<RtpPacket, AdaptiveFlushPolicy>::beginBatch;
+    using PacketCache<RtpPacket, AdaptiveFlushPolicy>::endBatch;
+
 private:
     /**
      * 批量flush rtp包时触发该函数
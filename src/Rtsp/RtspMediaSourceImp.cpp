@@ -68,6 +68,7 @@ void RtspMediaSource::onWrite(RtpPacket::Ptr rtp, bool keyPos) {
             if (!strongSelf) {
                 return;
             }
+            strongSelf->getFlushPolicy().setReaderCount(size);
             strongSelf->onReaderChanged(size);
         };
         // GOP默认缓冲512组RTP包，每组RTP包时间戳相同(如果开启合并写了，那么每组为合并写时间内的RTP包),  [AUTO-TRANSLATED:dc09b92e]
@@ -75,12 +76,20 @@ void RtspMediaSource::onWrite(RtpPacket::Ptr rtp, bool keyPos) {
         // 每次遇到关键帧第一个RTP包，则会清空GOP缓存(因为有新的关键帧了，同样可以实现秒开)  [AUTO-TRANSLATED:db44dc72]
         // Every time a key frame's first RTP packet is encountered, the GOP cache will be cleared (because there is a new key frame, which can also achieve instant playback)
         _ring = std::make_shared<RingType>(_ring_size, std::move(lam));
+        _ring->setOnPressure([weakSelf]() {
+            if (auto strongSelf = weakSelf.lock()) {
+                strongSelf->getFlushPolicy().onSendPressure();
+            }
+        });
+        auto latency = LatencyStats::get(getMediaTuple());
+        setLatencyStats(latency);
+        _ring->setLatencyStats(latency);
         if (!_sdp.empty()) {
             regist();
         }
     }
    
-    PacketCache<RtpPacket>::inputPacket(stamp, is_video, std::move(rtp), keyPos);
+    PacketCache<RtpPacket, AdaptiveFlushPolicy>::inputPacket(stamp, is_video, std::move(rtp), keyPos);
 }
 
 RtspMediaSourceImp::RtspMediaSourceImp(const MediaTuple& tuple, int ringSize): RtspMediaSource(tuple, ringSize)
@@ -13,17 +13,18 @@
 
 #include "RtspMuxer.h"
 #include "Rtsp/RtspMediaSource.h"
+#include "Util/onceToken.h"
 
 namespace mediakit {
 
-class RtspMediaSourceMuxer final : public RtspMuxer, public MediaSourceEventInterceptor,
+class RtspMediaSourceMuxer final : public RtspMuxer, public MediaSourceEventInterceptor, public DemandMuxerState,
                                    public std::enable_shared_from_this<RtspMediaSourceMuxer> {
 public:
     using Ptr = std::shared_ptr<RtspMediaSourceMuxer>;
 
     RtspMediaSourceMuxer(const MediaTuple& tuple,
                          const ProtocolOption &option,
-                         const TitleSdp::Ptr &title = nullptr) : RtspMuxer(title) {
+                         const TitleSdp::Ptr &title = nullptr) : RtspMuxer(title), DemandMuxerState(option.rtsp_demand) {
         _option = option;
         _media_src = std::make_shared<RtspMediaSource>(tuple);
         getRtpRing()->setDelegate(_media_src);
@@ -56,28 +57,23 @@ public:
     }
 
     void onReaderChanged(MediaSource &sender, int size) override {
-        _enabled = _option.rtsp_demand ? size : true;
-        if (!size && _option.rtsp_demand) {
-            _clear_cache = true;
-        }
+        onDemandReaderChanged(size);
         MediaSourceEventInterceptor::onReaderChanged(sender, size);
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.rtsp_demand) {
-            _clear_cache = false;
+        if (needClearCache()) {
             _media_src->clearCache();
         }
-        if (_enabled || !_option.rtsp_demand) {
+        if (needMux()) {
             return RtspMuxer::inputFrame(frame);
         }
         return false;
     }
 
-    bool isEnabled() {
-        // 缓存尚未清空时，还允许触发inputFrame函数，以便及时清空缓存  [AUTO-TRANSLATED:7cfd4d49]
-        // The inputFrame function is still allowed to be triggered when the cache has not been cleared, so that the cache can be cleared in time.
-        return _option.rtsp_demand ? (_clear_cache ? true : _enabled) : true;
+    bool inputFrames(const Frame::Ptr *frames, size_t count) override {
+        toolkit::onceToken token([&]() { _media_src->beginBatch(); }, [&]() { _media_src->endBatch(); });
+        return RtspMuxer::inputFrames(frames, count);
     }
 
     MediaSource::Ptr getMediaSource() const {
@@ -85,8 +81,6 @@ public:
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
     ProtocolOption _option;
     RtspMediaSource::Ptr _media_src;
 };
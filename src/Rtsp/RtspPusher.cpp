@@ -402,16 +402,15 @@ void RtspPusher::updateRtcpContext(const RtpPacket::Ptr &rtp){
 void RtspPusher::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
     switch (_rtp_type) {
         case Rtsp::RTP_TCP: {
-            size_t i = 0;
-            auto size = pkt->size();
             setSendFlushFlag(false);
             pkt->for_each([&](const RtpPacket::Ptr &rtp) {
                 updateRtcpContext(rtp);
-                if (++i == size) {
-                    setSendFlushFlag(true);
-                }
-                send(rtp);
+                // 零拷贝rtp包拆分为头部与负载，由socket聚合发送
+                // The zero copy rtp packet is split into the header and payload, which are gathered by the socket
+                RtpPacket::forEachSlice(rtp, 0, [&](Buffer::Ptr buf) { send(std::move(buf)); });
             });
+            flushAll();
+            setSendFlushFlag(true);
             break;
         }
 
@@ -11,6 +11,7 @@
 #include <atomic>
 #include <iomanip>
 #include "Common/config.h"
+#include "Common/UdpBatchSender.h"
 #include "UDPServer.h"
 #include "RtspSession.h"
 #include "Util/MD5.h"
@@ -879,6 +880,11 @@ void RtspSession::handleReq_Play(const Parser &parser) {
                 return;
             }
             strong_self->sendRtpPacket(pack);
+            if (strong_self->getSock()->isSocketBusy()) {
+                // 发送缓存已满，通知媒体源加大合并写时长
+                // The send buffer is full, notify the media source to increase the merge write duration
+                strong_self->_play_reader->onSendPressure();
+            }
         });
     }
 }
@@ -1246,7 +1252,9 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
             pkt->for_each([&](const RtpPacket::Ptr &rtp) {
                 if (_target_play_track == TrackInvalid || _target_play_track == rtp->type) {
                     updateRtcpContext(rtp);
-                    send(rtp);
+                    // 零拷贝rtp包拆分为头部与负载，由socket聚合发送
+                    // The zero copy rtp packet is split into the header and payload, which are gathered by the socket
+                    RtpPacket::forEachSlice(rtp, 0, [&](Buffer::Ptr buf) { send(std::move(buf)); });
                 }
             });
             flushAll();
@@ -1258,6 +1266,9 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
             Socket::Ptr rtp_socks[2];
             rtp_socks[TrackVideo] = _rtp_socks[getTrackIndexByTrackType(TrackVideo)];
             rtp_socks[TrackAudio] = _rtp_socks[getTrackIndexByTrackType(TrackAudio)];
+            // 一次刷新的rtp按socket分组后批量发送
+            // The rtp of one flush is grouped by socket and sent in batch
+            std::vector<Buffer::Ptr> batch[2];
             pkt->for_each([&](const RtpPacket::Ptr &rtp) {
                 if (_target_play_track == TrackInvalid || _target_play_track == rtp->type) {
                     updateRtcpContext(rtp);
@@ -1267,12 +1278,12 @@ void RtspSession::sendRtpPacket(const RtspMediaSource::RingDataType &pkt) {
                         return;
                     }
                     _bytes_usage += rtp->size() - RtpPacket::kRtpTcpHeaderSize;
-                    sock->send(std::make_shared<BufferRtp>(rtp, RtpPacket::kRtpTcpHeaderSize), nullptr, 0, false);
+                    batch[rtp->type].emplace_back(std::make_shared<BufferRtp>(rtp, RtpPacket::kRtpTcpHeaderSize));
                 }
             });
-            for (auto &sock : rtp_socks) {
-                if (sock) {
-                    sock->flushAll();
+            for (auto i = 0; i < 2; ++i) {
+                if (rtp_socks[i]) {
+                    UdpBatchSender::send(rtp_socks[i], batch[i]);
                 }
             }
         }
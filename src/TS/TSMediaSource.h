@@ -13,6 +13,7 @@
 
 #include "Common/MediaSource.h"
 #include "Common/PacketCache.h"
+#include "Common/SpmcRing.h"
 #include "Util/RingBuffer.h"
 
 #define TS_GOP_SIZE 512
@@ -34,11 +35,11 @@ public:
 
 // TS直播源  [AUTO-TRANSLATED:0d25ead6]
 // TS Live Source
-class TSMediaSource final : public MediaSource, public toolkit::RingDelegate<TSPacket::Ptr>, private PacketCache<TSPacket>{
+class TSMediaSource final : public MediaSource, public toolkit::RingDelegate<TSPacket::Ptr>, private PacketCache<TSPacket, AdaptiveFlushPolicy> {
 public:
     using Ptr = std::shared_ptr<TSMediaSource>;
     using RingDataType = std::shared_ptr<toolkit::List<TSPacket::Ptr> >;
-    using RingType = toolkit::RingBuffer<RingDataType>;
+    using RingType = SpmcRing<RingDataType>;
 
     TSMediaSource(const MediaTuple& tuple, int ring_size = TS_GOP_SIZE): MediaSource(TS_SCHEMA, tuple), _ring_size(ring_size) {}
 
@@ -75,6 +76,10 @@ public:
         return _ring ? _ring->readerCount() : 0;
     }
 
+    int getMergeWriteMS() const override {
+        return getFlushPolicy().getMergeMS();
+    }
+
     /**
      * 输入TS包
      * @param packet TS包
@@ -94,7 +99,7 @@ public:
             _have_video = true;
         }
         auto stamp = packet->time_stamp;
-        PacketCache<TSPacket>::inputPacket(stamp, true, std::move(packet), key);
+        PacketCache<TSPacket, AdaptiveFlushPolicy>::inputPacket(stamp, true, std::move(packet), key);
     }
 
     /**
@@ -104,10 +109,13 @@ public:
      * [AUTO-TRANSLATED:d863f8c9]
      */
     void clearCache() override {
-        PacketCache<TSPacket>::clearCache();
+        PacketCache<TSPacket, AdaptiveFlushPolicy>::clearCache();
         _ring->clearCache();
     }
 
+    using PacketCache<TSPacket, AdaptiveFlushPolicy>::beginBatch;
+    using PacketCache<TSPacket, AdaptiveFlushPolicy>::endBatch;
+
 private:
     void createRing(){
         std::weak_ptr<TSMediaSource> weak_self = std::static_pointer_cast<TSMediaSource>(shared_from_this());
@@ -116,8 +124,17 @@ private:
             if (!strong_self) {
                 return;
             }
+            strong_self->getFlushPolicy().setReaderCount(size);
             strong_self->onReaderChanged(size);
         });
+        _ring->setOnPressure([weak_self]() {
+            if (auto strong_self = weak_self.lock()) {
+                strong_self->getFlushPolicy().onSendPressure();
+            }
+        });
+        auto latency = LatencyStats::get(getMediaTuple());
+        setLatencyStats(latency);
+        _ring->setLatencyStats(latency);
         // 注册媒体源  [AUTO-TRANSLATED:b87b5ac4]
         // Register media source
         regist();
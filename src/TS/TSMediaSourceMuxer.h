@@ -13,15 +13,16 @@
 
 #include "TSMediaSource.h"
 #include "Record/MPEG.h"
+#include "Util/onceToken.h"
 
 namespace mediakit {
 
-class TSMediaSourceMuxer final : public MpegMuxer, public MediaSourceEventInterceptor,
+class TSMediaSourceMuxer final : public MpegMuxer, public MediaSourceEventInterceptor, public DemandMuxerState,
                                  public std::enable_shared_from_this<TSMediaSourceMuxer> {
 public:
     using Ptr = std::shared_ptr<TSMediaSourceMuxer>;
 
-    TSMediaSourceMuxer(const MediaTuple& tuple, const ProtocolOption &option) : MpegMuxer(false) {
+    TSMediaSourceMuxer(const MediaTuple& tuple, const ProtocolOption &option) : MpegMuxer(false), DemandMuxerState(option.ts_demand) {
         _option = option;
         _media_src = std::make_shared<TSMediaSource>(tuple);
     }
@@ -44,28 +45,23 @@ public:
     }
 
     void onReaderChanged(MediaSource &sender, int size) override {
-        _enabled = _option.ts_demand ? size : true;
-        if (!size && _option.ts_demand) {
-            _clear_cache = true;
-        }
+        onDemandReaderChanged(size);
         MediaSourceEventInterceptor::onReaderChanged(sender, size);
     }
 
     bool inputFrame(const Frame::Ptr &frame) override {
-        if (_clear_cache && _option.ts_demand) {
-            _clear_cache = false;
+        if (needClearCache()) {
             _media_src->clearCache();
         }
-        if (_enabled || !_option.ts_demand) {
+        if (needMux()) {
             return MpegMuxer::inputFrame(frame);
         }
         return false;
     }
 
-    bool isEnabled() {
-        // 缓存尚未清空时，还允许触发inputFrame函数，以便及时清空缓存  [AUTO-TRANSLATED:7cfd4d49]
-        // Allow the inputFrame function to be triggered even when the cache is not yet cleared, so that the cache can be cleared in time.
-        return _option.ts_demand ? (_clear_cache ? true : _enabled) : true;
+    bool inputFrames(const Frame::Ptr *frames, size_t count) override {
+        toolkit::onceToken token([&]() { _media_src->beginBatch(); }, [&]() { _media_src->endBatch(); });
+        return MpegMuxer::inputFrames(frames, count);
     }
 
     MediaSource::Ptr getMediaSource() const {
@@ -83,8 +79,6 @@ protected:
     }
 
 private:
-    bool _enabled = true;
-    bool _clear_cache = false;
     ProtocolOption _option;
     TSMediaSource::Ptr _media_src;
 };
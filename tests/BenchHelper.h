@@ -0,0 +1,132 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_BENCHHELPER_H
+#define ZLMEDIAKIT_BENCHHELPER_H
+
+#include <string>
+#include <cstring>
+#include <iostream>
+#include <initializer_list>
+#include "Util/CMD.h"
+#include "Rtsp/Rtsp.h"
+
+namespace mediakit {
+
+/**
+ * 压测程序共用的命令行参数，选项均为可选，带值的选项都有默认值
+ * Command line arguments shared by the benchmark programs, all options are optional, and options with a value all have default values
+ */
+class BenchCmd : public toolkit::CMD {
+public:
+    struct Item {
+        // 带值的选项
+        // Option with a value
+        Item(char short_name, std::string name, std::string default_value, std::string description)
+            : short_name(short_name), flag(false), name(std::move(name)), default_value(std::move(default_value)), description(std::move(description)) {}
+        // 不带值的开关选项
+        // Switch option without a value
+        Item(char short_name, std::string name, std::string description)
+            : short_name(short_name), flag(true), name(std::move(name)), description(std::move(description)) {}
+
+        // 选项简称，如果是\x00则说明无简称
+        // Short name of the option, \x00 means no short name
+        char short_name;
+        bool flag;
+        std::string name;
+        std::string default_value;
+        std::string description;
+    };
+
+    BenchCmd(std::initializer_list<Item> items) {
+        _parser.reset(new toolkit::OptionParser(nullptr));
+        for (auto &item : items) {
+            (*_parser) << toolkit::Option(item.short_name, item.name.data(), item.flag ? toolkit::Option::ArgNone : toolkit::Option::ArgRequired,
+                                          item.flag ? nullptr : item.default_value.data(), false, item.description.data(), nullptr);
+        }
+    }
+
+    const char *description() const override { return "主程序命令参数"; }
+
+    /**
+     * 解析命令行参数
+     * @param ret 无需继续运行(打印帮助或者参数错误)时的进程返回值
+     * @return 是否继续运行
+     * Parse the command line arguments
+     * @param ret The process return value when there is no need to continue running (print help or argument error)
+     * @return Whether to continue running
+     */
+    bool parse(int argc, char *argv[], int &ret) {
+        try {
+            operator()(argc, argv);
+            return true;
+        } catch (toolkit::ExitException &) {
+            ret = 0;
+        } catch (std::exception &ex) {
+            std::cout << ex.what() << std::endl;
+            ret = -1;
+        }
+        return false;
+    }
+};
+
+/**
+ * 压测的同时校验结果，任一校验失败时进程返回非0，以便作为测试运行
+ * Verify the results while benchmarking, the process returns non-zero if any check fails, so that it can be run as a test
+ */
+class BenchChecker {
+public:
+    void check(bool ok, const std::string &name) {
+        if (!ok) {
+            _failed = true;
+            std::cout << "failed: " << name << std::endl;
+        }
+    }
+
+    int result() const {
+        std::cout << (_failed ? "some failed" : "all passed") << std::endl;
+        return _failed ? -1 : 0;
+    }
+
+private:
+    bool _failed = false;
+};
+
+/**
+ * 生成测试用的视频rtp包，负载全0
+ * @param seq rtp seq
+ * @param stamp rtp时间戳
+ * @param ntp_stamp ntp时间戳，单位毫秒
+ * @param payload_size 负载长度
+ * Generate a video rtp packet for testing, the payload is all zero
+ * @param seq Rtp seq
+ * @param stamp Rtp timestamp
+ * @param ntp_stamp Ntp timestamp, in milliseconds
+ * @param payload_size Payload length
+ */
+inline RtpPacket::Ptr makeTestRtp(uint16_t seq, uint32_t stamp, uint64_t ntp_stamp, size_t payload_size = 4) {
+    auto rtp = RtpPacket::create();
+    rtp->setCapacity(RtpPacket::kRtpTcpHeaderSize + RtpPacket::kRtpHeaderSize + payload_size);
+    rtp->setSize(rtp->getCapacity());
+    memset(rtp->data(), 0, rtp->size());
+    auto header = rtp->getHeader();
+    header->version = RtpPacket::kRtpVersion;
+    header->pt = 96;
+    header->seq = htons(seq);
+    header->stamp = htonl(stamp);
+    header->ssrc = htonl(0x1234);
+    rtp->type = TrackVideo;
+    rtp->sample_rate = 90000;
+    rtp->ntp_stamp = ntp_stamp;
+    return rtp;
+}
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_BENCHHELPER_H
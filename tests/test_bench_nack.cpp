@@ -0,0 +1,139 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <random>
+#include <bitset>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "../webrtc/Nack.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+// 生成接收到的seq序列，seq从65000开始以测试回环
+// Generate the received seq sequence, seq starts from 65000 to test the loop
+static vector<uint16_t> makeInput(size_t count, size_t loss, size_t reorder) {
+    vector<uint16_t> ret;
+    ret.reserve(count);
+    mt19937 rng(0);
+    uint16_t seq = 65000;
+    while (ret.size() < count) {
+        auto cur = seq++;
+        if (rng() % 100 < loss) {
+            continue;
+        }
+        ret.emplace_back(cur);
+    }
+    for (size_t i = 0; i < ret.size(); ++i) {
+        if (rng() % 100 < reorder) {
+            // MIN宏会多次求值，随机数需要先取出
+            // The MIN macro evaluates its arguments more than once, so the random number must be taken out first
+            size_t offset = 1 + rng() % 16;
+            swap(ret[i], ret[MIN(ret.size() - 1, i + offset)]);
+        }
+    }
+    return ret;
+}
+
+// rtp接收端：统计NackContext生成nack的吞吐量
+// Rtp receiver: count the throughput of NackContext generating nack
+static size_t benchNackContext(const char *name, const vector<uint16_t> &input) {
+    NackContext ctx;
+    size_t nack_count = 0;
+    size_t nack_rtp = 0;
+    ctx.setOnNack([&](const FCI_NACK &nack) {
+        ++nack_count;
+        nack_rtp += 1 + bitset<FCI_NACK::kBitSize>(nack.getBlp()).count();
+    });
+
+    auto start_us = getCurrentMicrosecond(true);
+    size_t i = 0;
+    for (auto seq : input) {
+        ctx.received(seq);
+        if (++i % 64 == 0) {
+            // 模拟定时重发nack
+            // Simulate resending nack regularly
+            ctx.reSendNack();
+        }
+    }
+    auto cost_us = MAX(getCurrentMicrosecond(true) - start_us, (uint64_t)1);
+    cout << "NackContext " << name << ": input " << input.size() << ", nack " << nack_count << ", nack rtp " << nack_rtp << ", "
+         << (double)input.size() / cost_us << " Mpps" << endl;
+    return nack_count;
+}
+
+// rtp发送端：统计NackList缓存rtp与查找重传包的吞吐量，返回请求重传的rtp是否都能找到
+// Rtp sender: count the throughput of NackList caching rtp and finding retransmitted packets, return whether all the requested rtp are found
+static bool benchNackList(size_t count, size_t loss) {
+    // 预先生成rtp，避免统计rtp分配的开销
+    // Generate rtp in advance to avoid counting the overhead of rtp allocation
+    vector<RtpPacket::Ptr> pool;
+    for (size_t i = 0; i < 4096; ++i) {
+        auto rtp = RtpPacket::create();
+        rtp->setCapacity(RtpPacket::kRtpTcpHeaderSize + RtpPacket::kRtpHeaderSize);
+        rtp->setSize(RtpPacket::kRtpTcpHeaderSize + RtpPacket::kRtpHeaderSize);
+        pool.emplace_back(std::move(rtp));
+    }
+
+    NackList list;
+    mt19937 rng(0);
+    size_t found = 0;
+    size_t nack_count = 0;
+    uint16_t seq = 65000;
+    auto start_us = getCurrentMicrosecond(true);
+    for (size_t i = 0; i < count; ++i, ++seq) {
+        auto &rtp = pool[i % pool.size()];
+        rtp->getHeader()->seq = htons(seq);
+        rtp->ntp_stamp = i / 10;
+        list.pushBack(rtp);
+        if (i >= 256 && rng() % 100 < loss) {
+            // 对端请求重传最近的rtp
+            // The peer requests to retransmit the recent rtp
+            ++nack_count;
+            list.forEach(FCI_NACK(seq - FCI_NACK::kBitSize - rng() % 240, vector<bool>(FCI_NACK::kBitSize, true)), [&](const RtpPacket::Ptr &pkt) { ++found; });
+        }
+    }
+    auto cost_us = MAX(getCurrentMicrosecond(true) - start_us, (uint64_t)1);
+    cout << "NackList: input " << count << ", nack " << nack_count << ", retransmit " << found << ", " << (double)count / cost_us << " Mpps" << endl;
+    // 最近256个rtp都在缓存内
+    // The latest 256 rtp are all in the cache
+    return found == nack_count * (FCI_NACK::kBitSize + 1);
+}
+
+// 此程序用于测试nack收发两端在不同丢包场景下的吞吐量
+// This program is used to test the throughput of both nack sides under different packet loss scenarios
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'c', "count", "10000000", "每种模式输入的包数" },
+        { 'l', "loss", "5", "丢包比例,单位百分比" },
+        { 'r', "reorder", "2", "乱序比例,单位百分比" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    auto count = MAX(cmd_main["count"].as<size_t>(), (size_t)1);
+    auto loss = cmd_main["loss"].as<size_t>();
+    auto reorder = cmd_main["reorder"].as<size_t>();
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+
+    BenchChecker checker;
+    checker.check(benchNackContext("in order", makeInput(count, 0, 0)) == 0, "nack when in order");
+    auto nack_count = benchNackContext("loss", makeInput(count, loss, 0));
+    checker.check(!loss || count < 1000 || nack_count, "no nack when loss");
+    benchNackContext("loss + reorder", makeInput(count, loss, reorder));
+    checker.check(benchNackList(count, loss), "retransmit");
+    return checker.result();
+}
@@ -0,0 +1,199 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <random>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/File.h"
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Rtp/PSDecoder.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(ENABLE_RTPPROXY)
+
+static void putTimestamp(string &out, int flag, int64_t ts) {
+    out.push_back((char)((flag << 4) | (((ts >> 30) & 0x07) << 1) | 1));
+    out.push_back((char)(ts >> 22));
+    out.push_back((char)((((ts >> 15) & 0x7F) << 1) | 1));
+    out.push_back((char)(ts >> 7));
+    out.push_back((char)(((ts & 0x7F) << 1) | 1));
+}
+
+static void putPes(string &out, uint8_t id, const char *data, size_t size, bool with_pts, int64_t pts) {
+    out.append("\x00\x00\x01", 3);
+    out.push_back((char)id);
+    auto len = 3 + (with_pts ? 5 : 0) + size;
+    out.push_back((char)(len >> 8));
+    out.push_back((char)len);
+    out.push_back((char)0x80);
+    out.push_back((char)(with_pts ? 0x80 : 0x00));
+    out.push_back((char)(with_pts ? 5 : 0));
+    if (with_pts) {
+        putTimestamp(out, 2, pts);
+    }
+    out.append(data, size);
+}
+
+/**
+ * 生成h264 + aac的ps流，视频帧按海康的方式拆分为多个PES
+ * @param bytes 应当解析出的帧数据总字节数
+ * Generate a ps stream of h264 + aac, video frames are split into multiple PES in the way of Hikvision
+ * @param bytes Total bytes of the frame data that should be parsed
+ */
+static string makePS(size_t count, size_t size, size_t &bytes) {
+    mt19937 rng(0);
+    string ret, frame;
+    bytes = 0;
+    for (size_t i = 0; i < count; ++i) {
+        int64_t pts = 90000 + i * 3600;
+        ret.append("\x00\x00\x01\xBA\x44\x00\x04\x00\x04\x01\x01\x89\xC3\xF8", 14);
+        if (i % 50 == 0) {
+            // PSM: h264(0xE0) + aac(0xC0)
+            ret.append("\x00\x00\x01\xBC\x00\x12\xE0\xFF\x00\x00\x00\x08\x1B\xE0\x00\x00\x0F\xC0\x00\x00\x00\x00\x00\x00", 24);
+        }
+        frame.assign("\x00\x00\x00\x01", 4);
+        frame.push_back(i % 50 == 0 ? 0x65 : 0x41);
+        while (frame.size() < size) {
+            frame.push_back((char)(rng() | 0x04));
+        }
+        for (size_t offset = 0; offset < frame.size(); offset += 65000) {
+            putPes(ret, 0xE0, frame.data() + offset, MIN(frame.size() - offset, (size_t)65000), offset == 0, pts);
+        }
+        bytes += frame.size();
+
+        // adts头的帧长度字段包括7字节的头
+        // The frame length field of the adts header includes the 7-byte header
+        size_t len = 7 + 360;
+        frame.assign("\xFF\xF1\x50", 3);
+        frame.push_back((char)(0x80 | ((len >> 11) & 0x03)));
+        frame.push_back((char)(len >> 3));
+        frame.push_back((char)(((len & 0x07) << 5) | 0x1F));
+        frame.push_back((char)0xFC);
+        frame.append(360, (char)0x5A);
+        putPes(ret, 0xC0, frame.data(), frame.size(), true, pts);
+        bytes += frame.size();
+    }
+    return ret;
+}
+
+/**
+ * 解析结果，相同流相同pts的输出计为一帧(不同解析器拆分帧的方式可能不同)
+ * Parsing result, outputs with the same stream and pts are counted as one frame (different parsers may split frames in different ways)
+ */
+class BenchResult {
+public:
+    size_t frames = 0;
+    size_t bytes = 0;
+};
+
+template <typename DECODER>
+static BenchResult bench(const char *name, const vector<Buffer::Ptr> &packets, size_t total, size_t repeat, bool ref) {
+    BenchResult ret;
+    Ticker ticker;
+    for (size_t i = 0; i < repeat; ++i) {
+        auto holder = std::make_shared<DECODER>();
+        Decoder *decoder = holder.get();
+        map<int, int64_t> last_pts;
+        decoder->setOnDecode([&](int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t size) {
+            auto it = last_pts.find(stream);
+            if (it == last_pts.end() || it->second != pts) {
+                last_pts[stream] = pts;
+                ++ret.frames;
+            }
+            ret.bytes += size;
+        });
+        for (auto &pkt : packets) {
+            if (ref) {
+                // 引用rtp包缓存
+                // Reference the rtp packet buffer
+                decoder->input(pkt, (uint8_t *)pkt->data(), pkt->size());
+            } else {
+                decoder->input((uint8_t *)pkt->data(), pkt->size());
+            }
+        }
+        decoder->flush();
+    }
+    auto cost_ms = MAX(ticker.elapsedTime(), (uint64_t)1);
+    ret.frames /= repeat;
+    ret.bytes /= repeat;
+    cout << name << ": frames " << ret.frames << ", bytes " << ret.bytes << ", " << (double)total * repeat / cost_ms / 1000 << " MB/s" << endl;
+    return ret;
+}
+
+// 此程序用于对比media-server ps解复用器与流式ps解析器逐个rtp负载输入时的吞吐量
+// This program is used to compare the throughput of the media-server ps demuxer and the streaming ps parser when inputting rtp payloads one by one
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'i', "in", "", "ps文件，为空则随机生成数据" },
+        { 'c', "count", "2000", "随机生成数据的帧数" },
+        { 's', "size", "100", "随机生成数据的帧大小,单位KB" },
+        { 'm', "mtu", "1400", "rtp负载大小" },
+        { 'r', "repeat", "5", "重复解析次数" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    string in = cmd_main["in"];
+    string data;
+    size_t count = 0, expect_bytes = 0;
+    if (!in.empty()) {
+        data = File::loadFile(in);
+        if (data.empty()) {
+            cout << "load file failed: " << in << endl;
+            return -1;
+        }
+    } else {
+        count = MAX(cmd_main["count"].as<size_t>(), (size_t)1);
+        data = makePS(count, MAX(cmd_main["size"].as<size_t>(), (size_t)1) * 1024, expect_bytes);
+    }
+
+    // 按rtp负载大小切分，模拟逐个rtp包输入
+    // Split by the rtp payload size, to simulate inputting rtp packets one by one
+    auto mtu = MAX(cmd_main["mtu"].as<size_t>(), (size_t)1);
+    vector<Buffer::Ptr> packets;
+    for (size_t offset = 0; offset < data.size(); offset += mtu) {
+        auto pkt = BufferRaw::create();
+        pkt->assign(data.data() + offset, MIN(mtu, data.size() - offset));
+        packets.emplace_back(std::move(pkt));
+    }
+
+    auto repeat = MAX(cmd_main["repeat"].as<size_t>(), (size_t)1);
+    cout << "bytes: " << data.size() << ", packets: " << packets.size() << endl;
+    auto ps = bench<PSDecoder>("media-server", packets, data.size(), repeat, false);
+    auto stream = bench<PSStreamDecoder>("stream", packets, data.size(), repeat, true);
+
+    // media-server在收到下一帧前可能缓存每个流的最后一帧
+    // media-server may cache the last frame of each stream before receiving the next frame
+    BenchChecker checker;
+    checker.check(stream.frames && stream.frames >= ps.frames && stream.frames <= ps.frames + 2, "frames of media-server and stream");
+    checker.check(stream.bytes >= ps.bytes, "bytes of media-server and stream");
+    if (count) {
+        checker.check(stream.frames == count * 2, "frames of stream");
+        checker.check(stream.bytes == expect_bytes, "bytes of stream");
+    }
+    return checker.result();
+}
+
+#else
+int main(int argc, char *argv[]) {
+    cout << "please ENABLE_RTPPROXY and then test" << endl;
+    return 0;
+}
+#endif // defined(ENABLE_RTPPROXY)
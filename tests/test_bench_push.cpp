@@ -10,6 +10,7 @@
 #ifdef ENABLE_MP4
 #include <signal.h>
 #include <atomic>
+#include <random>
 #include <iostream>
 #include "Util/logger.h"
 #include "Util/onceToken.h"
@@ -21,6 +22,7 @@
 #include "Pusher/MediaPusher.h"
 #include "Player/PlayerProxy.h"
 #include "Record/MP4Reader.h"
+#include "Rtmp/RtmpProtocol.h"
 using namespace std;
 using namespace toolkit;
 using namespace mediakit;
@@ -51,7 +53,7 @@ public:
                              "in",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
                              Option::ArgRequired,/*该选项后面必须跟值*/
                              nullptr,/*该选项默认值*/
-                             true,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
                              "拉流url,支持rtsp/rtmp/hls/mp4文件",/*该选项说明文字*/
                              nullptr);
 
@@ -59,7 +61,7 @@ public:
                              "out",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
                              Option::ArgRequired,/*该选项后面必须跟值*/
                              nullptr,/*该选项默认值*/
-                             true,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
                              "推流url,支持rtsp/rtmp",/*该选项说明文字*/
                              nullptr);
 
@@ -94,6 +96,22 @@ public:
                              true,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
                             "rtsp拉流和推流方式,支持tcp/udp:0/1", /*该选项说明文字*/
                             nullptr);
+
+        (*_parser) << Option('s',/*该选项简称，如果是\x00则说明无简称*/
+                             "synthetic",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgNone,/*该选项后面无值*/
+                             nullptr,/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "进程内合成rtmp推流数据测试服务端chunk解析性能，无需网络及in/out参数",/*该选项说明文字*/
+                             nullptr);
+
+        (*_parser) << Option('k',/*该选项简称，如果是\x00则说明无简称*/
+                             "chunk",/*该选项全称,每个选项必须有全称；不得为null或空字符串*/
+                             Option::ArgRequired,/*该选项后面必须跟值*/
+                             "4096",/*该选项默认值*/
+                             false,/*该选项是否必须赋值，如果没有默认值且为ArgRequired时用户必须提供该参数否则将抛异常*/
+                             "合成rtmp推流数据的chunk大小",/*该选项说明文字*/
+                             nullptr);
     }
 
     ~CMD_main() override {}
@@ -101,6 +119,105 @@ public:
     const char *description() const override { return "主程序命令参数"; }
 };
 
+// 合成rtmp推流数据的客户端，或者解析推流数据的服务端
+// Client that synthesizes rtmp push data, or server that parses the push data
+class RtmpBenchProtocol : public RtmpProtocol {
+public:
+    using RtmpProtocol::sendChunkSize;
+    using RtmpProtocol::sendRtmp;
+
+    function<void(const Buffer::Ptr &buffer)> on_send;
+    size_t messages = 0;
+    size_t bytes = 0;
+
+protected:
+    void onSendRawData(Buffer::Ptr buffer) override {
+        if (on_send) {
+            on_send(buffer);
+        }
+    }
+
+    void onRtmpChunk(RtmpPacket::Ptr packet) override {
+        // 丢弃后回收到对象池
+        // Recycled to the object pool after discarded
+        ++messages;
+        bytes += packet->size();
+    }
+};
+
+// 生成rtmp推流数据(包括握手)，音视频交替发送
+// Generate rtmp push data (including handshake), audio and video are sent alternately
+static string makeRtmpPushData(size_t chunk_size) {
+    string ret;
+    string to_server, to_client;
+    RtmpBenchProtocol client, server;
+    client.on_send = [&](const Buffer::Ptr &buffer) {
+        ret.append(buffer->data(), buffer->size());
+        to_server.append(buffer->data(), buffer->size());
+    };
+    server.on_send = [&](const Buffer::Ptr &buffer) { to_client.append(buffer->data(), buffer->size()); };
+    bool handshake = false;
+    client.startClientSession([&]() { handshake = true; }, false);
+    // 握手期间双方交替收发数据(不能在发送回调中直接输入对端，否则会重入解析器)
+    // Both sides send and receive data alternately during the handshake (the peer cannot be input directly in the send callback, otherwise the parser is reentered)
+    auto pump = [](string &buffer, RtmpBenchProtocol &peer) {
+        string data;
+        data.swap(buffer);
+        if (!data.empty()) {
+            peer.onParseRtmp(data.data(), data.size());
+        }
+    };
+    while (!to_server.empty() || !to_client.empty()) {
+        pump(to_server, server);
+        pump(to_client, client);
+    }
+    if (!handshake) {
+        return "";
+    }
+    client.sendChunkSize((uint32_t)chunk_size);
+
+    // 25fps视频，每50帧一个大的关键帧；每帧视频后跟2个音频包
+    // 25fps video, a large key frame every 50 frames; 2 audio packets after each video frame
+    mt19937 rng(0);
+    uniform_int_distribution<size_t> frame_dis(2000, 20000);
+    for (uint32_t i = 0; i < 1500; ++i) {
+        auto video = std::make_shared<BufferLikeString>(string(i % 50 ? frame_dis(rng) : 150000, 'v'));
+        client.sendRtmp(MSG_VIDEO, 1, video, i * 40, CHUNK_VIDEO);
+        for (uint32_t j = 0; j < 2; ++j) {
+            auto audio = std::make_shared<BufferLikeString>(string(200, 'a'));
+            client.sendRtmp(MSG_AUDIO, 1, audio, i * 40 + j * 20, CHUNK_AUDIO);
+        }
+    }
+    return ret;
+}
+
+// 进程内测试rtmp推流数据的解析性能
+// Test the parsing performance of the rtmp push data in process
+static int benchSynthetic(size_t pusher_count, size_t chunk_size) {
+    auto data = makeRtmpPushData(chunk_size);
+    if (data.empty()) {
+        cout << "rtmp握手失败！" << endl;
+        return -1;
+    }
+    size_t messages = 0;
+    auto start_us = getCurrentMicrosecond(true);
+    for (size_t i = 0; i < pusher_count; ++i) {
+        // 模拟socket每次收到的数据，并在中间切割chunk
+        // Simulate the data received by the socket each time, and cut the chunks in the middle
+        RtmpBenchProtocol server;
+        for (size_t offset = 0; offset < data.size(); offset += 32 * 1024 + 7) {
+            server.onParseRtmp(data.data() + offset, MIN(data.size() - offset, (size_t)(32 * 1024 + 7)));
+        }
+        messages += server.messages;
+    }
+    auto cost_us = MAX(getCurrentMicrosecond(true) - start_us, (uint64_t)1);
+    auto pool = RtmpPacket::getPoolStatistic();
+    cout << "pushers: " << pusher_count << ", chunk size: " << chunk_size << ", messages: " << messages << ", "
+         << (double)messages / cost_us << " M msg/s, " << (double)data.size() * pusher_count / cost_us << " MB/s, rtmp packet pool hit rate: "
+         << (pool.obtain ? (double)pool.hit / pool.obtain : 0.0) << endl;
+    return 0;
+}
+
 // 此程序用于推流性能测试  [AUTO-TRANSLATED:45b48457]
 // This program is used for streaming performance testing
 int main(int argc, char *argv[]) {
@@ -114,6 +231,15 @@ int main(int argc, char *argv[]) {
         return -1;
     }
 
+    if (cmd_main.hasKey("synthetic")) {
+        Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+        return benchSynthetic(MAX(cmd_main["count"].as<size_t>(), (size_t)1), MAX(cmd_main["chunk"].as<size_t>(), (size_t)128));
+    }
+    if (!cmd_main.hasKey("in") || !cmd_main.hasKey("out")) {
+        cout << "请指定拉流url及推流url！" << endl;
+        return -1;
+    }
+
     int threads = cmd_main["threads"];
     LogLevel logLevel = (LogLevel)cmd_main["level"].as<int>();
     logLevel = MIN(MAX(logLevel, LTrace), LError);
@@ -0,0 +1,165 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Common/config.h"
+#include "Common/MediaSource.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+class BenchMediaSource : public MediaSource {
+public:
+    using Ptr = std::shared_ptr<BenchMediaSource>;
+    using MediaSource::MediaSource;
+
+    int readerCount() override { return 0; }
+    void doRegist() { regist(); }
+};
+
+static string streamId(size_t index) {
+    return "stream_" + to_string(index);
+}
+
+static size_t countSources() {
+    size_t ret = 0;
+    MediaSource::for_each_media([&](const MediaSource::Ptr &src) { ++ret; }, RTSP_SCHEMA, DEFAULT_VHOST, "live");
+    return ret;
+}
+
+// 此程序用于测试媒体源注册表在并发注册/查找/注销时的吞吐量
+// This program is used to test the throughput of the media source registry under concurrent register/find/unregister
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'c', "count", "10000", "注册的流个数" },
+        { 'p', "pollers", to_string(thread::hardware_concurrency()), "并发查找线程数" },
+        { 's', "seconds", "5", "并发查找测试时长,单位秒" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    size_t count = cmd_main["count"].as<size_t>();
+    size_t pollers = MAX(cmd_main["pollers"].as<size_t>(), (size_t)1);
+    size_t seconds = cmd_main["seconds"].as<size_t>();
+
+    // 注册时会打印日志，只输出告警以上级别避免干扰测试结果
+    // Logs are printed when registering, only output warnings and above to avoid interfering with the test results
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    vector<BenchMediaSource::Ptr> sources(count);
+    for (size_t i = 0; i < count; ++i) {
+        sources[i] = std::make_shared<BenchMediaSource>(RTSP_SCHEMA, MediaTuple { DEFAULT_VHOST, "live", streamId(i), "" });
+    }
+
+    // 注册测试，多线程并发注册
+    // Registration test, multi-threaded concurrent registration
+    Ticker ticker;
+    {
+        vector<thread> threads;
+        for (size_t t = 0; t < pollers; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t i = t; i < count; i += pollers) {
+                    sources[i]->doRegist();
+                }
+            });
+        }
+        for (auto &th : threads) {
+            th.join();
+        }
+    }
+    auto cost_ms = MAX(ticker.elapsedTime(), (uint64_t)1);
+    BenchChecker checker;
+    checker.check(countSources() == count, "regist count");
+    cout << "regist " << count << " sources in " << cost_ms << " ms, " << count * 1000 / cost_ms << " ops/s" << endl;
+
+    // 查找测试，pollers个线程并发查找，同时有一个线程不断注册注销
+    // Find test, pollers threads find concurrently, while one thread keeps registering and unregistering
+    atomic<bool> exit_flag { false };
+    atomic<uint64_t> find_count { 0 };
+    atomic<uint64_t> find_miss { 0 };
+    atomic<uint64_t> list_count { 0 };
+    atomic<uint64_t> churn_count { 0 };
+    {
+        vector<thread> threads;
+        for (size_t t = 0; t < pollers; ++t) {
+            threads.emplace_back([&, t]() {
+                uint64_t finds = 0, miss = 0, lists = 0;
+                size_t index = t;
+                while (!exit_flag) {
+                    index = (index * 1103515245 + 12345) % count;
+                    if (!MediaSource::find(RTSP_SCHEMA, DEFAULT_VHOST, "live", streamId(index))) {
+                        ++miss;
+                    }
+                    if (++finds % 10000 == 0) {
+                        // 模拟getMediaList接口轮询
+                        // Simulate getMediaList api polling
+                        size_t total = 0;
+                        MediaSource::for_each_media([&](const MediaSource::Ptr &src) { ++total; });
+                        ++lists;
+                    }
+                }
+                find_count += finds;
+                find_miss += miss;
+                list_count += lists;
+            });
+        }
+        threads.emplace_back([&]() {
+            size_t index = 0;
+            while (!exit_flag) {
+                auto src = std::make_shared<BenchMediaSource>(RTMP_SCHEMA, MediaTuple { DEFAULT_VHOST, "churn", streamId(index++ % 1000), "" });
+                src->doRegist();
+                src = nullptr;
+                ++churn_count;
+            }
+        });
+        this_thread::sleep_for(chrono::seconds(seconds));
+        exit_flag = true;
+        for (auto &th : threads) {
+            th.join();
+        }
+    }
+    auto total_seconds = MAX(seconds, (size_t)1);
+    cout << "find " << find_count / total_seconds << " ops/s with " << pollers << " pollers, miss " << find_miss
+         << ", for_each_media " << list_count / total_seconds << " ops/s, regist/unregist " << churn_count / total_seconds << " ops/s" << endl;
+    // 注册/注销其他流不能影响已注册的流
+    // Registering/unregistering other streams must not affect the registered streams
+    checker.check(find_miss == 0, "find miss");
+
+    // 注销测试，析构时自动注销
+    // Unregistration test, automatically unregistered when destructed
+    ticker.resetTime();
+    {
+        vector<thread> threads;
+        for (size_t t = 0; t < pollers; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t i = t; i < count; i += pollers) {
+                    sources[i] = nullptr;
+                }
+            });
+        }
+        for (auto &th : threads) {
+            th.join();
+        }
+    }
+    cost_ms = MAX(ticker.elapsedTime(), (uint64_t)1);
+    cout << "unregist " << count << " sources in " << cost_ms << " ms, " << count * 1000 / cost_ms << " ops/s" << endl;
+    checker.check(countSources() == 0, "unregist count");
+    checker.check(!MediaSource::find(RTSP_SCHEMA, DEFAULT_VHOST, "live", streamId(0)), "find after unregist");
+    return checker.result();
+}
@@ -0,0 +1,104 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Util/RingBuffer.h"
+#include "Poller/EventPoller.h"
+#include "Common/SpmcRing.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+using DataType = std::shared_ptr<uint64_t>;
+
+// 等待所有poller线程执行完已投递的任务
+// Wait for all poller threads to finish the posted tasks
+static void waitPollers() {
+    EventPollerPool::Instance().for_each([](const TaskExecutor::Ptr &executor) {
+        static_pointer_cast<EventPoller>(executor)->sync([]() {});
+    });
+}
+
+template <typename Ring>
+static void bench(const char *name, size_t readers, size_t count, size_t gop, BenchChecker &checker) {
+    auto ring = std::make_shared<Ring>(512);
+    atomic<uint64_t> read_count { 0 };
+    // 每个读者收到的最后一个数据，以及是否乱序或重复，只在读者所在poller线程修改
+    // The last data received by each reader and whether it is out of order or repeated, only modified in the poller thread of the reader
+    vector<int64_t> last(readers, -1);
+    vector<uint8_t> disorder(readers, 0);
+    vector<typename Ring::RingReader::Ptr> reader_vec;
+    mutex mtx;
+    for (size_t i = 0; i < readers; ++i) {
+        auto poller = EventPollerPool::Instance().getPoller(false);
+        poller->sync([&]() {
+            auto reader = ring->attach(poller, false);
+            reader->setReadCB([&read_count, &last, &disorder, i](const DataType &data) {
+                read_count.fetch_add(1, memory_order_relaxed);
+                if ((int64_t)*data <= last[i]) {
+                    disorder[i] = 1;
+                }
+                last[i] = *data;
+            });
+            lock_guard<mutex> lck(mtx);
+            reader_vec.emplace_back(std::move(reader));
+        });
+    }
+
+    Ticker ticker;
+    for (size_t i = 0; i < count; ++i) {
+        ring->write(std::make_shared<uint64_t>(i), i % gop == 0);
+    }
+    auto write_ms = ticker.elapsedTime();
+    waitPollers();
+    auto total_ms = MAX(ticker.elapsedTime(), (uint64_t)1);
+
+    cout << name << ": " << readers << " readers, write " << count << " in " << write_ms << " ms, all delivered in " << total_ms << " ms, "
+         << read_count * 1000 / total_ms << " reads/s, delivered " << read_count << "/" << readers * count << endl;
+
+    // 落后太多的读者可能跳到最新关键帧，但是数据必须有序且最终收到最后一个数据
+    // Readers that fall behind too much may jump to the latest key frame, but the data must be in order and the last data must be received finally
+    bool ok = read_count <= readers * count;
+    for (size_t i = 0; i < readers; ++i) {
+        ok = ok && !disorder[i] && last[i] == (int64_t)count - 1;
+    }
+    checker.check(ok, name);
+}
+
+// 此程序用于对比toolkit::RingBuffer与SpmcRing在大量读者时的分发性能
+// This program is used to compare the distribution performance of toolkit::RingBuffer and SpmcRing with a large number of readers
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'r', "readers", "10000", "读者个数，平均分布在所有poller线程" },
+        { 'c', "count", "5000", "写入次数" },
+        { 'g', "gop", "50", "关键帧间隔" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    size_t readers = cmd_main["readers"].as<size_t>();
+    size_t count = cmd_main["count"].as<size_t>();
+    size_t gop = MAX(cmd_main["gop"].as<size_t>(), (size_t)1);
+
+    BenchChecker checker;
+    bench<RingBuffer<DataType>>("RingBuffer", readers, count, gop, checker);
+    bench<SpmcRing<DataType>>("SpmcRing", readers, count, gop, checker);
+    return checker.result();
+}
@@ -0,0 +1,143 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <random>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Util/NoticeCenter.h"
+#include "Common/config.h"
+#include "Rtsp/RtspMuxer.h"
+#include "ext-codec/H264Rtp.h"
+#include "ext-codec/H265Rtp.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static Frame::Ptr makeFrame(bool h265, size_t size, uint64_t pts) {
+    static mt19937 rng(0);
+    Frame::Ptr ret;
+    string *buffer;
+    if (h265) {
+        auto frame = FrameImp::create<H265Frame>();
+        // TRAIL_R
+        frame->_buffer.assign("\x00\x00\x00\x01\x02\x01", 6);
+        frame->_prefix_size = 4;
+        frame->_dts = frame->_pts = pts;
+        buffer = &frame->_buffer;
+        ret = frame;
+    } else {
+        auto frame = FrameImp::create<H264Frame>();
+        // non-IDR slice
+        frame->_buffer.assign("\x00\x00\x00\x01\x41", 5);
+        frame->_prefix_size = 4;
+        frame->_dts = frame->_pts = pts;
+        buffer = &frame->_buffer;
+        ret = frame;
+    }
+    while (buffer->size() < size) {
+        buffer->push_back((char)(rng() | 0x04));
+    }
+    return ret;
+}
+
+// 此程序用于对比h264/h265 rtp打包时FU分片拷贝负载与零拷贝引用帧数据的开销
+// This program is used to compare the cost of copying the payload and zero copy referencing the frame data of the h264/h265 FU fragments
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'c', "count", "5000", "每种模式打包的帧数" },
+        { 's', "size", "100", "帧大小,单位KB" },
+        { 'm', "mtu", "1400", "rtp mtu大小" },
+        { 't', "h265", "测试h265打包，默认h264" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    auto count = MAX(cmd_main["count"].as<size_t>(), (size_t)1);
+    auto size = MAX(cmd_main["size"].as<size_t>(), (size_t)1) * 1024;
+    auto mtu = cmd_main["mtu"].as<size_t>();
+    auto h265 = cmd_main.hasKey("h265");
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    // 预先生成帧，避免干扰测试结果
+    // Generate frames in advance to avoid interfering with the test results
+    vector<Frame::Ptr> frames;
+    for (size_t i = 0; i < MIN(count, (size_t)64); ++i) {
+        frames.emplace_back(makeFrame(h265, size, i * 40));
+    }
+
+    // 预先生成的帧打包后的rtp，零拷贝与拷贝模式的输出必须一致
+    // The rtp of the pre-generated frames, the output of zero copy and copy mode must be the same
+    vector<string> outputs[2];
+    BenchChecker checker;
+    for (int zero_copy = 0; zero_copy <= 1; ++zero_copy) {
+        mINI::Instance()[Rtp::kLowLatency] = 1;
+        mINI::Instance()[Rtp::kZeroCopyFu] = zero_copy;
+        NOTICE_EMIT(BroadcastReloadConfigArgs, Broadcast::kBroadcastReloadConfig);
+
+        RtpCodec::Ptr encoder;
+        if (h265) {
+            encoder = std::make_shared<H265RtpEncoder>();
+        } else {
+            encoder = std::make_shared<H264RtpEncoder>();
+        }
+        encoder->setRtpInfo(0, mtu, 90000, 96);
+
+        uint64_t packets = 0;
+        uint64_t copied = 0;
+        uint64_t slices = 0;
+        // 发送时新创建的buffer个数，切片内嵌于rtp包，应当为0
+        // Number of buffers newly created when sending, the slices are embedded in the rtp packet, so it should be 0
+        uint64_t allocated = 0;
+        bool record = false;
+        auto ring = std::make_shared<RtpRing::RingType>();
+        ring->setDelegate(std::make_shared<RingDelegateHelper>([&](RtpPacket::Ptr rtp, bool is_key) {
+            ++packets;
+            // 拷贝的负载字节数(不包括引用的部分)
+            // Bytes of the copied payload (excluding the referenced part)
+            copied += rtp->getPayloadSize() - rtp->getRefSize();
+            // 模拟rtsp over tcp聚合发送
+            // Simulate rtsp over tcp gathered sending
+            string bytes;
+            auto buffers = ObjectStatistic<Buffer>::count();
+            RtpPacket::forEachSlice(rtp, 0, [&](Buffer::Ptr buf) {
+                ++slices;
+                allocated += ObjectStatistic<Buffer>::count() - buffers;
+                buffers = ObjectStatistic<Buffer>::count();
+                if (record) {
+                    bytes.append(buf->data(), buf->size());
+                }
+            });
+            if (record) {
+                outputs[zero_copy].emplace_back(std::move(bytes));
+            }
+        }));
+        encoder->setRtpRing(std::move(ring));
+
+        auto start_us = getCurrentMicrosecond(true);
+        for (size_t i = 0; i < count; ++i) {
+            record = i < frames.size();
+            encoder->inputFrame(frames[i % frames.size()]);
+        }
+        auto cost_us = MAX(getCurrentMicrosecond(true) - start_us, (uint64_t)1);
+        cout << (zero_copy ? "zero copy" : "copy") << ": " << packets / count << " packets/frame, copied " << copied / count
+             << " bytes/frame of " << size << ", " << (double)slices / MAX(packets, (uint64_t)1) << " buffers/packet, "
+             << cost_us * 1000 / count << " ns/frame" << endl;
+        checker.check(!allocated, string(zero_copy ? "zero copy" : "copy") + " slices without allocation");
+    }
+
+    checker.check(!outputs[0].empty() && outputs[0] == outputs[1], "zero copy output");
+    return checker.result();
+}
@@ -0,0 +1,110 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <random>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Rtsp/RtpReceiver.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+// 生成输入seq序列，seq从65000开始以测试回环
+// Generate the input seq sequence, seq starts from 65000 to test the loop
+static vector<uint16_t> makeInput(size_t count, size_t reorder, size_t loss, size_t distance) {
+    vector<uint16_t> ret;
+    ret.reserve(count);
+    mt19937 rng(0);
+    uint16_t seq = 65000;
+    while (ret.size() < count) {
+        auto cur = seq++;
+        if (rng() % 100 < loss) {
+            continue;
+        }
+        ret.emplace_back(cur);
+    }
+    if (reorder && distance) {
+        for (size_t i = 0; i < ret.size(); ++i) {
+            if (rng() % 100 < reorder) {
+                // MIN是宏，不能直接传入rng()
+                // MIN is a macro, rng() cannot be passed in directly
+                size_t offset = 1 + rng() % distance;
+                swap(ret[i], ret[MIN(ret.size() - 1, i + offset)]);
+            }
+        }
+    }
+    return ret;
+}
+
+/**
+ * 输出的seq必须严格递增(不乱序不重复)，lossless为true时不能丢弃任何包
+ * The output seq must be strictly increasing (no disorder and no repetition), no packet can be dropped when lossless is true
+ */
+static void bench(const char *name, const vector<uint16_t> &input, bool lossless, BenchChecker &checker) {
+    PacketSortor<uint16_t, uint16_t> sortor;
+    size_t output = 0;
+    size_t disorder = 0;
+    uint16_t last_seq = input[0] - 1;
+    sortor.setOnSort([&](uint16_t seq, uint16_t packet) {
+        ++output;
+        if ((uint16_t)(seq - last_seq - 1) >= 0x7FFF) {
+            ++disorder;
+        }
+        last_seq = seq;
+    });
+
+    size_t max_jitter = 0;
+    auto start_us = getCurrentMicrosecond(true);
+    for (auto seq : input) {
+        sortor.sortPacket(seq, seq);
+        max_jitter = MAX(max_jitter, sortor.getJitterSize());
+    }
+    sortor.flush();
+    auto cost_us = MAX(getCurrentMicrosecond(true) - start_us, (uint64_t)1);
+    cout << name << ": input " << input.size() << ", output " << output << ", disorder " << disorder << ", max jitter size " << max_jitter
+         << ", " << (double)input.size() / cost_us << " Mpps" << endl;
+    checker.check(!disorder && (!lossless || output == input.size()), name);
+}
+
+// 此程序用于测试rtp排序器在不同乱序/丢包场景下的吞吐量
+// This program is used to test the throughput of the rtp sorter under different reordering/loss scenarios
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'c', "count", "10000000", "每种模式输入的包数" },
+        { 'r', "reorder", "5", "乱序比例,单位百分比" },
+        { 'l', "loss", "1", "丢包比例,单位百分比" },
+        { 'd', "distance", "32", "乱序包最大偏移距离" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    auto count = MAX(cmd_main["count"].as<size_t>(), (size_t)1);
+    auto reorder = cmd_main["reorder"].as<size_t>();
+    auto loss = cmd_main["loss"].as<size_t>();
+    auto distance = cmd_main["distance"].as<size_t>();
+
+    // 屏蔽丢包日志
+    // Mask the packet loss log
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LError));
+
+    // 乱序与丢包同时存在时，迟到太久的包会被丢弃
+    // When reordering and loss coexist, packets that are too late will be dropped
+    BenchChecker checker;
+    bench("in order", makeInput(count, 0, 0, distance), true, checker);
+    bench("reorder", makeInput(count, reorder, 0, distance), true, checker);
+    bench("loss", makeInput(count, 0, loss, distance), true, checker);
+    bench("reorder + loss", makeInput(count, reorder, loss, distance), false, checker);
+    return checker.result();
+}
@@ -0,0 +1,156 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <random>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/File.h"
+#include "Util/TimeTicker.h"
+#include "Extension/StartCode.h"
+#include "ext-codec/H264.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+// 生成随机的Annex-B数据，nalu内部不含起始码(模拟防竞争字节)
+// Generate random Annex-B data, there is no start code inside nalu (simulate emulation prevention bytes)
+static string makeBitstream(size_t size, size_t nalu_size) {
+    string ret;
+    ret.reserve(size + nalu_size);
+    mt19937 rng(0);
+    uniform_int_distribution<size_t> len_dis(1, nalu_size * 2);
+    while (ret.size() < size) {
+        ret.append("\x00\x00\x00\x01", 4);
+        auto len = len_dis(rng);
+        for (size_t i = 0; i < len; ++i) {
+            auto c = (uint8_t)(rng() & 0xFF);
+            if (c <= 0x03 && ret.size() >= 2 && ret[ret.size() - 1] == 0 && ret[ret.size() - 2] == 0) {
+                // 防竞争字节
+                // Emulation prevention byte
+                ret.push_back(0x03);
+            }
+            ret.push_back((char)c);
+        }
+    }
+    return ret;
+}
+
+using FindFunc = const char *(*)(const char *, const char *);
+
+static size_t countStartCode(const string &data, FindFunc func) {
+    size_t count = 0;
+    auto ptr = data.data();
+    auto end = ptr + data.size();
+    while ((ptr = func(ptr, end))) {
+        ++count;
+        ptr += 3;
+    }
+    return count;
+}
+
+// 逐个比较与纯c实现的查找结果(包括重叠的起始码)
+// Compare the search results with the pure c implementation one by one (including overlapping start codes)
+static bool sameResult(const char *ptr, const char *end) {
+    auto expect = ptr;
+    auto found = ptr;
+    while (true) {
+        expect = findStartCodeScalar(expect, end);
+        found = findStartCode(found, end);
+        if (expect != found) {
+            return false;
+        }
+        if (!expect) {
+            return true;
+        }
+        ++expect;
+        ++found;
+    }
+}
+
+// 覆盖simd实现的各种对齐、长度以及块边界
+// Cover various alignments, lengths and block boundaries of the simd implementation
+static void verify(const string &data, BenchChecker &checker) {
+    checker.check(sameResult(data.data(), data.data() + data.size()), "whole data");
+
+    bool ok = true;
+    for (size_t offset = 0; offset < 64 && offset < data.size(); ++offset) {
+        for (size_t len = 0; len <= 300 && offset + len <= data.size(); ++len) {
+            ok = ok && sameResult(data.data() + offset, data.data() + offset + len);
+        }
+    }
+    checker.check(ok, "offset and length");
+
+    for (char fill : { (char)0x00, (char)0xFF }) {
+        for (size_t pos = 0; pos + 3 <= 160; ++pos) {
+            string buf(160, fill);
+            buf[pos] = buf[pos + 1] = 0;
+            buf[pos + 2] = 1;
+            for (size_t end = pos; end <= buf.size(); ++end) {
+                ok = ok && sameResult(buf.data(), buf.data() + end);
+            }
+        }
+    }
+    checker.check(ok, "start code position");
+}
+
+template <typename FUNC>
+static void bench(const char *name, const string &data, size_t repeat, FUNC &&func) {
+    size_t count = 0;
+    Ticker ticker;
+    for (size_t i = 0; i < repeat; ++i) {
+        count = func();
+    }
+    auto cost_ms = MAX(ticker.elapsedTime(), (uint64_t)1);
+    auto gbps = (double)data.size() * repeat / cost_ms / 1000 / 1000;
+    cout << name << ": found " << count << ", " << gbps << " GB/s" << endl;
+}
+
+// 此程序用于测试Annex-B起始码查找的吞吐量
+// This program is used to test the throughput of the Annex-B start code search
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'i', "in", "", "Annex-B格式的h264/h265裸流文件，为空则随机生成数据" },
+        { 's', "size", "64", "随机生成数据的大小,单位MB" },
+        { 'n', "nalu", "20000", "随机生成数据的平均nalu大小,单位字节" },
+        { 'r', "repeat", "10", "重复扫描次数" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    string in = cmd_main["in"];
+    auto repeat = MAX(cmd_main["repeat"].as<size_t>(), (size_t)1);
+    string data;
+    if (!in.empty()) {
+        data = File::loadFile(in);
+        if (data.empty()) {
+            cout << "load file failed: " << in << endl;
+            return -1;
+        }
+    } else {
+        data = makeBitstream(cmd_main["size"].as<size_t>() << 20, MAX(cmd_main["nalu"].as<size_t>(), (size_t)1));
+    }
+
+    cout << "bytes: " << data.size() << ", kernel: " << getStartCodeKernel() << endl;
+    bench("scalar", data, repeat, [&]() { return countStartCode(data, findStartCodeScalar); });
+    bench(getStartCodeKernel(), data, repeat, [&]() { return countStartCode(data, findStartCode); });
+    bench("splitH264", data, repeat, [&]() {
+        size_t count = 0;
+        splitH264(data.data(), data.size(), prefixSize(data.data(), data.size()), [&](const char *ptr, size_t len, size_t prefix) { ++count; });
+        return count;
+    });
+
+    BenchChecker checker;
+    verify(data, checker);
+    return checker.result();
+}
@@ -0,0 +1,219 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <random>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/File.h"
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Rtp/TSDecoder.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(ENABLE_HLS)
+
+static void putTimestamp(string &out, int flag, int64_t ts) {
+    out.push_back((char)((flag << 4) | (((ts >> 30) & 0x07) << 1) | 1));
+    out.push_back((char)(ts >> 22));
+    out.push_back((char)((((ts >> 15) & 0x7F) << 1) | 1));
+    out.push_back((char)(ts >> 7));
+    out.push_back((char)(((ts & 0x7F) << 1) | 1));
+}
+
+// 把PES或PSI section打包为ts包，不足一个包时用adaptation field填充
+// Pack the PES or PSI section into ts packets, fill with the adaptation field when less than one packet
+static void putTS(string &out, uint16_t pid, uint8_t &cc, const string &data) {
+    size_t offset = 0;
+    do {
+        char packet[TS_PACKET_SIZE];
+        auto left = data.size() - offset;
+        packet[0] = TS_SYNC_BYTE;
+        packet[1] = (char)((offset == 0 ? 0x40 : 0x00) | (pid >> 8));
+        packet[2] = (char)pid;
+        size_t pos = 4;
+        if (left < TS_PACKET_SIZE - 4) {
+            auto stuffing = TS_PACKET_SIZE - 4 - left;
+            packet[3] = (char)(0x30 | (cc++ & 0x0F));
+            packet[4] = (char)(stuffing - 1);
+            if (stuffing > 1) {
+                packet[5] = 0x00;
+                memset(packet + 6, 0xFF, stuffing - 2);
+            }
+            pos += stuffing;
+        } else {
+            packet[3] = (char)(0x10 | (cc++ & 0x0F));
+        }
+        auto take = TS_PACKET_SIZE - pos;
+        memcpy(packet + pos, data.data() + offset, take);
+        offset += take;
+        out.append(packet, TS_PACKET_SIZE);
+    } while (offset < data.size());
+}
+
+static string makePes(uint8_t id, const string &frame, bool bounded, int64_t pts) {
+    string ret("\x00\x00\x01", 3);
+    ret.push_back((char)id);
+    auto len = bounded ? 8 + frame.size() : 0;
+    ret.push_back((char)(len >> 8));
+    ret.push_back((char)len);
+    ret.append("\x80\x80\x05", 3);
+    putTimestamp(ret, 2, pts);
+    return ret + frame;
+}
+
+/**
+ * 生成h264 + aac的ts流，另外带一个不支持的私有数据pid(模拟scte35等)，测试跳过未选中pid的开销
+ * @param bytes 应当解析出的帧数据总字节数
+ * Generate a ts stream of h264 + aac, with an additional unsupported private data pid (simulating scte35 etc.), to test the cost of skipping unselected pids
+ * @param bytes Total bytes of the frame data that should be parsed
+ */
+static string makeTS(size_t count, size_t size, size_t &bytes) {
+    mt19937 rng(0);
+    string ret, frame;
+    bytes = 0;
+    uint8_t cc[4] = { 0 };
+    // PAT: program 1 -> pmt pid 0x1000
+    static const string s_pat("\x00\x00\xB0\x0D\x00\x01\xC1\x00\x00\x00\x01\xF0\x00\x2A\xB1\x04\xB2", 17);
+    // PMT: h264(0x100) + aac(0x101) + private(0x102)
+    static const string s_pmt("\x00\x02\xB0\x1C\x00\x01\xC1\x00\x00\xE1\x00\xF0\x00\x1B\xE1\x00\xF0\x00\x0F\xE1\x01\xF0\x00\x86\xE1\x02\xF0\x00\x91\x10\x0E\xFE", 32);
+    for (size_t i = 0; i < count; ++i) {
+        int64_t pts = 90000 + i * 3600;
+        if (i % 50 == 0) {
+            putTS(ret, 0x0000, cc[0], s_pat);
+            putTS(ret, 0x1000, cc[1], s_pmt);
+        }
+        frame.assign("\x00\x00\x00\x01", 4);
+        frame.push_back(i % 50 == 0 ? 0x65 : 0x41);
+        while (frame.size() < size) {
+            frame.push_back((char)(rng() | 0x04));
+        }
+        putTS(ret, 0x100, cc[2], makePes(0xE0, frame, false, pts));
+        bytes += frame.size();
+
+        // adts头的帧长度字段包括7字节的头
+        // The frame length field of the adts header includes the 7-byte header
+        size_t len = 7 + 360;
+        frame.assign("\xFF\xF1\x50", 3);
+        frame.push_back((char)(0x80 | ((len >> 11) & 0x03)));
+        frame.push_back((char)(len >> 3));
+        frame.push_back((char)(((len & 0x07) << 5) | 0x1F));
+        frame.push_back((char)0xFC);
+        frame.append(360, (char)0x5A);
+        putTS(ret, 0x101, cc[3], makePes(0xC0, frame, true, pts));
+        bytes += frame.size();
+        frame.assign(1000, (char)0xFC);
+        uint8_t private_cc = (uint8_t)i;
+        putTS(ret, 0x102, private_cc, makePes(0xBD, frame, true, pts));
+    }
+    return ret;
+}
+
+/**
+ * 解析结果，相同流相同pts的输出计为一帧(不同解析器拆分帧的方式可能不同)
+ * Parsing result, outputs with the same stream and pts are counted as one frame (different parsers may split frames in different ways)
+ */
+class BenchResult {
+public:
+    size_t frames = 0;
+    size_t bytes = 0;
+};
+
+template <typename DECODER>
+static BenchResult bench(const char *name, const string &data, size_t chunk, size_t repeat) {
+    BenchResult ret;
+    Ticker ticker;
+    for (size_t i = 0; i < repeat; ++i) {
+        auto holder = std::make_shared<DECODER>();
+        Decoder *decoder = holder.get();
+        map<int, int64_t> last_pts;
+        decoder->setOnDecode([&](int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t size) {
+            auto it = last_pts.find(stream);
+            if (it == last_pts.end() || it->second != pts) {
+                last_pts[stream] = pts;
+                ++ret.frames;
+            }
+            ret.bytes += size;
+        });
+        for (size_t offset = 0; offset < data.size(); offset += chunk) {
+            decoder->input((uint8_t *)data.data() + offset, MIN(chunk, data.size() - offset));
+        }
+        decoder->flush();
+    }
+    auto cost_ms = MAX(ticker.elapsedTime(), (uint64_t)1);
+    ret.frames /= repeat;
+    ret.bytes /= repeat;
+    cout << name << ": frames " << ret.frames << ", bytes " << ret.bytes << ", " << (double)data.size() * repeat / cost_ms / 1000 << " MB/s" << endl;
+    return ret;
+}
+
+// 此程序用于对比media-server ts解复用器与增量式ts解析器的吞吐量
+// This program is used to compare the throughput of the media-server ts demuxer and the incremental ts parser
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'i', "in", "", "ts文件，为空则随机生成数据" },
+        { 'c', "count", "2000", "随机生成数据的帧数" },
+        { 's', "size", "100", "随机生成数据的帧大小,单位KB" },
+        { 'm', "chunk", "1316", "每次输入的数据大小(rtp负载或http body分片)" },
+        { 'r', "repeat", "5", "重复解析次数" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    string in = cmd_main["in"];
+    string data;
+    size_t count = 0, expect_bytes = 0;
+    if (!in.empty()) {
+        data = File::loadFile(in);
+        if (data.empty()) {
+            cout << "load file failed: " << in << endl;
+            return -1;
+        }
+    } else {
+        count = MAX(cmd_main["count"].as<size_t>(), (size_t)1);
+        data = makeTS(count, MAX(cmd_main["size"].as<size_t>(), (size_t)1) * 1024, expect_bytes);
+    }
+
+    // 1316(188 * 7)为rtp承载ts的典型大小，非188整数倍时模拟http body分片
+    // 1316 (188 * 7) is the typical size of ts over rtp, simulate the http body fragments when not a multiple of 188
+    auto chunk = MAX(cmd_main["chunk"].as<size_t>(), (size_t)1);
+    auto repeat = MAX(cmd_main["repeat"].as<size_t>(), (size_t)1);
+    cout << "bytes: " << data.size() << ", chunk: " << chunk << endl;
+    auto ts = bench<TSDecoder>("media-server", data, chunk, repeat);
+    auto stream = bench<TSStreamDecoder>("stream", data, chunk, repeat);
+
+    // media-server没有flush，不定长PES的最后一帧可能未输出
+    // media-server has no flush, the last frame of the unbounded PES may not be output
+    BenchChecker checker;
+    checker.check(stream.frames && stream.frames >= ts.frames && stream.frames <= ts.frames + 1, "frames of media-server and stream");
+    checker.check(stream.bytes >= ts.bytes, "bytes of media-server and stream");
+    if (count) {
+        // 私有数据pid不输出
+        // The private data pid is not output
+        checker.check(stream.frames == count * 2, "frames of stream");
+        checker.check(stream.bytes == expect_bytes, "bytes of stream");
+    }
+    return checker.result();
+}
+
+#else
+int main(int argc, char *argv[]) {
+    cout << "please ENABLE_HLS and then test" << endl;
+    return 0;
+}
+#endif // defined(ENABLE_HLS)
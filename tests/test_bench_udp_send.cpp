@@ -0,0 +1,124 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/TimeTicker.h"
+#include "Util/NoticeCenter.h"
+#include "Network/Socket.h"
+#include "Common/config.h"
+#include "Common/UdpBatchSender.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static const char *modeName(int mode) {
+    switch (mode) {
+        case UdpBatchSender::kModeSocket: return "socket";
+        case UdpBatchSender::kModeMMsg: return "sendmmsg";
+        case UdpBatchSender::kModeGso: return "gso";
+        default: return "unknown";
+    }
+}
+
+// 此程序用于对比不同udp批量发送模式在本地回环上的发送性能
+// This program is used to compare the sending performance of different udp batch sending modes on the loopback
+int main(int argc, char *argv[]) {
+    BenchCmd cmd_main({
+        { 'c', "count", "200000", "每种模式发送的包个数" },
+        { 'b', "batch", "32", "每次刷新的包个数(模拟合并写一帧的rtp包个数)" },
+        { 's', "size", "1400", "udp包大小" }
+    });
+    int ret = 0;
+    if (!cmd_main.parse(argc, argv, ret)) {
+        return ret;
+    }
+
+    size_t count = cmd_main["count"].as<size_t>();
+    size_t batch = MAX(cmd_main["batch"].as<size_t>(), (size_t)1);
+    size_t size = MAX(cmd_main["size"].as<size_t>(), (size_t)12);
+
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    auto poller = EventPollerPool::Instance().getPoller();
+    auto receiver = Socket::createSocket(poller, false);
+    auto sender = Socket::createSocket(poller, false);
+    if (!receiver->bindUdpSock(0, "127.0.0.1") || !sender->bindUdpSock(0, "127.0.0.1")) {
+        cout << "bind udp socket failed: " << get_uv_errmsg(true) << endl;
+        return -1;
+    }
+    SockUtil::setRecvBuf(receiver->rawFD(), 8 * 1024 * 1024);
+    auto peer = SockUtil::make_sockaddr("127.0.0.1", receiver->get_local_port());
+    sender->bindPeerAddr((struct sockaddr *)&peer, 0, true);
+
+    atomic<uint64_t> received { 0 };
+    atomic<uint64_t> corrupted { 0 };
+    receiver->setOnRead([&](const Buffer::Ptr &buf, struct sockaddr *addr, int addr_len) {
+        ++received;
+        // gso分段后每个包的长度与内容都必须与发送时一致
+        // The length and content of each packet must be the same as when sent after gso segmentation
+        auto ptr = buf->data();
+        if (buf->size() != size || std::count(ptr, ptr + size, ptr[0]) != (ssize_t)size) {
+            ++corrupted;
+        }
+    });
+
+    BenchChecker checker;
+    for (int mode = UdpBatchSender::kModeSocket; mode <= UdpBatchSender::kModeGso; ++mode) {
+        mINI::Instance()[General::kUdpBatchSendMode] = mode;
+        NOTICE_EMIT(BroadcastReloadConfigArgs, Broadcast::kBroadcastReloadConfig);
+        // 等待接收完上一轮的数据
+        // Wait for the data of the previous round to be received
+        this_thread::sleep_for(chrono::milliseconds(200));
+        received = 0;
+
+        auto stat_before = UdpBatchSender::getStatistic();
+        Ticker ticker;
+        poller->sync([&]() {
+            vector<Buffer::Ptr> pkts;
+            pkts.reserve(batch);
+            for (size_t i = 0; i < count; ++i) {
+                auto buf = BufferRaw::create();
+                buf->setCapacity(size);
+                buf->setSize(size);
+                memset(buf->data(), (int)i, size);
+                pkts.emplace_back(std::move(buf));
+                if (pkts.size() == batch || i + 1 == count) {
+                    UdpBatchSender::send(sender, pkts);
+                }
+            }
+            sender->flushAll();
+        });
+        auto cost_ms = MAX(ticker.elapsedTime(), (uint64_t)1);
+        this_thread::sleep_for(chrono::milliseconds(200));
+
+        auto stat = UdpBatchSender::getStatistic();
+        auto syscalls = stat.syscalls - stat_before.syscalls;
+        auto packets = stat.packets - stat_before.packets;
+        cout << modeName(mode) << ": send " << count << " packets in " << cost_ms << " ms, " << count * 1000 / cost_ms << " pps"
+             << ", batch packets " << packets << ", syscalls " << syscalls << ", packets/syscall "
+             << (syscalls ? (double)packets / syscalls : 0) << ", gso " << stat.gso - stat_before.gso
+             << ", fallback " << stat.fallback - stat_before.fallback << ", errors " << stat.errors - stat_before.errors
+             << ", received " << received << endl;
+        // 批量发送路径一个包都没有发出去(例如未指定目标地址导致EDESTADDRREQ)，全部回退到了socket发送队列
+        // The batch sending path sent no packet at all (e.g. EDESTADDRREQ caused by missing target address), all fell back to the socket send queue
+        checker.check(mode == UdpBatchSender::kModeSocket || packets, string(modeName(mode)) + " batch sending path");
+        checker.check(received && !corrupted, string(modeName(mode)) + " received packets");
+        corrupted = 0;
+    }
+    return checker.result();
+}
@@ -0,0 +1,190 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <set>
+#include <random>
+#include <thread>
+#include <iostream>
+#include "Util/logger.h"
+#include "Common/config.h"
+#include "../webrtc/Nack.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static BenchChecker s_checker;
+
+static RtpPacket::Ptr makeRtp(uint16_t seq, uint64_t ntp_stamp) {
+    return makeTestRtp(seq, 0, ntp_stamp);
+}
+
+// 查询单个seq的重传缓存
+// Query the retransmission cache of a single seq
+static RtpPacket::Ptr findRtp(NackList &list, uint16_t seq) {
+    RtpPacket::Ptr ret;
+    list.forEach(FCI_NACK(seq, vector<bool>()), [&](const RtpPacket::Ptr &rtp) { ret = rtp; });
+    return ret;
+}
+
+/**
+ * rtp发送端：重传缓存按照个数与时长淘汰，扩容时不丢失已缓存的rtp
+ * Rtp sender: the retransmission cache is evicted by number and duration, cached rtp is not lost when expanding
+ */
+static void testNackList() {
+    GET_CONFIG(uint32_t, max_rtp_cache_ms, Rtc::kMaxRtpCacheMS);
+    GET_CONFIG(uint32_t, max_rtp_cache_size, Rtc::kMaxRtpCacheSize);
+
+    {
+        // 按个数淘汰，seq从65000开始以测试回环
+        // Evict by number, seq starts from 65000 to test the loop
+        NackList list;
+        uint16_t first = 65000;
+        size_t pushed = 0;
+        for (size_t target : { 1, 63, 64, 65, 127, 128, 129, 1000, 2047, 2048, 2049, 5000 }) {
+            for (; pushed < target; ++pushed) {
+                list.pushBack(makeRtp(first + pushed, pushed));
+            }
+            auto cached = min<size_t>(pushed, max_rtp_cache_size);
+            bool ok = true;
+            for (size_t i = 0; i < pushed; ++i) {
+                uint16_t seq = first + i;
+                auto rtp = findRtp(list, seq);
+                ok = ok && (i + cached >= pushed ? rtp && rtp->getSeq() == seq : !rtp);
+            }
+            s_checker.check(ok, "cache size after " + to_string(pushed) + " rtp");
+            s_checker.check(!findRtp(list, first + pushed), "not pushed seq after " + to_string(pushed) + " rtp");
+        }
+    }
+
+    {
+        // 按时长淘汰，每100个rtp检查一次
+        // Evict by duration, checked every 100 rtp
+        NackList list;
+        size_t count = 3000;
+        uint64_t step = 10;
+        for (size_t i = 0; i < count; ++i) {
+            list.pushBack(makeRtp(i, i * step));
+        }
+        auto newest = (count - 1) * step;
+        bool ok = true;
+        for (size_t i = 0; i < count; ++i) {
+            auto stamp = i * step;
+            auto rtp = findRtp(list, i);
+            if (stamp + max_rtp_cache_ms + 100 * step < newest) {
+                ok = ok && !rtp;
+            } else if (stamp + max_rtp_cache_ms / 2 > newest) {
+                ok = ok && rtp;
+            }
+        }
+        s_checker.check(ok, "cache duration");
+    }
+
+    {
+        // 相同seq的rtp保留旧的
+        // Keep the old rtp with the same seq
+        NackList list;
+        auto first = makeRtp(100, 0);
+        list.pushBack(first);
+        list.pushBack(makeRtp(100, 1));
+        list.pushBack(makeRtp(101, 2));
+        s_checker.check(findRtp(list, 100) == first, "duplicate seq");
+
+        // 一个nack包可以查询17个seq
+        // One nack packet can query 17 seq
+        for (uint16_t seq = 102; seq < 120; ++seq) {
+            list.pushBack(makeRtp(seq, seq));
+        }
+        vector<bool> bits(FCI_NACK::kBitSize, false);
+        bits[0] = bits[5] = bits[15] = true;
+        set<uint16_t> seqs;
+        list.forEach(FCI_NACK(100, bits), [&](const RtpPacket::Ptr &rtp) { seqs.emplace(rtp->getSeq()); });
+        s_checker.check(seqs == set<uint16_t>({ 100, 101, 106, 116 }), "nack bitmap");
+    }
+}
+
+/**
+ * rtp接收端：丢失的seq都会生成nack，未丢失的不会，收到重传包后不再请求重传
+ * Rtp receiver: all lost seq generate nack, the received ones do not, and retransmission is no longer requested after receiving the retransmitted packet
+ */
+static void testNackContext() {
+    mt19937 rng(0);
+    // seq从回环前开始
+    // Seq starts before the loop
+    uint16_t offset = 0xFFFF - 200 - 50;
+    size_t count = 10000;
+    set<uint16_t> lost, nacked;
+    bool repeated = false;
+
+    NackContext ctx;
+    ctx.setOnNack([&](const FCI_NACK &nack) {
+        auto pid = nack.getPid();
+        auto blp = nack.getBlp();
+        for (size_t i = 0; i <= FCI_NACK::kBitSize; ++i) {
+            if (i == 0 || (blp & (1 << (i - 1)))) {
+                repeated = repeated || !nacked.emplace((uint16_t)(pid + i)).second;
+            }
+        }
+    });
+
+    size_t drop_start = 0, drop_len = 0;
+    for (size_t i = 1; i < count; ++i) {
+        if (i % 100 == 0) {
+            drop_start = i + rng() % 16;
+            drop_len = 4 + rng() % 16;
+        }
+        uint16_t seq = i + offset;
+        if ((i >= drop_start && i <= drop_start + drop_len) || seq == 65535 || seq == 0 || seq == 1) {
+            // 跳过结尾尚未满足nack条件的丢包
+            // Skip the lost packets at the end that do not yet meet the nack condition
+            if (i + 100 < count) {
+                lost.emplace(seq);
+            }
+            continue;
+        }
+        ctx.received(seq);
+    }
+    s_checker.check(!repeated, "nack repeated");
+    set<uint16_t> diff;
+    for (auto seq : lost) {
+        if (!nacked.count(seq)) {
+            diff.emplace(seq);
+        }
+    }
+    s_checker.check(diff.empty(), "lost seq not nacked");
+    for (auto seq : nacked) {
+        if (!lost.count(seq) && (uint16_t)(seq - offset) + 100 < count) {
+            diff.emplace(seq);
+        }
+    }
+    s_checker.check(diff.empty(), "received seq nacked");
+
+    // 收到重传包后，再次请求重传时不包含该seq
+    // After receiving the retransmitted packet, the seq is not included when requesting retransmission again
+    auto rtx = *lost.begin();
+    ctx.received(rtx, true);
+    this_thread::sleep_for(chrono::milliseconds(200));
+    nacked.clear();
+    repeated = false;
+    ctx.reSendNack();
+    s_checker.check(!nacked.empty() && !nacked.count(rtx), "resend nack");
+}
+
+// 此程序用于检验rtp重传缓存(NackList)与丢包检测(NackContext)
+// This program is used to verify the rtp retransmission cache (NackList) and packet loss detection (NackContext)
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    testNackList();
+    testNackContext();
+
+    return s_checker.result();
+}
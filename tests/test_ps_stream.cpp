@@ -0,0 +1,342 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <random>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Rtp/PSDecoder.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(ENABLE_RTPPROXY)
+
+// mpeg-ps中的编码类型
+// Codec types in mpeg-ps
+static constexpr int kPsH264 = 0x1b;
+static constexpr int kPsH265 = 0x24;
+static constexpr int kPsAAC = 0x0f;
+
+class FrameInfo {
+public:
+    int stream;
+    int codec;
+    int64_t pts;
+    int64_t dts;
+    string data;
+};
+
+// 每个流的帧列表
+// Frame list of each stream
+using FrameMap = map<int, vector<FrameInfo>>;
+
+static void putTimestamp(string &out, int flag, int64_t ts) {
+    out.push_back((char)((flag << 4) | (((ts >> 30) & 0x07) << 1) | 1));
+    out.push_back((char)(ts >> 22));
+    out.push_back((char)((((ts >> 15) & 0x7F) << 1) | 1));
+    out.push_back((char)(ts >> 7));
+    out.push_back((char)(((ts & 0x7F) << 1) | 1));
+}
+
+static void putPes(string &out, uint8_t id, const char *data, size_t size, bool with_pts, int64_t pts, int64_t dts) {
+    auto with_dts = with_pts && dts != pts;
+    auto header_size = with_dts ? 10 : (with_pts ? 5 : 0);
+    out.append("\x00\x00\x01", 3);
+    out.push_back((char)id);
+    auto len = 3 + header_size + size;
+    out.push_back((char)(len >> 8));
+    out.push_back((char)len);
+    out.push_back((char)0x80);
+    out.push_back((char)(with_dts ? 0xC0 : (with_pts ? 0x80 : 0x00)));
+    out.push_back((char)header_size);
+    if (with_pts) {
+        putTimestamp(out, with_dts ? 3 : 2, pts);
+    }
+    if (with_dts) {
+        putTimestamp(out, 1, dts);
+    }
+    out.append(data, size);
+}
+
+static void putNalu(string &out, const char *header, size_t header_size, size_t size, mt19937 &rng) {
+    out.append("\x00\x00\x00\x01", 4);
+    out.append(header, header_size);
+    // slice的first_mb_in_slice(h264)或first_slice_segment_in_pic_flag(h265)为首个slice，每个slice都是新的一帧
+    // The first_mb_in_slice (h264) or first_slice_segment_in_pic_flag (h265) of the slice marks the first slice, every slice is a new frame
+    out.push_back((char)0x88);
+    for (size_t i = 0; i < size; ++i) {
+        // 随机数据不含0字节，避免出现起始码
+        // The random data contains no zero byte to avoid start codes
+        out.push_back((char)(rng() | 0x04));
+    }
+}
+
+/**
+ * 生成ps流及其应当解析出的帧
+ * @param h265 视频是否为h265，否则为h264
+ * @param psm 是否携带PSM，不携带时需要解析器猜测编码格式
+ * @param split_pack 大帧的每个PES是否都放在单独的PS包中
+ * @param packs 输出每帧所在PS包的偏移量
+ * Generate a ps stream and the frames that should be parsed from it
+ * @param h265 Whether the video is h265, otherwise h264
+ * @param psm Whether to carry PSM, the parser needs to guess the codec when not carried
+ * @param split_pack Whether every PES of large frames is put into a separate ps pack
+ * @param packs Output the offset of the ps pack of each frame
+ */
+static string makePS(FrameMap &frames, bool h265, bool psm, mt19937 &rng, bool split_pack = false, vector<size_t> *packs = nullptr) {
+    static const string s_pack_header("\x00\x00\x01\xBA\x44\x00\x04\x00\x04\x01\x01\x89\xC3\xF8", 14);
+    string ret;
+    int64_t pts = 90000;
+    for (int i = 0; i < 120; ++i) {
+        auto key = i % 30 == 0;
+        if (packs) {
+            packs->emplace_back(ret.size());
+        }
+        ret.append(s_pack_header);
+        if (key) {
+            ret.append("\x00\x00\x01\xBB\x00\x06\x80\x01\x01\x04\xE1\xFF", 12);
+            if (psm) {
+                string map("\x00\x00\x01\xBC\x00\x12\xE0\xFF\x00\x00\x00\x08\x00\xE0\x00\x00\x0F\xC0\x00\x00\x00\x00\x00\x00", 24);
+                map[12] = (char)(h265 ? kPsH265 : kPsH264);
+                ret.append(map);
+            }
+        }
+
+        // 每隔一帧带一个不同于pts的dts
+        // Every other frame carries a dts different from pts
+        pts += 3600;
+        FrameInfo video { 0xE0, h265 ? kPsH265 : kPsH264, pts, i % 2 ? pts - 3600 : pts, "" };
+        if (h265) {
+            if (key) {
+                putNalu(video.data, "\x40\x01", 2, 20, rng);
+                putNalu(video.data, "\x42\x01", 2, 30, rng);
+                putNalu(video.data, "\x44\x01", 2, 8, rng);
+            }
+            putNalu(video.data, key ? "\x26\x01" : "\x02\x01", 2, key ? 150000 : 10 + rng() % 20000, rng);
+        } else {
+            if (key) {
+                putNalu(video.data, "\x67", 1, 20, rng);
+                putNalu(video.data, "\x68", 1, 4, rng);
+            }
+            putNalu(video.data, key ? "\x65" : "\x41", 1, key ? 150000 : 10 + rng() % 20000, rng);
+        }
+        // 大帧拆分为多个PES，海康只有第一个PES带pts，大华每个PES都带pts
+        // Large frames are split into multiple PES, only the first PES carries pts for Hikvision, every PES carries pts for Dahua
+        auto every_pts = i % 4 == 0;
+        for (size_t offset = 0; offset < video.data.size(); offset += 60000) {
+            if (offset && split_pack) {
+                ret.append(s_pack_header);
+            }
+            putPes(ret, 0xE0, video.data.data() + offset, MIN(video.data.size() - offset, (size_t)60000), offset == 0 || every_pts, video.pts, video.dts);
+        }
+        frames[video.stream].emplace_back(std::move(video));
+
+        // adts头的帧长度字段包括7字节的头
+        // The frame length field of the adts header includes the 7-byte header
+        size_t aac_size = 200 + rng() % 200;
+        auto len = aac_size + 7;
+        FrameInfo audio { 0xC0, kPsAAC, pts + 10, pts + 10, "" };
+        audio.data.assign("\xFF\xF1\x50", 3);
+        audio.data.push_back((char)(0x80 | ((len >> 11) & 0x03)));
+        audio.data.push_back((char)(len >> 3));
+        audio.data.push_back((char)(((len & 0x07) << 5) | 0x1F));
+        audio.data.push_back((char)0xFC);
+        for (size_t j = 0; j < aac_size; ++j) {
+            audio.data.push_back((char)rng());
+        }
+        putPes(ret, 0xC0, audio.data.data(), audio.data.size(), true, audio.pts, audio.dts);
+        frames[audio.stream].emplace_back(std::move(audio));
+    }
+    return ret;
+}
+
+static vector<Buffer::Ptr> splitPackets(const string &data, bool random_size, mt19937 &rng) {
+    // 模拟逐个rtp负载输入，随机大小时包括只有几个字节的包，以覆盖头部跨包的情况
+    // Simulate inputting rtp payloads one by one, tiny packets are included for random sizes to cover headers across packets
+    vector<Buffer::Ptr> ret;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t size = random_size ? 1 + rng() % 1400 : 1400;
+        size = MIN(size, data.size() - offset);
+        auto pkt = BufferRaw::create();
+        pkt->assign(data.data() + offset, size);
+        ret.emplace_back(std::move(pkt));
+        offset += size;
+    }
+    return ret;
+}
+
+static FrameMap decode(Decoder &decoder, const vector<Buffer::Ptr> &packets, bool ref) {
+    FrameMap ret;
+    decoder.setOnDecode([&](int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes) {
+        auto &list = ret[stream];
+        if (!list.empty() && list.back().pts == pts) {
+            // 不同解析器拆分帧的方式可能不同，相同pts的数据合并后比较
+            // Different parsers may split frames in different ways, data with the same pts is merged before comparing
+            list.back().data.append((const char *)data, bytes);
+            return;
+        }
+        list.emplace_back(FrameInfo { stream, codecid, pts, dts, string((const char *)data, bytes) });
+    });
+    for (auto &pkt : packets) {
+        if (ref) {
+            decoder.input(pkt, (uint8_t *)pkt->data(), pkt->size());
+        } else {
+            decoder.input((uint8_t *)pkt->data(), pkt->size());
+        }
+    }
+    decoder.flush();
+    return ret;
+}
+
+/**
+ * 比较解析结果，帧数据一致则关键帧判断(由负载决定)也一致
+ * @param pending 允许每个流最后缓存未输出的帧数
+ * Compare the parsing results, the key frame judgment (determined by the payload) is also consistent if the frame data is consistent
+ * @param pending Number of frames allowed to be cached and not output at the end of each stream
+ */
+static bool compare(const string &name, const FrameMap &expected, const FrameMap &actual, size_t pending) {
+    bool ok = expected.size() == actual.size();
+    for (auto &pr : expected) {
+        auto it = actual.find(pr.first);
+        if (it == actual.end()) {
+            cout << name << ": stream " << pr.first << " not found" << endl;
+            ok = false;
+            continue;
+        }
+        auto &want = pr.second;
+        auto &got = it->second;
+        if (got.size() > want.size() || got.size() + pending < want.size()) {
+            cout << name << ": stream " << pr.first << " frame count " << got.size() << " != " << want.size() << endl;
+            ok = false;
+        }
+        for (size_t i = 0; i < MIN(want.size(), got.size()); ++i) {
+            auto &a = want[i];
+            auto &b = got[i];
+            if (a.codec != b.codec || a.pts != b.pts || a.dts != b.dts || a.data != b.data) {
+                cout << name << ": stream " << pr.first << " frame " << i << " mismatched, codec " << b.codec << "/" << a.codec << ", pts "
+                     << b.pts << "/" << a.pts << ", dts " << b.dts << "/" << a.dts << ", size " << b.data.size() << "/" << a.data.size() << endl;
+                ok = false;
+                break;
+            }
+        }
+    }
+    cout << name << (ok ? ": ok" : ": failed") << endl;
+    return ok;
+}
+
+// 此程序用于检验流式ps解析器与media-server ps解复用器输出的帧、时间戳及负载是否一致
+// 已知差异：流式解析器输出的flags恒为0(关键帧由负载判断)，猜测编码格式时finish为0，且跳过mpeg1 PES，因此不参与比较
+// This program is used to verify that the frames, timestamps and payloads output by the streaming ps parser are consistent with the media-server ps demuxer
+// Known differences: the flags output by the streaming parser are always 0 (key frames are judged by the payload), finish is 0 when guessing
+// the codec, and mpeg1 PES is skipped, so they are not compared
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    mt19937 rng(0);
+    bool ok = true;
+    for (auto h265 : { false, true }) {
+        for (auto random_size : { false, true }) {
+            string name = StrPrinter << (h265 ? "h265" : "h264") << (random_size ? " random size" : " mtu size");
+            FrameMap expected;
+            auto packets = splitPackets(makePS(expected, h265, true, rng), random_size, rng);
+
+            PSStreamDecoder stream_ref;
+            ok = compare(name + " stream(ref)", expected, decode(stream_ref, packets, true), 0) && ok;
+            PSStreamDecoder stream_copy;
+            ok = compare(name + " stream(copy)", expected, decode(stream_copy, packets, false), 0) && ok;
+            // media-server在收到下一帧前可能缓存最后一帧
+            // media-server may cache the last frame before receiving the next frame
+            PSDecoder ps_decoder;
+            ok = compare(name + " media-server", expected, decode(ps_decoder, packets, false), 1) && ok;
+        }
+    }
+
+    // 没有PSM时根据负载猜测编码格式
+    // Guess the codec according to the payload when there is no PSM
+    for (auto h265 : { false, true }) {
+        FrameMap expected;
+        auto packets = splitPackets(makePS(expected, h265, false, rng), true, rng);
+        PSStreamDecoder decoder;
+        ok = compare(string(h265 ? "h265" : "h264") + " without psm stream(ref)", expected, decode(decoder, packets, true), 0) && ok;
+    }
+
+    // 视频帧在下一个pack header到达时输出，不等待下一帧的pts
+    // The video frame is output when the next pack header arrives, without waiting for the pts of the next frame
+    for (auto h265 : { false, true }) {
+        string name = string(h265 ? "h265" : "h264") + " output at pack boundary";
+        FrameMap expected;
+        vector<size_t> packs;
+        auto ps = makePS(expected, h265, true, rng, false, &packs);
+        PSStreamDecoder decoder;
+        size_t video_frames = 0;
+        int64_t last_pts = -1;
+        decoder.setOnDecode([&](int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes) {
+            if (stream == 0xE0 && pts != last_pts) {
+                last_pts = pts;
+                ++video_frames;
+            }
+        });
+        bool latency_ok = true;
+        size_t offset = 0;
+        for (size_t i = 1; i < packs.size(); ++i) {
+            // 输入到第i帧的pack header结束，前i帧都应已输出
+            // Input until the end of the pack header of frame i, the first i frames should have been output
+            auto end = packs[i] + 14;
+            decoder.input((const uint8_t *)ps.data() + offset, end - offset);
+            offset = end;
+            if (video_frames != i) {
+                cout << name << ": " << video_frames << " frames output after pack " << i << endl;
+                latency_ok = false;
+                break;
+            }
+        }
+        decoder.input((const uint8_t *)ps.data() + offset, ps.size() - offset);
+        decoder.flush();
+        latency_ok = latency_ok && video_frames == expected[0xE0].size();
+        cout << name << (latency_ok ? ": ok" : ": failed") << endl;
+        ok = latency_ok && ok;
+    }
+
+    // 帧跨越多个PS包时退化为在pts变化时输出，检测到之前在pack边界输出的第一帧不完整
+    // Fall back to outputting when the pts changes if frames span multiple ps packs,
+    // the first frame output at the pack boundary before the detection is incomplete
+    for (auto h265 : { false, true }) {
+        string name = string(h265 ? "h265" : "h264") + " frames span packs";
+        FrameMap expected;
+        auto packets = splitPackets(makePS(expected, h265, true, rng, true), true, rng);
+        PSStreamDecoder decoder;
+        auto actual = decode(decoder, packets, true);
+        auto &want = expected[0xE0];
+        auto &got = actual[0xE0];
+        auto truncated = !got.empty() && got[0].pts == want[0].pts && got[0].data.size() < want[0].data.size()
+            && !want[0].data.compare(0, got[0].data.size(), got[0].data);
+        if (!truncated) {
+            cout << name << ": first frame is not truncated" << endl;
+        } else {
+            want.erase(want.begin());
+            got.erase(got.begin());
+        }
+        ok = compare(name, expected, actual, 0) && truncated && ok;
+    }
+
+    cout << (ok ? "all passed" : "some failed") << endl;
+    return ok ? 0 : -1;
+}
+
+#else
+int main(int argc, char *argv[]) {
+    cout << "please ENABLE_RTPPROXY and then test" << endl;
+    return 0;
+}
+#endif // defined(ENABLE_RTPPROXY)
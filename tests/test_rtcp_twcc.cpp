@@ -0,0 +1,192 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <random>
+#include <vector>
+#include <iostream>
+#include "Util/logger.h"
+#include "Rtcp/RtcpFCI.h"
+#include "../webrtc/TwccContext.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static BenchChecker s_checker;
+
+static int16_t makeDelta(SymbolStatus status, mt19937 &rng) {
+    switch (status) {
+        case SymbolStatus::small_delta: return (int16_t)(rng() % 256);
+        // large delta包括负数
+        // The large delta includes negative values
+        case SymbolStatus::large_delta: return (int16_t)(rng() % 2 ? 256 + rng() % 30000 : -(int16_t)(1 + rng() % 30000));
+        default: return 0;
+    }
+}
+
+/**
+ * 生成fci后用forEachPacket解析，检查seq、包状态、recv delta与输入一致
+ * Generate fci and parse it with forEachPacket, check that the seq, packet status and recv delta are consistent with the input
+ */
+static void roundTrip(const string &name, uint16_t base_seq, const vector<SymbolStatus> &status, const vector<int16_t> &delta) {
+    string fci;
+    FCI_TWCC::create(fci, base_seq, 0x123456, 7, status.data(), delta.data(), status.size());
+    auto twcc = (FCI_TWCC *)fci.data();
+    twcc->check(fci.size());
+    s_checker.check(twcc->getBaseSeq() == base_seq, name + " base seq");
+    s_checker.check(twcc->getPacketCount() == status.size(), name + " packet count");
+    s_checker.check(twcc->getReferenceTime() == 0x123456, name + " reference time");
+
+    size_t index = 0;
+    bool ok = true;
+    twcc->forEachPacket(fci.size(), [&](uint16_t seq, SymbolStatus s, int16_t d) {
+        if (index >= status.size() || seq != (uint16_t)(base_seq + index) || s != status[index] || d != delta[index]) {
+            ok = false;
+        }
+        ++index;
+    });
+    s_checker.check(ok && index == status.size(), name + " forEachPacket");
+
+    if ((size_t)base_seq + status.size() <= 0xFFFF) {
+        // 没有回环时与按seq排序的解析结果比较
+        // Compare with the result sorted by seq when there is no loop
+        auto list = twcc->getPacketChunkList(fci.size());
+        ok = list.size() == status.size();
+        for (auto &pr : list) {
+            auto i = (uint16_t)(pr.first - base_seq);
+            ok = ok && i < status.size() && pr.second.first == status[i] && pr.second.second == delta[i];
+        }
+        s_checker.check(ok, name + " getPacketChunkList");
+
+        // 按map生成的fci应与按数组生成的一致
+        // The fci generated by map should be the same as the one generated by array
+        FCI_TWCC::TwccPacketStatus map;
+        for (size_t i = 0; i < status.size(); ++i) {
+            map.emplace((uint16_t)(base_seq + i), make_pair(status[i], delta[i]));
+        }
+        s_checker.check(FCI_TWCC::create(0x123456, 7, map) == fci, name + " create by map");
+    }
+}
+
+static void randomRoundTrip(const string &name, uint16_t base_seq, size_t count, mt19937 &rng) {
+    vector<SymbolStatus> status;
+    vector<int16_t> delta;
+    while (status.size() < count) {
+        // 随机长度的相同状态，覆盖RunLengthChunk与1bit/2bit StatusVecChunk
+        // Same status with random length, covering RunLengthChunk and 1bit/2bit StatusVecChunk
+        auto s = (SymbolStatus)(rng() % 3);
+        auto run = rng() % 4 ? 1 + rng() % 3 : 1 + rng() % 20;
+        for (size_t i = 0; i < run && status.size() < count; ++i) {
+            status.emplace_back(s);
+            delta.emplace_back(makeDelta(s, rng));
+        }
+    }
+    roundTrip(name, base_seq, status, delta);
+}
+
+/**
+ * 模拟丢包与相邻乱序的接收，TwccContext生成的反馈中每个收到的seq只上报一次，且还原出的接收时间与输入一致
+ * Simulate packet loss and adjacent reordering, each received seq is reported only once in the feedback generated by TwccContext,
+ * and the restored receive time is consistent with the input
+ */
+static void testTwccContext(uint16_t first_seq, size_t count, mt19937 &rng) {
+    auto name = "context " + to_string(first_seq);
+    vector<uint16_t> input;
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t seq = first_seq + i;
+        if (rng() % 10 == 0) {
+            // 丢包
+            // Packet loss
+            continue;
+        }
+        input.emplace_back(seq);
+        // 回环附近不乱序，回环后收到的回环前的包会被丢弃
+        // No reordering near the loop, packets before the loop received after the loop are discarded
+        auto size = input.size();
+        if (size > 1 && rng() % 8 == 0 && input[size - 2] < input[size - 1]) {
+            swap(input[size - 2], input[size - 1]);
+        }
+    }
+
+    map<uint16_t, uint64_t> sent;
+    map<uint16_t, uint64_t> reported;
+    bool ok = true;
+    TwccContext ctx;
+    ctx.setOnSendTwccCB([&](uint32_t ssrc, const string &fci) {
+        auto twcc = (FCI_TWCC *)fci.data();
+        twcc->check(fci.size());
+        // 时间单位为250us
+        // The time unit is 250us
+        int64_t time = (int64_t)twcc->getReferenceTime() * 64 * 4;
+        twcc->forEachPacket(fci.size(), [&](uint16_t seq, SymbolStatus status, int16_t delta) {
+            if (status == SymbolStatus::not_received) {
+                return;
+            }
+            time += delta;
+            ok = ok && sent.count(seq) && reported.emplace(seq, time).second;
+        });
+    });
+    uint64_t stamp = 1000;
+    for (auto seq : input) {
+        // 偶尔出现超过64ms的接收间隔，生成large delta
+        // Occasionally a receive interval over 64ms occurs, generating large delta
+        stamp += rng() % 16 ? rng() % 20 : 64 + rng() % 200;
+        sent.emplace(seq, stamp * 4);
+        ctx.onRtp(0x1234, seq, stamp);
+    }
+    s_checker.check(ok, name + " reported once");
+    // 最后不满足发送条件的包尚未上报
+    // The last packets that do not meet the sending condition have not been reported yet
+    size_t matched = 0;
+    for (auto &pr : reported) {
+        matched += sent[pr.first] == pr.second;
+    }
+    s_checker.check(matched == reported.size(), name + " receive time");
+    s_checker.check(reported.size() + TwccContext::kMaxSeqSize >= sent.size(), name + " reported count");
+}
+
+// 此程序用于检验transport-cc反馈的生成(FCI_TWCC::create)与解析(FCI_TWCC::forEachPacket)是否互逆,
+// 以及TwccContext在乱序、丢包、序号回环下生成的反馈能否还原每个包的到达时间
+// This program is used to verify that the generation (FCI_TWCC::create) and parsing (FCI_TWCC::forEachPacket) of transport-cc feedback are inverse,
+// and that the feedback generated by TwccContext under reordering, loss and sequence wrap-around restores the arrival time of every packet
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    mt19937 rng(0);
+    for (int i = 0; i < 2000; ++i) {
+        auto base_seq = (uint16_t)rng();
+        if (i % 4 == 0) {
+            // seq回环
+            // Seq loop
+            base_seq = (uint16_t)(0xFFFF - rng() % 64);
+        }
+        randomRoundTrip("random " + to_string(i), base_seq, 1 + rng() % 600, rng);
+    }
+
+    // 超过RunLengthChunk上限(8191)的连续丢包
+    // Continuous packet loss exceeding the RunLengthChunk limit (8191)
+    vector<SymbolStatus> status(10000, SymbolStatus::not_received);
+    vector<int16_t> delta(status.size(), 0);
+    status.back() = SymbolStatus::small_delta;
+    delta.back() = 100;
+    roundTrip("long run", 60000, status, delta);
+
+    // 只有一个包
+    // Only one packet
+    roundTrip("single", 65535, { SymbolStatus::large_delta }, { -1 });
+
+    for (auto first_seq : { 0, 30000, 65000 }) {
+        testTwccContext(first_seq, 5000, rng);
+    }
+
+    return s_checker.result();
+}
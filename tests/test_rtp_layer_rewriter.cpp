@@ -0,0 +1,132 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <iostream>
+#include "Util/logger.h"
+#include "../webrtc/WebRtcPlayer.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static BenchChecker s_checker;
+
+/**
+ * 模拟一个simulcast层，每帧2个rtp
+ * Simulate a simulcast layer, 2 rtp per frame
+ */
+class Layer {
+public:
+    Layer(uint16_t seq, uint32_t stamp) : _seq(seq), _stamp(stamp) {}
+
+    RtpPacket::Ptr next(uint64_t ntp_stamp) {
+        auto ret = makeTestRtp(_seq++, _stamp, ntp_stamp);
+        if (++_count % 2 == 0) {
+            _stamp += 3000;
+        }
+        return ret;
+    }
+
+private:
+    uint16_t _seq;
+    uint32_t _stamp;
+    size_t _count = 0;
+};
+
+class Checker {
+public:
+    // 输出的seq必须连续，时间戳必须与输入同步递增，返回最后的输出包
+    // The output seq must be continuous and the timestamp must increase synchronously with the input, return the last output packet
+    RtpPacket::Ptr feed(const string &name, RtpLayerRewriter &rewriter, Layer &layer, size_t count, bool switch_layer, uint32_t expect_stamp_delta) {
+        RtpPacket::Ptr out;
+        for (size_t i = 0; i < count; ++i) {
+            auto rtp = layer.next(_ntp_stamp);
+            auto seq = rtp->getSeq();
+            auto stamp = rtp->getStamp();
+            out = rewriter.rewrite(rtp, switch_layer && i == 0);
+            // 输入包可能被其他播放器共享，不能被修改
+            // The input packet may be shared by other players and must not be modified
+            s_checker.check(rtp->getSeq() == seq && rtp->getStamp() == stamp, name + " input not modified");
+            if (_started) {
+                s_checker.check(out->getSeq() == (uint16_t)(_last_seq + 1), name + " seq continuous");
+                if (i == 0) {
+                    s_checker.check(out->getStamp() == _last_stamp + expect_stamp_delta, name + " stamp of first packet");
+                } else {
+                    s_checker.check(out->getStamp() - _last_stamp == stamp - _last_in_stamp, name + " stamp delta");
+                }
+            }
+            s_checker.check(out->type == rtp->type && out->sample_rate == rtp->sample_rate && out->ntp_stamp == rtp->ntp_stamp, name + " packet info");
+            _started = true;
+            _last_seq = out->getSeq();
+            _last_stamp = out->getStamp();
+            _last_in_stamp = stamp;
+            if (i % 2) {
+                _ntp_stamp += 33;
+            }
+        }
+        return out;
+    }
+
+    void skipNtp(int64_t ms) { _ntp_stamp += ms; }
+
+private:
+    bool _started = false;
+    uint16_t _last_seq = 0;
+    uint32_t _last_stamp = 0;
+    uint32_t _last_in_stamp = 0;
+    uint64_t _ntp_stamp = 100000;
+};
+
+// 此程序用于检验simulcast切换层时rtp seq与时间戳的改写
+// This program is used to verify the rewriting of rtp seq and timestamp when switching simulcast layers
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    RtpLayerRewriter rewriter;
+    Checker checker;
+    Layer low(100, 1000), high(65500, 0xFFFFF000), mid(30000, 123456);
+
+    // 未发生切换时(包括首包携带切换标记)返回原包
+    // Return the original packet when no switch has occurred (including the first packet carrying the switch flag)
+    auto rtp = low.next(100000);
+    s_checker.check(rewriter.rewrite(rtp, true) == rtp, "first packet passthrough");
+    for (int i = 0; i < 10; ++i) {
+        rtp = low.next(100000);
+        s_checker.check(rewriter.rewrite(rtp, false) == rtp, "passthrough");
+    }
+    checker.feed("low", rewriter, low, 1, false, 0);
+
+    // 按照ntp时间差推算时间戳，seq与时间戳均在切换后回环
+    // The timestamp is calculated by the ntp time difference, both seq and timestamp loop after the switch
+    checker.skipNtp(7);
+    checker.feed("switch to high", rewriter, high, 200, true, 7 * 90);
+
+    // ntp时间差超过1秒时按照30fps递增
+    // Increase by 30fps when the ntp time difference exceeds 1 second
+    checker.skipNtp(5000);
+    checker.feed("switch to mid", rewriter, mid, 100, true, 90000 / 30);
+
+    // ntp时间回退时按照30fps递增
+    // Increase by 30fps when the ntp time goes back
+    Checker back_checker;
+    RtpLayerRewriter back_rewriter;
+    Layer a(0, 0), b(0, 0);
+    back_checker.feed("a", back_rewriter, a, 10, false, 0);
+    back_checker.skipNtp(-1000);
+    back_checker.feed("b after ntp back", back_rewriter, b, 10, true, 90000 / 30);
+
+    // 切回原来的层
+    // Switch back to the original layer
+    checker.skipNtp(33);
+    checker.feed("switch back to low", rewriter, low, 100, true, 33 * 90 * 2);
+
+    return s_checker.result();
+}
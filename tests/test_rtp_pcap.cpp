@@ -3,9 +3,12 @@
 #include "Network/TcpServer.h"
 #include "Rtmp/RtmpSession.h"
 #include "Rtp/RtpProcess.h"
+#include "Rtp/RtpServer.h"
 #include "Rtsp/RtspSession.h"
 #include "Util/logger.h"
 #include "Util/util.h"
+#include "Util/TimeTicker.h"
+#include "Network/sockutil.h"
 #include <iostream>
 #include <map>
 #include <pcap.h>
@@ -219,6 +222,123 @@ static bool loadFile(const char *path, const EventPoller::Ptr &poller) {
     return true;
 }
 
+#if defined(ENABLE_RTPPROXY)
+// 读取pcap中第一个ssrc的所有rtp包，用于压测回放
+// Read all rtp packets of the first ssrc in the pcap, used for benchmark replay
+static bool loadRtpPackets(const char *path, vector<string> &pkts) {
+    char errbuf[PCAP_ERRBUF_SIZE] = {'\0'};
+    std::shared_ptr<pcap_t> handle(pcap_open_offline(path, errbuf), [](pcap_t *handle) {
+        if (handle) {
+            pcap_close(handle);
+        }
+    });
+    if (!handle) {
+        WarnL << "open file failed:" << path << "error: " << errbuf;
+        return false;
+    }
+    uint32_t first_ssrc = 0;
+    struct pcap_pkthdr header {};
+    const u_char *pkt_buff;
+    while ((pkt_buff = pcap_next(handle.get(), &header))) {
+        auto ethernet = (struct sniff_ethernet *)pkt_buff;
+        if (ntohs(ethernet->ether_type) != ETHERTYPE_IPV4) {
+            continue;
+        }
+        auto ip = (struct sniff_ip *)(pkt_buff + sizeof(struct sniff_ethernet));
+        if (ip->ip_p != IPTYPE_UDP) {
+            continue;
+        }
+        auto ip_len = (ip->ip_hl & 0x0f) * 4;
+        auto udp = (struct sniff_udp *)((const u_char *)ip + ip_len);
+        auto rtp = (const char *)udp + sizeof(struct sniff_udp);
+        size_t rtp_len = ntohs(udp->udp_length) - sizeof(struct sniff_udp);
+        uint32_t ssrc;
+        if ((const u_char *)rtp + rtp_len > pkt_buff + header.caplen || !isRtp(rtp, rtp_len) || !getSSRC(rtp, rtp_len, ssrc)) {
+            continue;
+        }
+        if (pkts.empty()) {
+            first_ssrc = ssrc;
+        }
+        if (ssrc == first_ssrc) {
+            pkts.emplace_back(rtp, rtp_len);
+        }
+    }
+    return !pkts.empty();
+}
+
+// 把pcap中的一路流改写ssrc后模拟成多路设备，按rtp时间戳实时推送到单端口多路复用(ssrc分片)的rtp服务器，
+// 每秒打印各poller线程负载，据此评估单核可承载的流数
+// Rewrite the ssrc of one stream in the pcap to simulate multiple devices, push them in real time according to the rtp timestamp to the rtp server in single-port multiplex (ssrc sharding) mode,
+// print the load of each poller thread every second, to evaluate the number of streams per core
+static void benchMultiplex(const char *path, size_t streams, uint64_t seconds, uint16_t port) {
+    vector<string> pkts;
+    if (!loadRtpPackets(path, pkts)) {
+        ErrorL << "no rtp packet found in " << path;
+        return;
+    }
+    mINI::Instance()[RtpProxy::kMultiplexShard] = 1;
+    auto server = std::make_shared<RtpServer>();
+    server->start(port, "::", MediaTuple{DEFAULT_VHOST, kRtpAppName, "", ""}, RtpServer::NONE, true, 0, 0, true);
+    port = server->getPort();
+
+    auto fd = SockUtil::bindUdpSock(0, "0.0.0.0");
+    if (fd == -1) {
+        ErrorL << "create udp socket failed";
+        return;
+    }
+    SockUtil::setSendBuf(fd, 16 * 1024 * 1024);
+    auto addr = SockUtil::make_sockaddr("127.0.0.1", port);
+
+    auto first_header = (RtpHeader *)pkts.front().data();
+    auto first_stamp = ntohl(first_header->stamp);
+    auto last_stamp = ntohl(((RtpHeader *)pkts.back().data())->stamp);
+    // 循环回放时时间戳与序号需要连续
+    // Timestamp and sequence need to be continuous when replaying in a loop
+    auto round_stamp = MAX(last_stamp - first_stamp, 1U) + 3600;
+    auto round_seq = (uint16_t)pkts.size();
+
+    InfoL << "replay " << pkts.size() << " rtp packets as " << streams << " streams to port " << port << ", duration: " << round_stamp / 90 << "ms";
+    Ticker ticker, print_ticker;
+    uint64_t sent = 0, last_sent = 0;
+    string buf;
+    for (uint32_t round = 0; ticker.elapsedTime() < seconds * 1000; ++round) {
+        for (auto &pkt : pkts) {
+            auto header = (RtpHeader *)pkt.data();
+            auto stamp = ntohl(header->stamp) - first_stamp + round * round_stamp;
+            auto delay = (int64_t)(stamp / 90) - (int64_t)ticker.elapsedTime();
+            if (delay > 0) {
+                usleep(delay * 1000);
+            }
+            buf = pkt;
+            auto out = (RtpHeader *)buf.data();
+            out->seq = htons(ntohs(header->seq) + round * round_seq);
+            out->stamp = htonl(stamp + first_stamp);
+            for (size_t i = 0; i < streams; ++i) {
+                out->ssrc = htonl(0x10000000 + i);
+                if (::sendto(fd, buf.data(), buf.size(), 0, (struct sockaddr *)&addr, SockUtil::get_sock_len((struct sockaddr *)&addr)) > 0) {
+                    ++sent;
+                }
+            }
+            if (print_ticker.elapsedTime() >= 1000) {
+                size_t sources = 0;
+                MediaSource::for_each_media([&](const MediaSource::Ptr &src) { ++sources; }, RTSP_SCHEMA, DEFAULT_VHOST, kRtpAppName);
+                _StrPrinter printer;
+                for (auto load : EventPollerPool::Instance().getExecutorLoad()) {
+                    printer << load << "% ";
+                }
+                InfoL << "sent " << (sent - last_sent) * 1000 / print_ticker.elapsedTime() << " pps, sources: " << sources << ", poller load: " << printer;
+                last_sent = sent;
+                print_ticker.resetTime();
+            }
+            if (ticker.elapsedTime() >= seconds * 1000) {
+                break;
+            }
+        }
+    }
+    close(fd);
+}
+#endif // #if defined(ENABLE_RTPPROXY)
+
 int main(int argc, char *argv[]) {
     // 设置日志
     Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel"));
@@ -242,6 +362,12 @@ int main(int argc, char *argv[]) {
         });
         sem.wait();
         sleep(1);
+    } else if (argc >= 3) {
+        // test_rtp_pcap <pcap文件> <模拟流数> [压测秒数] [端口]
+        // test_rtp_pcap <pcap file> <simulated streams> [benchmark seconds] [port]
+#if defined(ENABLE_RTPPROXY)
+        benchMultiplex(argv[1], MAX(atoi(argv[2]), 1), argc > 3 ? atoi(argv[3]) : 30, argc > 4 ? atoi(argv[4]) : 0);
+#endif // #if defined(ENABLE_RTPPROXY)
     } else {
         ErrorL << "parameter error.";
     }
@@ -0,0 +1,257 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <atomic>
+#include <random>
+#include <thread>
+#include <iostream>
+#include "Util/logger.h"
+#include "Util/util.h"
+#include "Poller/EventPoller.h"
+#include "../webrtc/TwccContext.h"
+#include "../webrtc/SendSideBwe.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static BenchChecker s_checker;
+
+static constexpr size_t kPacketSize = 1200;
+static constexpr uint64_t kTickUS = 5 * 1000;
+
+/**
+ * 模拟单向链路：带宽瓶颈+固定传播时延+随机丢包，接收端通过TwccContext生成反馈
+ * 使用虚拟时间，不依赖真实时钟
+ * Simulate a one-way link: bandwidth bottleneck + fixed propagation delay + random loss, the receiver generates feedback through TwccContext
+ * Virtual time is used, independent of the real clock
+ */
+class LinkSimulator {
+public:
+    LinkSimulator(SendSideBwe &bwe, uint32_t capacity_bps, double loss_rate)
+        : _bwe(bwe), _capacity_bps(capacity_bps), _loss_rate(loss_rate) {
+        _twcc.setOnSendTwccCB([this](uint32_t ssrc, const string &fci) {
+            // 反馈在最后一个包到达后经过传播时延到达发送端
+            // The feedback reaches the sender after the propagation delay following the arrival of the last packet
+            _feedbacks.emplace(_last_arrival_us + kPropagationUS, fci);
+        });
+    }
+
+    void setCapacity(uint32_t capacity_bps) { _capacity_bps = capacity_bps; }
+
+    /**
+     * 按照当前目标码率运行一段时间，每个周期回调一次目标码率
+     * Run for a period of time at the current target bitrate, the target bitrate is called back once per tick
+     */
+    void run(uint64_t duration_us, const function<void(uint32_t target_bps)> &on_tick = nullptr) {
+        auto end_us = _now_us + duration_us;
+        while (_now_us < end_us) {
+            _now_us += kTickUS;
+            deliverFeedback();
+            _budget += (double)_bwe.getTargetBitrate() * kTickUS / 8 / 1000000;
+            while (_budget >= kPacketSize) {
+                _budget -= kPacketSize;
+                sendPacket();
+            }
+            if (on_tick) {
+                on_tick(_bwe.getTargetBitrate());
+            }
+        }
+    }
+
+    uint64_t getQueueDelayUS() const { return _link_free_us > _now_us ? _link_free_us - _now_us : 0; }
+
+private:
+    void sendPacket() {
+        auto seq = _seq++;
+        _bwe.onSendPacket(seq, kPacketSize, _now_us);
+        // 先排队占用带宽再丢弃，模拟瓶颈之后的随机丢包
+        // Occupy the bandwidth in the queue before dropping, simulating random loss after the bottleneck
+        _link_free_us = MAX(_link_free_us, _now_us) + kPacketSize * 8 * 1000000 / _capacity_bps;
+        if (_dist(_rng) < _loss_rate) {
+            return;
+        }
+        _last_arrival_us = _link_free_us + kPropagationUS;
+        _twcc.onRtp(0x1234, seq, _last_arrival_us / 1000);
+    }
+
+    void deliverFeedback() {
+        while (!_feedbacks.empty() && _feedbacks.begin()->first <= _now_us) {
+            auto &fci = _feedbacks.begin()->second;
+            _bwe.onTwccFeedback(*reinterpret_cast<const FCI_TWCC *>(fci.data()), fci.size(), _now_us);
+            _feedbacks.erase(_feedbacks.begin());
+        }
+    }
+
+private:
+    static constexpr uint64_t kPropagationUS = 20 * 1000;
+
+    SendSideBwe &_bwe;
+    uint32_t _capacity_bps;
+    double _loss_rate;
+    double _budget = 0;
+    uint16_t _seq = 0;
+    // 从1秒开始，避免到达时间为0
+    // Start from 1 second to avoid an arrival time of 0
+    uint64_t _now_us = 1000 * 1000;
+    uint64_t _link_free_us = 0;
+    uint64_t _last_arrival_us = 0;
+    TwccContext _twcc;
+    multimap<uint64_t, string> _feedbacks;
+    mt19937 _rng { 0 };
+    uniform_real_distribution<double> _dist { 0, 1 };
+};
+
+static void testBwe() {
+    static constexpr uint32_t kMinBps = 100 * 1000;
+    static constexpr uint32_t kMaxBps = 5 * 1000 * 1000;
+    auto in_range = [&](uint32_t bps) { return bps >= kMinBps && bps <= kMaxBps; };
+
+    {
+        // 链路带宽充足，码率应持续增长，且不超过最大值
+        // The link bandwidth is sufficient, the bitrate should keep growing without exceeding the maximum
+        SendSideBwe bwe(300 * 1000, kMinBps, kMaxBps);
+        LinkSimulator link(bwe, 20 * 1000 * 1000, 0);
+        bool ok = true;
+        link.run(20 * 1000 * 1000, [&](uint32_t bps) { ok = ok && in_range(bps); });
+        s_checker.check(ok, "no congestion range");
+        s_checker.check(bwe.getTargetBitrate() >= 2 * 1000 * 1000, "no congestion ramp up " + to_string(bwe.getTargetBitrate()));
+        BweInfo info;
+        bwe.getInfo(info);
+        s_checker.check(info.feedbacks > 0 && info.loss_rate == 0, "no congestion info");
+    }
+
+    {
+        // 瓶颈带宽1Mbps，延时增长触发过载，码率应收敛到瓶颈附近且排队时延有界
+        // The bottleneck is 1Mbps, the delay growth triggers overuse, the bitrate should converge around the bottleneck and the queuing delay is bounded
+        SendSideBwe bwe(300 * 1000, kMinBps, kMaxBps);
+        LinkSimulator link(bwe, 1000 * 1000, 0);
+        bool ok = true;
+        link.run(10 * 1000 * 1000, [&](uint32_t bps) { ok = ok && in_range(bps); });
+        uint64_t sum = 0, ticks = 0, max_queue_us = 0;
+        link.run(20 * 1000 * 1000, [&](uint32_t bps) {
+            ok = ok && in_range(bps);
+            sum += bps;
+            ++ticks;
+            max_queue_us = MAX(max_queue_us, link.getQueueDelayUS());
+        });
+        auto avg = sum / ticks;
+        s_checker.check(ok, "bottleneck range");
+        s_checker.check(avg >= 500 * 1000 && avg <= 1300 * 1000, "bottleneck converge " + to_string(avg));
+        s_checker.check(max_queue_us < 1000 * 1000, "bottleneck queue delay " + to_string(max_queue_us));
+
+        // 瓶颈带宽降低，码率应随之下降
+        // The bottleneck bandwidth drops, the bitrate should drop accordingly
+        link.setCapacity(400 * 1000);
+        link.run(10 * 1000 * 1000, [&](uint32_t bps) { ok = ok && in_range(bps); });
+        s_checker.check(ok, "capacity drop range");
+        s_checker.check(bwe.getTargetBitrate() <= 600 * 1000, "capacity drop " + to_string(bwe.getTargetBitrate()));
+    }
+
+    {
+        // 带宽充足但丢包率20%，丢包部分应降低码率
+        // The bandwidth is sufficient but the loss rate is 20%, the loss based part should decrease the bitrate
+        SendSideBwe bwe(1000 * 1000, kMinBps, kMaxBps);
+        LinkSimulator link(bwe, 20 * 1000 * 1000, 0.2);
+        bool ok = true;
+        link.run(10 * 1000 * 1000, [&](uint32_t bps) { ok = ok && in_range(bps); });
+        BweInfo info;
+        bwe.getInfo(info);
+        s_checker.check(ok, "loss range");
+        s_checker.check(info.loss_rate > 0.1f && info.loss_rate < 0.3f, "loss rate " + to_string(info.loss_rate));
+        s_checker.check(info.loss_based_bps < 1000 * 1000 && bwe.getTargetBitrate() < 1000 * 1000, "loss decrease " + to_string(bwe.getTargetBitrate()));
+    }
+
+    {
+        // remb作为码率上限
+        // Remb is the upper limit of the bitrate
+        SendSideBwe bwe(300 * 1000, kMinBps, kMaxBps);
+        LinkSimulator link(bwe, 20 * 1000 * 1000, 0);
+        bwe.onRemb(400 * 1000);
+        bool ok = true;
+        link.run(10 * 1000 * 1000, [&](uint32_t bps) { ok = ok && bps <= 400 * 1000; });
+        s_checker.check(ok && bwe.getTargetBitrate() == 400 * 1000, "remb cap " + to_string(bwe.getTargetBitrate()));
+        // remb低于最小值时不低于最小值
+        // Not lower than the minimum when remb is lower than the minimum
+        bwe.onRemb(1000);
+        s_checker.check(bwe.getTargetBitrate() == kMinBps, "remb below min");
+    }
+
+    {
+        // 起始码率超出范围时被修正
+        // The start bitrate is corrected when it is out of range
+        SendSideBwe low(1000, kMinBps, kMaxBps);
+        SendSideBwe high(100 * 1000 * 1000, kMinBps, kMaxBps);
+        s_checker.check(low.getTargetBitrate() == kMinBps && high.getTargetBitrate() == kMaxBps, "start bitrate clamp");
+    }
+}
+
+static void testPacer() {
+    static constexpr size_t kCount = 100;
+    static constexpr uint32_t kTargetBps = 1000 * 1000;
+    auto poller = EventPollerPool::Instance().getPoller();
+    vector<pair<uint16_t, uint64_t>> sent;
+    atomic<size_t> sent_count { 0 };
+    bool last_flush = false;
+    BweInfo info;
+    RtpPacer::Ptr pacer;
+    poller->sync([&]() {
+        pacer = std::make_shared<RtpPacer>(poller, [&](const RtpPacket::Ptr &rtp, bool flush) {
+            sent.emplace_back(rtp->getSeq(), getCurrentMicrosecond());
+            last_flush = flush;
+            ++sent_count;
+        });
+        pacer->setTargetBitrate(kTargetBps);
+        // 一次性输入约1Mbit的突发数据(类似关键帧)
+        // Input a burst of about 1Mbit at once (like a key frame)
+        for (size_t i = 0; i < kCount; ++i) {
+            pacer->inputRtp(makeTestRtp(i, 0, 0, kPacketSize - RtpPacket::kRtpHeaderSize), i + 1 == kCount);
+        }
+        pacer->getInfo(info);
+    });
+    // 首次仅有10ms的预算，其余包需要排队
+    // There is only 10ms budget for the first time, and the rest of the packets need to be queued
+    s_checker.check(info.pacer_queue_packets > 0 && info.pacer_queue_packets < kCount, "pacer queued " + to_string(info.pacer_queue_packets));
+    s_checker.check(info.pacer_queue_bytes == info.pacer_queue_packets * kPacketSize, "pacer queue bytes");
+
+    auto start = getCurrentMillisecond();
+    while (sent_count < kCount && getCurrentMillisecond() - start < 3000) {
+        this_thread::sleep_for(chrono::milliseconds(10));
+    }
+    poller->sync([&]() {
+        s_checker.check(sent.size() == kCount, "pacer sent all " + to_string(sent.size()));
+        bool in_order = true;
+        for (size_t i = 0; i < sent.size(); ++i) {
+            in_order = in_order && sent[i].first == i;
+        }
+        s_checker.check(in_order, "pacer in order");
+        s_checker.check(last_flush, "pacer flush last");
+        if (sent.size() == kCount) {
+            // 按照2.5倍目标码率发送约需384ms，且排队不超过500ms
+            // It takes about 384ms to send at 2.5 times the target bitrate, and queuing does not exceed 500ms
+            auto duration_ms = (sent.back().second - sent.front().second) / 1000;
+            s_checker.check(duration_ms >= 250 && duration_ms <= 700, "pacer duration " + to_string(duration_ms));
+        }
+        pacer->getInfo(info);
+        s_checker.check(info.pacer_queue_packets == 0 && info.pacer_queue_bytes == 0, "pacer drained");
+        pacer = nullptr;
+    });
+}
+
+// 此程序用于检验发送端带宽估计在不同网络条件下的码率调整，以及pacer的平滑发送
+// This program is used to verify the bitrate adjustment of sender side bandwidth estimation under different network conditions, and the smooth sending of the pacer
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+    testBwe();
+    testPacer();
+    return s_checker.result();
+}
@@ -10,9 +10,13 @@
 
 #include <map>
 #include <list>
+#include <vector>
+#include <thread>
+#include <chrono>
 #include <iostream>
 #include <functional>
 #include "Rtsp/RtpReceiver.h"
+#include "BenchHelper.h"
 
 using namespace std;
 using namespace mediakit;
@@ -280,6 +284,104 @@ void test_rand(){
 #endif
 }
 
+static BenchChecker s_checker;
+
+// 源端重置seq计数器且新旧seq跨越回环，重置后的数据应按回环后的顺序输出
+// The source resets the seq counter and the new seqs cross the loop, the data after the reset should be output in looped order
+void test_reset_wrap() {
+    PacketSortor<uint16_t, uint16_t> sortor;
+    sortor.setParams(1024, 10, 64);
+    vector<uint16_t> sorted_list;
+    sortor.setOnSort([&](uint16_t seq, uint16_t packet) { sorted_list.push_back(seq); });
+
+    uint16_t seq = 65500;
+    for (int i = 0; i < 86; ++i) {
+        sortor.sortPacket(seq, seq);
+        ++seq;
+    }
+    s_checker.check(sorted_list.size() == 86 && seq == 50, "reset_wrap: in order input");
+    sorted_list.clear();
+
+    // 新计数器从65530开始(在next_seq之前56)，先到的两个包乱序
+    // The new counter starts from 65530 (56 before next_seq), the first two packets arrive out of order
+    vector<uint16_t> input = { 65531, 65530, 65532, 65533, 65534, 65535 };
+    for (uint16_t i = 0; i < 10; ++i) {
+        input.push_back(i);
+    }
+    for (auto item : input) {
+        sortor.sortPacket(item, item);
+    }
+    s_checker.check(sorted_list.empty(), "reset_wrap: rollback packets are cached");
+    this_thread::sleep_for(chrono::milliseconds(20));
+    // 超时后触发重置
+    // Trigger the reset after timeout
+    sortor.sortPacket(10, 10);
+    sortor.flush();
+
+    vector<uint16_t> expected;
+    for (uint16_t item = 65530; item != 11; ++item) {
+        expected.push_back(item);
+    }
+    s_checker.check(sorted_list == expected, "reset_wrap: output in looped order");
+}
+
+// seq向前跳跃超过32767时与回退无法区分，作为回退包缓存，超时后作为新的起点按顺序输出
+// A forward seq jump of more than 32767 cannot be distinguished from a rollback, it is cached as rollback,
+// and output in order as the new start after the timeout
+void test_forward_jump() {
+    PacketSortor<uint16_t, uint16_t> sortor;
+    sortor.setParams(1024, 10, 64);
+    vector<uint16_t> sorted_list;
+    sortor.setOnSort([&](uint16_t seq, uint16_t packet) { sorted_list.push_back(seq); });
+
+    for (uint16_t seq = 0; seq < 100; ++seq) {
+        sortor.sortPacket(seq, seq);
+    }
+    // 中间有乱序包在缓存中
+    // There is an out-of-order packet in the cache
+    sortor.sortPacket(101, 101);
+    s_checker.check(sorted_list.size() == 100 && sortor.getJitterSize() == 1, "forward_jump: out of order packet cached");
+
+    // 远距离的迟到包，重置时应被丢弃
+    // A far late packet, which should be dropped when resetting
+    sortor.sortPacket(50000, 50000);
+    s_checker.check(sorted_list.size() == 100, "forward_jump: far packet cached");
+
+    uint16_t seq = 40100;
+    for (int i = 0; i < 8; ++i) {
+        sortor.sortPacket(seq, seq);
+        ++seq;
+    }
+    s_checker.check(sorted_list.size() == 100, "forward_jump: jumped packets cached until timeout");
+    this_thread::sleep_for(chrono::milliseconds(20));
+    // 超时后触发重置
+    // Trigger the reset after timeout
+    sortor.sortPacket(seq, seq);
+    ++seq;
+    vector<uint16_t> expected;
+    for (uint16_t i = 0; i < 100; ++i) {
+        expected.push_back(i);
+    }
+    expected.push_back(101);
+    for (uint16_t i = 40100; i != seq; ++i) {
+        expected.push_back(i);
+    }
+    s_checker.check(sorted_list == expected, "forward_jump: output after timeout");
+
+    sortor.sortPacket(seq + 1, seq + 1);
+    sortor.sortPacket(seq, seq);
+    s_checker.check(sorted_list.size() == expected.size() + 2 && sorted_list.back() == seq + 1, "forward_jump: sorted after jump");
+    seq += 2;
+
+    // 回退距离在max_distance以内的迟到包仍然缓存
+    // Late packets within max_distance are still cached
+    auto size = sorted_list.size();
+    sortor.sortPacket(seq - 20, seq - 20);
+    s_checker.check(sorted_list.size() == size, "forward_jump: late packet cached");
+    sortor.sortPacket(seq, seq);
+    s_checker.check(sorted_list.size() == size + 1 && sorted_list.back() == seq, "forward_jump: continue after late packet");
+}
+
 // 该测试程序用于检验rtp排序算法的正确性  [AUTO-TRANSLATED:251b9c45]
 // This test program is used to verify the correctness of the rtp sorting algorithm
 int main(int argc, char *argv[]) {
@@ -292,5 +394,8 @@ int main(int argc, char *argv[]) {
     // Simulate rtp out-of-order, loopback, packet loss, and duplication scenarios
     cout << "###### 模拟的rtp seq #####" << endl;
     test_rand();
-    return 0;
+
+    test_reset_wrap();
+    test_forward_jump();
+    return s_checker.result();
 }
\ No newline at end of file
@@ -0,0 +1,428 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <map>
+#include <random>
+#include <iostream>
+#include "Util/util.h"
+#include "Util/logger.h"
+#include "Rtp/TSDecoder.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+#if defined(ENABLE_HLS)
+
+// mpeg-ts中的编码类型
+// Codec types in mpeg-ts
+static constexpr int kTsH264 = 0x1b;
+static constexpr int kTsAAC = 0x0f;
+// 关键帧标记，与media-server的MPEG_FLAG_IDR_FRAME一致
+// Key frame flag, consistent with MPEG_FLAG_IDR_FRAME of media-server
+static constexpr int kFlagKey = 0x0001;
+
+static constexpr uint16_t kPmtPid = 0x1000;
+static constexpr uint16_t kVideoPid = 0x100;
+static constexpr uint16_t kAudioPid = 0x101;
+
+class FrameInfo {
+public:
+    int stream;
+    int codec;
+    bool key;
+    int64_t pts;
+    int64_t dts;
+    string data;
+};
+
+// 每个流的帧列表
+// Frame list of each stream
+using FrameMap = map<int, vector<FrameInfo>>;
+
+class Packet {
+public:
+    uint16_t pid;
+    bool start;
+    bool random_access;
+    bool discontinuity;
+};
+
+static uint32_t crc32(const uint8_t *data, size_t size) {
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < size; ++i) {
+        crc ^= (uint32_t)data[i] << 24;
+        for (int j = 0; j < 8; ++j) {
+            crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04C11DB7 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static string makeSection(uint8_t table_id, uint16_t id, const string &body) {
+    string ret;
+    auto len = 5 + body.size() + 4;
+    ret.push_back((char)table_id);
+    ret.push_back((char)(0xB0 | (len >> 8)));
+    ret.push_back((char)len);
+    ret.push_back((char)(id >> 8));
+    ret.push_back((char)id);
+    // version 0, current_next_indicator 1, section_number 0, last_section_number 0
+    ret.append("\xC1\x00\x00", 3);
+    ret.append(body);
+    auto crc = crc32((const uint8_t *)ret.data(), ret.size());
+    for (int i = 3; i >= 0; --i) {
+        ret.push_back((char)(crc >> (i * 8)));
+    }
+    return ret;
+}
+
+static string makePat(const vector<uint16_t> &programs) {
+    string body;
+    for (auto program : programs) {
+        body.push_back((char)(program >> 8));
+        body.push_back((char)program);
+        body.push_back((char)(0xE0 | (kPmtPid >> 8)));
+        body.push_back((char)kPmtPid);
+    }
+    return makeSection(0x00, 1, body);
+}
+
+/**
+ * 生成PMT
+ * @param descriptors program_info中用户私有描述符的个数，用于使PMT跨越多个ts包
+ * Generate PMT
+ * @param descriptors Number of user private descriptors in program_info, used to make PMT span multiple ts packets
+ */
+static string makePmt(uint16_t program, const vector<pair<int, uint16_t>> &streams, size_t descriptors) {
+    string body;
+    auto pcr_pid = streams.front().second;
+    auto info_size = descriptors * (2 + 0x20);
+    body.push_back((char)(0xE0 | (pcr_pid >> 8)));
+    body.push_back((char)pcr_pid);
+    body.push_back((char)(0xF0 | (info_size >> 8)));
+    body.push_back((char)info_size);
+    for (size_t i = 0; i < descriptors; ++i) {
+        body.push_back((char)0xFE);
+        body.push_back((char)0x20);
+        body.append(0x20, (char)0x5A);
+    }
+    for (auto &pr : streams) {
+        body.push_back((char)pr.first);
+        body.push_back((char)(0xE0 | (pr.second >> 8)));
+        body.push_back((char)pr.second);
+        body.append("\xF0\x00", 2);
+    }
+    return makeSection(0x02, program, body);
+}
+
+static void putTimestamp(string &out, int flag, int64_t ts) {
+    out.push_back((char)((flag << 4) | (((ts >> 30) & 0x07) << 1) | 1));
+    out.push_back((char)(ts >> 22));
+    out.push_back((char)((((ts >> 15) & 0x7F) << 1) | 1));
+    out.push_back((char)(ts >> 7));
+    out.push_back((char)(((ts & 0x7F) << 1) | 1));
+}
+
+static string makePes(uint8_t id, const FrameInfo &frame, bool bounded) {
+    string ret("\x00\x00\x01", 3);
+    ret.push_back((char)id);
+    auto with_dts = frame.dts != frame.pts;
+    auto header_size = with_dts ? 10 : 5;
+    auto len = bounded ? 3 + header_size + frame.data.size() : 0;
+    ret.push_back((char)(len >> 8));
+    ret.push_back((char)len);
+    ret.push_back((char)0x80);
+    ret.push_back((char)(with_dts ? 0xC0 : 0x80));
+    ret.push_back((char)header_size);
+    putTimestamp(ret, with_dts ? 3 : 2, frame.pts);
+    if (with_dts) {
+        putTimestamp(ret, 1, frame.dts);
+    }
+    return ret + frame.data;
+}
+
+/**
+ * 把PES或PSI打包为ts包，PES不足一个包时用adaptation field填充，PSI用0xFF填充
+ * Pack PES or PSI into ts packets, PES is filled with the adaptation field when less than one packet, PSI is filled with 0xFF
+ */
+static vector<string> packetize(const Packet &info, uint8_t &cc, const string &data, bool psi) {
+    vector<string> ret;
+    size_t offset = 0;
+    auto payload = psi ? string(1, '\0') + data : data;
+    do {
+        string packet;
+        auto first = offset == 0;
+        packet.push_back((char)TS_SYNC_BYTE);
+        packet.push_back((char)((first && info.start ? 0x40 : 0x00) | (info.pid >> 8)));
+        packet.push_back((char)info.pid);
+        auto flags = first ? (info.discontinuity ? 0x80 : 0) | (info.random_access ? 0x40 : 0) : 0;
+        auto left = payload.size() - offset;
+        size_t stuffing = 0;
+        if (!psi && left < TS_PACKET_SIZE - 4) {
+            stuffing = TS_PACKET_SIZE - 4 - left;
+        }
+        if (flags) {
+            // adaptation field至少需要2字节才能携带标记
+            // The adaptation field needs at least 2 bytes to carry the flags
+            stuffing = MAX(stuffing, (size_t)2);
+        }
+        packet.push_back((char)((stuffing ? 0x30 : 0x10) | (cc++ & 0x0F)));
+        if (stuffing) {
+            packet.push_back((char)(stuffing - 1));
+            if (stuffing > 1) {
+                packet.push_back((char)flags);
+                packet.append(stuffing - 2, (char)0xFF);
+            }
+        }
+        auto take = MIN(left, TS_PACKET_SIZE - packet.size());
+        packet.append(payload, offset, take);
+        offset += take;
+        packet.resize(TS_PACKET_SIZE, (char)0xFF);
+        ret.emplace_back(std::move(packet));
+    } while (offset < payload.size());
+    return ret;
+}
+
+static void putPes(string &out, uint16_t pid, uint8_t &cc, const FrameInfo &frame, bool bounded, bool discontinuity) {
+    for (auto &packet : packetize(Packet { pid, true, frame.key, discontinuity }, cc, makePes(pid == kVideoPid ? 0xE0 : 0xC0, frame, bounded), false)) {
+        out.append(packet);
+    }
+}
+
+static FrameInfo makeVideo(int index, int64_t pts, mt19937 &rng) {
+    auto key = index % 30 == 0;
+    // 每隔一帧带一个不同于pts的dts
+    // Every other frame carries a dts different from pts
+    FrameInfo ret { kVideoPid, kTsH264, key, pts, index % 2 ? pts - 3600 : pts, "" };
+    if (key) {
+        ret.data.append("\x00\x00\x00\x01\x67\x42\x00\x1F\xA6\x81\x40\x7B\x20", 13);
+        ret.data.append("\x00\x00\x00\x01\x68\xCE\x3C\x80", 8);
+    }
+    ret.data.append("\x00\x00\x00\x01", 4);
+    ret.data.push_back(key ? 0x65 : 0x41);
+    // first_mb_in_slice为0，每个slice都是新的一帧
+    // first_mb_in_slice is 0, every slice is a new frame
+    ret.data.push_back((char)0x88);
+    size_t size = key ? 60000 : 10 + rng() % 20000;
+    for (size_t i = 0; i < size; ++i) {
+        // 随机数据不含0字节，避免出现起始码
+        // The random data contains no zero byte to avoid start codes
+        ret.data.push_back((char)(rng() | 0x04));
+    }
+    return ret;
+}
+
+static FrameInfo makeAudio(int64_t pts, mt19937 &rng) {
+    // adts头的帧长度字段包括7字节的头
+    // The frame length field of the adts header includes the 7-byte header
+    size_t size = 200 + rng() % 200;
+    auto len = size + 7;
+    FrameInfo ret { kAudioPid, kTsAAC, false, pts, pts, "" };
+    ret.data.assign("\xFF\xF1\x50", 3);
+    ret.data.push_back((char)(0x80 | ((len >> 11) & 0x03)));
+    ret.data.push_back((char)(len >> 3));
+    ret.data.push_back((char)(((len & 0x07) << 5) | 0x1F));
+    ret.data.push_back((char)0xFC);
+    for (size_t i = 0; i < size; ++i) {
+        ret.data.push_back((char)rng());
+    }
+    return ret;
+}
+
+/**
+ * 生成h264 + aac的ts流及其应当解析出的帧
+ * PMT跨越两个ts包，且中间穿插PAT包，检验PSI按pid缓存
+ * @param discontinuity 中途重置连续性计数器并设置discontinuity_indicator
+ * Generate a ts stream of h264 + aac and the frames that should be parsed from it
+ * PMT spans two ts packets with a PAT packet in between, to verify that PSI is buffered per pid
+ * @param discontinuity Reset the continuity counter halfway and set the discontinuity_indicator
+ */
+static string makeTS(FrameMap &frames, bool discontinuity, mt19937 &rng) {
+    string ret;
+    uint8_t pat_cc = 0, pmt_cc = 0, video_cc = 0, audio_cc = 0;
+    auto pat = makePat({ 1 });
+    auto pmt = makePmt(1, { { kTsH264, kVideoPid }, { kTsAAC, kAudioPid } }, 6);
+    for (int i = 0; i < 120; ++i) {
+        if (i % 30 == 0) {
+            auto pat_packet = packetize(Packet { 0, true, false, false }, pat_cc, pat, true)[0];
+            auto pmt_packets = packetize(Packet { kPmtPid, true, false, false }, pmt_cc, pmt, true);
+            ret.append(pat_packet);
+            ret.append(pmt_packets[0]);
+            // 重复的PAT(连续性计数器不变)
+            // Duplicate PAT (the continuity counter is unchanged)
+            ret.append(pat_packet);
+            for (size_t j = 1; j < pmt_packets.size(); ++j) {
+                ret.append(pmt_packets[j]);
+            }
+        }
+        auto reset_cc = discontinuity && i == 60;
+        if (reset_cc) {
+            video_cc += 5;
+            audio_cc += 9;
+        }
+        int64_t pts = 90000 + i * 3600;
+        auto video = makeVideo(i, pts, rng);
+        // 视频PES不定长，音频PES定长
+        // The video PES is unbounded, the audio PES is bounded
+        putPes(ret, kVideoPid, video_cc, video, false, reset_cc);
+        frames[video.stream].emplace_back(std::move(video));
+        auto audio = makeAudio(pts + 10, rng);
+        putPes(ret, kAudioPid, audio_cc, audio, true, reset_cc);
+        frames[audio.stream].emplace_back(std::move(audio));
+    }
+    return ret;
+}
+
+/**
+ * 生成两个节目共用同一个PMT pid的ts流，两个PMT section在同一个ts包内
+ * Generate a ts stream where two programs share the same PMT pid, with the two PMT sections in one ts packet
+ */
+static string makeMultiProgramTS(FrameMap &frames, mt19937 &rng) {
+    string ret;
+    uint8_t pat_cc = 0, pmt_cc = 0, video_cc = 0, audio_cc = 0;
+    auto pat = makePat({ 1, 2 });
+    auto pmt = makePmt(1, { { kTsH264, kVideoPid } }, 0) + makePmt(2, { { kTsAAC, kAudioPid } }, 0);
+    for (int i = 0; i < 60; ++i) {
+        if (i % 30 == 0) {
+            for (auto &packet : packetize(Packet { 0, true, false, false }, pat_cc, pat, true)) {
+                ret.append(packet);
+            }
+            for (auto &packet : packetize(Packet { kPmtPid, true, false, false }, pmt_cc, pmt, true)) {
+                ret.append(packet);
+            }
+        }
+        int64_t pts = 90000 + i * 3600;
+        auto video = makeVideo(i, pts, rng);
+        putPes(ret, kVideoPid, video_cc, video, true, false);
+        frames[video.stream].emplace_back(std::move(video));
+        auto audio = makeAudio(pts + 10, rng);
+        putPes(ret, kAudioPid, audio_cc, audio, true, false);
+        frames[audio.stream].emplace_back(std::move(audio));
+    }
+    return ret;
+}
+
+static vector<string> splitChunks(const string &data, bool random_size, mt19937 &rng) {
+    // 1316(188 * 7)为rtp承载ts的典型大小，随机大小时模拟http body分片
+    // 1316 (188 * 7) is the typical size of ts over rtp, simulate the http body fragments for random sizes
+    vector<string> ret;
+    size_t offset = 0;
+    while (offset < data.size()) {
+        size_t size = random_size ? 1 + rng() % 1500 : 1316;
+        size = MIN(size, data.size() - offset);
+        ret.emplace_back(data.substr(offset, size));
+        offset += size;
+    }
+    return ret;
+}
+
+static FrameMap decode(Decoder &decoder, const vector<string> &chunks) {
+    FrameMap ret;
+    decoder.setOnDecode([&](int stream, int codecid, int flags, int64_t pts, int64_t dts, const void *data, size_t bytes) {
+        auto &list = ret[stream];
+        if (!list.empty() && list.back().pts == pts) {
+            // 不同解析器拆分帧的方式可能不同，相同pts的数据合并后比较
+            // Different parsers may split frames in different ways, data with the same pts is merged before comparing
+            list.back().key |= (flags & kFlagKey) != 0;
+            list.back().data.append((const char *)data, bytes);
+            return;
+        }
+        list.emplace_back(FrameInfo { stream, codecid, (flags & kFlagKey) != 0, pts, dts, string((const char *)data, bytes) });
+    });
+    for (auto &chunk : chunks) {
+        decoder.input((const uint8_t *)chunk.data(), chunk.size());
+    }
+    decoder.flush();
+    return ret;
+}
+
+/**
+ * 比较解析结果，关键帧标记只比较视频
+ * @param pending 允许每个流最后缓存未输出的帧数
+ * Compare the parsing results, the key frame flag is only compared for video
+ * @param pending Number of frames allowed to be cached and not output at the end of each stream
+ */
+static bool compare(const string &name, const FrameMap &expected, const FrameMap &actual, size_t pending) {
+    bool ok = expected.size() == actual.size();
+    for (auto &pr : expected) {
+        auto it = actual.find(pr.first);
+        if (it == actual.end()) {
+            cout << name << ": stream " << pr.first << " not found" << endl;
+            ok = false;
+            continue;
+        }
+        auto &want = pr.second;
+        auto &got = it->second;
+        if (got.size() > want.size() || got.size() + pending < want.size()) {
+            cout << name << ": stream " << pr.first << " frame count " << got.size() << " != " << want.size() << endl;
+            ok = false;
+        }
+        for (size_t i = 0; i < MIN(want.size(), got.size()); ++i) {
+            auto &a = want[i];
+            auto &b = got[i];
+            auto key_ok = a.stream != kVideoPid || a.key == b.key;
+            if (a.codec != b.codec || !key_ok || a.pts != b.pts || a.dts != b.dts || a.data != b.data) {
+                cout << name << ": stream " << pr.first << " frame " << i << " mismatched, codec " << b.codec << "/" << a.codec << ", key " << b.key << "/"
+                     << a.key << ", pts " << b.pts << "/" << a.pts << ", dts " << b.dts << "/" << a.dts << ", size " << b.data.size() << "/" << a.data.size() << endl;
+                ok = false;
+                break;
+            }
+        }
+    }
+    cout << name << (ok ? ": ok" : ": failed") << endl;
+    return ok;
+}
+
+// 此程序用于检验增量式ts解析器与media-server ts解复用器输出的帧、时间戳、关键帧标记及负载是否一致
+// This program is used to verify that the frames, timestamps, key frame flags and payloads output by the incremental ts parser
+// are consistent with the media-server ts demuxer
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    mt19937 rng(0);
+    bool ok = true;
+    for (auto random_size : { false, true }) {
+        string name = random_size ? "random size" : "rtp size";
+        FrameMap expected;
+        auto chunks = splitChunks(makeTS(expected, false, rng), random_size, rng);
+        TSStreamDecoder stream_decoder;
+        ok = compare(name + " stream", expected, decode(stream_decoder, chunks), 0) && ok;
+        // media-server没有flush，不定长PES的最后一帧可能未输出
+        // media-server has no flush, the last frame of the unbounded PES may not be output
+        TSDecoder ts_decoder;
+        ok = compare(name + " media-server", expected, decode(ts_decoder, chunks), 1) && ok;
+    }
+
+    // 以下场景只与预期结果比较
+    // The following scenarios are only compared with the expected results
+    {
+        FrameMap expected;
+        auto chunks = splitChunks(makeTS(expected, true, rng), true, rng);
+        TSStreamDecoder decoder;
+        ok = compare("discontinuity stream", expected, decode(decoder, chunks), 0) && ok;
+    }
+    {
+        FrameMap expected;
+        auto chunks = splitChunks(makeMultiProgramTS(expected, rng), true, rng);
+        TSStreamDecoder decoder;
+        ok = compare("multi program stream", expected, decode(decoder, chunks), 0) && ok;
+    }
+
+    cout << (ok ? "all passed" : "some failed") << endl;
+    return ok ? 0 : -1;
+}
+
+#else
+int main(int argc, char *argv[]) {
+    cout << "please ENABLE_HLS and then test" << endl;
+    return 0;
+}
+#endif // defined(ENABLE_HLS)
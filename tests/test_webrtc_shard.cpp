@@ -0,0 +1,68 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <iostream>
+#include "Util/logger.h"
+#include "../webrtc/WebRtcTransport.h"
+#include "BenchHelper.h"
+
+using namespace std;
+using namespace toolkit;
+using namespace mediakit;
+
+static BenchChecker s_checker;
+
+static size_t parse(const string &key, size_t count) {
+    return WebRtcTransportManager::parseShardIndex(key, count);
+}
+
+// 此程序用于检验ice ufrag中poller序号的生成与解析
+// This program is used to verify the generation and parsing of the poller index in the ice ufrag
+int main(int argc, char *argv[]) {
+    Logger::Instance().add(std::make_shared<ConsoleChannel>("ConsoleChannel", LWarn));
+
+    // prefix为base64，可能包含'+'与'/'
+    // The prefix is base64, which may contain '+' and '/'
+    const string prefixes[] = { "wKgBAR+QIdo/", "wK/gB0+1/QIdo/", "+/", "/" };
+    size_t count = 16;
+    for (auto &prefix : prefixes) {
+        for (size_t index = 0; index <= count; ++index) {
+            auto suffix = WebRtcTransportManager::formatShardIndex(index);
+            // 序号固定4位且只包含数字，经过url编解码后不变
+            // The index is fixed to 4 digits and only contains numbers, unchanged after url encoding and decoding
+            s_checker.check(suffix.size() == 4 && suffix.find_first_not_of("0123456789") == string::npos, "format " + to_string(index));
+            for (auto number : { 1, 10, 9999, 123456789 }) {
+                auto key = prefix + suffix + to_string(number);
+                s_checker.check(parse(key, count) == index, "round trip " + key);
+            }
+        }
+    }
+
+    // 不携带序号
+    // Without the index
+    s_checker.check(parse("", count) == count, "empty");
+    s_checker.check(parse("wKgBAR+QIdo/", count) == count, "only prefix");
+    s_checker.check(parse("wKgBAR+QIdo/0001", count) == count, "without number");
+    s_checker.check(parse("wKgBAR+QIdo/001", count) == count, "short index");
+    s_checker.check(parse("wKgBAR+QIdo/1+2345", count) == count, "old format");
+    s_checker.check(parse("wKgBAR+QIdo/00a12", count) == count, "not digit");
+    s_checker.check(parse("0001/", count) == count, "index before slash");
+    s_checker.check(parse("00011", count) == 1, "without prefix");
+
+    // 序号超出范围
+    // The index is out of range
+    s_checker.check(parse("wKgBAR+QIdo/00161", count) == count, "index equal to count");
+    s_checker.check(parse("wKgBAR+QIdo/99991", count) == count, "max index");
+    s_checker.check(parse("wKgBAR+QIdo/00151", count) == 15, "last index");
+    s_checker.check(parse("wKgBAR+QIdo/00011", 0) == 0, "no poller");
+    s_checker.check(WebRtcTransportManager::formatShardIndex(100000) == "9999", "format overflow");
+
+    return s_checker.result();
+}
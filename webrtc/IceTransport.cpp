@@ -16,6 +16,7 @@
 #include "Network/UdpClient.h"
 #include "Common/Parser.h"
 #include "Common/config.h"
+#include "Common/UdpBatchSender.h"
 #include "IceTransport.hpp"
 #include "WebRtcTransport.h"
 
@@ -175,6 +176,14 @@ void IceTransport::sendSocketData_l(const Buffer::Ptr& buf, const Pair::Ptr& pai
         throw std::invalid_argument("pair should not be nullptr");
     }
 
+    GET_CONFIG(int, batch_mode, General::kUdpBatchSendMode);
+    auto batch = batch_mode != UdpBatchSender::kModeSocket && pair->_socket->getSock()->sockType() == SockNum::Sock_UDP;
+    if (_udp_batch_pair && (!batch || _udp_batch_pair != pair)) {
+        // 不走批量发送或对端变了，先发送之前缓存的包，保证发送顺序
+        // Not sent in batch or the peer has changed, send the previously cached packets first to keep the sending order
+        flushUdpBatch();
+    }
+
     // 一次性发送一帧的rtp数据，提高网络io性能  [AUTO-TRANSLATED:fbab421e]
     // Send one frame of rtp data at a time to improve network io performance
     if (pair->_socket->getSock()->sockType() == SockNum::Sock_TCP) {
@@ -188,6 +197,26 @@ void IceTransport::sendSocketData_l(const Buffer::Ptr& buf, const Pair::Ptr& pai
     TraceL << "data: " << hexdump(buf->data(), buf->size());
 #endif
 
+    if (batch) {
+        _udp_batch_pair = pair;
+        _udp_batch.emplace_back(buf);
+        if (flush || _udp_batch.size() >= (size_t)UdpBatchSender::kMaxBatchSize) {
+            flushUdpBatch();
+        } else if (!_udp_batch_flush_pending) {
+            // 未要求立即发送的包最迟在本轮事件循环结束时发送，避免滞留
+            // Packets not required to be sent immediately are sent at the end of this event loop iteration at the latest, to avoid being stranded
+            _udp_batch_flush_pending = true;
+            weak_ptr<IceTransport> weak_self = shared_from_this();
+            getPoller()->async([weak_self]() {
+                if (auto strong_self = weak_self.lock()) {
+                    strong_self->_udp_batch_flush_pending = false;
+                    strong_self->flushUdpBatch();
+                }
+            }, false);
+        }
+        return;
+    }
+
     sockaddr_storage peer_addr;
     pair->get_peer_addr(peer_addr);
     auto addr_len = SockUtil::get_sock_len((const struct sockaddr*)&peer_addr);
@@ -197,6 +226,17 @@ void IceTransport::sendSocketData_l(const Buffer::Ptr& buf, const Pair::Ptr& pai
     }
 }
 
+void IceTransport::flushUdpBatch() {
+    if (!_udp_batch_pair) {
+        return;
+    }
+    sockaddr_storage peer_addr;
+    _udp_batch_pair->get_peer_addr(peer_addr);
+    auto addr_len = SockUtil::get_sock_len((const struct sockaddr*)&peer_addr);
+    UdpBatchSender::send(_udp_batch_pair->_socket->getSock(), _udp_batch, (struct sockaddr*)&peer_addr, addr_len);
+    _udp_batch_pair = nullptr;
+}
+
 bool IceTransport::processSocketData(const uint8_t* data, size_t len, const Pair::Ptr& pair) {
 #if 0
     TraceL << pair->dumpString(0) << " data len: " << len;
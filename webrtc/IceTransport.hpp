@@ -354,6 +354,8 @@ public:
     void sendSocketData_l(const toolkit::Buffer::Ptr& buf, const Pair::Ptr& pair, bool flush = true);
 
 protected:
+    void flushUdpBatch();
+
     virtual void processStunPacket(const StunPacket::Ptr& packet, const Pair::Ptr& pair);
     virtual void processRequest(const StunPacket::Ptr& packet, const Pair::Ptr& pair);
     virtual void processResponse(const StunPacket::Ptr& packet, const Pair::Ptr& pair);
@@ -406,6 +408,12 @@ protected:
     
     // For STUN request retry
     std::shared_ptr<toolkit::Timer> _retry_timer;
+
+    // 发往同一对端的udp包，在flush、缓存满或本轮事件循环结束时批量发送
+    // Udp packets sent to the same peer, sent in batch when flushing, when the cache is full or at the end of the event loop iteration
+    bool _udp_batch_flush_pending = false;
+    Pair::Ptr _udp_batch_pair;
+    std::vector<toolkit::Buffer::Ptr> _udp_batch;
 };
 
 class IceServer : public IceTransport {
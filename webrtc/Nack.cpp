@@ -8,6 +8,7 @@
  * may be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
 #include "Nack.h"
 #include "Common/config.h"
 
@@ -61,19 +62,89 @@ static onceToken token([]() {
 
 } // namespace Rtc
 
+static inline int lowestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(v);
+#else
+    int ret = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        ++ret;
+    }
+    return ret;
+#endif
+}
+
+static inline size_t popCount(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(v);
+#else
+    size_t ret = 0;
+    for (; v; v &= v - 1) {
+        ++ret;
+    }
+    return ret;
+#endif
+}
+
+static inline int highestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(v);
+#else
+    int ret = 0;
+    while (v >>= 1) {
+        ++ret;
+    }
+    return ret;
+#endif
+}
+
+// 遍历nack包中丢失的seq，避免FCI_NACK::getBitArray()分配内存
+// Traverse the lost seq in the nack packet, avoiding the memory allocation of FCI_NACK::getBitArray()
+template <typename FUNC>
+static inline void forEachLostSeq(const FCI_NACK &nack, FUNC &&func) {
+    auto seq = nack.getPid();
+    // nack第一个包必丢
+    // The first packet of nack must be lost
+    func(seq);
+    auto blp = nack.getBlp();
+    for (size_t i = 0; i < FCI_NACK::kBitSize; ++i) {
+        ++seq;
+        if (blp & (1 << i)) {
+            func(seq);
+        }
+    }
+}
+
 void NackList::pushBack(RtpPacket::Ptr rtp) {
     GET_CONFIG(uint32_t, max_rtp_cache_ms, Rtc::kMaxRtpCacheMS);
     GET_CONFIG(uint32_t, max_rtp_cache_size, Rtc::kMaxRtpCacheSize);
 
+    if (_count + 1 >= _slots.size() && _slots.size() <= max_rtp_cache_size) {
+        // 环形数组长度为2的幂，从小容量开始按需翻倍，直到大于最大缓存个数，保证连续的seq不会冲突
+        // The ring array length is a power of 2, starting small and doubling on demand until it is greater than the maximum cache number,
+        // ensuring that continuous seq do not conflict
+        resize(_slots.empty() ? 64 : _slots.size() << 1);
+    }
+
     // 记录rtp  [AUTO-TRANSLATED:f08e12e2]
     // Record rtp
     auto seq = rtp->getSeq();
-    _nack_cache_seq.emplace_back(seq);
-    _nack_cache_pkt.emplace(seq, std::move(rtp));
+    if (_count == _seq_queue.size()) {
+        popFront();
+    }
+    _seq_queue[(_begin + _count++) & _mask] = seq;
+    auto &slot = _slots[seq & _mask];
+    if (!slot.rtp || slot.seq != seq) {
+        // 相同seq的rtp已经存在时保留旧的
+        // Keep the old one when the rtp with the same seq already exists
+        slot.seq = seq;
+        slot.rtp = std::move(rtp);
+    }
 
     // 限制rtp缓存最大个数  [AUTO-TRANSLATED:a6bb50f5]
     // Limit the maximum number of rtp cache
-    if (_nack_cache_seq.size() > max_rtp_cache_size) {
+    if (_count > max_rtp_cache_size) {
         popFront();
     }
 
@@ -91,47 +162,78 @@ void NackList::pushBack(RtpPacket::Ptr rtp) {
 }
 
 void NackList::forEach(const FCI_NACK &nack, const function<void(const RtpPacket::Ptr &rtp)> &func) {
-    auto seq = nack.getPid();
-    for (auto bit : nack.getBitArray()) {
-        if (bit) {
-            // 丢包  [AUTO-TRANSLATED:ac2c9d55]
-            // Packet loss
-            RtpPacket::Ptr *ptr = getRtp(seq);
-            if (ptr) {
-                func(*ptr);
-            }
+    forEachLostSeq(nack, [&](uint16_t seq) {
+        // 丢包  [AUTO-TRANSLATED:ac2c9d55]
+        // Packet loss
+        RtpPacket::Ptr *ptr = getRtp(seq);
+        if (ptr) {
+            func(*ptr);
+        }
+    });
+}
+
+void NackList::resize(size_t capacity) {
+    std::vector<uint16_t> seq_queue(capacity);
+    std::vector<Slot> slots(capacity);
+    auto mask = capacity - 1;
+    for (size_t i = 0; i < _count; ++i) {
+        auto seq = _seq_queue[(_begin + i) & _mask];
+        seq_queue[i] = seq;
+        auto &slot = _slots[seq & _mask];
+        if (slot.rtp && slot.seq == seq) {
+            // 新容量是旧容量的倍数，旧数组中不冲突的seq在新数组中也不会冲突
+            // The new capacity is a multiple of the old one, seq that do not conflict in the old array will not conflict in the new one
+            slots[seq & mask] = std::move(slot);
         }
-        ++seq;
     }
+    _begin = 0;
+    _mask = mask;
+    _seq_queue = std::move(seq_queue);
+    _slots = std::move(slots);
 }
 
 void NackList::popFront() {
-    if (_nack_cache_seq.empty()) {
+    if (!_count) {
         return;
     }
-    _nack_cache_pkt.erase(_nack_cache_seq.front());
-    _nack_cache_seq.pop_front();
+    auto seq = _seq_queue[_begin];
+    auto &slot = _slots[seq & _mask];
+    if (slot.seq == seq) {
+        slot.rtp = nullptr;
+    }
+    _begin = (_begin + 1) & _mask;
+    --_count;
+}
+
+void NackList::popBack() {
+    if (_count) {
+        --_count;
+    }
 }
 
 RtpPacket::Ptr *NackList::getRtp(uint16_t seq) {
-    auto it = _nack_cache_pkt.find(seq);
-    if (it == _nack_cache_pkt.end()) {
+    if (_slots.empty()) {
         return nullptr;
     }
-    return &it->second;
+    auto &slot = _slots[seq & _mask];
+    if (!slot.rtp || slot.seq != seq) {
+        return nullptr;
+    }
+    return &slot.rtp;
 }
 
 uint32_t NackList::getCacheMS() {
-    while (_nack_cache_seq.size() > 2) {
-        auto back_stamp = getNtpStamp(_nack_cache_seq.back());
+    while (_count > 2) {
+        auto back_stamp = getNtpStamp(_seq_queue[(_begin + _count - 1) & _mask]);
         if (back_stamp == -1) {
-            _nack_cache_seq.pop_back();
+            popBack();
             continue;
         }
 
-        auto front_stamp = getNtpStamp(_nack_cache_seq.front());
+        auto front_stamp = getNtpStamp(_seq_queue[_begin]);
         if (front_stamp == -1) {
-            _nack_cache_seq.pop_front();
+            _begin = (_begin + 1) & _mask;
+            --_count;
             continue;
         }
 
@@ -140,19 +242,117 @@ uint32_t NackList::getCacheMS() {
         }
         // ntp时间戳回退了，非法数据，丢掉  [AUTO-TRANSLATED:79ddf252]
         // Ntp timestamp has been rolled back, illegal data, discard
-        _nack_cache_seq.pop_front();
+        _begin = (_begin + 1) & _mask;
+        --_count;
     }
     return 0;
 }
 
 int64_t NackList::getNtpStamp(uint16_t seq) {
-    auto it = _nack_cache_pkt.find(seq);
-    if (it == _nack_cache_pkt.end()) {
+    auto ptr = getRtp(seq);
+    if (!ptr) {
         return -1;
     }
     // 使用ntp时间戳，不会回退  [AUTO-TRANSLATED:2d509f8f]
     // Use ntp timestamp, will not roll back
-    return it->second->getStampMS(true);
+    return (*ptr)->getStampMS(true);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////
+
+bool SeqBitmap::insert(uint16_t seq) {
+    auto &word = _bits[seq >> 6];
+    auto bit = (uint64_t)1 << (seq & 63);
+    if (word & bit) {
+        return false;
+    }
+    word |= bit;
+    if (!_size++) {
+        _min = _max = seq;
+    } else {
+        _min = std::min(_min, seq);
+        _max = std::max(_max, seq);
+    }
+    return true;
+}
+
+void SeqBitmap::erase(uint16_t seq) {
+    if (!contains(seq)) {
+        return;
+    }
+    _bits[seq >> 6] &= ~((uint64_t)1 << (seq & 63));
+    if (!--_size) {
+        return;
+    }
+    if (seq == _min) {
+        _min = findFirst(seq + 1, _max);
+    } else if (seq == _max) {
+        _max = findLast(_min, seq - 1);
+    }
+}
+
+void SeqBitmap::eraseUntil(uint16_t seq) {
+    if (!_size || seq < _min) {
+        return;
+    }
+    if (seq >= _max) {
+        clear();
+        return;
+    }
+    _size -= clearRange(_min, seq);
+    _min = findFirst(seq + 1, _max);
+}
+
+void SeqBitmap::clear() {
+    if (_size) {
+        clearRange(_min, _max);
+        _size = 0;
+    }
+}
+
+int SeqBitmap::findFirst(uint32_t from, uint32_t to) const {
+    for (auto i = from >> 6; i <= to >> 6; ++i) {
+        auto word = _bits[i];
+        if (i == from >> 6) {
+            word &= ~(uint64_t)0 << (from & 63);
+        }
+        if (word) {
+            auto ret = (int)(i << 6) + lowestBit(word);
+            return ret <= (int)to ? ret : -1;
+        }
+    }
+    return -1;
+}
+
+int SeqBitmap::findLast(uint32_t from, uint32_t to) const {
+    for (auto i = (int)(to >> 6); i >= (int)(from >> 6); --i) {
+        auto word = _bits[i];
+        if (i == (int)(to >> 6)) {
+            word &= ~(uint64_t)0 >> (63 - (to & 63));
+        }
+        if (word) {
+            auto ret = (i << 6) + highestBit(word);
+            return ret >= (int)from ? ret : -1;
+        }
+    }
+    return -1;
+}
+
+size_t SeqBitmap::clearRange(uint32_t from, uint32_t to) {
+    size_t ret = 0;
+    auto first = from >> 6, last = to >> 6;
+    for (auto i = first; i <= last; ++i) {
+        auto mask = ~(uint64_t)0;
+        if (i == first) {
+            mask &= ~(uint64_t)0 << (from & 63);
+        }
+        if (i == last) {
+            mask &= ~(uint64_t)0 >> (63 - (to & 63));
+        }
+        ret += popCount(_bits[i] & mask);
+        _bits[i] &= ~mask;
+    }
+    return ret;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////
@@ -174,7 +374,7 @@ void NackContext::received(uint16_t seq, bool is_rtx) {
         // seq回环,清空回环前状态  [AUTO-TRANSLATED:4cb8027e]
         // Seq loop, clear the state before the loop
         makeNack(UINT16_MAX, true);
-        _seq.emplace(seq);
+        _seq.insert(seq);
         return;
     }
 
@@ -185,15 +385,14 @@ void NackContext::received(uint16_t seq, bool is_rtx) {
         return;
     }
 
-    auto pr = _seq.emplace(seq);
-    if (!pr.second) {
+    if (!_seq.insert(seq)) {
         // seq重复, 忽略  [AUTO-TRANSLATED:95ec10db]
         // Seq duplicate, ignore
         return;
     }
 
-    auto max_seq = *_seq.rbegin();
-    auto min_seq = *_seq.begin();
+    auto max_seq = _seq.max();
+    auto min_seq = _seq.min();
     auto diff = max_seq - min_seq;
     if (diff > (UINT16_MAX >> 1)) {
         // 回环后，收到回环前的大值seq, 忽略掉  [AUTO-TRANSLATED:6a30b91f]
@@ -237,16 +436,13 @@ void NackContext::makeNack(uint16_t max_seq, bool flush) {
         vector<bool> vec;
         vec.resize(nack_rtp_count, false);
         for (size_t i = 0; i < nack_rtp_count; ++i) {
-            vec[i] = _seq.find((uint16_t)(_nack_seq + i + 2)) == _seq.end();
+            vec[i] = !_seq.contains((uint16_t)(_nack_seq + i + 2));
         }
         doNack(FCI_NACK(_nack_seq + 1, vec), true);
         _nack_seq += nack_rtp_count + 1;
-        // 返回第一个比_last_max_seq大的元素  [AUTO-TRANSLATED:425c4e63]
-        // Return the first element greater than _last_max_seq
-        auto it = _seq.upper_bound(_nack_seq);
         // 移除 <=_last_max_seq 的seq  [AUTO-TRANSLATED:a64ff3fd]
         // Remove seq <= _last_max_seq
-        _seq.erase(_seq.begin(), it);
+        _seq.eraseUntil(_nack_seq);
     }
 }
 
@@ -268,20 +464,25 @@ void NackContext::doNack(const FCI_NACK &nack, bool record_nack) {
 void NackContext::eraseFrontSeq() {
     // 前面部分seq是连续的，未丢包，移除之  [AUTO-TRANSLATED:ef3eed87]
     // The previous part of the sequence is continuous and has no packet loss, remove it.
-    for (auto it = _seq.begin(); it != _seq.end();) {
-        if (*it != (uint16_t)(_nack_seq + 1)) {
+    while (!_seq.empty()) {
+        if (_seq.min() != (uint16_t)(_nack_seq + 1)) {
             // seq不连续，丢包了  [AUTO-TRANSLATED:dcee49fe]
             // The sequence is not continuous, there is packet loss.
             break;
         }
-        _nack_seq = *it;
-        it = _seq.erase(it);
+        _nack_seq = _seq.min();
+        _seq.erase(_nack_seq);
     }
 }
 
+NackContext::NackStatusList::iterator NackContext::findNackStatus(uint16_t seq) {
+    return std::lower_bound(_nack_send_status.begin(), _nack_send_status.end(), seq,
+                            [](const NackStatusList::value_type &item, uint16_t seq) { return item.first < seq; });
+}
+
 void NackContext::clearNackStatus(uint16_t seq) {
-    auto it = _nack_send_status.find(seq);
-    if (it == _nack_send_status.end()) {
+    auto it = findNackStatus(seq);
+    if (it == _nack_send_status.end() || it->first != seq) {
         return;
     }
     // 收到重传包与第一个nack包间的时间约等于rtt时间  [AUTO-TRANSLATED:f702811e]
@@ -298,57 +499,62 @@ void NackContext::clearNackStatus(uint16_t seq) {
 
 void NackContext::recordNack(const FCI_NACK &nack) {
     auto now = getCurrentMillisecond();
-    auto i = nack.getPid();
-    for (auto flag : nack.getBitArray()) {
-        if (flag) {
-            auto &ref = _nack_send_status[i];
-            ref.first_stamp = now;
-            ref.update_stamp = now;
-            ref.nack_count = 1;
+    forEachLostSeq(nack, [&](uint16_t seq) {
+        auto it = findNackStatus(seq);
+        if (it == _nack_send_status.end() || it->first != seq) {
+            it = _nack_send_status.emplace(it, seq, NackStatus());
         }
-        ++i;
-    }
+        auto &ref = it->second;
+        ref.first_stamp = now;
+        ref.update_stamp = now;
+        ref.nack_count = 1;
+    });
     // 记录太多了，移除一部分早期的记录  [AUTO-TRANSLATED:6f4ea62d]
     // There are too many records, remove some of the earlier records.
     GET_CONFIG(uint32_t, nack_maxsize, Rtc::kNackMaxSize);
-    while (_nack_send_status.size() > nack_maxsize) {
-        _nack_send_status.erase(_nack_send_status.begin());
+    if (_nack_send_status.size() > nack_maxsize) {
+        _nack_send_status.erase(_nack_send_status.begin(), _nack_send_status.begin() + (_nack_send_status.size() - nack_maxsize));
     }
 }
 
 uint64_t NackContext::reSendNack() {
-    set<uint16_t> nack_rtp;
+    // 按照seq数值顺序排列
+    // Arranged in seq numerical order
+    vector<uint16_t> nack_rtp;
     auto now = getCurrentMillisecond();
     GET_CONFIG(uint32_t, nack_maxms, Rtc::kNackMaxMS);
     GET_CONFIG(uint32_t, nack_maxcount, Rtc::kNackMaxCount);
     GET_CONFIG(float, nack_intervalratio, Rtc::kNackIntervalRatio);
-    for (auto it = _nack_send_status.begin(); it != _nack_send_status.end();) {
+    // 原地压缩保留下来的状态
+    // Compact the retained status in place
+    auto out = _nack_send_status.begin();
+    for (auto it = _nack_send_status.begin(); it != _nack_send_status.end(); ++it) {
         if (now - it->second.first_stamp > nack_maxms) {
             // 该rtp丢失太久了，不再要求重传  [AUTO-TRANSLATED:a0a1e471]
             // This rtp has been lost for too long, no longer require retransmission.
-            it = _nack_send_status.erase(it);
             continue;
         }
-        if (now - it->second.update_stamp < nack_intervalratio * _rtt) {
-            // 距离上次nack不足2倍的rtt，不用再发送nack  [AUTO-TRANSLATED:0e7edf4d]
-            // The distance from the last nack is less than 2 times the rtt, no need to send nack again.
-            ++it;
-            continue;
+        if (now - it->second.update_stamp >= nack_intervalratio * _rtt) {
+            // 此rtp需要请求重传  [AUTO-TRANSLATED:c29d8eb5]
+            // This rtp needs to request retransmission.
+            nack_rtp.emplace_back(it->first);
+            // 更新nack发送时间戳  [AUTO-TRANSLATED:16ef9fac]
+            // Update the nack sending timestamp.
+            it->second.update_stamp = now;
+            if (++(it->second.nack_count) == nack_maxcount) {
+                // nack次数太多，移除之  [AUTO-TRANSLATED:1b684a9c]
+                // Too many nack times, remove it.
+                continue;
+            }
         }
-        // 此rtp需要请求重传  [AUTO-TRANSLATED:c29d8eb5]
-        // This rtp needs to request retransmission.
-        nack_rtp.emplace(it->first);
-        // 更新nack发送时间戳  [AUTO-TRANSLATED:16ef9fac]
-        // Update the nack sending timestamp.
-        it->second.update_stamp = now;
-        if (++(it->second.nack_count) == nack_maxcount) {
-            // nack次数太多，移除之  [AUTO-TRANSLATED:1b684a9c]
-            // Too many nack times, remove it.
-            it = _nack_send_status.erase(it);
-            continue;
+        // 距离上次nack不足rtt倍数的，不用再发送nack
+        // If the distance from the last nack is less than the multiple of rtt, no need to send nack again
+        if (out != it) {
+            *out = std::move(*it);
         }
-        ++it;
+        ++out;
     }
+    _nack_send_status.erase(out, _nack_send_status.end());
 
     int pid = -1;
     vector<bool> vec;
@@ -11,10 +11,8 @@
 #ifndef ZLMEDIAKIT_NACK_H
 #define ZLMEDIAKIT_NACK_H
 
-#include <set>
-#include <map>
-#include <deque>
-#include <unordered_map>
+#include <array>
+#include <vector>
 #include "Rtsp/Rtsp.h"
 #include "Rtcp/RtcpFCI.h"
 
@@ -23,6 +21,15 @@ namespace mediakit {
 // RTC配置项目  [AUTO-TRANSLATED:19940011]
 // RTC configuration project
 namespace Rtc {
+// ~ nack接收端, rtp发送端
+// ~ nack receiver, rtp sender
+// rtp重发缓存列队最大长度，单位毫秒
+// rtp retransmission cache queue maximum length, in milliseconds
+extern const std::string kMaxRtpCacheMS;
+// rtp重发缓存列队最大长度，单位个数
+// rtp retransmission cache queue maximum length, in number
+extern const std::string kMaxRtpCacheSize;
+
 // ~ nack发送端，rtp接收端  [AUTO-TRANSLATED:bb169205]
 // ~ nack sender, rtp receiver
 // 最大保留的rtp丢包状态个数  [AUTO-TRANSLATED:70eee442]
@@ -33,6 +40,11 @@ extern const std::string kNackMaxSize;
 extern const std::string kNackMaxMS;
 } // namespace Rtc
 
+/**
+ * rtp重传缓存，rtp按照seq存放在长度为2的幂的环形数组中，另有一个环形队列记录写入顺序用于淘汰
+ * Rtp retransmission cache, rtp is stored in a ring array with a power of 2 length indexed by seq,
+ * and another ring queue records the write order for eviction
+ */
 class NackList {
 public:
     void pushBack(RtpPacket::Ptr rtp);
@@ -40,14 +52,66 @@ public:
 
 private:
     void popFront();
+    void popBack();
+    void resize(size_t capacity);
     uint32_t getCacheMS();
     int64_t getNtpStamp(uint16_t seq);
     RtpPacket::Ptr *getRtp(uint16_t seq);
 
 private:
+    struct Slot {
+        uint16_t seq;
+        RtpPacket::Ptr rtp;
+    };
+
     uint32_t _cache_ms_check = 0;
-    std::deque<uint16_t> _nack_cache_seq;
-    std::unordered_map<uint16_t, RtpPacket::Ptr> _nack_cache_pkt;
+    // 写入顺序队列，_seq_queue[(_begin + i) & _mask]
+    // Write order queue, _seq_queue[(_begin + i) & _mask]
+    size_t _begin = 0;
+    size_t _count = 0;
+    size_t _mask = 0;
+    std::vector<uint16_t> _seq_queue;
+    // 以seq & _mask为下标的rtp
+    // Rtp indexed by seq & _mask
+    std::vector<Slot> _slots;
+};
+
+/**
+ * 覆盖整个16位seq空间的位图，按seq数值顺序维护最小与最大值，插入删除不分配内存
+ * A bitmap covering the entire 16-bit seq space, maintaining the minimum and maximum values in seq numerical order,
+ * insertion and deletion do not allocate memory
+ */
+class SeqBitmap {
+public:
+    bool empty() const { return _size == 0; }
+    size_t size() const { return _size; }
+    uint16_t min() const { return _min; }
+    uint16_t max() const { return _max; }
+    bool contains(uint16_t seq) const { return (_bits[seq >> 6] >> (seq & 63)) & 1; }
+
+    // seq已存在时返回false
+    // Return false if seq already exists
+    bool insert(uint16_t seq);
+    void erase(uint16_t seq);
+    // 移除所有不大于seq的值
+    // Remove all values not greater than seq
+    void eraseUntil(uint16_t seq);
+    void clear();
+
+private:
+    // 查找[from, to]范围内第一个/最后一个存在的值，不存在返回-1
+    // Find the first/last existing value in the range [from, to], return -1 if it does not exist
+    int findFirst(uint32_t from, uint32_t to) const;
+    int findLast(uint32_t from, uint32_t to) const;
+    // 返回移除的个数
+    // Return the number of removed values
+    size_t clearRange(uint32_t from, uint32_t to);
+
+private:
+    size_t _size = 0;
+    uint16_t _min = 0;
+    uint16_t _max = 0;
+    std::array<uint64_t, 65536 / 64> _bits {};
 };
 
 class NackContext {
@@ -73,7 +137,9 @@ private:
     int _rtt = 50;
     TrackType _type;
     onNack _cb;
-    std::set<uint16_t> _seq;
+    // 已收到但尚未确认连续的seq
+    // Received seq that have not yet been confirmed as continuous
+    SeqBitmap _seq;
     // 最新nack包中的rtp seq值  [AUTO-TRANSLATED:6984d95a]
     // RTP seq value in the latest nack packet
     uint16_t _nack_seq = 0;
@@ -83,7 +149,11 @@ private:
         uint64_t update_stamp;
         uint32_t nack_count = 0;
     };
-    std::map<uint16_t /*seq*/, NackStatus> _nack_send_status;
+    // 按照seq数值排序的nack状态，数量受nackMaxSize限制，使用有序数组避免频繁分配节点
+    // Nack status sorted by seq value, the number is limited by nackMaxSize, use a sorted array to avoid frequent node allocation
+    using NackStatusList = std::vector<std::pair<uint16_t /*seq*/, NackStatus>>;
+    NackStatusList::iterator findNackStatus(uint16_t seq);
+    NackStatusList _nack_send_status;
 };
 
 } // namespace mediakit
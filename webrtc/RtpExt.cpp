@@ -363,6 +363,13 @@ uint16_t RtpExt::getTransportCCSeq() const {
     return ret;
 }
 
+void RtpExt::setTransportCCSeq(uint16_t seq) {
+    CHECK(_type == RtpExtType::transport_cc && size() >= 2);
+    auto ptr = (uint8_t *)_data;
+    ptr[0] = seq >> 8;
+    ptr[1] = seq & 0xFF;
+}
+
 //https://tools.ietf.org/html/draft-ietf-avtext-sdes-hdr-ext-07
 //    0                   1                   2                   3
 //    0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1 2 3 4 5 6 7 8 9 0 1
@@ -580,6 +587,10 @@ void RtpExtContext::setRid(uint32_t ssrc, const string &rid) {
     _ssrc_to_rid[ssrc] = rid;
 }
 
+bool RtpExtContext::supportExt(RtpExtType type) const {
+    return _rtp_ext_type_to_id.find(type) != _rtp_ext_type_to_id.end();
+}
+
 RtpExt RtpExtContext::changeRtpExtId(const RtpHeader *header, bool is_recv, string *rid_ptr, RtpExtType type) {
     string rid, repaired_rid;
     RtpExt ret;
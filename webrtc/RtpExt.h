@@ -67,6 +67,7 @@ public:
     uint8_t getAudioLevel(bool *vad) const;
     uint32_t getAbsSendTime() const;
     uint16_t getTransportCCSeq() const;
+    void setTransportCCSeq(uint16_t seq);
     std::string getSdesMid() const;
     std::string getRtpStreamId() const;
     std::string getRepairedRtpStreamId() const;
@@ -123,6 +124,9 @@ public:
     void setOnGetRtp(OnGetRtp cb);
     std::string getRid(uint32_t ssrc) const;
     void setRid(uint32_t ssrc, const std::string &rid);
+    // 对端是否协商了该rtp扩展
+    // Whether the rtp extension is negotiated by the peer
+    bool supportExt(RtpExtType type) const;
     RtpExt changeRtpExtId(const RtpHeader *header, bool is_recv, std::string *rid_ptr = nullptr, RtpExtType type = RtpExtType::padding);
 
 private:
@@ -1392,6 +1392,19 @@ bool RtcSession::supportRtcpFb(const string &name, TrackType type) const {
     return ref.find(name) != ref.end();
 }
 
+bool RtcSession::supportRtpExt(RtpExtType ext_type, TrackType type) const {
+    auto media = getMedia(type);
+    if (!media) {
+        return false;
+    }
+    for (auto &ext : media->extmap) {
+        if (RtpExt::getExtType(ext.ext) == ext_type) {
+            return true;
+        }
+    }
+    return false;
+}
+
 bool RtcSession::supportSimulcast() const {
     for (auto &m : media) {
         if (m.supportSimulcast()) {
@@ -703,6 +703,7 @@ public:
     std::string toRtspSdp() const;
     const RtcMedia *getMedia(TrackType type) const;
     bool supportRtcpFb(const std::string &name, TrackType type = TrackType::TrackVideo) const;
+    bool supportRtpExt(RtpExtType ext_type, TrackType type = TrackType::TrackVideo) const;
     bool supportSimulcast() const;
     bool isOnlyDatachannel() const;
 
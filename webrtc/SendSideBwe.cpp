@@ -0,0 +1,439 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <cmath>
+#include <algorithm>
+#include "SendSideBwe.h"
+#include "Util/util.h"
+
+using namespace std;
+using namespace toolkit;
+
+namespace mediakit {
+
+// 发送间隔在该时间内的包视为一次突发，作为一组计算延时梯度
+// Packets sent within this time are regarded as a burst, and the delay gradient is calculated as a group
+static constexpr uint64_t kBurstUS = 5 * 1000;
+// trendline滤波参数
+// Trendline filter parameters
+static constexpr size_t kTrendlineWindowSize = 20;
+static constexpr double kTrendlineSmoothing = 0.9;
+static constexpr double kTrendlineThresholdGain = 4.0;
+static constexpr size_t kMaxNumDeltas = 60;
+// 自适应阈值参数
+// Adaptive threshold parameters
+static constexpr double kThresholdUp = 0.0087;
+static constexpr double kThresholdDown = 0.039;
+static constexpr double kMinThreshold = 6;
+static constexpr double kMaxThreshold = 600;
+static constexpr double kMaxAdaptOffsetMS = 15;
+static constexpr double kOverusingTimeThresholdMS = 10;
+// 两次降码率的最小间隔
+// Minimum interval between two bitrate decreases
+static constexpr uint64_t kDecreaseIntervalUS = 200 * 1000;
+// 对端确认码率统计窗口
+// Statistics window of the bitrate acknowledged by the peer
+static constexpr uint64_t kAckedWindowUS = 500 * 1000;
+// 统计丢包率最少需要的包数
+// Minimum number of packets required to count the loss rate
+static constexpr size_t kLossMinPackets = 50;
+
+SendSideBwe::SendSideBwe(uint32_t start_bps, uint32_t min_bps, uint32_t max_bps) {
+    _min_bps = min_bps;
+    _max_bps = MAX(max_bps, min_bps);
+    _delay_bps = MIN(MAX(start_bps, _min_bps), _max_bps);
+    // 未发生丢包前，丢包部分不限制码率
+    // The loss based part does not limit the bitrate before packet loss occurs
+    _loss_bps = _max_bps;
+    _target_bps = _delay_bps;
+    _history.resize(kHistorySize);
+}
+
+void SendSideBwe::onSendPacket(uint16_t twcc_seq, size_t size, uint64_t now_us) {
+    auto &pkt = _history[twcc_seq % kHistorySize];
+    pkt.send_us = now_us;
+    pkt.size = (uint32_t)size;
+    pkt.seq = twcc_seq;
+    pkt.acked = false;
+}
+
+void SendSideBwe::onTwccFeedback(const FCI_TWCC &fci, size_t fci_size, uint64_t now_us) {
+    ++_feedbacks;
+    // 基准时间单位为64ms，recv delta单位为250us，且为相对上一个收到包的增量
+    // The unit of reference time is 64ms, the unit of recv delta is 250us, and it is the increment relative to the previous received packet
+    int64_t arrival_us = (int64_t)fci.getReferenceTime() * 64 * 1000;
+    fci.forEachPacket(fci_size, [&](uint16_t seq, SymbolStatus status, int16_t delta) {
+        auto &pkt = _history[seq % kHistorySize];
+        auto known = pkt.send_us && pkt.seq == seq;
+        switch (status) {
+            case SymbolStatus::small_delta:
+            case SymbolStatus::large_delta: {
+                arrival_us += (int64_t)delta * 250;
+                if (!known || pkt.acked || arrival_us < 0) {
+                    break;
+                }
+                pkt.acked = true;
+                ++_received;
+                onPacketArrival(pkt, arrival_us, now_us);
+                break;
+            }
+            case SymbolStatus::not_received: {
+                if (known && !pkt.acked) {
+                    ++_lost;
+                }
+                break;
+            }
+            default: break;
+        }
+    });
+    updateDelayBased(now_us);
+    updateLossBased(now_us);
+    updateTarget();
+}
+
+void SendSideBwe::onRemb(uint32_t bitrate_bps) {
+    _remb_bps = bitrate_bps;
+    updateTarget();
+}
+
+void SendSideBwe::onPacketArrival(const SentPacket &pkt, uint64_t arrival_us, uint64_t now_us) {
+    updateAckedBitrate(pkt.size, arrival_us);
+    if (!_cur_group.first_send_us) {
+        _cur_group = PacketGroup { pkt.send_us, pkt.send_us, arrival_us, false };
+        return;
+    }
+    if (pkt.send_us < _cur_group.first_send_us) {
+        // 乱序的包，忽略
+        // Out of order packet, ignore
+        return;
+    }
+    if (pkt.send_us - _cur_group.first_send_us <= kBurstUS) {
+        _cur_group.last_send_us = MAX(_cur_group.last_send_us, pkt.send_us);
+        _cur_group.last_arrival_us = MAX(_cur_group.last_arrival_us, arrival_us);
+        return;
+    }
+    // 当前组结束，与上一组比较得到延时梯度
+    // The current group is over, compare with the previous group to get the delay gradient
+    if (_prev_group.complete) {
+        auto send_delta_ms = (double)(_cur_group.last_send_us - _prev_group.last_send_us) / 1000;
+        auto arrival_delta_ms = ((double)_cur_group.last_arrival_us - (double)_prev_group.last_arrival_us) / 1000;
+        onGroupDelta(send_delta_ms, arrival_delta_ms, _cur_group.last_arrival_us, now_us);
+    }
+    _prev_group = _cur_group;
+    _prev_group.complete = true;
+    _cur_group = PacketGroup { pkt.send_us, pkt.send_us, arrival_us, false };
+}
+
+static double linearFitSlope(const deque<pair<double, double>> &points) {
+    double sum_x = 0, sum_y = 0;
+    for (auto &pr : points) {
+        sum_x += pr.first;
+        sum_y += pr.second;
+    }
+    auto avg_x = sum_x / points.size();
+    auto avg_y = sum_y / points.size();
+    double numerator = 0, denominator = 0;
+    for (auto &pr : points) {
+        auto dx = pr.first - avg_x;
+        numerator += dx * (pr.second - avg_y);
+        denominator += dx * dx;
+    }
+    return denominator == 0 ? NAN : numerator / denominator;
+}
+
+void SendSideBwe::onGroupDelta(double send_delta_ms, double arrival_delta_ms, uint64_t arrival_us, uint64_t now_us) {
+    if (fabs(arrival_delta_ms - send_delta_ms) > 10 * 1000) {
+        // 对端时钟跳变或基准时间回环，重新开始统计
+        // The peer clock jumps or the reference time loops, restart the statistics
+        _accumulated_delay_ms = _smoothed_delay_ms = 0;
+        _first_arrival_us = 0;
+        _num_deltas = 0;
+        _delay_window.clear();
+        return;
+    }
+    _num_deltas = MIN(_num_deltas + 1, kMaxNumDeltas);
+    if (!_first_arrival_us) {
+        _first_arrival_us = arrival_us;
+    }
+    _accumulated_delay_ms += arrival_delta_ms - send_delta_ms;
+    _smoothed_delay_ms = kTrendlineSmoothing * _smoothed_delay_ms + (1 - kTrendlineSmoothing) * _accumulated_delay_ms;
+    _delay_window.emplace_back(((double)arrival_us - (double)_first_arrival_us) / 1000, _smoothed_delay_ms);
+    if (_delay_window.size() > kTrendlineWindowSize) {
+        _delay_window.pop_front();
+    }
+    if (_delay_window.size() == kTrendlineWindowSize) {
+        auto slope = linearFitSlope(_delay_window);
+        if (!std::isnan(slope)) {
+            _trend = slope;
+        }
+    }
+    _modified_trend = _num_deltas * _trend * kTrendlineThresholdGain;
+
+    if (_modified_trend > _threshold) {
+        if (_time_over_using_ms < 0) {
+            // 假定过载发生在两组之间的中点
+            // Assume the overuse occurs at the midpoint between the two groups
+            _time_over_using_ms = send_delta_ms / 2;
+        } else {
+            _time_over_using_ms += send_delta_ms;
+        }
+        ++_overuse_counter;
+        if (_time_over_using_ms > kOverusingTimeThresholdMS && _overuse_counter > 1 && _trend >= _prev_trend) {
+            _time_over_using_ms = 0;
+            _overuse_counter = 0;
+            _state = BwState::overusing;
+        }
+    } else if (_modified_trend < -_threshold) {
+        _time_over_using_ms = -1;
+        _overuse_counter = 0;
+        _state = BwState::underusing;
+    } else {
+        _time_over_using_ms = -1;
+        _overuse_counter = 0;
+        _state = BwState::normal;
+    }
+    _prev_trend = _trend;
+    updateThreshold(_modified_trend, now_us);
+}
+
+void SendSideBwe::updateThreshold(double modified_trend, uint64_t now_us) {
+    if (!_last_threshold_update_us) {
+        _last_threshold_update_us = now_us;
+    }
+    auto abs_trend = fabs(modified_trend);
+    if (abs_trend > _threshold + kMaxAdaptOffsetMS) {
+        // 突发的大幅波动不参与阈值调整
+        // Sudden large fluctuations do not participate in threshold adjustment
+        _last_threshold_update_us = now_us;
+        return;
+    }
+    auto k = abs_trend < _threshold ? kThresholdDown : kThresholdUp;
+    auto elapsed_ms = MIN((double)(now_us - _last_threshold_update_us) / 1000, 100.0);
+    _threshold += k * (abs_trend - _threshold) * elapsed_ms;
+    _threshold = MIN(MAX(_threshold, kMinThreshold), kMaxThreshold);
+    _last_threshold_update_us = now_us;
+}
+
+void SendSideBwe::updateAckedBitrate(size_t bytes, uint64_t arrival_us) {
+    if (!_acked_window_start_us || arrival_us < _acked_window_start_us) {
+        _acked_window_start_us = arrival_us;
+        _acked_window_bytes = 0;
+    }
+    _acked_window_bytes += bytes;
+    auto elapsed_us = arrival_us - _acked_window_start_us;
+    if (elapsed_us < kAckedWindowUS) {
+        return;
+    }
+    auto bps = (uint32_t)(_acked_window_bytes * 8 * 1000000 / elapsed_us);
+    _acked_bps = _acked_bps ? (_acked_bps + bps) / 2 : bps;
+    _acked_window_start_us = arrival_us;
+    _acked_window_bytes = 0;
+}
+
+void SendSideBwe::updateDelayBased(uint64_t now_us) {
+    if (!_last_delay_update_us) {
+        _last_delay_update_us = now_us;
+        return;
+    }
+    auto elapsed_sec = MIN((double)(now_us - _last_delay_update_us) / 1000000, 1.0);
+    _last_delay_update_us = now_us;
+
+    switch (_state) {
+        case BwState::overusing: {
+            if (now_us - _last_decrease_us < kDecreaseIntervalUS) {
+                break;
+            }
+            // 乘性降低到对端实际收到码率的0.85倍
+            // Multiplicatively decrease to 0.85 times the bitrate actually received by the peer
+            auto base = _acked_bps ? _acked_bps : _delay_bps;
+            _delay_bps = MIN(_delay_bps, (uint32_t)(base * 0.85));
+            _last_decrease_us = now_us;
+            _start_phase = false;
+            break;
+        }
+        case BwState::underusing: {
+            // 队列正在排空，保持码率
+            // The queue is draining, hold the bitrate
+            break;
+        }
+        default: {
+            // 起始阶段每秒翻倍，之后每秒增长8%，且不超过对端实际收到码率太多
+            // Double per second in the start phase, then increase by 8% per second, and not too much higher than the bitrate actually received by the peer
+            auto bps = _delay_bps * pow(_start_phase ? 2.0 : 1.08, elapsed_sec);
+            if (_acked_bps) {
+                bps = MIN(bps, MAX(1.5 * _acked_bps + 10 * 1000, (double)_delay_bps));
+            }
+            _delay_bps = (uint32_t)MIN(bps, (double)_max_bps);
+            break;
+        }
+    }
+    _delay_bps = MAX(_delay_bps, _min_bps);
+}
+
+void SendSideBwe::updateLossBased(uint64_t now_us) {
+    auto total = _received + _lost;
+    if (total < kLossMinPackets) {
+        return;
+    }
+    _loss_rate = (float)_lost / total;
+    _received = _lost = 0;
+    if (_loss_rate < 0.02f) {
+        if (_loss_bps < _max_bps && now_us - _last_loss_increase_us >= 1000 * 1000) {
+            _loss_bps = (uint32_t)MIN(_loss_bps * 1.08, (double)_max_bps);
+            _last_loss_increase_us = now_us;
+        }
+    } else if (_loss_rate > 0.1f) {
+        if (now_us - _last_loss_decrease_us >= 300 * 1000) {
+            _loss_bps = (uint32_t)(MIN(_loss_bps, _target_bps) * (1 - 0.5 * _loss_rate));
+            _last_loss_decrease_us = _last_loss_increase_us = now_us;
+            _start_phase = false;
+        }
+    }
+    _loss_bps = MAX(_loss_bps, _min_bps);
+}
+
+void SendSideBwe::updateTarget() {
+    auto bps = MIN(_delay_bps, _loss_bps);
+    if (_remb_bps) {
+        bps = MIN(bps, _remb_bps);
+    }
+    _target_bps = MIN(MAX(bps, _min_bps), _max_bps);
+}
+
+void SendSideBwe::getInfo(BweInfo &info) const {
+    static const char *s_state[] = { "normal", "overusing", "underusing" };
+    info.target_bps = _target_bps;
+    info.delay_based_bps = _delay_bps;
+    info.loss_based_bps = _loss_bps;
+    info.remb_bps = _remb_bps;
+    info.acked_bps = _acked_bps;
+    info.loss_rate = _loss_rate;
+    info.trend = _modified_trend;
+    info.threshold = _threshold;
+    info.state = s_state[(int)_state];
+    info.feedbacks = _feedbacks;
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+
+// 发送速率为目标码率的倍数，允许视频码率短时间高于估计值
+// The sending rate is a multiple of the target bitrate, allowing the video bitrate to be higher than the estimated value for a short time
+static constexpr double kPacingFactor = 2.5;
+static constexpr uint64_t kProcessIntervalMS = 5;
+// 排队最长时间，超过后提高发送速率以排空队列
+// Maximum queuing time, the sending rate is increased to drain the queue after it is exceeded
+static constexpr uint64_t kMaxQueueMS = 500;
+// 空闲时最多积累的预算
+// Maximum budget accumulated when idle
+static constexpr uint64_t kMaxBudgetMS = 10;
+
+RtpPacer::RtpPacer(EventPoller::Ptr poller, onSend cb) {
+    _poller = std::move(poller);
+    _cb = std::move(cb);
+}
+
+void RtpPacer::setTargetBitrate(uint32_t bps) {
+    _target_bps = bps;
+}
+
+void RtpPacer::inputRtp(const RtpPacket::Ptr &rtp, bool flush) {
+    auto now_us = getCurrentMicrosecond();
+    updateBudget(now_us);
+    auto size = rtp->size() - RtpPacket::kRtpTcpHeaderSize;
+    if (_queue.empty() && _budget > 0) {
+        _budget -= size;
+        _cb(rtp, flush);
+        return;
+    }
+    _queue.emplace_back(rtp, now_us);
+    _queue_bytes += size;
+    startTimer();
+}
+
+void RtpPacer::onBypassSent(size_t bytes) {
+    updateBudget(getCurrentMicrosecond());
+    _budget -= bytes;
+}
+
+uint64_t RtpPacer::getPacingRate(uint64_t now_us) const {
+    uint64_t rate = _target_bps * kPacingFactor;
+    if (!_queue.empty()) {
+        // 保证队列在最长排队时间内发送完毕
+        // Ensure that the queue is sent within the maximum queuing time
+        auto wait_us = now_us - _queue.front().second;
+        auto left_us = wait_us + kProcessIntervalMS * 1000 < kMaxQueueMS * 1000 ? kMaxQueueMS * 1000 - wait_us : kProcessIntervalMS * 1000;
+        rate = MAX(rate, (uint64_t)_queue_bytes * 8 * 1000000 / left_us);
+    }
+    return rate;
+}
+
+void RtpPacer::updateBudget(uint64_t now_us) {
+    auto rate = getPacingRate(now_us);
+    if (!_last_update_us) {
+        // 首次发送允许满额预算
+        // Allow full budget for the first sending
+        _budget = (double)rate * kMaxBudgetMS / 8 / 1000;
+        _last_update_us = now_us;
+    }
+    auto elapsed_us = now_us - _last_update_us;
+    _last_update_us = now_us;
+    _budget = MIN(_budget + (double)rate * elapsed_us / 8 / 1000000, (double)rate * kMaxBudgetMS / 8 / 1000);
+}
+
+bool RtpPacer::process() {
+    updateBudget(getCurrentMicrosecond());
+    RtpPacket::Ptr last;
+    while (!_queue.empty() && _budget > 0) {
+        auto rtp = std::move(_queue.front().first);
+        _queue.pop_front();
+        auto size = rtp->size() - RtpPacket::kRtpTcpHeaderSize;
+        _queue_bytes -= size;
+        _budget -= size;
+        if (last) {
+            _cb(last, false);
+        }
+        last = std::move(rtp);
+    }
+    if (last) {
+        // 本轮最后一个包才flush
+        // Only flush the last packet of this round
+        _cb(last, true);
+    }
+    return !_queue.empty();
+}
+
+void RtpPacer::startTimer() {
+    if (_timer_started) {
+        return;
+    }
+    _timer_started = true;
+    weak_ptr<RtpPacer> weak_self = shared_from_this();
+    _poller->doDelayTask(kProcessIntervalMS, [weak_self]() -> uint64_t {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return 0;
+        }
+        if (strong_self->process()) {
+            return kProcessIntervalMS;
+        }
+        // 队列已清空，停止定时器
+        // The queue is empty, stop the timer
+        strong_self->_timer_started = false;
+        return 0;
+    });
+}
+
+void RtpPacer::getInfo(BweInfo &info) const {
+    info.pacer_queue_packets = _queue.size();
+    info.pacer_queue_bytes = _queue_bytes;
+    info.pacer_queue_ms = _queue.empty() ? 0 : (uint32_t)((getCurrentMicrosecond() - _queue.front().second) / 1000);
+}
+
+} // namespace mediakit
@@ -0,0 +1,232 @@
+﻿/*
+ * Copyright (c) 2016-present The ZLMediaKit project authors. All Rights Reserved.
+ *
+ * This file is part of ZLMediaKit(https://github.com/ZLMediaKit/ZLMediaKit).
+ *
+ * Use of this source code is governed by MIT-like license that can be found in the
+ * LICENSE file in the root of the source tree. All contributing project authors
+ * may be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef ZLMEDIAKIT_SENDSIDEBWE_H
+#define ZLMEDIAKIT_SENDSIDEBWE_H
+
+#include <deque>
+#include <vector>
+#include <memory>
+#include <functional>
+#include "Poller/EventPoller.h"
+#include "Rtsp/Rtsp.h"
+#include "Rtcp/RtcpFCI.h"
+
+namespace mediakit {
+
+struct BweInfo {
+    // 最终目标码率，单位bps
+    // Final target bitrate, in bps
+    uint32_t target_bps = 0;
+    uint32_t delay_based_bps = 0;
+    uint32_t loss_based_bps = 0;
+    // 对端通过remb告知的码率，0表示未收到
+    // Bitrate reported by the peer through remb, 0 means not received
+    uint32_t remb_bps = 0;
+    // 对端确认收到的码率
+    // Bitrate acknowledged by the peer
+    uint32_t acked_bps = 0;
+    float loss_rate = 0;
+    double trend = 0;
+    double threshold = 0;
+    const char *state = "";
+    uint64_t feedbacks = 0;
+    // pacer排队情况
+    // Pacer queue status
+    size_t pacer_queue_packets = 0;
+    size_t pacer_queue_bytes = 0;
+    uint32_t pacer_queue_ms = 0;
+};
+
+/**
+ * 发送端带宽估计(类似GCC)，根据对端反馈的transport-cc与remb计算目标码率
+ * 延时部分采用trendline滤波+自适应阈值+AIMD，丢包部分根据twcc统计的丢包率调整码率
+ * Sender side bandwidth estimation (GCC like), calculate the target bitrate according to the transport-cc and remb fed back by the peer
+ * The delay based part uses trendline filter + adaptive threshold + AIMD, the loss based part adjusts the bitrate by the loss rate counted from twcc
+ */
+class SendSideBwe {
+public:
+    using Ptr = std::shared_ptr<SendSideBwe>;
+
+    /**
+     * @param start_bps 起始码率
+     * @param min_bps 最小码率
+     * @param max_bps 最大码率
+     * @param start_bps Start bitrate
+     * @param min_bps Minimum bitrate
+     * @param max_bps Maximum bitrate
+     */
+    SendSideBwe(uint32_t start_bps, uint32_t min_bps, uint32_t max_bps);
+
+    /**
+     * 记录发送的rtp，用于匹配twcc反馈
+     * @param twcc_seq rtp的transport-cc扩展序号
+     * @param size rtp大小(包括rtp头)
+     * @param now_us 发送时间
+     * Record the sent rtp for matching twcc feedback
+     * @param twcc_seq Transport-cc extension sequence of the rtp
+     * @param size Rtp size (including rtp header)
+     * @param now_us Send time
+     */
+    void onSendPacket(uint16_t twcc_seq, size_t size, uint64_t now_us);
+
+    /**
+     * 收到对端的transport-cc反馈
+     * Received the transport-cc feedback of the peer
+     */
+    void onTwccFeedback(const FCI_TWCC &fci, size_t fci_size, uint64_t now_us);
+
+    /**
+     * 收到对端的remb，作为码率上限
+     * Received the remb of the peer, used as the upper limit of the bitrate
+     */
+    void onRemb(uint32_t bitrate_bps);
+
+    uint32_t getTargetBitrate() const { return _target_bps; }
+    void getInfo(BweInfo &info) const;
+
+private:
+    struct SentPacket {
+        uint64_t send_us = 0;
+        uint32_t size = 0;
+        uint16_t seq = 0;
+        bool acked = false;
+    };
+
+    struct PacketGroup {
+        uint64_t first_send_us;
+        uint64_t last_send_us;
+        uint64_t last_arrival_us;
+        bool complete;
+    };
+
+    enum class BwState : int { normal = 0, overusing, underusing };
+
+    void onPacketArrival(const SentPacket &pkt, uint64_t arrival_us, uint64_t now_us);
+    void onGroupDelta(double send_delta_ms, double arrival_delta_ms, uint64_t arrival_us, uint64_t now_us);
+    void updateThreshold(double modified_trend, uint64_t now_us);
+    void updateAckedBitrate(size_t bytes, uint64_t arrival_us);
+    void updateDelayBased(uint64_t now_us);
+    void updateLossBased(uint64_t now_us);
+    void updateTarget();
+
+private:
+    static constexpr size_t kHistorySize = 4096;
+
+    uint32_t _min_bps;
+    uint32_t _max_bps;
+    uint32_t _target_bps;
+    uint32_t _delay_bps;
+    uint32_t _loss_bps;
+    uint32_t _remb_bps = 0;
+    uint32_t _acked_bps = 0;
+    uint64_t _feedbacks = 0;
+    // 起始阶段码率快速增长，直到首次过载或丢包
+    // Bitrate grows fast in the start phase until the first overuse or packet loss
+    bool _start_phase = true;
+
+    // 以twcc seq为索引的发送记录
+    // Send records indexed by twcc seq
+    std::vector<SentPacket> _history;
+
+    // 发送间隔5ms内的包归为一组
+    // Packets sent within 5ms are grouped together
+    PacketGroup _cur_group {};
+    PacketGroup _prev_group {};
+
+    // trendline滤波
+    // Trendline filter
+    double _accumulated_delay_ms = 0;
+    double _smoothed_delay_ms = 0;
+    uint64_t _first_arrival_us = 0;
+    size_t _num_deltas = 0;
+    std::deque<std::pair<double /*arrival ms*/, double /*smoothed delay ms*/>> _delay_window;
+    double _trend = 0;
+    double _prev_trend = 0;
+    double _modified_trend = 0;
+
+    // 过载检测
+    // Overuse detection
+    double _threshold = 12.5;
+    double _time_over_using_ms = -1;
+    int _overuse_counter = 0;
+    uint64_t _last_threshold_update_us = 0;
+    BwState _state = BwState::normal;
+
+    // 码率控制
+    // Rate control
+    uint64_t _last_delay_update_us = 0;
+    uint64_t _last_decrease_us = 0;
+    uint64_t _acked_window_start_us = 0;
+    size_t _acked_window_bytes = 0;
+
+    // 丢包统计
+    // Loss statistics
+    size_t _received = 0;
+    size_t _lost = 0;
+    float _loss_rate = 0;
+    uint64_t _last_loss_increase_us = 0;
+    uint64_t _last_loss_decrease_us = 0;
+};
+
+/**
+ * rtp平滑发送器，按照目标码率的倍数发送视频rtp，避免关键帧等突发数据导致弱网丢包
+ * 音频与重传包不排队，但是占用发送预算
+ * Rtp pacer, sends video rtp at a multiple of the target bitrate, avoiding packet loss in weak networks caused by bursts such as key frames
+ * Audio and retransmitted packets are not queued, but they consume the sending budget
+ */
+class RtpPacer : public std::enable_shared_from_this<RtpPacer> {
+public:
+    using Ptr = std::shared_ptr<RtpPacer>;
+    using onSend = std::function<void(const RtpPacket::Ptr &rtp, bool flush)>;
+
+    RtpPacer(toolkit::EventPoller::Ptr poller, onSend cb);
+
+    /**
+     * 设置目标码率，实际发送速率为其2.5倍
+     * Set the target bitrate, the actual sending rate is 2.5 times of it
+     */
+    void setTargetBitrate(uint32_t bps);
+
+    /**
+     * 输入需要平滑发送的rtp，预算充足且无排队时直接发送
+     * Input the rtp to be paced, send it directly when the budget is sufficient and there is no queue
+     */
+    void inputRtp(const RtpPacket::Ptr &rtp, bool flush);
+
+    /**
+     * 未经过队列直接发送的数据也需要占用预算
+     * Data sent directly without going through the queue also consumes the budget
+     */
+    void onBypassSent(size_t bytes);
+
+    void getInfo(BweInfo &info) const;
+
+private:
+    void updateBudget(uint64_t now_us);
+    uint64_t getPacingRate(uint64_t now_us) const;
+    bool process();
+    void startTimer();
+
+private:
+    bool _timer_started = false;
+    uint32_t _target_bps = 0;
+    uint64_t _last_update_us = 0;
+    size_t _queue_bytes = 0;
+    // 可发送字节数，可能为负数(欠债)
+    // The number of bytes that can be sent, may be negative (debt)
+    double _budget = 0;
+    onSend _cb;
+    toolkit::EventPoller::Ptr _poller;
+    std::deque<std::pair<RtpPacket::Ptr, uint64_t /*enqueue us*/>> _queue;
+};
+
+} // namespace mediakit
+#endif // ZLMEDIAKIT_SENDSIDEBWE_H
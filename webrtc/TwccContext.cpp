@@ -8,8 +8,8 @@
  * may be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <algorithm>
 #include "TwccContext.h"
-#include "Rtcp/RtcpFCI.h"
 
 namespace mediakit {
 
@@ -19,6 +19,9 @@ enum class ExtSeqStatus : int {
     jumped,
 };
 
+static constexpr uint64_t kNotReceived = UINT64_MAX;
+static constexpr size_t kSeqMask = TwccContext::kMaxSeqSpan - 1;
+
 void TwccContext::onRtp(uint32_t ssrc, uint16_t twcc_ext_seq, uint64_t stamp_ms) {
     switch ((ExtSeqStatus) checkSeqStatus(twcc_ext_seq)) {
         case ExtSeqStatus::jumped: /*seq异常,过滤掉*/ return;
@@ -27,13 +30,38 @@ void TwccContext::onRtp(uint32_t ssrc, uint16_t twcc_ext_seq, uint64_t stamp_ms)
         default: /*不可达*/assert(0); break;
     }
 
-    auto result = _rtp_recv_status.emplace(twcc_ext_seq, stamp_ms);
-    if (!result.second) {
+    if (_recv_stamp.empty()) {
+        _recv_stamp.assign(kMaxSeqSpan, kNotReceived);
+        _symbols.reserve(kMaxSeqSpan);
+        _deltas.reserve(kMaxSeqSpan);
+    }
+
+    if (_recv_count) {
+        auto min_seq = std::min(_min_seq, twcc_ext_seq);
+        auto max_seq = std::max(_max_seq, twcc_ext_seq);
+        if ((size_t)(max_seq - min_seq) >= kMaxSeqSpan) {
+            // seq跨度太大，先发送已有的状态
+            // The seq span is too large, send the existing status first
+            onSendTwcc(ssrc);
+        }
+    }
+
+    auto &stamp = _recv_stamp[twcc_ext_seq & kSeqMask];
+    if (stamp != kNotReceived) {
+        // seq范围内的槽位才可能有值，所以此处必定是同一个seq
+        // Only slots within the seq range may have a value, so it must be the same seq here
         WarnL << "recv same twcc ext seq:" << twcc_ext_seq;
         return;
     }
+    stamp = stamp_ms;
+    if (!_recv_count++) {
+        _min_seq = _max_seq = twcc_ext_seq;
+    } else {
+        _min_seq = std::min(_min_seq, twcc_ext_seq);
+        _max_seq = std::max(_max_seq, twcc_ext_seq);
+    }
 
-    _max_stamp = result.first->second;
+    _max_stamp = stamp_ms;
     if (!_min_stamp) {
         _min_stamp = _max_stamp;
     }
@@ -46,17 +74,17 @@ void TwccContext::onRtp(uint32_t ssrc, uint16_t twcc_ext_seq, uint64_t stamp_ms)
 }
 
 bool TwccContext::needSendTwcc() const {
-    if (_rtp_recv_status.empty()) {
+    if (!_recv_count) {
         return false;
     }
-    return (_rtp_recv_status.size() >= kMaxSeqSize) || (_max_stamp - _min_stamp >= kMaxTimeDelta);
+    return (_recv_count >= kMaxSeqSize) || (_max_stamp - _min_stamp >= kMaxTimeDelta);
 }
 
 int TwccContext::checkSeqStatus(uint16_t twcc_ext_seq) const {
-    if (_rtp_recv_status.empty()) {
+    if (!_recv_count) {
         return (int) ExtSeqStatus::normal;
     }
-    auto max = _rtp_recv_status.rbegin()->first;
+    auto max = _max_seq;
     auto delta = (int32_t) twcc_ext_seq - (int32_t) max;
     if (delta > 0 && delta < 0xFFFF / 2) {
         // 正常增长  [AUTO-TRANSLATED:7699c37d]
@@ -75,7 +103,7 @@ int TwccContext::checkSeqStatus(uint16_t twcc_ext_seq) const {
         TraceL << "rtp twcc ext seq jumped after looped:" << max << " -> " << twcc_ext_seq;
         return (int) ExtSeqStatus::jumped;
     }
-    auto min = _rtp_recv_status.begin()->first;
+    auto min = _min_seq;
     if (min <= twcc_ext_seq || twcc_ext_seq <= max) {
         // 正常回退  [AUTO-TRANSLATED:c8c6803f]
         // Normal rollback
@@ -88,42 +116,44 @@ int TwccContext::checkSeqStatus(uint16_t twcc_ext_seq) const {
 }
 
 void TwccContext::onSendTwcc(uint32_t ssrc) {
-    auto max = _rtp_recv_status.rbegin()->first;
-    auto begin = _rtp_recv_status.begin();
-    auto min = begin->first;
     // 参考时间戳的最小单位是64ms  [AUTO-TRANSLATED:2e701a8c]
     // The minimum unit of the reference timestamp is 64ms
-    auto ref_time = begin->second >> 6;
+    auto ref_time = _recv_stamp[_min_seq & kSeqMask] >> 6;
     // 还原基准时间戳  [AUTO-TRANSLATED:bab53195]
     // Restore the baseline timestamp
     auto last_time = ref_time << 6;
-    FCI_TWCC::TwccPacketStatus status;
-    for (auto seq = min; seq <= max; ++seq) {
+    _symbols.clear();
+    _deltas.clear();
+    for (uint32_t seq = _min_seq; seq <= _max_seq; ++seq) {
         int16_t delta = 0;
         SymbolStatus symbol = SymbolStatus::not_received;
-        auto it = _rtp_recv_status.find(seq);
-        if (it != _rtp_recv_status.end()) {
+        auto &stamp = _recv_stamp[seq & kSeqMask];
+        if (stamp != kNotReceived) {
             // recv delta,单位为250us,1ms等于4x250us  [AUTO-TRANSLATED:46a0e186]
             // recv delta, unit is 250us, 1ms equals 4x250us
-            delta = (int16_t) (4 * ((int64_t) it->second - (int64_t) last_time));
+            delta = (int16_t) (4 * ((int64_t) stamp - (int64_t) last_time));
             if (delta < 0 || delta > 0xFF) {
                 symbol = SymbolStatus::large_delta;
             } else {
                 symbol = SymbolStatus::small_delta;
             }
-            last_time = it->second;
+            last_time = stamp;
+            // 清空槽位，供下一个twcc包使用
+            // Clear the slot for the next twcc packet
+            stamp = kNotReceived;
         }
-        status.emplace(seq, std::make_pair(symbol, delta));
+        _symbols.emplace_back(symbol);
+        _deltas.emplace_back(delta);
     }
-    auto fci = FCI_TWCC::create(ref_time, _twcc_pkt_count++, status);
+    FCI_TWCC::create(_fci, _min_seq, ref_time, _twcc_pkt_count++, _symbols.data(), _deltas.data(), _symbols.size());
     if (_cb) {
-        _cb(ssrc, std::move(fci));
+        _cb(ssrc, _fci);
     }
     clearStatus();
 }
 
 void TwccContext::clearStatus() {
-    _rtp_recv_status.clear();
+    _recv_count = 0;
     _min_stamp = 0;
 }
 
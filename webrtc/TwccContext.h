@@ -12,21 +12,25 @@
 #define ZLMEDIAKIT_TWCCCONTEXT_H
 
 #include <stdint.h>
-#include <map>
+#include <vector>
 #include <functional>
 #include <string>
+#include "Rtcp/RtcpFCI.h"
 
 namespace mediakit {
 
 class TwccContext {
 public:
-    using onSendTwccCB = std::function<void(uint32_t ssrc, std::string fci)>;
+    using onSendTwccCB = std::function<void(uint32_t ssrc, const std::string &fci)>;
     // 每个twcc rtcp包最多表明的rtp ext seq增量  [AUTO-TRANSLATED:530d1e35]
     // Maximum RTP ext seq increment indicated by each twcc rtcp packet
     static constexpr size_t kMaxSeqSize = 20;
     // 每个twcc rtcp包发送的最大时间间隔，单位毫秒  [AUTO-TRANSLATED:e45656da]
     // Maximum time interval for sending each twcc rtcp packet, in milliseconds
     static constexpr size_t kMaxTimeDelta = 256;
+    // 每个twcc rtcp包覆盖的最大seq跨度，超过时先发送已有的状态
+    // Maximum seq span covered by each twcc rtcp packet, the existing status is sent first when exceeded
+    static constexpr size_t kMaxSeqSpan = 1024;
 
     void onRtp(uint32_t ssrc, uint16_t twcc_ext_seq, uint64_t stamp_ms);
     void setOnSendTwccCB(onSendTwccCB cb);
@@ -40,7 +44,19 @@ private:
 private:
     uint64_t _min_stamp = 0;
     uint64_t _max_stamp;
-    std::map<uint32_t /*twcc_ext_seq*/, uint64_t/*recv time in ms*/> _rtp_recv_status;
+    // 已收到的rtp个数及其seq范围(数值大小，不跨越回环)
+    // The number of received rtp and its seq range (numerical value, does not cross the loop)
+    size_t _recv_count = 0;
+    uint16_t _min_seq = 0;
+    uint16_t _max_seq = 0;
+    // 以seq & (kMaxSeqSpan - 1)为下标的接收时间，单位毫秒，kNotReceived表示未收到
+    // Receive time indexed by seq & (kMaxSeqSpan - 1), in milliseconds, kNotReceived means not received
+    std::vector<uint64_t> _recv_stamp;
+    // 生成fci的缓存，避免每次分配内存
+    // Buffers for generating fci, avoiding memory allocation every time
+    std::vector<SymbolStatus> _symbols;
+    std::vector<int16_t> _deltas;
+    std::string _fci;
     uint8_t _twcc_pkt_count = 0;
     onSendTwccCB _cb;
 };
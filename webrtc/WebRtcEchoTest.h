@@ -27,7 +27,7 @@ protected:
     void onRtp(const char *buf, size_t len, uint64_t stamp_ms) override;
     void onRtcp(const char *buf, size_t len) override;
 
-    void onBeforeEncryptRtp(const char *buf, int &len, void *ctx) override {};
+    void onBeforeEncryptRtp(const char *src, char *dst, int &len, void *ctx) override { WebRtcTransport::onBeforeEncryptRtp(src, dst, len, ctx); };
     void onBeforeEncryptRtcp(const char *buf, int &len, void *ctx) override {};
 
 private:
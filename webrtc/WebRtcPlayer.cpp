@@ -10,8 +10,10 @@
 
 #include "WebRtcPlayer.h"
 
+#include <algorithm>
 #include "Common/config.h"
 #include "Extension/Factory.h"
+#include "Rtsp/RtspDemuxer.h"
 #include "Util/base64.h"
 
 using namespace std;
@@ -22,9 +24,28 @@ namespace mediakit {
 namespace Rtc {
 #define RTC_FIELD "rtc."
 const string kBfilter = RTC_FIELD "bfilter";
-static onceToken token([]() { mINI::Instance()[kBfilter] = 0; });
+// 是否根据发送端带宽估计在同一推流者的simulcast各层间切换
+// Whether to switch between the simulcast layers of the same publisher according to the sender side bandwidth estimation
+const string kSimulcastSwitch = RTC_FIELD "simulcastSwitch";
+static onceToken token([]() {
+    mINI::Instance()[kBfilter] = 0;
+    mINI::Instance()[kSimulcastSwitch] = 0;
+});
 } // namespace Rtc
 
+// 层选择周期
+// Layer selection period
+static constexpr uint64_t kLayerCheckIntervalMS = 1000;
+// 切换到更高层前当前层至少保持的时间，避免在临界码率附近来回切换
+// The minimum time to stay on the current layer before switching up, avoiding switching back and forth around the critical bitrate
+static constexpr uint64_t kLayerUpSwitchIntervalMS = 5000;
+// 升层时只使用可用码率的80%
+// Only 80% of the available bitrate is used when switching up
+static constexpr double kLayerUpSwitchHeadroom = 0.8;
+// 等待新层关键帧的超时时间，推流端每2秒会被请求一次关键帧
+// Timeout for waiting for the key frame of the new layer, the publisher is asked for a key frame every 2 seconds
+static constexpr uint64_t kPendingLayerTimeoutMS = 5000;
+
 H264BFrameFilter::H264BFrameFilter()
     : _last_seq(0)
     , _last_stamp(0)
@@ -168,6 +189,46 @@ uint8_t H264BFrameFilter::extractSliceType(const uint8_t *data, size_t size) con
     return -1;
 }
 
+static RtpPacket::Ptr copyRtp(const RtpPacket::Ptr &rtp) {
+    auto ret = RtpPacket::create();
+    ret->assign(rtp->data(), rtp->size());
+    ret->type = rtp->type;
+    ret->sample_rate = rtp->sample_rate;
+    ret->ntp_stamp = rtp->ntp_stamp;
+    ret->track_index = rtp->track_index;
+    return ret;
+}
+
+RtpPacket::Ptr RtpLayerRewriter::rewrite(const RtpPacket::Ptr &rtp, bool switch_layer) {
+    if (switch_layer && _started) {
+        // 新层的第一个包紧接着上一层的最后一个包，时间戳按照ntp时间差推算，无法推算时按照30fps递增
+        // The first packet of the new layer follows the last packet of the previous layer,
+        // the timestamp is calculated by the ntp time difference, or increased by 30fps if it cannot be calculated
+        uint32_t stamp_delta = rtp->sample_rate / 30;
+        if (rtp->ntp_stamp > _last_ntp_stamp && rtp->ntp_stamp - _last_ntp_stamp < 1000) {
+            stamp_delta = (uint32_t)((rtp->ntp_stamp - _last_ntp_stamp) * rtp->sample_rate / 1000);
+        }
+        _seq_offset = (uint16_t)(_last_seq + 1 - rtp->getSeq());
+        _stamp_offset = _last_stamp + std::max<uint32_t>(stamp_delta, 1) - rtp->getStamp();
+    }
+    _started = true;
+    _last_ntp_stamp = rtp->ntp_stamp;
+    if (!_seq_offset && !_stamp_offset) {
+        _last_seq = rtp->getSeq();
+        _last_stamp = rtp->getStamp();
+        return rtp;
+    }
+    // rtp在环形缓存中被多个播放器共享，不能直接修改
+    // The rtp is shared by multiple players in the ring buffer and cannot be modified directly
+    auto ret = copyRtp(rtp);
+    _last_seq = rtp->getSeq() + _seq_offset;
+    _last_stamp = rtp->getStamp() + _stamp_offset;
+    auto header = ret->getHeader();
+    header->seq = htons(_last_seq);
+    header->stamp = htonl(_last_stamp);
+    return ret;
+}
+
 WebRtcPlayer::Ptr WebRtcPlayer::create(const EventPoller::Ptr &poller,
                                        const RtspMediaSource::Ptr &src,
                                        const MediaInfo &info,
@@ -208,68 +269,263 @@ void WebRtcPlayer::onStartWebRTC() {
     WebRtcTransportImp::onStartWebRTC();
     if (canSendRtp()) {
         playSrc->pause(false);
-        _reader = playSrc->getRing()->attach(getPoller(), true);
-        weak_ptr<WebRtcPlayer> weak_self = static_pointer_cast<WebRtcPlayer>(shared_from_this());
-        weak_ptr<Session> weak_session = static_pointer_cast<Session>(getSession());
-        _reader->setGetInfoCB([weak_session]() {
-            Any ret;
-            ret.set(static_pointer_cast<Session>(weak_session.lock()));
-            return ret;
-        });
-        _reader->setReadCB([weak_self](const RtspMediaSource::RingDataType &pkt) {
-            auto strong_self = weak_self.lock();
-            if (!strong_self) {
-                return;
-            }
+        _reader = attachReader(playSrc, 0, true);
+        GET_CONFIG(bool, simulcast_switch, Rtc::kSimulcastSwitch);
+        if (simulcast_switch && getTargetBitrate()) {
+            // 层切换依赖发送端带宽估计
+            // Layer switching depends on the sender side bandwidth estimation
+            startSimulcastSwitch(playSrc);
+        }
+    }
+}
 
-            if (strong_self->_send_config_frames_once && !pkt->empty()) {
-                const auto &first_rtp = pkt->front();
-                strong_self->sendConfigFrames(first_rtp->getSeq(), first_rtp->sample_rate, first_rtp->getStamp(), first_rtp->ntp_stamp);
-                strong_self->_send_config_frames_once = false;
-            }
+RtspMediaSource::RingType::RingReader::Ptr WebRtcPlayer::attachReader(const RtspMediaSource::Ptr &src, int layer, bool use_cache) {
+    auto reader = src->getRing()->attach(getPoller(), use_cache);
+    weak_ptr<WebRtcPlayer> weak_self = static_pointer_cast<WebRtcPlayer>(shared_from_this());
+    weak_ptr<Session> weak_session = static_pointer_cast<Session>(getSession());
+    reader->setGetInfoCB([weak_session]() {
+        Any ret;
+        ret.set(static_pointer_cast<Session>(weak_session.lock()));
+        return ret;
+    });
+    reader->setReadCB([weak_self, layer](const RtspMediaSource::RingDataType &pkt) {
+        if (auto strong_self = weak_self.lock()) {
+            strong_self->onReadRtp(pkt, layer);
+        }
+    });
+    reader->setDetachCB([weak_self, layer]() {
+        if (auto strong_self = weak_self.lock()) {
+            strong_self->onLayerDetach(layer);
+        }
+    });
+    reader->setMessageCB([weak_self, layer](const toolkit::Any &data) {
+        auto strong_self = weak_self.lock();
+        if (!strong_self || layer != strong_self->_cur_layer) {
+            return;
+        }
+        if (data.is<Buffer>()) {
+            auto &buffer = data.get<Buffer>();
+            // PPID 51: 文本string  [AUTO-TRANSLATED:69a8cf81]
+            // PPID 51: Text string
+            // PPID 53: 二进制  [AUTO-TRANSLATED:faf00c3e]
+            // PPID 53: Binary
+            strong_self->sendDatachannel(0, 51, buffer.data(), buffer.size());
+        } else {
+            WarnL << "Send unknown message type to webrtc player: " << data.type_name();
+        }
+    });
+    return reader;
+}
 
-            size_t i = 0;
-            pkt->for_each([&](const RtpPacket::Ptr &rtp) {
-                if (strong_self->_bfliter_flag) {
-                    if (TrackVideo == rtp->type && strong_self->_is_h264) {
-                        auto rtp_filter = strong_self->_bfilter->processPacket(rtp);
-                        if (rtp_filter) {
-                            strong_self->onSendRtp(rtp_filter, ++i == pkt->size());
-                        }
-                    } else {
-                        strong_self->onSendRtp(rtp, ++i == pkt->size());
-                    }
-                } else {
-                    strong_self->onSendRtp(rtp, ++i == pkt->size());
+void WebRtcPlayer::onReadRtp(const RtspMediaSource::RingDataType &pkt, int layer) {
+    if (layer == _pending_layer) {
+        // 丢弃新层gop起始位置之前的数据，从关键帧处切入
+        // Drop the data before the gop start of the new layer, switch in at the key frame
+        size_t i = 0;
+        bool switched = false;
+        pkt->for_each([&](const RtpPacket::Ptr &rtp) {
+            ++i;
+            if (!switched) {
+                if (rtp->type != TrackVideo || !_pending_demuxer->inputRtp(rtp)) {
+                    return;
                 }
-            });
-        });
-        _reader->setDetachCB([weak_self]() {
-            auto strong_self = weak_self.lock();
-            if (!strong_self) {
+                InfoL << "switch simulcast layer: " << _layers[_cur_layer].stream << " -> " << _layers[layer].stream
+                      << ", target bitrate:" << getTargetBitrate();
+                switched = true;
+                _reader = std::move(_pending_reader);
+                _cur_layer = layer;
+                _pending_layer = -1;
+                _pending_demuxer = nullptr;
+                _switch_ticker.resetTime();
+                sendLayerRtp(rtp, i == pkt->size(), true);
                 return;
             }
-            strong_self->onShutdown(SockException(Err_shutdown, "rtsp ring buffer detached"));
+            sendLayerRtp(rtp, i == pkt->size(), false);
         });
+        return;
+    }
+    if (layer != _cur_layer) {
+        return;
+    }
+
+    if (_send_config_frames_once && !pkt->empty()) {
+        const auto &first_rtp = pkt->front();
+        sendConfigFrames(first_rtp->getSeq(), first_rtp->sample_rate, first_rtp->getStamp(), first_rtp->ntp_stamp);
+        _send_config_frames_once = false;
+    }
 
-        _reader->setMessageCB([weak_self](const toolkit::Any &data) {
-            auto strong_self = weak_self.lock();
-            if (!strong_self) {
+    size_t i = 0;
+    pkt->for_each([&](const RtpPacket::Ptr &rtp) {
+        sendLayerRtp(rtp, ++i == pkt->size(), false);
+    });
+}
+
+void WebRtcPlayer::sendLayerRtp(const RtpPacket::Ptr &rtp, bool flush, bool switch_layer) {
+    auto out = rtp;
+    if (!_layers.empty()) {
+        if (rtp->type == TrackVideo) {
+            out = _video_rewriter.rewrite(rtp, switch_layer);
+        } else {
+            auto seq = rtp->getSeq();
+            if (_audio_started && (int16_t)(seq - _last_audio_seq) <= 0) {
                 return;
             }
-            if (data.is<Buffer>()) {
-                auto &buffer = data.get<Buffer>();
-                // PPID 51: 文本string  [AUTO-TRANSLATED:69a8cf81]
-                // PPID 51: Text string
-                // PPID 53: 二进制  [AUTO-TRANSLATED:faf00c3e]
-                // PPID 53: Binary
-                strong_self->sendDatachannel(0, 51, buffer.data(), buffer.size());
-            } else {
-                WarnL << "Send unknown message type to webrtc player: " << data.type_name();
+            _audio_started = true;
+            _last_audio_seq = seq;
+        }
+    }
+    if (_bfliter_flag && TrackVideo == out->type && _is_h264) {
+        out = _bfilter->processPacket(out);
+        if (!out) {
+            return;
+        }
+    }
+    onSendRtp(out, flush);
+}
+
+void WebRtcPlayer::onLayerDetach(int layer) {
+    if (layer == _pending_layer) {
+        cancelPendingLayer();
+        return;
+    }
+    if (layer == _cur_layer) {
+        onShutdown(SockException(Err_shutdown, "rtsp ring buffer detached"));
+    }
+}
+
+void WebRtcPlayer::startSimulcastSwitch(const RtspMediaSource::Ptr &src) {
+    if (src->getOriginType() != MediaOriginType::rtc_push) {
+        // 只有webrtc推流才有simulcast
+        // Only webrtc push streams have simulcast
+        return;
+    }
+    _origin_url = src->getOriginUrl();
+    _layers.push_back({ src->getMediaTuple().stream, src });
+    _switch_ticker.resetTime();
+    weak_ptr<WebRtcPlayer> weak_self = static_pointer_cast<WebRtcPlayer>(shared_from_this());
+    getPoller()->doDelayTask(kLayerCheckIntervalMS, [weak_self]() -> uint64_t {
+        auto strong_self = weak_self.lock();
+        if (!strong_self) {
+            return 0;
+        }
+        strong_self->checkSimulcastLayer();
+        return kLayerCheckIntervalMS;
+    });
+}
+
+void WebRtcPlayer::findSimulcastLayers() {
+    // simulcast各层由同一个webrtc推流者产生，由推流者提供各层流id，只按流id查找新出现或者已失效的层
+    // The simulcast layers are produced by the same webrtc publisher, which provides the stream id of each layer,
+    // only look up new or expired layers by stream id
+    auto play_src = _play_src.lock();
+    if (!play_src) {
+        return;
+    }
+    for (auto &stream : play_src->getSimulcastStreams()) {
+        auto it = std::find_if(_layers.begin(), _layers.end(), [&](const SimulcastLayer &layer) { return layer.stream == stream; });
+        if (it != _layers.end() && !it->src.expired()) {
+            continue;
+        }
+        auto rtsp_src = dynamic_pointer_cast<RtspMediaSource>(MediaSource::find(RTSP_SCHEMA, _media_info.vhost, _media_info.app, stream));
+        if (!rtsp_src || rtsp_src->getOriginUrl() != _origin_url) {
+            continue;
+        }
+        if (it == _layers.end()) {
+            InfoL << "found simulcast layer: " << _media_info.shortUrl() << " -> " << stream;
+            _layers.push_back({ stream, rtsp_src });
+        } else if (it->src.expired()) {
+            it->src = rtsp_src;
+        }
+    }
+}
+
+void WebRtcPlayer::checkSimulcastLayer() {
+    findSimulcastLayers();
+    if (_pending_layer >= 0 && _pending_ticker.elapsedTime() > kPendingLayerTimeoutMS) {
+        WarnL << "wait key frame of simulcast layer timeout: " << _layers[_pending_layer].stream;
+        cancelPendingLayer();
+    }
+
+    // 扣除音频后视频可用的码率
+    // The bitrate available for video after deducting audio
+    uint64_t available_bps = getTargetBitrate();
+    size_t cur_bps = 0;
+    std::vector<std::pair<int /*layer*/, size_t /*bps*/>> layers;
+    // 扫描时锁定的媒体源，切换时直接使用，避免期间被释放
+    // The media sources locked during the scan, used directly when switching, to avoid being released in the meantime
+    std::vector<RtspMediaSource::Ptr> srcs(_layers.size());
+    for (int i = 0; i < (int)_layers.size(); ++i) {
+        auto &src = srcs[i];
+        src = _layers[i].src.lock();
+        if (!src) {
+            continue;
+        }
+        auto bps = src->getBytesSpeed(TrackVideo) * 8;
+        if (i == _cur_layer) {
+            cur_bps = bps;
+            auto audio_bps = src->getBytesSpeed(TrackAudio) * 8;
+            available_bps = available_bps > audio_bps ? available_bps - audio_bps : 0;
+        }
+        if (bps) {
+            // 码率为0说明该层已停止推流
+            // A bitrate of 0 means that the layer has stopped pushing
+            layers.emplace_back(i, bps);
+        }
+    }
+    if (layers.empty()) {
+        return;
+    }
+
+    // 选择可用码率以内的最高层，都超出时选择最低层；降层立即生效，升层需要保留余量且间隔足够久
+    // Select the highest layer within the available bitrate, or the lowest layer if all exceed it;
+    // switching down takes effect immediately, switching up requires headroom and a long enough interval
+    bool can_up = _switch_ticker.elapsedTime() > kLayerUpSwitchIntervalMS;
+    int best = -1, lowest = -1;
+    size_t best_bps = 0, lowest_bps = SIZE_MAX;
+    for (auto &pr : layers) {
+        if (pr.second < lowest_bps) {
+            lowest = pr.first;
+            lowest_bps = pr.second;
+        }
+        bool up = cur_bps && pr.second > cur_bps;
+        if (up ? (can_up && pr.second <= available_bps * kLayerUpSwitchHeadroom) : pr.second <= available_bps) {
+            if (pr.second > best_bps) {
+                best = pr.first;
+                best_bps = pr.second;
             }
-        });
+        }
     }
+    if (best < 0) {
+        best = lowest;
+        best_bps = lowest_bps;
+    }
+
+    if (best == _cur_layer) {
+        cancelPendingLayer();
+        return;
+    }
+    if (best == _pending_layer) {
+        return;
+    }
+    cancelPendingLayer();
+    // layers中只有成功锁定的层，src不为空
+    // Only the successfully locked layers are in layers, so src is not null
+    auto &src = srcs[best];
+    _pending_demuxer = std::make_shared<RtspDemuxer>();
+    _pending_demuxer->loadSdp(src->getSdp());
+    _pending_reader = attachReader(src, best, false);
+    _pending_layer = best;
+    _pending_ticker.resetTime();
+    DebugL << "wait key frame of simulcast layer: " << _layers[best].stream << "(" << best_bps << "bps)"
+           << ", available bitrate:" << available_bps;
+}
+
+void WebRtcPlayer::cancelPendingLayer() {
+    _pending_layer = -1;
+    _pending_reader = nullptr;
+    _pending_demuxer = nullptr;
 }
+
 void WebRtcPlayer::onDestory() {
     auto duration = getDuration();
     auto bytes_usage = getBytesUsage();
@@ -297,6 +553,14 @@ void WebRtcPlayer::onRtcConfigure(RtcConfigure &configure) const {
     configure.setPlayRtspInfo(playSrc->getSdp());
 }
 
+void WebRtcPlayer::onGetTransportInfo(Json::Value &result) const {
+    WebRtcTransportImp::onGetTransportInfo(result);
+    if (!_layers.empty()) {
+        result["simulcastLayer"] = _layers[_cur_layer].stream;
+        result["simulcastLayers"] = (Json::UInt64)_layers.size();
+    }
+}
+
 void WebRtcPlayer::sendConfigFrames(uint32_t before_seq, uint32_t sample_rate, uint32_t timestamp, uint64_t ntp_timestamp) {
     auto play_src = _play_src.lock();
     if (!play_src) {
@@ -122,6 +122,33 @@ private:
     bool _first_packet; // 是否是第一个包的标记
 };
 
+/**
+ * simulcast切换层时改写视频rtp的seq与时间戳，使输出给播放器的rtp流保持连续
+ * Rewrite the seq and timestamp of the video rtp when switching simulcast layers, keeping the rtp stream output to the player continuous
+ */
+class RtpLayerRewriter {
+public:
+    /**
+     * @param rtp 输入rtp，可能被多个播放器共享，改写时会拷贝
+     * @param switch_layer 是否为新层关键帧的第一个rtp
+     * @return 改写后的rtp，未发生过切换时返回原包
+     * @param rtp Input rtp, which may be shared by multiple players, it will be copied when rewritten
+     * @param switch_layer Whether it is the first rtp of the key frame of the new layer
+     * @return The rewritten rtp, return the original packet if no switch has occurred
+     */
+    RtpPacket::Ptr rewrite(const RtpPacket::Ptr &rtp, bool switch_layer);
+
+private:
+    bool _started = false;
+    uint16_t _seq_offset = 0;
+    uint32_t _stamp_offset = 0;
+    uint16_t _last_seq = 0;
+    uint32_t _last_stamp = 0;
+    uint64_t _last_ntp_stamp = 0;
+};
+
+class RtspDemuxer;
+
 class WebRtcPlayer : public WebRtcTransportImp {
 public:
     using Ptr = std::shared_ptr<WebRtcPlayer>;
@@ -134,11 +161,23 @@ protected:
     void onStartWebRTC() override;
     void onDestory() override;
     void onRtcConfigure(RtcConfigure &configure) const override;
+    void onGetTransportInfo(Json::Value &result) const override;
 
 private:
     WebRtcPlayer(const toolkit::EventPoller::Ptr &poller, const RtspMediaSource::Ptr &src, const MediaInfo &info);
 
     void sendConfigFrames(uint32_t before_seq, uint32_t sample_rate, uint32_t timestamp, uint64_t ntp_timestamp);
+    RtspMediaSource::RingType::RingReader::Ptr attachReader(const RtspMediaSource::Ptr &src, int layer, bool use_cache);
+    void onReadRtp(const RtspMediaSource::RingDataType &pkt, int layer);
+    void sendLayerRtp(const RtpPacket::Ptr &rtp, bool flush, bool switch_layer);
+    void onLayerDetach(int layer);
+
+    // simulcast层切换
+    // Simulcast layer switching
+    void startSimulcastSwitch(const RtspMediaSource::Ptr &src);
+    void findSimulcastLayers();
+    void checkSimulcastLayer();
+    void cancelPendingLayer();
 
 private:
     // 媒体相关元数据  [AUTO-TRANSLATED:f4cf8045]
@@ -159,6 +198,30 @@ private:
     bool _is_h264 { false };
     bool _bfliter_flag { false };
     std::shared_ptr<H264BFrameFilter> _bfilter;
+
+    struct SimulcastLayer {
+        std::string stream;
+        std::weak_ptr<RtspMediaSource> src;
+    };
+    // 同一推流者的simulcast各层，第0层为播放的源，层切换未开启时为空
+    // Simulcast layers of the same publisher, layer 0 is the played source, empty when layer switching is not enabled
+    std::vector<SimulcastLayer> _layers;
+    std::string _origin_url;
+    // 当前转发的层，即_reader对应的层
+    // The layer currently forwarded, that is, the layer corresponding to _reader
+    int _cur_layer = 0;
+    // 等待关键帧以切入的层，-1表示无
+    // The layer waiting for a key frame to switch in, -1 means none
+    int _pending_layer = -1;
+    RtspMediaSource::RingType::RingReader::Ptr _pending_reader;
+    std::shared_ptr<RtspDemuxer> _pending_demuxer;
+    toolkit::Ticker _pending_ticker;
+    toolkit::Ticker _switch_ticker;
+    RtpLayerRewriter _video_rewriter;
+    // 各层音频相同，切换时根据seq去重
+    // The audio of each layer is the same, deduplicated by seq when switching
+    bool _audio_started = false;
+    uint16_t _last_audio_seq = 0;
 };
 
 }// namespace mediakit
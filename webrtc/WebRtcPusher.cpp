@@ -111,6 +111,18 @@ void WebRtcPusher::onRecvRtp(MediaTrack &track, const string &rid, RtpPacket::Pt
     }
 }
 
+std::vector<std::string> WebRtcPusher::getSimulcastStreams(MediaSource &sender) const {
+    std::vector<std::string> ret;
+    if (!_simulcast) {
+        return ret;
+    }
+    std::lock_guard<std::recursive_mutex> lock(_mtx);
+    for (auto &pr : _push_src_sim) {
+        ret.emplace_back(pr.second->getMediaTuple().stream);
+    }
+    return ret;
+}
+
 void WebRtcPusher::onStartWebRTC() {
     WebRtcTransportImp::onStartWebRTC();
     _simulcast = _answer_sdp->supportSimulcast();
@@ -59,6 +59,9 @@ protected:
     // 获取丢包率  [AUTO-TRANSLATED:ec61b378]
     // Get packet loss rate
     float getLossRate(MediaSource &sender,TrackType type) override;
+    // 获取simulcast各层流id，供播放器按照带宽切换层
+    // Get the stream ids of the simulcast layers, for players to switch layers according to the bandwidth
+    std::vector<std::string> getSimulcastStreams(MediaSource &sender) const override;
 
 private:
     WebRtcPusher(const toolkit::EventPoller::Ptr &poller, const RtspMediaSource::Ptr &src,
@@ -80,7 +83,7 @@ private:
     std::shared_ptr<void> _push_src_ownership;
     // 推流的rtsp源,支持simulcast  [AUTO-TRANSLATED:44be9120]
     // Rtsp source of the stream, supports simulcast
-    std::recursive_mutex _mtx;
+    mutable std::recursive_mutex _mtx;
     std::unordered_map<std::string/*rid*/, RtspMediaSource::Ptr> _push_src_sim;
     std::unordered_map<std::string/*rid*/, std::shared_ptr<void> > _push_src_sim_ownership;
 };
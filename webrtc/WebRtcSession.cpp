@@ -40,8 +40,7 @@ EventPoller::Ptr WebRtcSession::queryPoller(const Buffer::Ptr &buffer) {
     if (user_name.empty()) {
         return nullptr;
     }
-    auto ret = WebRtcTransportManager::Instance().getItem(user_name);
-    return ret ? ret->getPoller() : nullptr;
+    return WebRtcTransportManager::Instance().getPoller(user_name);
 }
 
 ////////////////////////////////////////////////////////////////////////////////
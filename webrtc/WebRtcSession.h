@@ -33,6 +33,9 @@ public:
     void onError(const toolkit::SockException &err) override;
     void onManager() override;
     static toolkit::EventPoller::Ptr queryPoller(const toolkit::Buffer::Ptr &buffer);
+    // 获取该连接对应的webrtc对象，尚未收到数据时为空，只能在本连接的poller线程调用
+    // Get the webrtc object of this connection, it is null before any data is received, can only be called in the poller thread of this connection
+    const WebRtcTransportImp::Ptr &getTransport() const { return _transport; }
 
 protected:
     WebRtcTransportImp::Ptr _transport;
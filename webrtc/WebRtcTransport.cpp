@@ -84,6 +84,10 @@ const string kMinBitrate = RTC_FIELD "min_bitrate";
 const string kDataChannelEcho = RTC_FIELD "datachannel_echo";
 const string kPreferredTcp = RTC_FIELD "preferred_tcp";
 
+// 发送端带宽估计与rtp平滑发送，对端支持transport-cc时生效
+// Sender side bandwidth estimation and rtp pacing, effective when the peer supports transport-cc
+const string kSendSideBwe = RTC_FIELD "sendSideBwe";
+
 static onceToken token([]() {
     mINI::Instance()[kTimeOutSec] = 15;
     mINI::Instance()[kExternIP] = "";
@@ -97,6 +101,7 @@ static onceToken token([]() {
     mINI::Instance()[kMinBitrate] = 0;
 
     mINI::Instance()[kDataChannelEcho] = true;
+    mINI::Instance()[kSendSideBwe] = 0;
 
     mINI::Instance()[kSignalingPort] = 3000;
     mINI::Instance()[kSignalingSslPort] = 3001;
@@ -279,7 +284,10 @@ const char* WebRtcTransport::RoleStr(Role role) {
 WebRtcTransport::WebRtcTransport(const EventPoller::Ptr &poller) {
     _poller = poller;
     static auto prefix = getServerPrefix();
-    _identifier = prefix + to_string(++s_key);
+    // ufrag格式: prefix(以'/'结尾) + 4位poller序号 + 自增长数，udp收到stun包时可以直接定位所属poller
+    // ufrag format: prefix (ending with '/') + 4-digit poller index + auto-incrementing number,
+    // the owner poller can be located directly when receiving stun by udp
+    _identifier = prefix + WebRtcTransportManager::Instance().makeKeySuffix(poller) + to_string(++s_key);
     _packet_pool.setSize(64);
 }
 
@@ -351,7 +359,7 @@ void WebRtcTransport::getTransportInfo(const std::function<void(Json::Value)>& c
             } else {
                 result["ice_checklists"] = Json::nullValue;
             }
-            
+            strong_self->onGetTransportInfo(result);
             
         } catch (const std::exception& ex) {
             result["error"] = std::string("Exception occurred: ") + ex.what();
@@ -785,11 +793,15 @@ void WebRtcTransport::inputSockData(const char *buf, int len, const IceTransport
 void WebRtcTransport::sendRtpPacket(const char *buf, int len, bool flush, void *ctx) {
     if (_srtp_session_send) {
         auto pkt = _packet_pool.obtain2();
-        // 预留rtx加入的两个字节  [AUTO-TRANSLATED:d1eb5cd7]
-        // Reserve two bytes for rtx joining
-        pkt->setCapacity((size_t)len + SRTP_MAX_TRAILER_LEN + 2);
-        memcpy(pkt->data(), buf, len);
-        onBeforeEncryptRtp(pkt->data(), len, ctx);
+        // 预留rtx加入的两个字节以及插入transport-cc扩展的字节
+        // Reserve two bytes for rtx joining and the bytes for inserting the transport-cc extension
+        pkt->setCapacity((size_t)len + SRTP_MAX_TRAILER_LEN + 2 + kTwccExtInsertSize);
+        // 源rtp在多个连接间共享，拷贝与改写rtp头一次完成，负载只拷贝一次
+        // The source rtp is shared among multiple connections, copy and rewrite the rtp header at once, the payload is copied only once
+        // srtp对头部与负载原地加密并在尾部追加认证标签，必须是连续且每个连接独立的内存，所以这次拷贝无法用iovec分散发送替代
+        // srtp encrypts the header and payload in place and appends the auth tag, which requires contiguous per-connection memory,
+        // so this copy cannot be replaced by scatter/gather sending with iovec
+        onBeforeEncryptRtp(buf, pkt->data(), len, ctx);
         if (_srtp_session_send->EncryptRtp(reinterpret_cast<uint8_t *>(pkt->data()), &len)) {
             pkt->setSize(len);
             onSendSockData(std::move(pkt), flush);
@@ -797,6 +809,10 @@ void WebRtcTransport::sendRtpPacket(const char *buf, int len, bool flush, void *
     }
 }
 
+void WebRtcTransport::onBeforeEncryptRtp(const char *src, char *dst, int &len, void *ctx) {
+    memcpy(dst, src, len);
+}
+
 void WebRtcTransport::sendRtcpPacket(const char *buf, int len, bool flush, void *ctx) {
     if (_srtp_session_send) {
         auto pkt = _packet_pool.obtain2();
@@ -834,7 +850,7 @@ void WebRtcTransportImp::onCreate() {
         },
         getPoller());
 
-    _twcc_ctx.setOnSendTwccCB([this](uint32_t ssrc, string fci) { onSendTwcc(ssrc, fci); });
+    _twcc_ctx.setOnSendTwccCB([this](uint32_t ssrc, const string &fci) { onSendTwcc(ssrc, fci); });
 }
 
 void WebRtcTransportImp::OnDtlsTransportApplicationDataReceived(const RTC::DtlsTransport *dtlsTransport, const uint8_t *data, size_t len) {
@@ -969,6 +985,65 @@ void WebRtcTransportImp::onStartWebRTC() {
             ++index;
         }
     }
+    setupSendSideBwe();
+}
+
+void WebRtcTransportImp::setupSendSideBwe() {
+    GET_CONFIG(bool, send_side_bwe, Rtc::kSendSideBwe);
+    // 需要同时协商transport-cc反馈与扩展，否则发送的扩展会被改写为padding，收不到反馈
+    // Both the transport-cc feedback and extension must be negotiated, otherwise the sent extension is rewritten as padding and no feedback is received
+    if (!send_side_bwe || !canSendRtp() || !_answer_sdp->supportRtcpFb(SdpConst::kTWCCRtcpFb)
+        || !_answer_sdp->supportRtpExt(RtpExtType::transport_cc)) {
+        return;
+    }
+    GET_CONFIG(uint32_t, start_bitrate, Rtc::kStartBitrate);
+    GET_CONFIG(uint32_t, min_bitrate, Rtc::kMinBitrate);
+    GET_CONFIG(uint32_t, max_bitrate, Rtc::kMaxBitrate);
+    // 码率配置单位为kbps，未配置时使用默认值
+    // The unit of bitrate configuration is kbps, use the default value when not configured
+    auto start_bps = start_bitrate ? start_bitrate * 1000 : 1000 * 1000;
+    auto min_bps = min_bitrate ? min_bitrate * 1000 : 100 * 1000;
+    auto max_bps = max_bitrate ? max_bitrate * 1000 : 100 * 1000 * 1000;
+    _bwe = std::make_shared<SendSideBwe>(start_bps, min_bps, max_bps);
+
+    weak_ptr<WebRtcTransportImp> weak_self = static_pointer_cast<WebRtcTransportImp>(shared_from_this());
+    _pacer = std::make_shared<RtpPacer>(getPoller(), [weak_self](const RtpPacket::Ptr &rtp, bool flush) {
+        if (auto strong_self = weak_self.lock()) {
+            strong_self->sendRtp(rtp, flush, false);
+        }
+    });
+    _pacer->setTargetBitrate(_bwe->getTargetBitrate());
+    InfoL << "enable send side bwe, start bitrate:" << start_bps << ", min:" << min_bps << ", max:" << max_bps;
+}
+
+bool WebRtcTransportImp::getBweInfo(Json::Value &bwe) const {
+    if (!_bwe) {
+        return false;
+    }
+    BweInfo info;
+    _bwe->getInfo(info);
+    _pacer->getInfo(info);
+    bwe["targetBitrate"] = info.target_bps;
+    bwe["delayBasedBitrate"] = info.delay_based_bps;
+    bwe["lossBasedBitrate"] = info.loss_based_bps;
+    bwe["rembBitrate"] = info.remb_bps;
+    bwe["ackedBitrate"] = info.acked_bps;
+    bwe["lossRate"] = info.loss_rate;
+    bwe["trend"] = info.trend;
+    bwe["threshold"] = info.threshold;
+    bwe["state"] = info.state;
+    bwe["feedbacks"] = (Json::UInt64)info.feedbacks;
+    bwe["pacerQueuePackets"] = (Json::UInt64)info.pacer_queue_packets;
+    bwe["pacerQueueBytes"] = (Json::UInt64)info.pacer_queue_bytes;
+    bwe["pacerQueueMS"] = info.pacer_queue_ms;
+    return true;
+}
+
+void WebRtcTransportImp::onGetTransportInfo(Json::Value &result) const {
+    Json::Value bwe;
+    if (getBweInfo(bwe)) {
+        result["bwe"] = std::move(bwe);
+    }
 }
 
 void WebRtcTransportImp::onCheckAnswer(RtcSession &sdp) {
@@ -1267,10 +1342,26 @@ void WebRtcTransportImp::onRtcp(const char *buf, size_t len) {
         case RtcpType::RTCP_PSFB:
         case RtcpType::RTCP_RTPFB: {
             if ((RtcpType)rtcp->pt == RtcpType::RTCP_PSFB) {
+                if (_bwe && (PSFBType)rtcp->report_count == PSFBType::RTCP_PSFB_REMB) {
+                    // 对端的接收端带宽估计，作为发送码率上限
+                    // The receiver side bandwidth estimation of the peer, used as the upper limit of the sending bitrate
+                    RtcpFB *fb = (RtcpFB *)rtcp;
+                    _bwe->onRemb(fb->getFci<FCI_REMB>().getBitRate());
+                    _pacer->setTargetBitrate(_bwe->getTargetBitrate());
+                }
                 break;
             }
             // RTPFB
             switch ((RTPFBType)rtcp->report_count) {
+            case RTPFBType::RTCP_RTPFB_TWCC: {
+                if (!_bwe) {
+                    break;
+                }
+                RtcpFB *fb = (RtcpFB *)rtcp;
+                _bwe->onTwccFeedback(fb->getFci<FCI_TWCC>(), fb->getFciSize(), getCurrentMicrosecond());
+                _pacer->setTargetBitrate(_bwe->getTargetBitrate());
+                break;
+            }
             case RTPFBType::RTCP_RTPFB_NACK: {
                 RtcpFB *fb = (RtcpFB *)rtcp;
                 auto it = _ssrc_to_track.find(fb->ssrc_media);
@@ -1476,6 +1567,21 @@ void WebRtcTransportImp::onSortedRtp(MediaTrack &track, const string &rid, RtpPa
 ///////////////////////////////////////////////////////////////////
 
 void WebRtcTransportImp::onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool rtx) {
+    if (_pacer) {
+        if (!rtx && rtp->type == TrackVideo && _type_to_track[TrackVideo]) {
+            // 视频rtp经过pacer平滑发送
+            // Video rtp is sent smoothly through the pacer
+            _pacer->inputRtp(rtp, flush);
+            return;
+        }
+        // 音频与重传包直接发送，但占用pacer预算
+        // Audio and retransmitted packets are sent directly, but occupy the pacer budget
+        _pacer->onBypassSent(rtp->size() - RtpPacket::kRtpTcpHeaderSize);
+    }
+    sendRtp(rtp, flush, rtx);
+}
+
+void WebRtcTransportImp::sendRtp(const RtpPacket::Ptr &rtp, bool flush, bool rtx) {
     auto &track = _type_to_track[rtp->type];
     if (!track) {
         // 忽略，对方不支持该编码类型  [AUTO-TRANSLATED:498ee936]
@@ -1516,20 +1622,44 @@ void WebRtcTransportImp::onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool r
     }
 }
 
-void WebRtcTransportImp::onBeforeEncryptRtp(const char *buf, int &len, void *ctx) {
+void WebRtcTransportImp::onBeforeEncryptRtp(const char *src, char *dst, int &len, void *ctx) {
     auto pr = (pair<bool /*rtx*/, MediaTrack *> *)ctx;
-    auto header = (RtpHeader *)buf;
+    auto header = (RtpHeader *)dst;
+    auto src_header_size = (int)(((RtpHeader *)src)->getPayloadData() - (uint8_t *)src);
+    auto header_size = src_header_size;
+    memcpy(dst, src, src_header_size);
+    auto use_twcc = _bwe && pr->second->rtp_ext_ctx->supportExt(RtpExtType::transport_cc);
+    if (use_twcc && !((RtpHeader *)src)->ext) {
+        // 源rtp没有扩展时，在csrc后插入one-byte格式的transport-cc扩展，id暂为扩展类型，随后与其他扩展一起改写为客户端的id
+        // When the source rtp has no extension, insert a one-byte transport-cc extension after csrc, the id is temporarily the extension type,
+        // and then rewritten to the client id together with other extensions
+        auto ext = (uint8_t *)dst + header_size;
+        ext[0] = 0xBE;
+        ext[1] = 0xDE;
+        ext[2] = 0;
+        ext[3] = 1;
+        ext[4] = (uint8_t)RtpExtType::transport_cc << 4 | 1;
+        ext[5] = ext[6] = ext[7] = 0;
+        header->ext = 1;
+        header_size += kTwccExtInsertSize;
+        len += kTwccExtInsertSize;
+    }
+    auto twcc = pr->second->rtp_ext_ctx->changeRtpExtId(header, false, nullptr, use_twcc ? RtpExtType::transport_cc : RtpExtType::padding);
 
     if (!pr->first || !pr->second->plan_rtx) {
         // 普通的rtp,或者不支持rtx, 修改目标pt和ssrc  [AUTO-TRANSLATED:e1264971]
         // Ordinary RTP, or does not support RTX, modify the target PT and SSRC
-        pr->second->rtp_ext_ctx->changeRtpExtId(header, false);
+        memcpy(dst + header_size, src + src_header_size, len - header_size);
         header->pt = pr->second->plan_rtp->pt;
         header->ssrc = htonl(pr->second->answer_ssrc_rtp);
     } else {
         // 重传的rtp, rtx  [AUTO-TRANSLATED:e863a518]
         // Retransmitted RTP, RTX
-        pr->second->rtp_ext_ctx->changeRtpExtId(header, false);
+        // rtp头(包括csrc与ext)后留出两个字节用于存放osn，负载直接拷贝到其后，无需再整体后移
+        // Leave two bytes after the rtp header (including csrc and ext) for osn, the payload is copied directly after it without shifting
+        // https://datatracker.ietf.org/doc/html/rfc4588#section-4
+        memcpy(dst + header_size + 2, src + src_header_size, len - header_size);
+
         header->pt = pr->second->plan_rtx->pt;
         if (pr->second->answer_ssrc_rtx) {
             // 有rtx单独的ssrc,有些情况下，浏览器支持rtx，但是未指定rtx单独的ssrc  [AUTO-TRANSLATED:181cee9a]
@@ -1547,18 +1677,18 @@ void WebRtcTransportImp::onBeforeEncryptRtp(const char *buf, int &len, void *ctx
         header->seq = htons(_rtx_seq[pr->second->media->type]);
         ++_rtx_seq[pr->second->media->type];
 
-        auto payload = header->getPayloadData();
-        auto payload_size = header->getPayloadSize(len);
-        if (payload_size) {
-            // rtp负载后移两个字节，这两个字节用于存放osn  [AUTO-TRANSLATED:b7eed70e]
-            // The RTP payload is shifted two bytes, these two bytes are used to store OSN
-            // https://datatracker.ietf.org/doc/html/rfc4588#section-4
-            memmove(payload + 2, payload, payload_size);
-        }
+        auto payload = (uint8_t *)dst + header_size;
         payload[0] = origin_seq >> 8;
         payload[1] = origin_seq & 0xFF;
         len += 2;
     }
+
+    if (twcc) {
+        // 重传包也使用新的transport-cc序号，以便带宽估计统计
+        // Retransmitted packets also use a new transport-cc sequence for bandwidth estimation
+        twcc.setTransportCCSeq(_twcc_send_seq);
+        _bwe->onSendPacket(_twcc_send_seq++, len, getCurrentMicrosecond());
+    }
 }
 
 void WebRtcTransportImp::safeShutdown(const SockException &ex) {
@@ -1608,26 +1738,99 @@ WebRtcTransportManager &WebRtcTransportManager::Instance() {
     return s_instance;
 }
 
+WebRtcTransportManager::WebRtcTransportManager() {
+    EventPollerPool::Instance().for_each([&](const TaskExecutor::Ptr &executor) {
+        // 序号需要预留一个给不属于EventPollerPool的transport
+        // One index needs to be reserved for transports that do not belong to EventPollerPool
+        if (_pollers.size() < kMaxShardIndex) {
+            _pollers.emplace_back(static_pointer_cast<EventPoller>(executor));
+        }
+    });
+    for (size_t i = 0; i <= _pollers.size(); ++i) {
+        _shards.emplace_back(new Shard);
+    }
+}
+
+string WebRtcTransportManager::formatShardIndex(size_t index) {
+    char buf[kShardIndexWidth + 1];
+    snprintf(buf, sizeof(buf), "%0*u", (int)kShardIndexWidth, (unsigned)MIN(index, (size_t)kMaxShardIndex));
+    return buf;
+}
+
+size_t WebRtcTransportManager::parseShardIndex(const string &key, size_t count) {
+    // prefix为base64，可能包含'/'与'+'，poller序号位于最后一个'/'之后
+    // The prefix is base64 and may contain '/' and '+', the poller index is after the last '/'
+    auto pos = key.rfind('/');
+    pos = pos == string::npos ? 0 : pos + 1;
+    // poller序号后至少还有一位自增长数
+    // There is at least one digit of the auto-incrementing number after the poller index
+    if (key.size() <= pos + kShardIndexWidth) {
+        return count;
+    }
+    size_t index = 0;
+    for (auto end = pos + kShardIndexWidth; pos < end; ++pos) {
+        if (!isdigit((uint8_t)key[pos])) {
+            return count;
+        }
+        index = index * 10 + (key[pos] - '0');
+    }
+    return index < count ? index : count;
+}
+
+string WebRtcTransportManager::makeKeySuffix(const EventPoller::Ptr &poller) const {
+    // 不属于EventPollerPool时使用最后一个分片的序号
+    // Use the index of the last shard if it does not belong to EventPollerPool
+    auto it = std::find(_pollers.begin(), _pollers.end(), poller);
+    return formatShardIndex(it - _pollers.begin());
+}
+
+size_t WebRtcTransportManager::getShardIndex(const string &key) const {
+    return parseShardIndex(key, _pollers.size());
+}
+
 void WebRtcTransportManager::addItem(const string &key, const WebRtcTransportImp::Ptr &ptr) {
-    lock_guard<mutex> lck(_mtx);
-    _map[key] = ptr;
+    auto &shard = *_shards[getShardIndex(key)];
+    lock_guard<mutex> lck(shard.mtx);
+    shard.map[key] = ptr;
 }
 
 WebRtcTransportImp::Ptr WebRtcTransportManager::getItem(const string &key) {
     if (key.empty()) {
         return nullptr;
     }
-    lock_guard<mutex> lck(_mtx);
-    auto it = _map.find(key);
-    if (it == _map.end()) {
+    auto &shard = *_shards[getShardIndex(key)];
+    lock_guard<mutex> lck(shard.mtx);
+    auto it = shard.map.find(key);
+    if (it == shard.map.end()) {
         return nullptr;
     }
     return it->second.lock();
 }
 
+EventPoller::Ptr WebRtcTransportManager::getPoller(const string &key) {
+    if (key.empty()) {
+        return nullptr;
+    }
+    auto index = getShardIndex(key);
+    if (index < _pollers.size()) {
+        // ufrag携带poller序号，只需确认transport存在
+        // The ufrag carries the poller index, only need to confirm the transport exists
+        auto &shard = *_shards[index];
+        lock_guard<mutex> lck(shard.mtx);
+        auto it = shard.map.find(key);
+        if (it == shard.map.end() || it->second.expired()) {
+            return nullptr;
+        }
+        return _pollers[index];
+    }
+    auto transport = getItem(key);
+    return transport ? transport->getPoller() : nullptr;
+}
+
 void WebRtcTransportManager::removeItem(const string &key) {
-    lock_guard<mutex> lck(_mtx);
-    _map.erase(key);
+    auto &shard = *_shards[getShardIndex(key)];
+    lock_guard<mutex> lck(shard.mtx);
+    shard.map.erase(key);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////
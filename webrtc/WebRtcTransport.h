@@ -25,6 +25,7 @@
 #include "Network/Session.h"
 #include "Nack.h"
 #include "TwccContext.h"
+#include "SendSideBwe.h"
 #include "SctpAssociation.hpp"
 #include "Rtcp/RtcpContext.h"
 #include "Rtsp/RtspMediaSource.h"
@@ -124,6 +125,10 @@ public:
 
     using WeakPtr = std::weak_ptr<WebRtcTransport>;
     using Ptr = std::shared_ptr<WebRtcTransport>;
+    // 发送rtp时插入transport-cc扩展所需的字节数
+    // Number of bytes required to insert the transport-cc extension when sending rtp
+    static constexpr int kTwccExtInsertSize = 8;
+
     WebRtcTransport(const toolkit::EventPoller::Ptr &poller);
 
     virtual void onCreate();
@@ -218,9 +223,22 @@ protected:
     virtual void onRtp(const char *buf, size_t len, uint64_t stamp_ms) = 0;
     virtual void onRtcp(const char *buf, size_t len) = 0;
     virtual void onShutdown(const toolkit::SockException &ex);
-    virtual void onBeforeEncryptRtp(const char *buf, int &len, void *ctx) = 0;
+    /**
+     * 加密前把rtp从共享的只读源包拷贝到本连接的发送缓存，同时改写rtp头
+     * @param src 共享的源rtp，不可修改
+     * @param dst 本连接的发送缓存，预留了rtx osn的2个字节与kTwccExtInsertSize个字节
+     * @param len 输入为src长度，输出为dst长度
+     * Copy the rtp from the shared read-only source packet to the send buffer of this connection before encryption, rewriting the rtp header at the same time
+     * @param src Shared source rtp, must not be modified
+     * @param dst Send buffer of this connection, 2 bytes reserved for rtx osn and kTwccExtInsertSize bytes
+     * @param len Input is the length of src, output is the length of dst
+     */
+    virtual void onBeforeEncryptRtp(const char *src, char *dst, int &len, void *ctx);
     virtual void onBeforeEncryptRtcp(const char *buf, int &len, void *ctx) = 0;
     virtual void onRtcpBye() = 0;
+    // getTransportInfo时由子类补充信息，在poller线程执行
+    // Subclasses supplement the information when getTransportInfo, executed in the poller thread
+    virtual void onGetTransportInfo(Json::Value &result) const {}
 
 protected:
     void sendRtcpRemb(uint32_t ssrc, size_t bit_rate);
@@ -321,6 +339,16 @@ public:
     bool canSendRtp(const RtcMedia& media) const;
     bool canRecvRtp(const RtcMedia& media) const;
     void onSendRtp(const RtpPacket::Ptr &rtp, bool flush, bool rtx = false);
+    /**
+     * 获取发送端带宽估计与pacer状态，未开启时返回false，需在poller线程调用
+     * Get the sender side bandwidth estimation and pacer status, return false if not enabled, must be called in the poller thread
+     */
+    bool getBweInfo(Json::Value &bwe) const;
+    /**
+     * 获取发送端带宽估计的目标码率，单位bps，未开启时返回0
+     * Get the target bitrate of the sender side bandwidth estimation, in bps, return 0 if not enabled
+     */
+    uint32_t getTargetBitrate() const { return _bwe ? _bwe->getTargetBitrate() : 0; }
 
     void createRtpChannel(const std::string &rid, uint32_t ssrc, MediaTrack &track);
     void safeShutdown(const toolkit::SockException &ex);
@@ -343,7 +371,7 @@ protected:
 
     void onRtp(const char *buf, size_t len, uint64_t stamp_ms) override;
     void onRtcp(const char *buf, size_t len) override;
-    void onBeforeEncryptRtp(const char *buf, int &len, void *ctx) override;
+    void onBeforeEncryptRtp(const char *src, char *dst, int &len, void *ctx) override;
     void onBeforeEncryptRtcp(const char *buf, int &len, void *ctx) override {};
     void onCreate() override;
     void onDestory() override;
@@ -352,8 +380,11 @@ protected:
     void updateTicker();
     float getLossRate(TrackType type);
     void onRtcpBye() override;
+    void onGetTransportInfo(Json::Value &result) const override;
 
 private:
+    void sendRtp(const RtpPacket::Ptr &rtp, bool flush, bool rtx);
+    void setupSendSideBwe();
     void onSortedRtp(MediaTrack &track, const std::string &rid, RtpPacket::Ptr rtp);
     void onSendNack(MediaTrack &track, const FCI_NACK &nack, uint32_t ssrc);
     void onSendTwcc(uint32_t ssrc, const std::string &twcc_fci);
@@ -388,6 +419,11 @@ private:
     // twcc rtcp发送上下文对象  [AUTO-TRANSLATED:aef6476a]
     // twcc rtcp send context object
     TwccContext _twcc_ctx;
+    // 发送端带宽估计与平滑发送，对端支持transport-cc时开启
+    // Sender side bandwidth estimation and pacing, enabled when the peer supports transport-cc
+    uint16_t _twcc_send_seq = 0;
+    SendSideBwe::Ptr _bwe;
+    RtpPacer::Ptr _pacer;
     // 根据发送rtp的track类型获取相关信息  [AUTO-TRANSLATED:ff31c272]
     // Get relevant information based on the track type of the sent rtp
     MediaTrack::Ptr _type_to_track[2];
@@ -403,20 +439,65 @@ private:
     std::string _local_ip;
 };
 
+/**
+ * WebRtcTransport管理器，按poller分片存储，每个分片独立加锁
+ * ice ufrag中携带所属poller的序号，通过ufrag可以直接定位分片与poller，避免全局锁竞争
+ * WebRtcTransport manager, stored in shards by poller, each shard is locked independently
+ * The ice ufrag carries the index of the owner poller, so the shard and the poller can be located directly by the ufrag, avoiding global lock contention
+ */
 class WebRtcTransportManager {
 public:
+    friend class WebRtcTransport;
     friend class WebRtcTransportImp;
     static WebRtcTransportManager &Instance();
     WebRtcTransportImp::Ptr getItem(const std::string &key);
 
+    /**
+     * 根据ice ufrag获取transport所属poller，transport不存在时返回nullptr
+     * Get the owner poller of the transport by the ice ufrag, return nullptr if the transport does not exist
+     */
+    toolkit::EventPoller::Ptr getPoller(const std::string &key);
+
+    /**
+     * 生成ufrag中固定4位的poller序号
+     * Generate the fixed 4-digit poller index in the ufrag
+     */
+    static std::string formatShardIndex(size_t index);
+
+    /**
+     * 解析ufrag中的poller序号
+     * @param count poller个数
+     * @return poller序号，不携带序号或者序号超出范围时返回count
+     * Parse the poller index in the ufrag
+     * @param count Number of pollers
+     * @return The poller index, return count if there is no index or the index is out of range
+     */
+    static size_t parseShardIndex(const std::string &key, size_t count);
+
 private:
-    WebRtcTransportManager() = default;
+    static constexpr size_t kShardIndexWidth = 4;
+    static constexpr size_t kMaxShardIndex = 9999;
+
+    struct Shard {
+        std::mutex mtx;
+        std::unordered_map<std::string, std::weak_ptr<WebRtcTransportImp> > map;
+    };
+
+    WebRtcTransportManager();
     void addItem(const std::string &key, const WebRtcTransportImp::Ptr &ptr);
     void removeItem(const std::string &key);
+    // 生成携带poller序号的ufrag后缀
+    // Generate the ufrag suffix carrying the poller index
+    std::string makeKeySuffix(const toolkit::EventPoller::Ptr &poller) const;
+    size_t getShardIndex(const std::string &key) const;
 
 private:
-    mutable std::mutex _mtx;
-    std::unordered_map<std::string, std::weak_ptr<WebRtcTransportImp> > _map;
+    // EventPollerPool中的poller，下标即ufrag中的poller序号
+    // Pollers of EventPollerPool, the subscript is the poller index in the ufrag
+    std::vector<toolkit::EventPoller::Ptr> _pollers;
+    // 最后一个分片存放不属于EventPollerPool的transport
+    // The last shard stores the transports that do not belong to EventPollerPool
+    std::vector<std::unique_ptr<Shard> > _shards;
 };
 
 class WebRtcArgs : public std::enable_shared_from_this<WebRtcArgs> {